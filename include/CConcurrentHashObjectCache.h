@@ -0,0 +1,276 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_C_CONCURRENT_HASH_OBJECT_CACHE_H_INCLUDED__
+#define __NBL_C_CONCURRENT_HASH_OBJECT_CACHE_H_INCLUDED__
+
+#include "nbl/core/decl/Types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <shared_mutex>
+
+namespace nbl { namespace core
+{
+
+namespace impl
+{
+    //! Same interface as `CMakeCacheConcurrent` (minus the reservation and swap methods), but instead of one reader-writer lock around the whole
+    //! container the keys live in a `phmap::parallel_flat_hash_map` made of 2^SubmapCountLog2 submaps, each with its own `std::shared_mutex`,
+    //! so lookups and insertions of different keys mostly don't touch the same cache line.
+    //! Greeting and disposal still happen with the submap's lock held, just like in the other caches.
+    //! Every method is atomic with respect to its key, `changeObjectKey` is the exception as it touches two keys which may live in different submaps,
+    //! and `outputAll`, `contains` and `clear` only lock one submap at a time.
+    template<typename K, typename T, bool isMultiCache, typename Hash, typename KeyEqual, size_t SubmapCountLog2>
+    class CConcurrentHashObjectCacheBase
+    {
+            // a multi cache keeps all the objects of a key in one small vector
+            using MappedType = std::conditional_t<isMultiCache,core::vector<T>,T>;
+            using ContainerT = phmap::parallel_flat_hash_map<K,MappedType,Hash,KeyEqual,core::allocator<std::pair<const K,MappedType>>,SubmapCountLog2,std::shared_mutex>;
+            using ContainerValueType = typename ContainerT::value_type;
+
+        public:
+            using KeyType = K;
+            using CachedType = T;
+            using PairType = std::pair<const K,T>;
+            using MutablePairType = std::pair<K,T>;
+
+            using GreetFuncType = std::function<void(T&)>;
+            using DisposalFuncType = std::function<void(T&)>;
+
+            CConcurrentHashObjectCacheBase() = default;
+            inline explicit CConcurrentHashObjectCacheBase(const GreetFuncType& _greeting, const DisposalFuncType& _disposal) : m_greetingFunc(_greeting), m_disposalFunc(_disposal) {}
+            inline explicit CConcurrentHashObjectCacheBase(GreetFuncType&& _greeting, DisposalFuncType&& _disposal) : m_greetingFunc(std::move(_greeting)), m_disposalFunc(std::move(_disposal)) {}
+            // explicitely making concurrent caches non-copy-and-move-constructible and non-copy-and-move-assignable
+            CConcurrentHashObjectCacheBase(const CConcurrentHashObjectCacheBase&) = delete;
+            CConcurrentHashObjectCacheBase(CConcurrentHashObjectCacheBase&&) = delete;
+            CConcurrentHashObjectCacheBase& operator=(const CConcurrentHashObjectCacheBase&) = delete;
+            CConcurrentHashObjectCacheBase& operator=(CConcurrentHashObjectCacheBase&&) = delete;
+
+            inline virtual ~CConcurrentHashObjectCacheBase()
+            {
+                clear();
+            }
+
+            //! A multi cache always inserts, a unique one only if the key is not present yet
+            template<bool GreetOnInsert = true>
+            inline bool insert(const K& _key, const T& _val)
+            {
+                // the copy gets greeted before it goes in, that way it happens under the submap's lock and only if inserting at all
+                auto greeted = [&]() -> T
+                {
+                    T retval(_val);
+                    if constexpr (GreetOnInsert)
+                        greet(retval);
+                    return retval;
+                };
+                bool inserted = m_container.lazy_emplace_l(_key,
+                    [&](ContainerValueType& _existing) -> void
+                    {
+                        if constexpr (isMultiCache)
+                            _existing.second.push_back(greeted());
+                    },
+                    [&](const auto& _ctor) -> void
+                    {
+                        if constexpr (isMultiCache)
+                            _ctor(_key,MappedType{greeted()});
+                        else
+                            _ctor(_key,greeted());
+                    }
+                );
+                if constexpr (isMultiCache)
+                    inserted = true;
+                if (inserted)
+                    m_size.fetch_add(1ull,std::memory_order_relaxed);
+                return inserted;
+            }
+
+            //! @returns true if object was removed (i.e. was present in cache)
+            template<bool DisposeOnRemove = true>
+            inline bool removeObject(const T& _obj, const K& _key)
+            {
+                bool removed = false;
+                m_container.erase_if(_key,[&](ContainerValueType& _entry) -> bool
+                {
+                    if constexpr (isMultiCache)
+                    {
+                        auto& objects = _entry.second;
+                        auto found = std::find(objects.begin(),objects.end(),_obj);
+                        if (found==objects.end())
+                            return false;
+                        if constexpr (DisposeOnRemove)
+                            dispose(*found);
+                        objects.erase(found);
+                        removed = true;
+                        return objects.empty();
+                    }
+                    else
+                    {
+                        if (!(_entry.second==_obj))
+                            return false;
+                        if constexpr (DisposeOnRemove)
+                            dispose(_entry.second);
+                        removed = true;
+                        return true;
+                    }
+                });
+                if (removed)
+                    m_size.fetch_sub(1ull,std::memory_order_relaxed);
+                return removed;
+            }
+
+            //! Not atomic, for a moment the object is under neither key
+            inline bool changeObjectKey(const T& _obj, const K& _key, const K& _newKey)
+            {
+                constexpr bool DoGreetOrDispose = false;
+                if (removeObject<DoGreetOrDispose>(_obj,_key))
+                {
+                    insert<DoGreetOrDispose>(_newKey,_obj);
+                    return true;
+                }
+                return false;
+            }
+
+            inline bool findAndStoreRange(const K& _key, size_t& _inOutStorageSize, MutablePairType* _out) const
+            {
+                return findAndStoreRange_impl(_key,_inOutStorageSize,_out);
+            }
+            inline bool findAndStoreRange(const K& _key, size_t& _inOutStorageSize, T* _out) const
+            {
+                return findAndStoreRange_impl(_key,_inOutStorageSize,_out);
+            }
+
+            //! Only a snapshot when other threads keep inserting, with `_out==nullptr` just reports the size needed
+            inline bool outputAll(size_t& _inOutStorageSize, MutablePairType* _out) const
+            {
+                if (!_out)
+                {
+                    _inOutStorageSize = getSize();
+                    return false;
+                }
+                size_t i = 0u;
+                m_container.for_each([&](const ContainerValueType& _entry) -> void
+                {
+                    forEachObject(_entry,[&](const T& _object) -> void
+                    {
+                        if (i<_inOutStorageSize)
+                            _out[i++] = MutablePairType(_entry.first,_object);
+                    });
+                });
+                const bool res = _inOutStorageSize<=getSize();
+                _inOutStorageSize = i;
+                return res;
+            }
+
+            inline bool contains(const T& _object) const
+            {
+                bool found = false;
+                m_container.for_each([&](const ContainerValueType& _entry) -> void
+                {
+                    forEachObject(_entry,[&](const T& _other) -> void {found = found || _other==_object;});
+                });
+                return found;
+            }
+
+            inline void clear()
+            {
+                for (size_t i=0u; i<m_container.subcnt(); i++)
+                {
+                    m_container.with_submap_m(i,[&](auto& _submap) -> void
+                    {
+                        size_t count = 0u;
+                        for (auto& entry : _submap)
+                        {
+                            if constexpr (isMultiCache)
+                            {
+                                for (auto& object : entry.second)
+                                    dispose(object);
+                                count += entry.second.size();
+                            }
+                            else
+                            {
+                                dispose(entry.second);
+                                count++;
+                            }
+                        }
+                        _submap.clear();
+                        m_size.fetch_sub(count,std::memory_order_relaxed);
+                    });
+                }
+            }
+
+            inline size_t getSize() const { return m_size.load(std::memory_order_relaxed); }
+
+        private:
+            template<typename F>
+            static inline void forEachObject(const ContainerValueType& _entry, F&& f)
+            {
+                if constexpr (isMultiCache)
+                {
+                    for (const auto& object : _entry.second)
+                        f(object);
+                }
+                else
+                    f(_entry.second);
+            }
+
+            // same return value and `_inOutStorageSize` semantics as `CObjectCacheBase::outputRange`
+            template<typename StorageT>
+            inline bool findAndStoreRange_impl(const K& _key, size_t& _inOutStorageSize, StorageT* _out) const
+            {
+                size_t reqSize = 0u, i = 0u;
+                m_container.if_contains(_key,[&](const ContainerValueType& _entry) -> void
+                {
+                    forEachObject(_entry,[&](const T& _object) -> void
+                    {
+                        if (_out && i<_inOutStorageSize)
+                        {
+                            if constexpr (std::is_same_v<StorageT,MutablePairType>)
+                                _out[i] = MutablePairType(_entry.first,_object);
+                            else
+                                _out[i] = _object;
+                            i++;
+                        }
+                        reqSize++;
+                    });
+                });
+                if (!_out)
+                {
+                    _inOutStorageSize = reqSize;
+                    return false;
+                }
+                const bool res = _inOutStorageSize<=reqSize;
+                _inOutStorageSize = i;
+                return res;
+            }
+
+            inline void dispose(T& _object) const
+            {
+                if (m_disposalFunc)
+                    m_disposalFunc(_object);
+            }
+            inline void greet(T& _object) const
+            {
+                if (m_greetingFunc)
+                    m_greetingFunc(_object);
+            }
+
+            ContainerT m_container;
+            // the container only knows the number of keys
+            std::atomic_size_t m_size = 0u;
+            GreetFuncType m_greetingFunc;
+            DisposalFuncType m_disposalFunc;
+    };
+}
+
+template<typename K, typename T, typename Hash = phmap::Hash<K>, typename KeyEqual = std::equal_to<K>, size_t SubmapCountLog2 = 4u>
+using CConcurrentHashObjectCache = impl::CConcurrentHashObjectCacheBase<K,T,false,Hash,KeyEqual,SubmapCountLog2>;
+
+template<typename K, typename T, typename Hash = phmap::Hash<K>, typename KeyEqual = std::equal_to<K>, size_t SubmapCountLog2 = 4u>
+using CConcurrentHashMultiObjectCache = impl::CConcurrentHashObjectCacheBase<K,T,true,Hash,KeyEqual,SubmapCountLog2>;
+
+}}
+
+#endif
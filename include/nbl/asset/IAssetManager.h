@@ -11,6 +11,7 @@
 #include "nbl/core/declarations.h"
 #include "nbl/system/path.h"
 #include "CConcurrentObjectCache.h"
+#include "CConcurrentHashObjectCache.h"
 
 #include "nbl/system/ISystem.h"
 #include "nbl/system/IFile.h"
@@ -22,6 +23,7 @@
 
 
 #define USE_MAPS_FOR_PATH_BASED_CACHE //benchmark and choose, paths can be full system paths
+#define USE_HASHMAPS_FOR_CONCURRENT_CACHES //per-submap locks instead of one lock per cache which parallel loaders all contend on, takes precedence over the above
 
 namespace nbl::asset
 {
@@ -52,13 +54,19 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted
         friend std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* const _mgr);
 
     public:
-#ifdef USE_MAPS_FOR_PATH_BASED_CACHE
+#if defined(USE_HASHMAPS_FOR_CONCURRENT_CACHES)
+        using AssetCacheType = core::CConcurrentHashMultiObjectCache<std::string, SAssetBundle>;
+#elif defined(USE_MAPS_FOR_PATH_BASED_CACHE)
         using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, SAssetBundle, std::multimap>;
 #else
         using AssetCacheType = core::CConcurrentMultiObjectCache<std::string, IAssetBundle, std::vector>;
 #endif //USE_MAPS_FOR_PATH_BASED_CACHE
 
+#ifdef USE_HASHMAPS_FOR_CONCURRENT_CACHES
+        using CpuGpuCacheType = core::CConcurrentHashObjectCache<const IAsset*, core::smart_refctd_ptr<core::IReferenceCounted> >;
+#else
         using CpuGpuCacheType = core::CConcurrentObjectCache<const IAsset*, core::smart_refctd_ptr<core::IReferenceCounted> >;
+#endif //USE_HASHMAPS_FOR_CONCURRENT_CACHES
 
     private:
         struct WriterKey
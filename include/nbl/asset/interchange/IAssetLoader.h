@@ -82,6 +82,8 @@ public:
 		a way that it'll look correctly in right-handed camera system. If it isn't set, compatibility with 
 		left-handed coordinate camera is assumed.
 		E_LOADER_PARAMETER_FLAGS::ELPF_DONT_COMPILE_GLSL means that GLSL won't be compiled to SPIR-V if it is loaded or generated.
+		E_LOADER_PARAMETER_FLAGS::ELPF_WELD_VERTICES makes loaders of formats which only store triangle soups (STL) merge the vertices
+		which are identical in every attribute and output an indexed mesh instead.
 	*/
 
 	enum E_LOADER_PARAMETER_FLAGS : uint64_t
@@ -89,7 +91,8 @@ public:
 		ELPF_NONE = 0,											//!< default value, it doesn't do anything
 		ELPF_RIGHT_HANDED_MESHES = 0x1,							//!< specifies that a mesh will be flipped in such a way that it'll look correctly in right-handed camera system
 		ELPF_DONT_COMPILE_GLSL = 0x2,							//!< it states that GLSL won't be compiled to SPIR-V if it is loaded or generated
-		ELPF_LOAD_METADATA_ONLY = 0x4							//!< it forces the loader to not load the entire scene for performance in special cases to fetch metadata.
+		ELPF_LOAD_METADATA_ONLY = 0x4,							//!< it forces the loader to not load the entire scene for performance in special cases to fetch metadata.
+		ELPF_WELD_VERTICES = 0x8								//!< triangle soups get their identical vertices merged and an index buffer
 	};
 
     struct SAssetLoadParams
@@ -279,14 +279,14 @@ protected:
 
             MortonTriangle(uint16_t fixedPointPos[3], float area)
             {
-                auto tmp = reinterpret_cast<uint16_t*>(key);
+                auto tmp = reinterpret_cast<uint16_t*>(&key);
                 std::copy_n(fixedPointPos,3u,tmp);
                 tmp[3] = core::Float16Compressor::compress(area);
             }
 
             void complete(float maxArea)
             {
-                auto tmp = reinterpret_cast<const uint16_t*>(key);
+                auto tmp = reinterpret_cast<const uint16_t*>(&key);
                 const float area = core::Float16Compressor::decompress(tmp[3]);
                 const float scale = 0.5f; // square root
                 uint16_t logRelArea = uint16_t(65535.5f+core::clamp(scale*std::log2f(area/maxArea),-65535.5f,0.f));
@@ -296,23 +296,11 @@ protected:
             uint64_t key;
         };
 
-        //TODO: use SoA instead (with core::radix_sort):
-        //core::vector<Triangle> triangles;
-        //core::vector<MortonTriangle> triangleMortonCodes;
-        //where `triangles` is member of `TriangleBatch` struct
-        struct TriangleMortonCodePair
-        {
-            Triangle triangle;
-            MortonTriangle mortonCode;
-
-            inline bool operator<(const TriangleMortonCodePair& other)
-            {
-                return this->mortonCode.key < other.mortonCode.key;
-            }
-        };
-
         TriangleBatches triangleBatches(triCnt);
-        core::vector<TriangleMortonCodePair> triangles(triCnt); //#1
+        // SoA, the morton codes get sorted together with indices into `triangles` which then get permuted just once
+        core::vector<Triangle> triangles(triCnt);
+        core::vector<uint64_t> mortonCodes(triCnt*2u);
+        core::vector<uint32_t> sortIndices(triCnt*2u);
 
         core::smart_refctd_ptr<ICPUMeshBuffer> mbTmp = core::smart_refctd_ptr_static_cast<ICPUMeshBuffer>(meshBuffer->clone());
         mbTmp->setIndexBufferBinding(std::move(idxBufferParams.idxBuffer));
@@ -323,18 +311,18 @@ protected:
         {
             const core::aabbox3df aabb = IMeshManipulator::calculateBoundingBox(mbTmp.get());
 
-            uint32_t ix = 0u;
             float maxTriangleArea = 0.0f;
-            for (auto it = triangles.begin(); it != triangles.end(); it++)
+            for (uint32_t ix = 0u; ix < triCnt; ix++)
             {
-                auto triangleIndices = IMeshManipulator::getTriangleIndices(mbTmp.get(), ix++);
+                auto& triangle = triangles[ix];
+                auto triangleIndices = IMeshManipulator::getTriangleIndices(mbTmp.get(), ix);
                 //have to copy there
-                std::copy(triangleIndices.begin(), triangleIndices.end(), it->triangle.oldIndices);
+                std::copy(triangleIndices.begin(), triangleIndices.end(), triangle.oldIndices);
 
                 core::vectorSIMDf trianglePos[3];
-                trianglePos[0] = mbTmp->getPosition(it->triangle.oldIndices[0]);
-                trianglePos[1] = mbTmp->getPosition(it->triangle.oldIndices[1]);
-                trianglePos[2] = mbTmp->getPosition(it->triangle.oldIndices[2]);
+                trianglePos[0] = mbTmp->getPosition(triangle.oldIndices[0]);
+                trianglePos[1] = mbTmp->getPosition(triangle.oldIndices[1]);
+                trianglePos[2] = mbTmp->getPosition(triangle.oldIndices[2]);
 
                 const core::vectorSIMDf centroid = ((trianglePos[0] + trianglePos[1] + trianglePos[2]) / 3.0f) - core::vectorSIMDf(aabb.MinEdge.X, aabb.MinEdge.Y, aabb.MinEdge.Z);
                 uint16_t fixedPointPos[3];
@@ -343,25 +331,27 @@ protected:
                 fixedPointPos[2] = uint16_t(centroid.z * 65535.5f / aabb.getExtent().Z);
 
                 float area = core::cross(trianglePos[1] - trianglePos[0], trianglePos[2] - trianglePos[0]).x;
-                it->mortonCode = MortonTriangle(fixedPointPos, area);
+                mortonCodes[ix] = MortonTriangle(fixedPointPos, area).key;
 
                 if (area > maxTriangleArea)
                     maxTriangleArea = area;
             }
 
             //complete morton code
-            for (auto it = triangles.begin(); it != triangles.end(); it++)
-                it->mortonCode.complete(maxTriangleArea);
+            for (uint32_t ix = 0u; ix < triCnt; ix++)
+            {
+                MortonTriangle mortonCode;
+                mortonCode.key = mortonCodes[ix];
+                mortonCode.complete(maxTriangleArea);
+                mortonCodes[ix] = mortonCode.key;
+                sortIndices[ix] = ix;
+            }
 
-            std::sort(triangles.begin(), triangles.end());
+            const uint32_t* sortedIndices = core::radix_sort_by_key(core::execution::par_unseq, mortonCodes.data(), mortonCodes.data()+triCnt, sortIndices.data(), sortIndices.data()+triCnt, triCnt).second;
+            for (uint32_t i = 0u; i < triCnt; i++)
+                triangleBatches.triangles[i] = triangles[sortedIndices[i]];
         }
 
-        //copying, after radix_sort this will be removed
-        //TODO durning radix_sort integration:
-        //since there will be distinct arrays for triangles and their morton code use `triangleBatches.triangles` instead of #1
-        for (uint32_t i = 0u; i < triCnt; i++)
-            triangleBatches.triangles[i] = triangles[i].triangle;
-
         //set ranges
         Triangle* triangleArrayBegin = triangleBatches.triangles.data();
         Triangle* triangleArrayEnd = triangleArrayBegin + triangleBatches.triangles.size();
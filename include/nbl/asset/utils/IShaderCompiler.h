@@ -334,31 +334,38 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 					// to get the "real" stage before lookup in the cache, defeating its purpose
 					inline SEntry(const std::string_view _mainFileContents, const SCompilerOptions& compilerOptions) : mainFileContents(std::move(std::string(_mainFileContents))), compilerArgs(compilerOptions)
 					{
-						// Form the hashable for the compiler data
-						size_t preprocessorArgsHashableSize = compilerArgs.preprocessorArgs.sourceIdentifier.size() + compilerArgs.preprocessorArgs.extraDefines.size() * sizeof(SMacroDefinition);
-						size_t compilerArgsHashableSize = sizeof(compilerArgs.stage) + sizeof(compilerArgs.targetSpirvVersion) + sizeof(compilerArgs.debugInfoFlags.value) + compilerArgs.optimizerPasses.size();
-						std::vector<uint8_t> hashable;
-						hashable.reserve(preprocessorArgsHashableSize + compilerArgsHashableSize + mainFileContents.size());
+						// Hash the compiler data and the source in place, the total length is needed up front
+						size_t hashableSize = compilerArgs.preprocessorArgs.sourceIdentifier.size();
+						for (const auto& defines : compilerArgs.preprocessorArgs.extraDefines)
+							hashableSize += defines.identifier.size() + defines.definition.size();
+						hashableSize += sizeof(compilerArgs.stage) + sizeof(compilerArgs.targetSpirvVersion) + sizeof(compilerArgs.debugInfoFlags.value) + compilerArgs.optimizerPasses.size();
+						hashableSize += mainFileContents.size();
+						core::XXHash256Hasher hasher(hashableSize);
+						auto hashBytes = [&hasher](const auto* begin, const size_t size) -> void
+						{
+							hasher.update(reinterpret_cast<const uint8_t*>(begin), size);
+						};
 					
 						// Insert preproc stuff
-						hashable.insert(hashable.end(), compilerArgs.preprocessorArgs.sourceIdentifier.begin(), compilerArgs.preprocessorArgs.sourceIdentifier.end());
+						hashBytes(compilerArgs.preprocessorArgs.sourceIdentifier.data(), compilerArgs.preprocessorArgs.sourceIdentifier.size());
 						for (const auto& defines : compilerArgs.preprocessorArgs.extraDefines)
 						{
-							hashable.insert(hashable.end(), defines.identifier.begin(), defines.identifier.end());
-							hashable.insert(hashable.end(), defines.definition.begin(), defines.definition.end());
+							hashBytes(defines.identifier.data(), defines.identifier.size());
+							hashBytes(defines.definition.data(), defines.definition.size());
 						}
 
 						// Insert rest of stuff from this struct. We're going to treat stage, targetSpirvVersion and debugInfoFlags.value as byte arrays for simplicity
-						hashable.insert(hashable.end(), reinterpret_cast<uint8_t*>(&compilerArgs.stage), reinterpret_cast<uint8_t*>(&compilerArgs.stage) + sizeof(compilerArgs.stage));
-						hashable.insert(hashable.end(), reinterpret_cast<uint8_t*>(&compilerArgs.targetSpirvVersion), reinterpret_cast<uint8_t*>(&compilerArgs.targetSpirvVersion) + sizeof(compilerArgs.targetSpirvVersion));
-						hashable.insert(hashable.end(), reinterpret_cast<uint8_t*>(&compilerArgs.debugInfoFlags.value), reinterpret_cast<uint8_t*>(&compilerArgs.debugInfoFlags.value) + sizeof(compilerArgs.debugInfoFlags.value));
+						hashBytes(&compilerArgs.stage, sizeof(compilerArgs.stage));
+						hashBytes(&compilerArgs.targetSpirvVersion, sizeof(compilerArgs.targetSpirvVersion));
+						hashBytes(&compilerArgs.debugInfoFlags.value, sizeof(compilerArgs.debugInfoFlags.value));
 						for (auto pass : compilerArgs.optimizerPasses) {
-							hashable.push_back(static_cast<uint8_t>(pass));
+							const auto passByte = static_cast<uint8_t>(pass);
+							hashBytes(&passByte, 1);
 						}
 
 						// Now add the mainFileContents and produce both lookup and early equality rejection hashes
-						hashable.insert(hashable.end(), mainFileContents.begin(), mainFileContents.end());
-						hash = nbl::core::XXHash_256(hashable.data(), hashable.size());
+						hashBytes(mainFileContents.data(), mainFileContents.size());
+						hash = hasher.finalize();
 						lookupHash = hash[0];
 						for (auto i = 1u; i < 4; i++) {
 							core::hash_combine<uint64_t>(lookupHash, hash[i]);
@@ -6,11 +6,16 @@
 #define __NBL_CORE_RADIX_SORT_H_INCLUDED__
 
 #include <algorithm>
+#include <bit>
 #include <bitset>
 #include <cstdint>
+#include <iterator>
 #include <numeric>
+#include <thread>
+#include <vector>
 
 #include "nbl/macros.h"
+#include "nbl/core/execution.h"
 
 namespace nbl
 {
@@ -91,12 +96,134 @@ struct RadixSorter
 		alignas(sizeof(histogram_t)) histogram_t histogram[histogram_size];
 };
 
+//! Splits the range into one contiguous chunk per thread, every pass each chunk counts into its own histogram,
+// then a single exclusive scan over the digit-major histograms hands every (digit,chunk) pair its output offset
+// and the chunks scatter independently without breaking stability.
+template<size_t key_bit_count>
+struct ParallelRadixSorter
+{
+		// small enough for a chunk's histogram and write cursors to stay in L1
+		_NBL_STATIC_INLINE_CONSTEXPR uint8_t radix_bits = 8u;
+		_NBL_STATIC_INLINE_CONSTEXPR size_t histogram_size = 0x1ull<<radix_bits;
+		_NBL_STATIC_INLINE_CONSTEXPR size_t last_pass = (key_bit_count-1ull)/size_t(radix_bits);
+		_NBL_STATIC_INLINE_CONSTEXPR uint16_t radix_mask = (1u<<radix_bits)-1u;
+		// below this many elements per thread, spawning work costs more than it saves
+		_NBL_STATIC_INLINE_CONSTEXPR size_t min_chunk_size = 0x1ull<<16ull;
+
+		static inline size_t getChunkCount(const size_t rangeSize, const bool parallel)
+		{
+			if (!parallel)
+				return 1ull;
+			const size_t maxChunks = std::max<size_t>(std::thread::hardware_concurrency(),1ull);
+			return std::clamp<size_t>(rangeSize/min_chunk_size,1ull,maxChunks);
+		}
+
+		ParallelRadixSorter(const size_t _rangeSize, const size_t _chunkCount) :
+			rangeSize(_rangeSize), chunkCount(_chunkCount), chunkSize((_rangeSize+_chunkCount-1ull)/_chunkCount),
+			chunks(_chunkCount), histograms(histogram_size*_chunkCount), offsets(histogram_size*_chunkCount)
+		{
+			std::iota(chunks.begin(),chunks.end(),0u);
+		}
+
+		//! `ValueIt` of `std::nullptr_t` sorts just the keys
+		template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor>
+		inline std::pair<KeyIt,ValueIt> operator()(ExecutionPolicy&& policy, KeyIt keys, KeyIt keysScratch, ValueIt values, ValueIt valuesScratch, const KeyAccessor& comp)
+		{
+			return pass<ExecutionPolicy,KeyIt,ValueIt,KeyAccessor,0ull>(policy,keys,keysScratch,values,valuesScratch,comp);
+		}
+
+	private:
+		template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor, size_t pass_ix>
+		inline std::pair<KeyIt,ValueIt> pass(ExecutionPolicy& policy, KeyIt keys, KeyIt keysOut, ValueIt values, ValueIt valuesOut, const KeyAccessor& comp)
+		{
+			constexpr auto shift = static_cast<size_t>(radix_bits*pass_ix);
+			// count, histograms are laid out digit-major so that the scan below produces the scatter offsets directly
+			core::for_each(policy,chunks.begin(),chunks.end(),[&](const uint32_t chunk)->void
+			{
+				size_t local[histogram_size] = {};
+				const size_t end = std::min<size_t>(rangeSize,(chunk+1ull)*chunkSize);
+				for (size_t i=chunk*chunkSize; i<end; i++)
+					++local[comp.template operator()<shift,radix_mask>(keys[i])];
+				for (size_t digit=0u; digit<histogram_size; digit++)
+					histograms[digit*chunkCount+chunk] = local[digit];
+			});
+
+			// all keys share the digit, the pass would be a plain copy
+			const size_t firstDigit = comp.template operator()<shift,radix_mask>(keys[0]);
+			const auto firstDigitHistogram = histograms.begin()+firstDigit*chunkCount;
+			if (std::accumulate(firstDigitHistogram,firstDigitHistogram+chunkCount,size_t(0u))!=rangeSize)
+			{
+				// not in-place, some parallel STL backends get that wrong
+				core::exclusive_scan(policy,histograms.begin(),histograms.end(),offsets.begin(),size_t(0u));
+				// scatter
+				core::for_each(policy,chunks.begin(),chunks.end(),[&](const uint32_t chunk)->void
+				{
+					size_t cursors[histogram_size];
+					for (size_t digit=0u; digit<histogram_size; digit++)
+						cursors[digit] = offsets[digit*chunkCount+chunk];
+					const size_t end = std::min<size_t>(rangeSize,(chunk+1ull)*chunkSize);
+					for (size_t i=chunk*chunkSize; i<end; i++)
+					{
+						const size_t dst = cursors[comp.template operator()<shift,radix_mask>(keys[i])]++;
+						keysOut[dst] = keys[i];
+						if constexpr (!std::is_same_v<ValueIt,std::nullptr_t>)
+							valuesOut[dst] = values[i];
+					}
+				});
+				std::swap(keys,keysOut);
+				std::swap(values,valuesOut);
+			}
+
+			if constexpr (pass_ix != last_pass)
+				return pass<ExecutionPolicy,KeyIt,ValueIt,KeyAccessor,pass_ix+1ull>(policy,keys,keysOut,values,valuesOut,comp);
+			else
+				return {keys,values};
+		}
+
+		const size_t rangeSize;
+		const size_t chunkCount;
+		const size_t chunkSize;
+		std::vector<uint32_t> chunks;
+		std::vector<size_t> histograms;
+		std::vector<size_t> offsets;
+};
+
+template<class ExecutionPolicy>
+constexpr inline bool is_sequenced_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>,std::remove_cvref_t<decltype(core::execution::seq)>>;
+
 }
 
+//! Maps IEEE754 floats onto unsigned integers of the same width which sort in the same order (-0 before +0, NaNs at the ends)
+template<typename T, bool Descending=false>
+struct FloatKeyAdaptor
+{
+	static_assert(std::is_same_v<T,float>||std::is_same_v<T,double>,"Only 32 and 64 bit IEEE754 floats are supported.");
+	using bits_t = std::conditional_t<sizeof(T)==4u,uint32_t,uint64_t>;
+	_NBL_STATIC_INLINE_CONSTEXPR size_t key_bit_count = sizeof(T)*8u;
+
+	static inline bits_t toOrderedBits(const T item)
+	{
+		const bits_t bits = std::bit_cast<bits_t>(item);
+		// negative numbers need their order reversed, positive ones just need to end up above them
+		constexpr bits_t signBit = bits_t(1u)<<(key_bit_count-1u);
+		const bits_t ordered = bits^((bits&signBit) ? ~bits_t(0u):signBit);
+		if constexpr (Descending)
+			return ~ordered;
+		else
+			return ordered;
+	}
+
+	template<auto bit_offset, auto radix_mask>
+	inline decltype(radix_mask) operator()(const T& item) const
+	{
+		return static_cast<decltype(radix_mask)>(toOrderedBits(item)>>static_cast<bits_t>(bit_offset))&radix_mask;
+	}
+};
+
 template<class RandomIt, class KeyAccessor>
 inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeSize, const KeyAccessor& comp)
 {
-	assert(std::abs(std::distance(input,scratch))>=rangeSize);
+	assert(static_cast<size_t>(std::abs(std::distance(input,scratch)))>=rangeSize);
 
 	if (rangeSize<static_cast<decltype(rangeSize)>(0x1ull<<16ull))
 		return impl::RadixSorter<KeyAccessor::key_bit_count,uint16_t>()(input,scratch,static_cast<uint16_t>(rangeSize),comp);
@@ -110,7 +237,46 @@ inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeS
 template<class RandomIt>
 inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeSize)
 {
-	return radix_sort<RandomIt>(input,scratch,rangeSize,impl::KeyAdaptor<decltype(*input)>());
+	return radix_sort<RandomIt>(input,scratch,rangeSize,impl::KeyAdaptor<typename std::iterator_traits<RandomIt>::value_type>());
+}
+
+//! Multi-threaded variant, the sort stays stable and the sorted range can still end up in either `input` or `scratch`
+template<class ExecutionPolicy, class RandomIt, class KeyAccessor, std::enable_if_t<is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>,bool> = true>
+inline RandomIt radix_sort(ExecutionPolicy&& policy, RandomIt input, RandomIt scratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	using sorter_t = impl::ParallelRadixSorter<KeyAccessor::key_bit_count>;
+	const size_t chunkCount = sorter_t::getChunkCount(rangeSize,!impl::is_sequenced_policy_v<ExecutionPolicy>);
+	if (chunkCount<2ull)
+		return radix_sort(input,scratch,rangeSize,comp);
+
+	assert(static_cast<size_t>(std::abs(std::distance(input,scratch)))>=rangeSize);
+	return sorter_t(rangeSize,chunkCount)(policy,input,scratch,nullptr,nullptr,comp).first;
+}
+
+template<class ExecutionPolicy, class RandomIt, std::enable_if_t<is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>,bool> = true>
+inline RandomIt radix_sort(ExecutionPolicy&& policy, RandomIt input, RandomIt scratch, const size_t rangeSize)
+{
+	return radix_sort(std::forward<ExecutionPolicy>(policy),input,scratch,rangeSize,impl::KeyAdaptor<typename std::iterator_traits<RandomIt>::value_type>());
+}
+
+//! Sorts the keys and applies the same permutation to `values`, which is meant to be a 32bit index or similar.
+// Large payloads should not be sorted directly, sort their keys with indices into them and permute the payload once afterwards.
+// Both returned iterators point into the same half (original or scratch) of their respective SoA arrays.
+template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor>
+inline std::pair<KeyIt,ValueIt> radix_sort_by_key(ExecutionPolicy&& policy, KeyIt keys, KeyIt keysScratch, ValueIt values, ValueIt valuesScratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	if (rangeSize==0ull)
+		return {keys,values};
+
+	using sorter_t = impl::ParallelRadixSorter<KeyAccessor::key_bit_count>;
+	const size_t chunkCount = sorter_t::getChunkCount(rangeSize,!impl::is_sequenced_policy_v<ExecutionPolicy>);
+	return sorter_t(rangeSize,chunkCount)(policy,keys,keysScratch,values,valuesScratch,comp);
+}
+
+template<class ExecutionPolicy, class KeyIt, class ValueIt>
+inline std::pair<KeyIt,ValueIt> radix_sort_by_key(ExecutionPolicy&& policy, KeyIt keys, KeyIt keysScratch, ValueIt values, ValueIt valuesScratch, const size_t rangeSize)
+{
+	return radix_sort_by_key(std::forward<ExecutionPolicy>(policy),keys,keysScratch,values,valuesScratch,rangeSize,impl::KeyAdaptor<typename std::iterator_traits<KeyIt>::value_type>());
 }
 
 }
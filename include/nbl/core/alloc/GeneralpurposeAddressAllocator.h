@@ -11,6 +11,7 @@
 #include "nbl/core/math/glslFunctions.h"
 
 #include "nbl/core/alloc/AddressAllocatorBase.h"
+#include "nbl/core/algorithm/radix_sort.h"
 
 namespace nbl
 {
@@ -40,6 +41,18 @@ class GeneralpurposeAddressAllocatorBase
                 assert(getLength()>>level); // in the right free list
                 #endif // _NBL_DEBUG
             }
+
+            //! for `core::radix_sort` on the block-start value
+            struct StartKeyAccessor
+            {
+                _NBL_STATIC_INLINE_CONSTEXPR size_t key_bit_count = sizeof(size_type)*8ull;
+
+                template<auto bit_offset, auto radix_mask>
+                inline decltype(radix_mask) operator()(const Block& item) const
+                {
+                    return static_cast<decltype(radix_mask)>(item.startOffset>>static_cast<size_type>(bit_offset))&radix_mask;
+                }
+            };
         };
         static inline uint32_t  findFreeListCount(size_type byteSize, size_type minBlockSz) noexcept
         {
@@ -246,24 +259,6 @@ protected:
         }
 
 
-        //! Return index of freelist or one past the end for nothing
-        inline decltype(freeListCount)  findMinimum(const Block* const* listOfLists, const Block* const* listOfListsEnd) noexcept
-        {
-            size_type               minval = ~size_type(0u);
-            decltype(freeListCount) retval = freeListCount;
-
-            for (decltype(freeListCount) i=0; i<freeListCount; i++)
-            {
-                if (listOfLists[i]==listOfListsEnd[i] || listOfLists[i]->startOffset>=minval)
-                    continue;
-
-                minval = listOfLists[i]->startOffset;
-                retval = i;
-            }
-
-            return retval;
-        }
-
     private:
         //! Lists contain blocks of size < (minBlock<<listIndex)*2 && size >= (minBlock<<listIndex)
         static inline uint32_t  findFreeListInsertIndex(size_type byteSize, size_type minBlockSz) noexcept
@@ -638,53 +633,69 @@ class GeneralpurposeAddressAllocator : public AddressAllocatorBase<Generalpurpos
     protected:
         inline size_type        defragment() noexcept
         {
-            // TODO: radix sort the whole thing on the block-start value and do a coalesce without `AllocStrategy::findMinimum`
-            // also add the blocks in reverse order
-            Block* freeListOld[AllocStrategy::maxListLevels];
-            const Block* freeListOldEnd[AllocStrategy::maxListLevels];
+            // below this many free blocks clearing the radix sort histograms costs more than a comparison sort
+            constexpr size_type radixSortThreshold = 512u;
+
+            // the old lists stay intact in their half of the reserved space until we overwrite them
+            const Block* freeListOld[AllocStrategy::maxListLevels];
+            size_type freeListOldCount[AllocStrategy::maxListLevels];
             for (decltype(AllocStrategy::freeListCount) i=0u; i<AllocStrategy::freeListCount; i++)
             {
                 freeListOld[i] = AllocStrategy::freeListStack[i];
-                freeListOldEnd[i] = freeListOld[i]+AllocStrategy::freeListStackCtr[i];
-                std::sort(freeListOld[i],const_cast<Block*>(freeListOldEnd[i]));
+                freeListOldCount[i] = AllocStrategy::freeListStackCtr[i];
             }
+            Block* const oldHalf = AllocStrategy::freeListStack[0];
 
             AllocStrategy::swapFreeLists(Base::reservedSpace);
 
-            // begin the coalesce
-            Block lastBlock{0u,0u};
-            auto minimum = AllocStrategy::findMinimum(freeListOld,freeListOldEnd);
-            while (minimum!=AllocStrategy::freeListCount)
+            // gather all free blocks into the new half, either half can hold every free block there could possibly be
+            Block* const newHalf = AllocStrategy::freeListStack[0];
+            size_type blockCount = 0u;
+            for (decltype(AllocStrategy::freeListCount) i=0u; i<AllocStrategy::freeListCount; i++)
             {
-                // find next free block and pop it
-                const Block* nextBlock = freeListOld[minimum]++;
+                std::copy_n(freeListOld[i],freeListOldCount[i],newHalf+blockCount);
+                blockCount += freeListOldCount[i];
+            }
 
+            // sort the whole thing on the block-start value, the old half is free to be used as scratch now
+            Block* sorted = newHalf;
+            if (blockCount<radixSortThreshold)
+                std::sort(newHalf,newHalf+blockCount);
+            else
+                sorted = core::radix_sort(newHalf,oldHalf,blockCount,typename Block::StartKeyAccessor());
+            // the new free lists will get built in the new half, so the sorted blocks must not be there
+            if (sorted!=oldHalf)
+            {
+                std::copy_n(sorted,blockCount,oldHalf);
+                sorted = oldHalf;
+            }
+
+            // coalesce in one linear sweep, back to front so the lowest addresses end up on the top of the free list stacks
+            size_type retval = AllocStrategy::bufferSize;
+            auto insertCoalesced = [&](const Block& block) -> void
+            {
+                AllocStrategy::insertFreeBlock(block);
+                if (block.endOffset==AllocStrategy::bufferSize)
+                    retval = block.startOffset;
+            };
+            Block coalesced{invalid_address,invalid_address};
+            for (auto it=sorted+blockCount; it!=sorted; )
+            {
+                const Block& prevBlock = *(--it);
                 // check if broke continuity
-                if (nextBlock->startOffset!=lastBlock.endOffset)
+                if (prevBlock.endOffset!=coalesced.startOffset)
                 {
-                    // put old on correct free list
-                    if (lastBlock.getLength())
-                        AllocStrategy::insertFreeBlock(lastBlock);
-
-                    lastBlock.startOffset = nextBlock->startOffset;
+                    if (coalesced.startOffset!=invalid_address)
+                        insertCoalesced(coalesced);
+                    coalesced = prevBlock;
                 }
-
-                lastBlock.endOffset = nextBlock->endOffset;
-                minimum = AllocStrategy::findMinimum(freeListOld,freeListOldEnd);
-            }
-            #ifdef _NBL_DEBUG
-            for (decltype(AllocStrategy::freeListCount) i=0u; i<AllocStrategy::freeListCount; i++)
-                assert(freeListOld[i]==freeListOldEnd[i]);
-            #endif // _NBL_DEBUG
-            // put last block on correct free list
-            if (lastBlock.getLength())
-            {
-                AllocStrategy::insertFreeBlock(lastBlock);
-                if (lastBlock.endOffset==AllocStrategy::bufferSize)
-                    return lastBlock.startOffset;
+                else
+                    coalesced.startOffset = prevBlock.startOffset;
             }
+            if (coalesced.startOffset!=invalid_address)
+                insertCoalesced(coalesced);
 
-            return AllocStrategy::bufferSize;
+            return retval;
         }
 };
 
@@ -0,0 +1,470 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_CORE_LOCK_FREE_POOL_ADDRESS_ALLOCATOR_H_INCLUDED__
+#define __NBL_CORE_LOCK_FREE_POOL_ADDRESS_ALLOCATOR_H_INCLUDED__
+
+#include "BuildConfigOptions.h"
+
+#include "nbl/core/alloc/AddressAllocatorBase.h"
+
+#include <atomic>
+#include <vector>
+
+namespace nbl
+{
+namespace core
+{
+
+namespace impl
+{
+//! Threads get handed magazine slots round-robin the first time they touch any `LockFreePoolAddressAllocator`
+inline uint32_t getLockFreePoolThreadSlot() noexcept
+{
+    static std::atomic_uint32_t nextSlot = 0u;
+    thread_local const uint32_t slot = nextSlot.fetch_add(1u,std::memory_order_relaxed);
+    return slot;
+}
+}
+
+//! Thread-safe drop-in replacement for `PoolAddressAllocatorMT` which never takes a lock.
+/** The free blocks form a Treiber stack, every block's successor lives in the reserved space and the stack head
+is a 32bit block index packed together with a 32bit tag which gets bumped on every successful push or pop (ABA protection).
+With `MagazineCapacity!=0` every thread also gets a magazine of cached block indices (threads beyond `MagazineSlotCount` share them,
+a thread which finds its magazine busy just goes straight to the shared stack), which gets refilled and returned in bulk,
+half a magazine per CAS on the stack head, so the shared cache line only gets touched once every few allocations.
+Addresses sitting in magazines still count as free, but cannot be allocated by other threads until returned.
+
+Nothing except `alloc_addr`, `free_addr`, `multi_alloc_addr`, `multi_free_addr` and the size queries may be called concurrently,
+the queries only give a snapshot which may be out of date by the time they return.
+Can only allocate up to a size of a single block and at most 2^32-1 blocks. */
+template<typename _size_type, uint32_t MagazineCapacity=0u>
+class LockFreePoolAddressAllocator : public AddressAllocatorBase<LockFreePoolAddressAllocator<_size_type,MagazineCapacity>,_size_type>
+{
+        typedef AddressAllocatorBase<LockFreePoolAddressAllocator<_size_type,MagazineCapacity>,_size_type> Base;
+    public:
+        _NBL_DECLARE_ADDRESS_ALLOCATOR_TYPEDEFS(_size_type);
+
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t MagazineSlotCount = 32u;
+        static constexpr bool supportsNullBuffer = true;
+
+    private:
+        static_assert(MagazineCapacity!=1u,"A magazine needs to hold at least 2 blocks to be of any use.");
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t invalid_index = ~0u;
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t refillCount = (MagazineCapacity+1u)/2u;
+
+        struct alignas(64) SMagazine
+        {
+            std::atomic_flag busy;
+            // only written by the owner while `busy`, but read by the size queries
+            std::atomic_uint32_t count;
+            uint32_t blocks[MagazineCapacity ? MagazineCapacity:1u];
+        };
+        _NBL_STATIC_INLINE_CONSTEXPR size_t magazinesByteSize = MagazineCapacity ? (sizeof(SMagazine)*MagazineSlotCount+alignof(SMagazine)):0ull;
+
+        static inline uint64_t packHead(const uint64_t tag, const uint32_t index) {return (tag<<32ull)|index;}
+        static inline uint32_t getHeadIndex(const uint64_t head) {return static_cast<uint32_t>(head);}
+
+        inline SMagazine* getMagazines() noexcept
+        {
+            return reinterpret_cast<SMagazine*>(core::alignUp(reinterpret_cast<size_t>(Base::reservedSpace),alignof(SMagazine)));
+        }
+        inline const SMagazine* getMagazines() const noexcept
+        {
+            return const_cast<LockFreePoolAddressAllocator*>(this)->getMagazines();
+        }
+        inline std::atomic_uint32_t* getNext() noexcept
+        {
+            return reinterpret_cast<std::atomic_uint32_t*>(reinterpret_cast<uint8_t*>(Base::reservedSpace)+magazinesByteSize);
+        }
+
+        inline size_type indexToAddress(const uint32_t index) const noexcept {return index*blockSize+Base::combinedOffset;}
+        inline uint32_t addressToIndex(const size_type addr) const noexcept {return static_cast<uint32_t>((addr-Base::combinedOffset)/blockSize);}
+
+        // returns nullptr if some other thread is using our magazine right now
+        inline SMagazine* acquireMagazine() noexcept
+        {
+            auto* magazine = getMagazines()+(impl::getLockFreePoolThreadSlot()%MagazineSlotCount);
+            if (magazine->busy.test_and_set(std::memory_order_acquire))
+                return nullptr;
+            return magazine;
+        }
+        static inline void releaseMagazine(SMagazine* magazine) noexcept
+        {
+            magazine->busy.clear(std::memory_order_release);
+        }
+
+        //! pops up to `maxCount` blocks with a single CAS, returns how many
+        inline uint32_t popChain(uint32_t* outIndices, const uint32_t maxCount) noexcept
+        {
+            auto* next = getNext();
+            uint64_t head = stackHead.load(std::memory_order_acquire);
+            while (true)
+            {
+                uint32_t count = 0u;
+                uint32_t newTop = getHeadIndex(head);
+                // the successors might be getting rewritten under us, but then the tag changed and the CAS will fail
+                for (; count<maxCount && newTop!=invalid_index; count++)
+                {
+                    outIndices[count] = newTop;
+                    newTop = next[newTop].load(std::memory_order_relaxed);
+                }
+                if (count==0u)
+                    return 0u;
+                if (stackHead.compare_exchange_weak(head,packHead((head>>32ull)+1ull,newTop),std::memory_order_acquire,std::memory_order_acquire))
+                {
+                    stackSize.fetch_sub(count,std::memory_order_relaxed);
+                    return count;
+                }
+            }
+        }
+        //! pushes a chain of blocks with a single CAS
+        inline void pushChain(const uint32_t* indices, const uint32_t count) noexcept
+        {
+            if (count==0u)
+                return;
+
+            auto* next = getNext();
+            for (uint32_t i=1u; i<count; i++)
+                next[indices[i-1u]].store(indices[i],std::memory_order_relaxed);
+
+            // count them in before they become poppable, so that the size never underflows
+            stackSize.fetch_add(count,std::memory_order_relaxed);
+            const uint32_t bottom = indices[count-1u];
+            uint64_t head = stackHead.load(std::memory_order_relaxed);
+            do
+            {
+                next[bottom].store(getHeadIndex(head),std::memory_order_relaxed);
+            } while (!stackHead.compare_exchange_weak(head,packHead((head>>32ull)+1ull,indices[0]),std::memory_order_release,std::memory_order_relaxed));
+        }
+
+        //! gathers every free block, only valid while no other thread is using the allocator
+        template<class F>
+        inline void forEachFreeIndex(F& f) const noexcept
+        {
+            auto* next = const_cast<LockFreePoolAddressAllocator*>(this)->getNext();
+            for (uint32_t index=getHeadIndex(stackHead.load(std::memory_order_acquire)); index!=invalid_index; index=next[index].load(std::memory_order_relaxed))
+                f(index);
+            if constexpr (MagazineCapacity!=0u)
+            for (uint32_t i=0u; i<MagazineSlotCount; i++)
+            {
+                const auto& magazine = getMagazines()[i];
+                for (uint32_t j=0u; j<magazine.count.load(std::memory_order_relaxed); j++)
+                    f(magazine.blocks[j]);
+            }
+        }
+
+        void copyState(const LockFreePoolAddressAllocator& other, _size_type newBuffSz)
+        {
+            #ifdef _NBL_DEBUG
+                assert(Base::checkResize(newBuffSz,Base::alignOffset));
+            #endif // _NBL_DEBUG
+
+            initMagazines();
+            auto* next = getNext();
+            uint32_t top = invalid_index;
+            size_type count = 0u;
+            auto push = [&](const uint32_t index) -> void
+            {
+                next[index].store(top,std::memory_order_relaxed);
+                top = index;
+                count++;
+            };
+            // any new blocks go last, so they get allocated after the existing ones
+            for (size_type index=blockCount; index>other.blockCount; index--)
+                push(static_cast<uint32_t>(index-1u));
+            // check in case of shrink
+            auto pushOther = [&](const uint32_t otherIndex) -> void
+            {
+                const size_type freeEntry = other.indexToAddress(otherIndex)-other.combinedOffset;
+                if (freeEntry<blockCount*blockSize)
+                    push(static_cast<uint32_t>(freeEntry/blockSize));
+            };
+            other.forEachFreeIndex(pushOther);
+            stackHead.store(packHead(0ull,top),std::memory_order_relaxed);
+            stackSize.store(count,std::memory_order_relaxed);
+        }
+        inline void initMagazines() noexcept
+        {
+            if constexpr (MagazineCapacity!=0u)
+            for (uint32_t i=0u; i<MagazineSlotCount; i++)
+            {
+                auto* magazine = new (getMagazines()+i) SMagazine;
+                magazine->busy.clear(std::memory_order_relaxed);
+                magazine->count.store(0u,std::memory_order_relaxed);
+            }
+        }
+
+    public:
+        LockFreePoolAddressAllocator() : blockCount(0u), blockSize(1u), stackHead(packHead(0ull,invalid_index)), stackSize(0u) {}
+
+        virtual ~LockFreePoolAddressAllocator() {}
+
+        LockFreePoolAddressAllocator(void* reservedSpc, _size_type addressOffsetToApply, _size_type alignOffsetNeeded, _size_type maxAllocatableAlignment, size_type bufSz, size_type blockSz) noexcept :
+                    Base(reservedSpc,addressOffsetToApply,alignOffsetNeeded,maxAllocatableAlignment),
+                        blockCount((bufSz-alignOffsetNeeded)/blockSz), blockSize(blockSz), stackHead(packHead(0ull,invalid_index)), stackSize(0u)
+        {
+            assert(blockCount<invalid_index);
+            reset();
+        }
+
+        //! When resizing we require that the copying of data buffer has already been handled by the user of the address allocator, and that nobody uses `other`
+        template<typename... Args>
+        LockFreePoolAddressAllocator(_size_type newBuffSz, LockFreePoolAddressAllocator&& other, Args&&... args) noexcept :
+                    Base(std::move(other),std::forward<Args>(args)...),
+                        blockCount((newBuffSz-Base::alignOffset)/other.blockSize), blockSize(other.blockSize), stackHead(packHead(0ull,invalid_index)), stackSize(0u)
+        {
+            copyState(other,newBuffSz);
+
+            other.blockCount = invalid_address;
+            other.blockSize = invalid_address;
+            other.stackHead.store(packHead(0ull,invalid_index),std::memory_order_relaxed);
+            other.stackSize.store(0u,std::memory_order_relaxed);
+        }
+        template<typename... Args>
+        LockFreePoolAddressAllocator(_size_type newBuffSz, const LockFreePoolAddressAllocator& other, Args&&... args) noexcept :
+                    Base(other,std::forward<Args>(args)...),
+                        blockCount((newBuffSz-Base::alignOffset)/other.blockSize), blockSize(other.blockSize), stackHead(packHead(0ull,invalid_index)), stackSize(0u)
+        {
+            copyState(other,newBuffSz);
+        }
+
+        LockFreePoolAddressAllocator& operator=(LockFreePoolAddressAllocator&& other)
+        {
+            Base::operator=(std::move(other));
+            std::swap(blockCount,other.blockCount);
+            std::swap(blockSize,other.blockSize);
+            const auto otherHead = other.stackHead.exchange(stackHead.load(std::memory_order_relaxed),std::memory_order_relaxed);
+            stackHead.store(otherHead,std::memory_order_relaxed);
+            const auto otherSize = other.stackSize.exchange(stackSize.load(std::memory_order_relaxed),std::memory_order_relaxed);
+            stackSize.store(otherSize,std::memory_order_relaxed);
+            return *this;
+        }
+
+
+        inline size_type        alloc_addr( size_type bytes, size_type alignment, size_type hint=0ull) noexcept
+        {
+            if ((blockSize%alignment)!=0u || bytes==0u || bytes>blockSize)
+                return invalid_address;
+
+            uint32_t index;
+            if constexpr (MagazineCapacity!=0u)
+            {
+                if (auto* magazine=acquireMagazine(); magazine)
+                {
+                    uint32_t count = magazine->count.load(std::memory_order_relaxed);
+                    if (count==0u)
+                        count = popChain(magazine->blocks,refillCount);
+                    size_type retval = invalid_address;
+                    if (count)
+                    {
+                        retval = indexToAddress(magazine->blocks[--count]);
+                        magazine->count.store(count,std::memory_order_relaxed);
+                    }
+                    releaseMagazine(magazine);
+                    return retval;
+                }
+            }
+            if (popChain(&index,1u)==0u)
+                return invalid_address;
+            return indexToAddress(index);
+        }
+
+        inline void             free_addr(size_type addr, size_type bytes) noexcept
+        {
+            #ifdef _NBL_DEBUG
+                assert(addr>=Base::combinedOffset && (addr-Base::combinedOffset)%blockSize==0 && addressToIndex(addr)<blockCount);
+            #endif // _NBL_DEBUG
+            const uint32_t index = addressToIndex(addr);
+            if constexpr (MagazineCapacity!=0u)
+            {
+                if (auto* magazine=acquireMagazine(); magazine)
+                {
+                    uint32_t count = magazine->count.load(std::memory_order_relaxed);
+                    // return the older half, the top of the magazine is the most likely to still be in cache
+                    if (count==MagazineCapacity)
+                    {
+                        pushChain(magazine->blocks,refillCount);
+                        std::move(magazine->blocks+refillCount,magazine->blocks+count,magazine->blocks);
+                        count -= refillCount;
+                    }
+                    magazine->blocks[count++] = index;
+                    magazine->count.store(count,std::memory_order_relaxed);
+                    releaseMagazine(magazine);
+                    return;
+                }
+            }
+            pushChain(&index,1u);
+        }
+
+        //! Serves the whole batch with at most one CAS on the shared stack
+        /** Warning outAddresses needs to be primed with `invalid_address` values,
+        otherwise no allocation happens for elements not equal to `invalid_address`. */
+        inline void             multi_alloc_addr(uint32_t count, size_type* outAddresses, const size_type* bytes, const size_type* alignment, const size_type* hint=nullptr) noexcept
+        {
+            multi_alloc_addr_impl(count,outAddresses,bytes,[alignment](const uint32_t i){return alignment[i];});
+        }
+        inline void             multi_alloc_addr(uint32_t count, size_type* outAddresses, const size_type* bytes, const size_type alignment, const size_type* hint=nullptr) noexcept
+        {
+            multi_alloc_addr_impl(count,outAddresses,bytes,[alignment](const uint32_t i){return alignment;});
+        }
+
+        //! Returns the whole batch with at most one CAS on the shared stack
+        inline void             multi_free_addr(uint32_t count, const size_type* addr, const size_type* bytes) noexcept
+        {
+            constexpr uint32_t batchSize = 256u;
+            uint32_t indices[batchSize];
+            for (uint32_t i=0u; i<count; )
+            {
+                uint32_t batchCount = 0u;
+                for (; batchCount<batchSize && i<count; i++)
+                if (addr[i]!=invalid_address)
+                    indices[batchCount++] = addressToIndex(addr[i]);
+
+                uint32_t* toPush = indices;
+                if constexpr (MagazineCapacity!=0u)
+                {
+                    if (auto* magazine=acquireMagazine(); magazine)
+                    {
+                        uint32_t magazineCount = magazine->count.load(std::memory_order_relaxed);
+                        const uint32_t cached = std::min(MagazineCapacity-magazineCount,batchCount);
+                        std::copy_n(indices,cached,magazine->blocks+magazineCount);
+                        magazine->count.store(magazineCount+cached,std::memory_order_relaxed);
+                        releaseMagazine(magazine);
+                        toPush += cached;
+                        batchCount -= cached;
+                    }
+                }
+                pushChain(toPush,batchCount);
+            }
+        }
+
+        //! Not thread-safe
+        inline void             reset()
+        {
+            initMagazines();
+            auto* next = getNext();
+            for (size_type i=0u; i<blockCount; i++)
+                next[i].store(i+1u<blockCount ? static_cast<uint32_t>(i+1u):invalid_index,std::memory_order_relaxed);
+            stackHead.store(packHead(0ull,blockCount ? 0u:invalid_index),std::memory_order_relaxed);
+            stackSize.store(blockCount,std::memory_order_relaxed);
+        }
+
+        //! conservative estimate, does not account for space lost to alignment
+        inline size_type        max_size() const noexcept
+        {
+            return blockSize;
+        }
+
+        //! Most allocators do not support e.g. 1-byte allocations
+        inline size_type        min_size() const noexcept
+        {
+            return blockSize;
+        }
+
+        //! Not thread-safe, would need to know exactly which blocks are free
+        inline size_type        safe_shrink_size(size_type sizeBound, size_type newBuffAlignmentWeCanGuarantee=1u) const noexcept
+        {
+            const size_type capacity = get_total_size()-Base::alignOffset;
+            if (sizeBound<capacity)
+            {
+                // the highest allocated block bounds the shrink
+                size_type allocatedEnd = capacity;
+                if (get_free_size()!=0u)
+                {
+                    std::vector<bool> isFree(blockCount,false);
+                    auto markFree = [&isFree](const uint32_t index) -> void {isFree[index] = true;};
+                    forEachFreeIndex(markFree);
+                    while (allocatedEnd && isFree[allocatedEnd/blockSize-1u])
+                        allocatedEnd -= blockSize;
+                }
+                sizeBound = std::max(sizeBound,allocatedEnd);
+            }
+            return Base::safe_shrink_size(sizeBound,newBuffAlignmentWeCanGuarantee);
+        }
+
+
+        static inline size_type reserved_size(size_type maxAlignment, size_type bufSz, size_type blockSz) noexcept
+        {
+            size_type maxBlockCount = bufSz/blockSz;
+            return magazinesByteSize+maxBlockCount*sizeof(uint32_t);
+        }
+        static inline size_type reserved_size(const LockFreePoolAddressAllocator& other, size_type bufSz) noexcept
+        {
+            return reserved_size(other.maxRequestableAlignment,bufSz,other.blockSize);
+        }
+
+        inline size_type        get_free_size() const noexcept
+        {
+            size_type freeBlocks = stackSize.load(std::memory_order_relaxed);
+            if constexpr (MagazineCapacity!=0u)
+            for (uint32_t i=0u; i<MagazineSlotCount; i++)
+                freeBlocks += getMagazines()[i].count.load(std::memory_order_relaxed);
+            return freeBlocks*blockSize;
+        }
+        inline size_type        get_allocated_size() const noexcept
+        {
+            return blockCount*blockSize-get_free_size();
+        }
+        inline size_type        get_total_size() const noexcept
+        {
+            return blockCount*blockSize+Base::alignOffset;
+        }
+
+
+
+        inline size_type addressToBlockID(size_type addr) const noexcept
+        {
+            return (addr-Base::combinedOffset)/blockSize;
+        }
+    protected:
+        template<class AlignmentGetter>
+        inline void multi_alloc_addr_impl(uint32_t count, size_type* outAddresses, const size_type* bytes, const AlignmentGetter& getAlignment) noexcept
+        {
+            constexpr uint32_t batchSize = 256u;
+            uint32_t indices[batchSize];
+            for (uint32_t i=0u; i<count; )
+            {
+                // gather a batch of requests we can actually satisfy
+                uint32_t requests[batchSize];
+                uint32_t requestCount = 0u;
+                for (; requestCount<batchSize && i<count; i++)
+                {
+                    if (outAddresses[i]!=invalid_address)
+                        continue;
+                    if ((blockSize%getAlignment(i))!=0u || bytes[i]==0u || bytes[i]>blockSize)
+                        continue;
+                    requests[requestCount++] = i;
+                }
+
+                uint32_t served = 0u;
+                if constexpr (MagazineCapacity!=0u)
+                {
+                    if (auto* magazine=acquireMagazine(); magazine)
+                    {
+                        uint32_t magazineCount = magazine->count.load(std::memory_order_relaxed);
+                        for (; served<requestCount && magazineCount; served++)
+                            indices[served] = magazine->blocks[--magazineCount];
+                        magazine->count.store(magazineCount,std::memory_order_relaxed);
+                        releaseMagazine(magazine);
+                    }
+                }
+                served += popChain(indices+served,requestCount-served);
+                for (uint32_t j=0u; j<served; j++)
+                    outAddresses[requests[j]] = indexToAddress(indices[j]);
+            }
+        }
+
+        size_type   blockCount;
+        size_type   blockSize;
+        // the stack head and size are modified together, keep them on the same cache line
+        std::atomic_uint64_t stackHead;
+        std::atomic<size_type> stackSize;
+};
+
+
+}
+}
+
+#endif
@@ -0,0 +1,356 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_CORE_THREAD_CACHING_ALLOCATOR_ADAPTOR_H_INCLUDED__
+#define __NBL_CORE_THREAD_CACHING_ALLOCATOR_ADAPTOR_H_INCLUDED__
+
+#include "nbl/core/decl/Types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace nbl::core
+{
+
+namespace impl
+{
+//! Threads get handed cache slots round-robin the first time they touch any `ThreadCachingAllocatorAdaptor`
+inline uint32_t getThreadCacheSlot() noexcept
+{
+	static std::atomic_uint32_t nextSlot = 0u;
+	thread_local const uint32_t slot = nextSlot.fetch_add(1u,std::memory_order_relaxed);
+	return slot;
+}
+}
+
+//! Per-thread caching front end for a locked allocator such as `SimpleBlockBasedAllocatorMT`, similar to tcmalloc's thread caches.
+/** Freed allocations of up to `MaxCachedSize` bytes don't go back to the backing allocator, instead they get pushed onto an intrusive
+free list (the link lives in the freed memory itself) in the calling thread's cache, segregated by exact size into one of `BinCount` bins.
+An allocation of the same size then pops them back off without ever touching the backing allocator's lock.
+An empty bin gets refilled in a batch under a single lock, a bin which grows past `MaxBinLength` returns its colder half in a batch,
+and every `ScavengeInterval` operations a cache gives back half of what each bin has been sitting on unused since the last scavenge.
+That only happens on the caching thread's own operations, so a thread which went idle keeps its blocks until the owner calls
+`scavenge()` (periodically, for example once per frame) or `flushThreadCaches()`.
+
+Threads beyond `CacheSlotCount` share caches, a thread which finds its cache busy goes straight to the backing allocator,
+as does anything smaller than a pointer, bigger than `MaxCachedSize` or of a size which finds no free bin.
+Cached memory still counts as allocated as far as the backing allocator is concerned, `flushThreadCaches()` gives all of it back.
+
+The `BackingAllocator` needs `allocate(bytes,alignment)`, `deallocate(p,bytes)`, `reset()` and `get_lock()` returning a recursive lockable
+which its own `allocate` and `deallocate` take, so that a batch can hold it throughout. */
+template<class BackingAllocator, uint32_t MaxCachedSize=256u, uint32_t BinCount=8u>
+class ThreadCachingAllocatorAdaptor
+{
+	public:
+		using size_type = typename BackingAllocator::size_type;
+
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t CacheSlotCount = 32u;
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t MaxBinLength = 256u;
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t ScavengeInterval = 4096u;
+		//! a refill tries to grab about this many bytes worth of blocks at once
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t RefillByteSize = 4096u;
+
+		//! Monotonic counters summed over all thread caches
+		struct SStatistics
+		{
+			//! allocations served straight from a thread cache
+			uint64_t hits = 0ull;
+			//! allocations which had to refill their bin from the backing allocator
+			uint64_t refills = 0ull;
+			//! allocations and deallocations which didn't go through a thread cache at all
+			uint64_t bypasses = 0ull;
+			//! blocks obtained from and given back to the backing allocator by refills, overflows, scavenges and flushes
+			uint64_t blocksRefilled = 0ull;
+			uint64_t blocksReturned = 0ull;
+		};
+
+		template<typename... CtorArgs>
+		ThreadCachingAllocatorAdaptor(CtorArgs&&... args) : backing(std::forward<CtorArgs>(args)...)
+		{
+			for (auto& cache : caches)
+				cache.busy.clear();
+		}
+		~ThreadCachingAllocatorAdaptor()
+		{
+			flushThreadCaches();
+		}
+
+		inline void		reset()
+		{
+			flushThreadCaches();
+			backing.reset();
+		}
+
+		inline void*	allocate(size_type bytes, size_type alignment) noexcept
+		{
+			if (!isCacheable(bytes))
+				return bypassAllocate(bytes,alignment);
+			SThreadCache* cache = acquireCache();
+			if (!cache)
+				return bypassAllocate(bytes,alignment);
+
+			void* retval = nullptr;
+			if (SBin* bin=cache->findBin(bytes))
+			{
+				const bool refilled = !bin->head;
+				if (refilled)
+				{
+					increment(cache->refills);
+					refill(cache,*bin,alignment);
+				}
+				// blocks which came in through `deallocate` may have been allocated with a smaller alignment
+				if (bin->head && (reinterpret_cast<size_t>(bin->head)&(alignment-1u))==0u)
+				{
+					if (!refilled)
+						increment(cache->hits);
+					retval = bin->head;
+					bin->head = getNext(retval);
+					if (--bin->count<bin->lowWater)
+						bin->lowWater = bin->count;
+				}
+			}
+			if (!retval)
+				retval = bypassAllocate(bytes,alignment);
+			tick(cache);
+			releaseCache(cache);
+			return retval;
+		}
+		inline void		deallocate(void* p, size_type bytes) noexcept
+		{
+			if (!isCacheable(bytes))
+				return bypassDeallocate(p,bytes);
+			SThreadCache* cache = acquireCache();
+			if (!cache)
+				return bypassDeallocate(p,bytes);
+
+			if (SBin* bin=cache->findBin(bytes))
+			{
+				setNext(p,bin->head);
+				bin->head = p;
+				if (++bin->count>MaxBinLength)
+					returnBlocks(cache,*bin,bin->count/2u);
+			}
+			else
+				bypassDeallocate(p,bytes);
+			tick(cache);
+			releaseCache(cache);
+		}
+
+		//! Gives every cached block back to the backing allocator, waits for threads currently using their caches
+		inline void		flushThreadCaches() noexcept
+		{
+			for (auto& cache : caches)
+			{
+				while (cache.busy.test_and_set(std::memory_order_acquire))
+					std::this_thread::yield();
+				for (auto& bin : cache.bins)
+				{
+					returnBlocks(&cache,bin,bin.count);
+					bin.bytes = 0u;
+				}
+				releaseCache(&cache);
+			}
+		}
+
+		//! Does the periodic scavenge of every thread cache not in use right now, the way to get memory back from threads which went idle
+		inline void		scavenge() noexcept
+		{
+			for (auto& cache : caches)
+			{
+				// a thread using its cache right now is clearly not idle
+				if (cache.busy.test_and_set(std::memory_order_acquire))
+					continue;
+				scavengeCache(&cache);
+				releaseCache(&cache);
+			}
+		}
+
+		//! Only a snapshot, the counters keep moving while other threads allocate
+		inline SStatistics getStatistics() const noexcept
+		{
+			SStatistics retval;
+			retval.bypasses = bypasses.load(std::memory_order_relaxed);
+			for (const auto& cache : caches)
+			{
+				retval.hits += cache.hits.load(std::memory_order_relaxed);
+				retval.refills += cache.refills.load(std::memory_order_relaxed);
+				retval.blocksRefilled += cache.blocksRefilled.load(std::memory_order_relaxed);
+				retval.blocksReturned += cache.blocksReturned.load(std::memory_order_relaxed);
+			}
+			return retval;
+		}
+
+		//! Extra == Use WITH EXTREME CAUTION, anything allocated through the backing allocator directly must be freed through it too
+		inline BackingAllocator&	getBackingAllocator() noexcept {return backing;}
+
+	private:
+		struct SBin
+		{
+			// 0 when the bin is not claimed by any size
+			size_type bytes = 0u;
+			uint32_t count = 0u;
+			// smallest `count` since the last scavenge, that many blocks have not been needed in the meantime
+			uint32_t lowWater = 0u;
+			void* head = nullptr;
+		};
+		struct alignas(64) SThreadCache
+		{
+			std::atomic_flag busy;
+			uint32_t opCount = 0u;
+			SBin bins[BinCount];
+			// only ever written by the thread holding `busy`, atomic so `getStatistics` can read them from anywhere
+			std::atomic_uint64_t hits = 0ull;
+			std::atomic_uint64_t refills = 0ull;
+			std::atomic_uint64_t blocksRefilled = 0ull;
+			std::atomic_uint64_t blocksReturned = 0ull;
+
+			// claims a free bin if there's none for the size yet
+			inline SBin* findBin(const size_type bytes) noexcept
+			{
+				SBin* unclaimed = nullptr;
+				for (auto& bin : bins)
+				{
+					if (bin.bytes==bytes)
+						return &bin;
+					if (!unclaimed && bin.bytes==0u)
+						unclaimed = &bin;
+				}
+				if (unclaimed)
+				{
+					unclaimed->bytes = bytes;
+					unclaimed->count = 0u;
+					unclaimed->lowWater = 0u;
+					unclaimed->head = nullptr;
+				}
+				return unclaimed;
+			}
+		};
+
+		static inline bool isCacheable(const size_type bytes) noexcept
+		{
+			return bytes>=sizeof(void*) && bytes<=MaxCachedSize;
+		}
+		// the free list link gets stored unaligned, the block might be smaller or less aligned than a pointer would like
+		static inline void* getNext(void* block) noexcept
+		{
+			void* next;
+			memcpy(&next,block,sizeof(void*));
+			return next;
+		}
+		static inline void setNext(void* block, void* next) noexcept
+		{
+			memcpy(block,&next,sizeof(void*));
+		}
+		// relaxed load-store pair instead of a read-modify-write, there's only ever one writer
+		static inline void increment(std::atomic_uint64_t& counter, const uint64_t value=1ull) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed)+value,std::memory_order_relaxed);
+		}
+
+		// returns nullptr if some other thread is using our cache right now
+		inline SThreadCache* acquireCache() noexcept
+		{
+			auto* cache = caches+(impl::getThreadCacheSlot()%CacheSlotCount);
+			if (cache->busy.test_and_set(std::memory_order_acquire))
+				return nullptr;
+			return cache;
+		}
+		static inline void releaseCache(SThreadCache* cache) noexcept
+		{
+			cache->busy.clear(std::memory_order_release);
+		}
+
+		// these take the backing allocator's lock anyway, a shared counter costs nothing extra
+		inline void*	bypassAllocate(size_type bytes, size_type alignment) noexcept
+		{
+			bypasses.fetch_add(1ull,std::memory_order_relaxed);
+			return backing.allocate(bytes,alignment);
+		}
+		inline void		bypassDeallocate(void* p, size_type bytes) noexcept
+		{
+			bypasses.fetch_add(1ull,std::memory_order_relaxed);
+			backing.deallocate(p,bytes);
+		}
+
+		inline void refill(SThreadCache* cache, SBin& bin, const size_type alignment) noexcept
+		{
+			const uint32_t batchSize = std::max<uint32_t>(std::min<uint32_t>(RefillByteSize/bin.bytes,MaxBinLength/2u),2u);
+			uint32_t refilled = 0u;
+			auto& lock = backing.get_lock();
+			lock.lock();
+			for (; refilled<batchSize; refilled++)
+			{
+				void* block = backing.allocate(bin.bytes,alignment);
+				if (!block)
+					break;
+				setNext(block,bin.head);
+				bin.head = block;
+			}
+			lock.unlock();
+			bin.count += refilled;
+			increment(cache->blocksRefilled,refilled);
+		}
+		// gives back the `n` coldest blocks, which are the ones at the end of the list
+		inline void returnBlocks(SThreadCache* cache, SBin& bin, const uint32_t n) noexcept
+		{
+			if (n==0u)
+				return;
+			const uint32_t keep = bin.count-n;
+			void* block = bin.head;
+			if (keep)
+			{
+				void* last = block;
+				for (uint32_t i=1u; i<keep; i++)
+					last = getNext(last);
+				block = getNext(last);
+				setNext(last,nullptr);
+			}
+			else
+				bin.head = nullptr;
+
+			auto& lock = backing.get_lock();
+			lock.lock();
+			while (block)
+			{
+				void* next = getNext(block);
+				backing.deallocate(block,bin.bytes);
+				block = next;
+			}
+			lock.unlock();
+			bin.count = keep;
+			bin.lowWater = std::min(bin.lowWater,keep);
+			increment(cache->blocksReturned,n);
+		}
+		// Periodic return of memory the thread has not been using. Only runs on the caching thread's own next operation,
+		// so it's `scavenge()` which catches the threads that stopped allocating altogether.
+		inline void tick(SThreadCache* cache) noexcept
+		{
+			if (++cache->opCount<ScavengeInterval)
+				return;
+			scavengeCache(cache);
+		}
+		// call with `cache->busy` held
+		inline void scavengeCache(SThreadCache* cache) noexcept
+		{
+			cache->opCount = 0u;
+			for (auto& bin : cache->bins)
+			{
+				returnBlocks(cache,bin,(bin.lowWater+1u)/2u);
+				// a bin which saw no use gets freed up for other sizes
+				if (bin.count==0u)
+					bin.bytes = 0u;
+				bin.lowWater = bin.count;
+			}
+		}
+
+		BackingAllocator backing;
+		SThreadCache caches[CacheSlotCount];
+		std::atomic_uint64_t bypasses = 0ull;
+};
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "nbl/core/decl/compile_config.h"
 #include "nbl/core/alloc/SimpleBlockBasedAllocator.h"
+#include "nbl/core/alloc/ThreadCachingAllocatorAdaptor.h"
 #include "nbl/core/decl/BaseClasses.h"
 
 #include <memory>
@@ -11,18 +12,18 @@
 namespace nbl::core
 {
 
-template <class AddressAllocator, template<class> class DataAllocator, bool isThreadSafe, typename... Args>
-class CMemoryPool : public Uncopyable
+namespace impl
+{
+template <class AddressAllocator, template<class> class DataAllocator, class Allocator, typename... Args>
+class CMemoryPoolBase : public Uncopyable
 {
 public:
     using addr_allocator_type = AddressAllocator;
-    using allocator_type = typename std::conditional<isThreadSafe,
-        SimpleBlockBasedAllocatorMT<AddressAllocator,DataAllocator, std::recursive_mutex, Args...>,
-        SimpleBlockBasedAllocatorST<AddressAllocator,DataAllocator, Args...>>::type;
+    using allocator_type = Allocator;
     using size_type = typename core::address_allocator_traits<addr_allocator_type>::size_type;
     using addr_type = size_type;
 
-    CMemoryPool(size_type _blockSize, size_type _minBlockCount, size_type _maxBlockCount, Args... args) : // intentionally no && here, i dont wont to do here anything like reference collapsing, `Args` come from class template
+    CMemoryPoolBase(size_type _blockSize, size_type _minBlockCount, size_type _maxBlockCount, Args... args) : // intentionally no && here, i dont wont to do here anything like reference collapsing, `Args` come from class template
         m_alctr(_blockSize,_minBlockCount,_maxBlockCount,std::forward<Args>(args)...)
     {
     }
@@ -80,9 +81,40 @@ public:
         return free_n<T>(ptr, 1u);
     }
 
-private:
+protected:
     allocator_type m_alctr;
 };
+}
+
+template <class AddressAllocator, template<class> class DataAllocator, bool isThreadSafe, typename... Args>
+class CMemoryPool : public impl::CMemoryPoolBase<AddressAllocator,DataAllocator,
+    typename std::conditional<isThreadSafe,
+        SimpleBlockBasedAllocatorMT<AddressAllocator,DataAllocator, std::recursive_mutex, Args...>,
+        SimpleBlockBasedAllocatorST<AddressAllocator,DataAllocator, Args...>>::type,
+    Args...>
+{
+    using base_t = typename CMemoryPool::CMemoryPoolBase;
+public:
+    using base_t::base_t;
+};
+
+//! Thread-safe pool with a `ThreadCachingAllocatorAdaptor` in front, small object churn from many threads mostly stays off the lock
+template <class AddressAllocator, template<class> class DataAllocator, typename... Args>
+class CThreadCachedMemoryPool : public impl::CMemoryPoolBase<AddressAllocator,DataAllocator,
+    ThreadCachingAllocatorAdaptor<SimpleBlockBasedAllocatorMT<AddressAllocator,DataAllocator, std::recursive_mutex, Args...>>,
+    Args...>
+{
+    using base_t = typename CThreadCachedMemoryPool::CMemoryPoolBase;
+public:
+    using base_t::base_t;
+    using statistics_t = typename base_t::allocator_type::SStatistics;
+
+    //! Call this when the pool is about to go idle, otherwise memory cached by the threads only trickles back while they keep using the pool
+    inline void flushThreadCaches() {base_t::m_alctr.flushThreadCaches();}
+    //! Call this periodically to get back the memory threads have been sitting on unused, even the ones which stopped using the pool
+    inline void scavengeThreadCaches() {base_t::m_alctr.scavenge();}
+    inline statistics_t getStatistics() const {return base_t::m_alctr.getStatistics();}
+};
 
 }
 
@@ -0,0 +1,238 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_CORE_CONCURRENT_LRU_CACHE_H_INCLUDED__
+#define __NBL_CORE_CONCURRENT_LRU_CACHE_H_INCLUDED__
+
+#include "nbl/core/containers/LRUCache.h"
+
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace nbl
+{
+namespace core
+{
+
+namespace impl
+{
+	// every entry costs the same, which makes the byte budget an entry budget
+	struct UnitCost
+	{
+		template<typename Value>
+		inline size_t operator()(const Value&) const { return 1ull; }
+	};
+}
+
+// Thread-safe Key-Value Least Recently Used cache
+// Keys get spread over a power of two number of `LRUCache` shards, each behind its own lock, so threads working on different keys rarely meet.
+// Every entry has a cost given by `CostFunction` (usually its size in bytes), when inserting would take a shard over its share of the budget
+// (or its share of the entry count) the least recently used entries of that shard get evicted, recency is only tracked within a shard.
+// Values get handed out by copy since another thread may evict them the moment the lock is released, so store handles like `smart_refctd_ptr`.
+template<typename Key, typename Value, typename CostFunction=impl::UnitCost, typename MapHash=std::hash<Key>, typename MapEquals=std::equal_to<Key> >
+class ConcurrentLRUCache
+{
+		struct SEntry
+		{
+			Value value;
+			size_t cost;
+		};
+		using shard_cache_t = LRUCache<Key,SEntry,MapHash,MapEquals>;
+
+	public:
+		using assoc_t = std::pair<Key,Value>;
+		// called with the shard's lock held for everything evicted or erased, overwritten values just get assigned over like in `LRUCache`
+		using disposal_func_t = std::function<void(const assoc_t&)>;
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t DefaultShardCount = 16u;
+
+		struct SStatistics
+		{
+			uint64_t hits = 0ull;
+			uint64_t misses = 0ull;
+			uint64_t evictions = 0ull;
+			//! inserts of entries costing more than a whole shard's budget, they don't get cached
+			uint64_t rejections = 0ull;
+			size_t size = 0ull;
+			size_t cost = 0ull;
+		};
+
+		//Constructor, `shardCount` gets rounded up to a power of two
+		ConcurrentLRUCache(const size_t costBudget, const uint32_t capacity, const uint32_t shardCount=DefaultShardCount, CostFunction&& _cost=CostFunction(),
+			disposal_func_t&& _df=disposal_func_t(), MapHash&& _hash=MapHash(), MapEquals&& _equals=MapEquals()) :
+			m_shardCount(std::bit_ceil(std::max(shardCount,1u))), m_shards(std::make_unique<SShard[]>(m_shardCount)), m_cost(std::move(_cost)), m_hash(std::move(_hash)),
+			m_shardBudget((costBudget+m_shardCount-1u)/m_shardCount), m_shardCapacity(std::max((capacity+m_shardCount-1u)/m_shardCount,2u))
+		{
+			typename shard_cache_t::disposal_func_t df;
+			if (_df)
+				df = [_df](typename shard_cache_t::assoc_t& entry)->void
+				{
+					const assoc_t assoc(entry.first,entry.second.value);
+					_df(assoc);
+				};
+			for (uint32_t i=0u; i<m_shardCount; i++)
+				m_shards[i].cache.emplace(m_shardCapacity,typename shard_cache_t::disposal_func_t(df),MapHash(m_hash),MapEquals(_equals));
+		}
+
+		// `evictCallback` gets called for every evicted value after the shard's lock has been released, so it may use the cache again
+		// returns false if the value alone costs more than a shard's budget, in which case it doesn't get cached (and any old value for the key gets erased)
+		template<typename K, typename V, std::invocable<const Value&> EvictionCallback> requires std::is_constructible_v<Value,V>
+		inline bool insert(K&& k, V&& v, EvictionCallback&& evictCallback)
+		{
+			core::vector<Value> evicted;
+			const bool retval = insert_impl(std::forward<K>(k),Value(std::forward<V>(v)),&evicted);
+			for (const auto& value : evicted)
+				evictCallback(value);
+			return retval;
+		}
+
+		template<typename K, typename V>
+		inline bool insert(K&& k, V&& v)
+		{
+			return insert_impl(std::forward<K>(k),Value(std::forward<V>(v)),nullptr);
+		}
+
+		//get a copy of the value at an associated Key, or nothing if Key is not contained within cache. Marks the value as most recently used
+		inline std::optional<Value> get(const Key& key)
+		{
+			auto& shard = getShard(key);
+			std::unique_lock lock(shard.mutex);
+			if (auto* entry=shard.cache->get(key))
+			{
+				shard.stats.hits++;
+				return entry->value;
+			}
+			shard.stats.misses++;
+			return std::nullopt;
+		}
+
+		//get a copy of the value at an associated Key, or nothing if Key is not contained within cache. Does not alter the value use order
+		inline std::optional<Value> peek(const Key& key) const
+		{
+			auto& shard = getShard(key);
+			std::unique_lock lock(shard.mutex);
+			if (const auto* entry=std::as_const(*shard.cache).peek(key))
+			{
+				shard.stats.hits++;
+				return entry->value;
+			}
+			shard.stats.misses++;
+			return std::nullopt;
+		}
+
+		//remove element at key if present
+		inline void erase(const Key& key)
+		{
+			auto& shard = getShard(key);
+			std::unique_lock lock(shard.mutex);
+			if (const auto* entry=shard.cache->peek(key))
+			{
+				shard.stats.cost -= entry->cost;
+				shard.stats.size--;
+				shard.cache->erase(key);
+			}
+		}
+
+		//counters summed over all shards, each shard is consistent in itself but they get locked one after another
+		inline SStatistics getStatistics() const
+		{
+			SStatistics retval;
+			for (uint32_t i=0u; i<m_shardCount; i++)
+			{
+				std::unique_lock lock(m_shards[i].mutex);
+				const auto& stats = m_shards[i].stats;
+				retval.hits += stats.hits;
+				retval.misses += stats.misses;
+				retval.evictions += stats.evictions;
+				retval.rejections += stats.rejections;
+				retval.size += stats.size;
+				retval.cost += stats.cost;
+			}
+			return retval;
+		}
+
+		inline uint32_t getShardCount() const { return m_shardCount; }
+
+	private:
+		struct alignas(64) SShard
+		{
+			std::mutex mutex;
+			// `LRUCache` can't be moved (its hash functors point at it), hence the `optional`
+			std::optional<shard_cache_t> cache;
+			// `size` and `cost` are kept up to date, the rest are monotonic
+			SStatistics stats;
+		};
+
+		inline SShard& getShard(const Key& key) const
+		{
+			// the shard's own hash map uses the low bits, pick the shard from the high ones after mixing
+			const uint64_t mixed = static_cast<uint64_t>(m_hash(key))*0x9E3779B97F4A7C15ull;
+			return m_shards[m_shardCount>1u ? (mixed>>(64u-std::countr_zero(m_shardCount))):0u];
+		}
+
+		// needs the shard's lock held
+		inline void evictLeastRecentlyUsed(SShard& shard, core::vector<Value>* evicted)
+		{
+			const auto* lru = shard.cache->peekLeastRecentlyUsed();
+			shard.stats.cost -= lru->second.cost;
+			shard.stats.size--;
+			shard.stats.evictions++;
+			if (evicted)
+				evicted->push_back(lru->second.value);
+			shard.cache->popLeastRecentlyUsed();
+		}
+
+		template<typename K>
+		inline bool insert_impl(K&& k, Value&& value, core::vector<Value>* evicted)
+		{
+			const size_t cost = m_cost(value);
+			auto& shard = getShard(k);
+			std::unique_lock lock(shard.mutex);
+			// marking it most recently used keeps making room below from evicting the very entry which is about to get overwritten
+			auto* existing = shard.cache->get(k);
+			if (existing)
+			{
+				// stops counting towards the budget, so once it's the only entry left the shard has room
+				shard.stats.cost -= existing->cost;
+				existing->cost = 0u;
+			}
+			if (cost>m_shardBudget)
+			{
+				shard.stats.rejections++;
+				if (existing)
+				{
+					shard.stats.size--;
+					shard.cache->erase(k);
+				}
+				return false;
+			}
+
+			while (shard.stats.cost+cost>m_shardBudget)
+				evictLeastRecentlyUsed(shard,evicted);
+			// the entry count is a hard limit of `LRUCache` which would otherwise evict behind our back
+			if (!shard.cache->peek(k))
+			{
+				if (shard.stats.size>=m_shardCapacity)
+					evictLeastRecentlyUsed(shard,evicted);
+				shard.stats.size++;
+			}
+			shard.cache->insert(std::forward<K>(k),SEntry{std::move(value),cost});
+			shard.stats.cost += cost;
+			return true;
+		}
+
+		const uint32_t m_shardCount;
+		std::unique_ptr<SShard[]> m_shards;
+		CostFunction m_cost;
+		MapHash m_hash;
+		const size_t m_shardBudget;
+		const uint32_t m_shardCapacity;
+};
+
+
+}	//namespace core
+}		//namespace nbl
+#endif
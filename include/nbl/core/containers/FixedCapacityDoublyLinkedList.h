@@ -26,12 +26,14 @@ namespace impl
 
 			FixedCapacityDoublyLinkedListBase() = default;
 
+			// returns the reserved space, the derived class' members can't be written before they get initialized
 			template<typename T>
-			FixedCapacityDoublyLinkedListBase(const uint32_t capacity, void*& _reservedSpace, T*& _array)
+			static inline void* allocate(const uint32_t capacity, T*& _array)
 			{
 				const auto firstPart = core::alignUp(PoolAddressAllocator<uint32_t>::reserved_size(1u,capacity,1u),alignof(T));
-				_reservedSpace = _NBL_ALIGNED_MALLOC(firstPart+capacity*sizeof(T),alignof(T));
-				_array = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(_reservedSpace)+firstPart);
+				void* reservedSpace = _NBL_ALIGNED_MALLOC(firstPart+capacity*sizeof(T),alignof(T));
+				_array = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(reservedSpace)+firstPart);
+				return reservedSpace;
 			}
 	};
 }
@@ -115,6 +117,9 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 				get(backNode->prev)->next = invalid_iterator;
 			uint32_t temp = m_back;
 			m_back = backNode->prev;
+			// popped the only element
+			if (m_back == invalid_iterator)
+				m_begin = invalid_iterator;
 			common_delete(temp);
 		}
 
@@ -181,13 +186,11 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 
 		//Constructor, capacity determines the amount of allocated space
 		FixedCapacityDoublyLinkedList(const uint32_t capacity, disposal_func_t&& dispose_f = disposal_func_t()) :
-			FixedCapacityDoublyLinkedListBase(capacity,m_reservedSpace,m_array),
 			m_dispose_f(std::move(dispose_f))
 		{
+			m_reservedSpace = allocate(capacity,m_array);
 			addressAllocator = std::unique_ptr<AddressAllocator>(new AddressAllocator(m_reservedSpace, 0u, 0u, 1u, capacity, 1u));
 			cap = capacity;
-			m_back = invalid_iterator;
-			m_begin = invalid_iterator;
 		}
 		
 		FixedCapacityDoublyLinkedList() = default;
@@ -198,6 +201,9 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 		
 		FixedCapacityDoublyLinkedList& operator=(FixedCapacityDoublyLinkedList&& other)
 		{
+			if (this == &other)
+				return *this;
+			common_destroy();
 			addressAllocator = std::move(other.addressAllocator);
 			m_reservedSpace = std::move(other.m_reservedSpace);
 			m_array = std::move(other.m_array);
@@ -211,35 +217,25 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 			other.m_reservedSpace = nullptr;
 			other.m_array = nullptr;
 			other.cap = 0u;
-			other.m_back = 0u;
-			other.m_begin = 0u;
+			other.m_back = invalid_iterator;
+			other.m_begin = invalid_iterator;
 			return *this;
 		}
 
 		~FixedCapacityDoublyLinkedList()
 		{
-			if (m_dispose_f && m_begin != invalid_iterator)
-			{
-				auto* begin = getBegin();
-				auto* back = getBack();
-				do 
-				{
-					m_dispose_f(begin->data);
-					begin = get(begin->next);
-				} while (begin != back);
-			}
-			_NBL_ALIGNED_FREE(m_reservedSpace);
+			common_destroy();
 		}
 		
 
 	private:
 		std::unique_ptr<AddressAllocator> addressAllocator;
-		void* m_reservedSpace;
-		node_t* m_array;
+		void* m_reservedSpace = nullptr;
+		node_t* m_array = nullptr;
 
-		uint32_t cap;
-		uint32_t m_back;
-		uint32_t m_begin;
+		uint32_t cap = 0u;
+		uint32_t m_back = invalid_iterator;
+		uint32_t m_begin = invalid_iterator;
 
 		disposal_func_t m_dispose_f;
 		
@@ -274,6 +270,23 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 			addressAllocator->free_addr(address, 1u);
 		}
 
+		//dispose and destroy every node, including the back one, then free the storage
+		inline void common_destroy()
+		{
+			// default constructed and moved-from lists have no storage
+			if (!m_array)
+				return;
+			for (uint32_t addr = m_begin; addr != invalid_iterator;)
+			{
+				node_t* node = get(addr);
+				addr = node->next;
+				if (m_dispose_f)
+					m_dispose_f(node->data);
+				node->~node_t();
+			}
+			_NBL_ALIGNED_FREE(m_reservedSpace);
+		}
+
 		inline void common_detach(node_t* node)
 		{
 			if (node->next != invalid_iterator)
@@ -215,6 +215,30 @@ class LRUCache : protected impl::LRUCacheBase<Key,Value,MapHash,MapEquals>
 				return nullptr;
 		}
 
+		//get the least recently used key-value pair, or nullptr if the cache is empty. Does not alter the value use order
+		inline const assoc_t* peekLeastRecentlyUsed() const
+		{
+			const uint32_t i = base_t::m_list.getLastAddress();
+			if (i!=invalid_iterator)
+				return &(base_t::m_list.get(i)->data);
+			else
+				return nullptr;
+		}
+
+		//remove the least recently used element if present, handy for caches bounded by something else than the element count
+		inline void popLeastRecentlyUsed()
+		{
+			const uint32_t i = base_t::m_list.getLastAddress();
+			if (i!=invalid_iterator)
+			{
+				m_shortcut_map.erase(i);
+				base_t::m_list.popBack();
+			}
+		}
+
+		//number of elements currently in the cache
+		inline size_t getSize() const { return m_shortcut_map.size(); }
+
 		//remove element at key if present
 		inline void erase(const Key& key)
 		{
@@ -17,6 +17,7 @@
 
 // TODO: split the rest into declarations and definitions
 #include "CConcurrentObjectCache.h"
+#include "CConcurrentHashObjectCache.h"
 // allocator
 #include "nbl/core/alloc/AddressAllocatorBase.h"
 #include "nbl/core/alloc/AddressAllocatorConcurrencyAdaptors.h"
@@ -31,9 +32,11 @@
 #include "nbl/core/alloc/LinearAddressAllocator.h"
 #include "nbl/core/alloc/null_allocator.h"
 #include "nbl/core/alloc/PoolAddressAllocator.h"
+#include "nbl/core/alloc/LockFreePoolAddressAllocator.h"
 #include "nbl/core/alloc/IteratablePoolAddressAllocator.h"
 #include "nbl/core/alloc/StackAddressAllocator.h"
 #include "nbl/core/alloc/SimpleBlockBasedAllocator.h"
+#include "nbl/core/alloc/ThreadCachingAllocatorAdaptor.h"
 // algorithm
 #include "nbl/core/algorithm/radix_sort.h"
 #include "nbl/core/algorithm/utility.h"
@@ -42,6 +45,7 @@
 #include "nbl/core/containers/refctd_dynamic_array.h"
 #include "nbl/core/containers/FixedCapacityDoublyLinkedList.h"
 #include "nbl/core/containers/LRUCache.h"
+#include "nbl/core/containers/ConcurrentLRUCache.h"
 // math
 #include "nbl/core/math/intutil.h"
 #include "nbl/core/math/colorutil.h"
@@ -8,9 +8,11 @@
 #if __has_include (<execution>)
 #include <execution>
 #include <algorithm>
+#include <numeric>
 #else
 #include <oneapi/dpl/algorithm>
 #include <oneapi/dpl/execution>
+#include <oneapi/dpl/numeric>
 #include <oneapi/dpl/iterator>
 #include "oneapi/dpl/pstl/execution_defs.h"
 #include "oneapi/dpl/pstl/glue_algorithm_defs.h"
@@ -28,11 +30,14 @@ namespace nbl::core
 {
 #if __has_include(<execution>)
 namespace execution = std::execution;
+template<class T>
+constexpr inline bool is_execution_policy_v = std::is_execution_policy_v<T>;
 
 ALIAS_TEMPLATE_FUNCTION(for_each_n, std::for_each_n)
 ALIAS_TEMPLATE_FUNCTION(for_each, std::for_each)
 ALIAS_TEMPLATE_FUNCTION(swap_ranges, std::swap_ranges)
 ALIAS_TEMPLATE_FUNCTION(nth_element, std::nth_element)
+ALIAS_TEMPLATE_FUNCTION(exclusive_scan, std::exclusive_scan)
 //template <class _ExPo, class _FwdIt, class _Diff, class _Fn>
 //const auto for_each_n = std::for_each_n<_ExPo, _FwdIt, _Diff, _Fn>;
 //
@@ -43,11 +48,14 @@ ALIAS_TEMPLATE_FUNCTION(nth_element, std::nth_element)
 //const auto swap_ranges = std::swap_ranges<_ExPo, _FwdIt1, _FwdIt2>;
 #else
 namespace execution = oneapi::dpl::execution;
+template<class T>
+constexpr inline bool is_execution_policy_v = oneapi::dpl::is_execution_policy_v<T>;
 
 ALIAS_TEMPLATE_FUNCTION(for_each_n, oneapi::dpl::for_each_n)
 ALIAS_TEMPLATE_FUNCTION(for_each, oneapi::dpl::for_each)
 ALIAS_TEMPLATE_FUNCTION(swap_ranges, oneapi::dpl::swap_ranges)
 ALIAS_TEMPLATE_FUNCTION(nth_element, oneapi::dpl::nth_element)
+ALIAS_TEMPLATE_FUNCTION(exclusive_scan, oneapi::dpl::exclusive_scan)
 //template <class _ExPo, class _FwdIt, class _Diff, class _Fn>
 //const auto for_each_n = oneapi::dpl::for_each_n<_ExPo, _FwdIt, _Diff, _Fn>;
 //
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <cmath>
 #include <algorithm>
+#include <span>
 
 #include "BuildConfigOptions.h"
 #include "nbl/macros.h"
@@ -430,6 +431,10 @@ class Float16Compressor
 			v.si |= sign;
 			return v.f;
 		}
+
+		//! Batch versions of the above, bit-identical to them but using F16C and AVX2 or SSE2 when the CPU has them, `out` needs to be as long as `in`
+		NBL_API2 static void compress(std::span<const float> in, std::span<uint16_t> out);
+		NBL_API2 static void decompress(std::span<const uint16_t> in, std::span<float> out);
 };
 
 struct rgb32f {
@@ -540,6 +545,87 @@ inline rgb32f rgb19e7_to_rgb32f(uint64_t _rgb19e7)
 	return r;
 }
 
+//! Batch version of the above, bit-identical to it but vectorized, `out` needs to be as long as `in`
+NBL_API2 void rgb32f_to_rgb19e7(std::span<const rgb32f> in, std::span<uint64_t> out);
+NBL_API2 void rgb19e7_to_rgb32f(std::span<const uint64_t> in, std::span<rgb32f> out);
+
+/*
+	RGB9E5
+*/
+
+[[maybe_unused]] constexpr uint32_t RGB9E5_EXP_BITS = 5u;
+constexpr uint32_t RGB9E5_MANTISSA_BITS = 9u;
+constexpr uint32_t RGB9E5_EXP_BIAS = 15u;
+constexpr uint32_t RGB9E5_MAX_VALID_BIASED_EXP = 31u;
+constexpr uint32_t MAX_RGB9E5_EXP = RGB9E5_MAX_VALID_BIASED_EXP - RGB9E5_EXP_BIAS;
+constexpr uint32_t RGB9E5_MANTISSA_VALUES = 1u<<RGB9E5_MANTISSA_BITS;
+constexpr uint32_t MAX_RGB9E5_MANTISSA = RGB9E5_MANTISSA_VALUES-1u;
+constexpr float MAX_RGB9E5 = static_cast<float>(MAX_RGB9E5_MANTISSA)/RGB9E5_MANTISSA_VALUES * (1u<<MAX_RGB9E5_EXP);
+[[maybe_unused]] constexpr float EPSILON_RGB9E5 = (1.f/RGB9E5_MANTISSA_VALUES) / (1u<<RGB9E5_EXP_BIAS);
+//! Same layout as `EF_E5B9G9R9_UFLOAT_PACK32`, red in the lowest bits and the exponent in the top 5
+inline uint32_t rgb32f_to_rgb9e5(const float _rgb[3])
+{
+	auto clamp_rgb9e5 = [=](float x) -> float {
+		return std::max(0.f, std::min(x, MAX_RGB9E5));
+	};
+
+	const float r = clamp_rgb9e5(_rgb[0]);
+	const float g = clamp_rgb9e5(_rgb[1]);
+	const float b = clamp_rgb9e5(_rgb[2]);
+
+	auto f32_exp = [](float x) -> int32_t { return ((reinterpret_cast<int32_t&>(x)>>23) & 0xff) - 127; };
+
+	const float maxrgb = std::max({r,g,b});
+	int32_t exp_shared = std::max(-static_cast<int32_t>(RGB9E5_EXP_BIAS)-1, f32_exp(maxrgb)) + 1 + RGB9E5_EXP_BIAS;
+	assert(exp_shared <= static_cast<int32_t>(RGB9E5_MAX_VALID_BIASED_EXP));
+	assert(exp_shared >= 0);
+
+	double denom = std::exp2(static_cast<int32_t>(exp_shared-RGB9E5_EXP_BIAS-RGB9E5_MANTISSA_BITS));
+
+	const uint32_t maxm = static_cast<uint32_t>(maxrgb/denom+0.5);
+	if (maxm == MAX_RGB9E5_MANTISSA+1u)
+	{
+		denom *= 2.0;
+		++exp_shared;
+		assert(exp_shared <= static_cast<int32_t>(RGB9E5_MAX_VALID_BIASED_EXP));
+	}
+	else
+	{
+		assert(maxm <= MAX_RGB9E5_MANTISSA);
+	}
+
+	const uint32_t rm = static_cast<uint32_t>(r/denom + 0.5);
+	const uint32_t gm = static_cast<uint32_t>(g/denom + 0.5);
+	const uint32_t bm = static_cast<uint32_t>(b/denom + 0.5);
+
+	assert(rm <= MAX_RGB9E5_MANTISSA);
+	assert(gm <= MAX_RGB9E5_MANTISSA);
+	assert(bm <= MAX_RGB9E5_MANTISSA);
+
+	return rm | (gm<<RGB9E5_MANTISSA_BITS) | (bm<<(2u*RGB9E5_MANTISSA_BITS)) | (static_cast<uint32_t>(exp_shared)<<(3u*RGB9E5_MANTISSA_BITS));
+}
+inline uint32_t rgb32f_to_rgb9e5(float r, float g, float b)
+{
+	const float rgb[3]{ r,g,b };
+
+	return rgb32f_to_rgb9e5(rgb);
+}
+inline rgb32f rgb9e5_to_rgb32f(uint32_t _rgb9e5)
+{
+	const int32_t exp = static_cast<int32_t>(_rgb9e5>>(3u*RGB9E5_MANTISSA_BITS)) - RGB9E5_EXP_BIAS - RGB9E5_MANTISSA_BITS;
+	float scale = static_cast<float>(std::exp2(exp));
+
+	rgb32f r;
+	r.x = static_cast<int32_t>(_rgb9e5&MAX_RGB9E5_MANTISSA) * scale;
+	r.y = static_cast<int32_t>((_rgb9e5>>RGB9E5_MANTISSA_BITS)&MAX_RGB9E5_MANTISSA) * scale;
+	r.z = static_cast<int32_t>((_rgb9e5>>(2u*RGB9E5_MANTISSA_BITS))&MAX_RGB9E5_MANTISSA) * scale;
+
+	return r;
+}
+//! Batch version of the above, bit-identical to it but vectorized, `out` needs to be as long as `in`
+NBL_API2 void rgb32f_to_rgb9e5(std::span<const rgb32f> in, std::span<uint32_t> out);
+NBL_API2 void rgb9e5_to_rgb32f(std::span<const uint32_t> in, std::span<rgb32f> out);
+
 uint32_t& floatBitsToUint(float& _f);
 uint32_t floatBitsToUint(float&& _f);
 
@@ -656,6 +742,16 @@ inline uint64_t rgb32f_to_rgb18e7s3(float r, float g, float b)
 
 	return rgb32f_to_rgb18e7s3(rgb);
 }
+namespace impl
+{
+NBL_API2 void rgb32f_to_rgb18e7s3(std::span<const rgb32f> in, std::span<uint64_t> out, const E_ROUNDING_DIRECTION rounding);
+}
+//! Batch version of the above, bit-identical to it but vectorized, `out` needs to be as long as `in`
+template<E_ROUNDING_DIRECTION rounding=ERD_NEAREST>
+inline void rgb32f_to_rgb18e7s3(std::span<const rgb32f> in, std::span<uint64_t> out)
+{
+	impl::rgb32f_to_rgb18e7s3(in,out,rounding);
+}
 
 inline rgb32f rgb18e7s3_to_rgb32f(uint64_t _rgb18e7s3)
 {
@@ -695,6 +791,8 @@ inline rgb32f rgb18e7s3_to_rgb32f(uint64_t _rgb18e7s3)
 
 	return rgb;
 }
+//! Batch version of the above, bit-identical to it but vectorized, `out` needs to be as long as `in`
+NBL_API2 void rgb18e7s3_to_rgb32f(std::span<const uint64_t> in, std::span<rgb32f> out);
 
 NBL_FORCE_INLINE float nextafter32(float x, float y)
 {
@@ -6,6 +6,8 @@
 #define __NBL_CORE_MORTON_H_INCLUDED__
 
 #include <cstdint>
+#include <span>
+#include "BuildConfigOptions.h"
 #include "nbl/macros.h"
 
 namespace nbl
@@ -35,7 +37,7 @@ namespace impl
         {
             0x1249249249249249ull,
             0x10C30C30C30C30C3ull,
-            0x010F00F00F00F00Full,
+            0x100F00F00F00F00Full,
             0x001F0000FF0000FFull,
             0x001F00000000FFFFull
         };
@@ -75,6 +77,48 @@ namespace impl
         return x;
     }
 
+    //! Gathers every third bit, same as BMI2's `pext` with `morton3d_mask<T>(0)` at full `bitDepth`
+    template <typename T, uint32_t bitDepth>
+    inline T morton3d_decode(T x)
+    {
+        x = x & morton3d_mask<T>(0);
+        x = (x | (x >> 2)) & morton3d_mask<T>(1);
+        x = (x | (x >> 4)) & morton3d_mask<T>(2);
+        if constexpr (bitDepth>8u)
+        {
+            x = (x | (x >> 8)) & morton3d_mask<T>(3);
+        }
+        if constexpr (bitDepth>16u)
+        {
+            x = (x | (x >> 16)) & morton3d_mask<T>(4);
+        }
+        if constexpr (bitDepth>32u)
+        {
+            x = (x | (x >> 32)) & static_cast<T>(0x1FFFFFull);
+        }
+        return x;
+    }
+    //! Gathers every fourth bit, same as BMI2's `pext` with `morton4d_mask<T>(0)` at full `bitDepth`
+    template <typename T, uint32_t bitDepth>
+    inline T morton4d_decode(T x)
+    {
+        x = x & morton4d_mask<T>(0);
+        x = (x | (x >> 3)) & morton4d_mask<T>(1);
+        if constexpr (bitDepth>8u)
+        {
+            x = (x | (x >> 6)) & morton4d_mask<T>(2);
+        }
+        if constexpr (bitDepth>16u)
+        {
+            x = (x | (x >> 12)) & morton4d_mask<T>(3);
+        }
+        if constexpr (bitDepth>32u)
+        {
+            x = (x | (x >> 24)) & static_cast<T>(0xFFFFull);
+        }
+        return x;
+    }
+
     //! Puts bits on even positions filling gaps with 0s
     template <typename T, uint32_t bitDepth>
     inline T separate_bits_2d(T x)
@@ -149,6 +193,38 @@ T morton3d_encode(T x, T y, T z) { return impl::separate_bits_3d<T,bitDepth>(x)
 template<typename T, uint32_t bitDepth=sizeof(T)*8u>
 T morton4d_encode(T x, T y, T z, T w) { return impl::separate_bits_4d<T,bitDepth>(x) | (impl::separate_bits_4d<T,bitDepth>(y)<<1) | (impl::separate_bits_4d<T,bitDepth>(z)<<2) | (impl::separate_bits_4d<T,bitDepth>(w)<<3); }
 
+//! 64bit codes hold 21 bits per axis in 3D and 16 in 4D, 32bit ones 10 and 8
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton3d_decode_x(T _morton) { return impl::morton3d_decode<T,bitDepth>(_morton); }
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton3d_decode_y(T _morton) { return impl::morton3d_decode<T,bitDepth>(_morton>>1); }
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton3d_decode_z(T _morton) { return impl::morton3d_decode<T,bitDepth>(_morton>>2); }
+
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton4d_decode_x(T _morton) { return impl::morton4d_decode<T,bitDepth>(_morton); }
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton4d_decode_y(T _morton) { return impl::morton4d_decode<T,bitDepth>(_morton>>1); }
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton4d_decode_z(T _morton) { return impl::morton4d_decode<T,bitDepth>(_morton>>2); }
+template<typename T, uint32_t bitDepth=sizeof(T)*8u>
+T morton4d_decode_w(T _morton) { return impl::morton4d_decode<T,bitDepth>(_morton>>3); }
+
+//! Batch versions of the full `bitDepth` functions above over spans of equal length, `out[i]` is bit-identical to `morton3d_encode<T>(x[i],y[i],z[i])` etc.
+//! for any input, including coordinates with more bits than fit the code. The CPU gets checked once, with AVX2 the same bit spreading runs on 8 32bit
+//! (or 4 64bit) codes at a time, without it BMI2's `pdep` encodes every code whose coordinates fit. Zen 1 and 2 don't count as having BMI2, their `pdep`
+//! and `pext` are microcoded and slower than the plain code.
+NBL_API2 void morton2d_encode(std::span<const uint32_t> x, std::span<const uint32_t> y, std::span<uint32_t> out);
+NBL_API2 void morton2d_encode(std::span<const uint64_t> x, std::span<const uint64_t> y, std::span<uint64_t> out);
+NBL_API2 void morton3d_encode(std::span<const uint32_t> x, std::span<const uint32_t> y, std::span<const uint32_t> z, std::span<uint32_t> out);
+NBL_API2 void morton3d_encode(std::span<const uint64_t> x, std::span<const uint64_t> y, std::span<const uint64_t> z, std::span<uint64_t> out);
+NBL_API2 void morton4d_encode(std::span<const uint32_t> x, std::span<const uint32_t> y, std::span<const uint32_t> z, std::span<const uint32_t> w, std::span<uint32_t> out);
+NBL_API2 void morton4d_encode(std::span<const uint64_t> x, std::span<const uint64_t> y, std::span<const uint64_t> z, std::span<const uint64_t> w, std::span<uint64_t> out);
+
+//! Batch versions of `morton3d_decode_x/y/z` using `pext` under the same conditions
+NBL_API2 void morton3d_decode(std::span<const uint32_t> codes, std::span<uint32_t> x, std::span<uint32_t> y, std::span<uint32_t> z);
+NBL_API2 void morton3d_decode(std::span<const uint64_t> codes, std::span<uint64_t> x, std::span<uint64_t> y, std::span<uint64_t> z);
+
 }}
 
 #endif
\ No newline at end of file
@@ -14,13 +14,14 @@ namespace core
 {
 
 	//! TODO: make the tree sampler/generator configurable and let RandomSampler be default
+	//! Every dimension's scramble tree comes from its own random stream seeded with the seed and the dimension,
+	//! so the dimensions can be sampled in any order and `sampleBatch` produces exactly what `sample` does.
 	template<class SequenceSampler=SobolSampler>
 	class OwenSampler : protected SequenceSampler
 	{
 	public:
-		OwenSampler(uint32_t _dimensions, uint32_t _seed) : SequenceSampler(_dimensions)
+		OwenSampler(uint32_t _dimensions, uint32_t _seed) : SequenceSampler(_dimensions), seed(_seed)
 		{
-			mersenneTwister.seed(_seed);
 			cachedFlip.resize(MAX_SAMPLES-1u);
 			resetDimensionCounter(0u);
 		}
@@ -28,13 +29,11 @@ namespace core
 		{
 		}
 
-		// 
+		// Switching dimensions rebuilds the whole tree, so visit all samples of a dimension before moving to another (or use `sampleBatch`)
 		inline uint32_t sample(uint32_t dim, uint32_t sampleNum)
 		{
-			if (dim>lastDim)
+			if (dim!=lastDim)
 				resetDimensionCounter(dim);
-			else if (dim<lastDim)
-				assert(false);
 
 			uint32_t oldsample = SequenceSampler::sample(dim,sampleNum);
 			#ifdef _NBL_DEBUG
@@ -51,6 +50,57 @@ namespace core
 			return oldsample^cachedFlip[index];
 		}
 
+		//! Fills `out[(s-firstSample)*dimCount+d-firstDim]` with `sample(d,s)` without touching the tree `sample` uses.
+		/** The unscrambled values come from `SequenceSampler::sampleBatch`. A sample only ever reads a leaf of the scramble tree, and the first
+		`2^n` samples can only reach every `2^(LEAF_DEPTH-n)`-th leaf, so each dimension only keeps those leaves and their ancestors while
+		replaying its random stream, which takes `4*2^n` bytes instead of the 64MB of the full tree.
+		With a parallel policy the trees of up to `std::thread::hardware_concurrency()` dimensions (but never more than `MAX_BATCH_TREE_BYTES`
+		worth of them) get generated at once, then get applied to their columns with the samples split into chunks, otherwise it's one
+		dimension at a time. */
+		template<class ExecutionPolicy>
+		inline void sampleBatch(ExecutionPolicy&& policy, uint32_t* out, const uint32_t firstSample, const uint32_t sampleCount, const uint32_t firstDim, const uint32_t dimCount) const
+		{
+			assert(sampleCount<=MAX_SAMPLES && firstSample<=MAX_SAMPLES-sampleCount);
+			SequenceSampler::sampleBatch(policy,out,firstSample,sampleCount,firstDim,dimCount);
+			if (sampleCount==0u || dimCount==0u)
+				return;
+
+			const uint32_t levels = std::clamp<uint32_t>(std::bit_width(firstSample+sampleCount-1u),1u,LEAF_DEPTH);
+			const uint32_t leafCount = 0x1u<<levels;
+			using policy_t = std::remove_cvref_t<ExecutionPolicy>;
+			constexpr bool is_parallel_policy_v = !std::is_same_v<policy_t,core::execution::sequenced_policy> && !std::is_same_v<policy_t,core::execution::unsequenced_policy>;
+			const uint32_t maxThreads = is_parallel_policy_v ? std::max(std::thread::hardware_concurrency(),1u):1u;
+			const uint32_t maxGroupSize = std::max<uint32_t>(MAX_BATCH_TREE_BYTES/(sizeof(uint32_t)*leafCount),1u);
+			const uint32_t groupSize = std::min({dimCount,maxThreads,maxGroupSize});
+			const uint32_t chunkCount = std::clamp(sampleCount/SequenceSampler::MIN_SAMPLES_PER_CHUNK,1u,maxThreads);
+			const uint32_t chunkSize = (sampleCount-1u)/chunkCount+1u;
+			core::vector<uint32_t> leafFlips(size_t(groupSize)*leafCount);
+			core::vector<uint32_t> indices(std::max(groupSize,chunkCount));
+			std::iota(indices.begin(),indices.end(),0u);
+			for (uint32_t groupStart=0u; groupStart<dimCount; groupStart+=groupSize)
+			{
+				const uint32_t groupDims = std::min(groupSize,dimCount-groupStart);
+				core::for_each(policy,indices.begin(),indices.begin()+groupDims,[&](const uint32_t i)->void
+				{
+					generateLeafFlips(firstDim+groupStart+i,levels,leafFlips.data()+size_t(i)*leafCount);
+				});
+				core::for_each(policy,indices.begin(),indices.begin()+chunkCount,[&](const uint32_t chunk)->void
+				{
+					const uint32_t end = std::min(sampleCount,(chunk+1u)*chunkSize);
+					for (uint32_t s=chunk*chunkSize; s<end; s++)
+					{
+						uint32_t* const row = out+size_t(s)*dimCount+groupStart;
+						for (uint32_t i=0u; i<groupDims; i++)
+							row[i] ^= leafFlips[size_t(i)*leafCount+(row[i]>>(OUT_BITS-levels))];
+					}
+				});
+			}
+		}
+		inline void sampleBatch(uint32_t* out, const uint32_t firstSample, const uint32_t sampleCount, const uint32_t firstDim, const uint32_t dimCount) const
+		{
+			sampleBatch(core::execution::seq,out,firstSample,sampleCount,firstDim,dimCount);
+		}
+
 		//!
 		inline void resetDimensionCounter(uint32_t dimension)
 		{
@@ -60,11 +110,9 @@ namespace core
 			- The above can be stored in 1x array of sample count uint16_t/uint32_t per Dimension
 			- We should store samples as uint32_t always because the total amount of memory to fetch is always the same
 			**/
+			seedTreeGenerator(mersenneTwister,dimension);
 			for (uint32_t i=0u; i<MAX_SAMPLES-1u; i++) 
-			{
-				uint32_t randMask = (i<(MAX_SAMPLES/2u-1u)) ? 0x80000000u:0xffffffffu;
-				cachedFlip[i] = mersenneTwister()&(randMask>>getTreeDepth(i));
-			}
+				cachedFlip[i] = mersenneTwister()&getFlipMask(getTreeDepth(i));
 			for (uint32_t i=1u; i<MAX_SAMPLES_LOG2; i++)
 			{
 				uint32_t previousLevelStart = (0x1u<<(i-1u))-1u;
@@ -92,11 +140,62 @@ namespace core
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t MAX_SAMPLES_LOG2 = 24u;
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t MAX_SAMPLES = 0x1u<<MAX_SAMPLES_LOG2;
 
-		inline uint32_t getTreeDepth(uint32_t sampleNum)
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t LEAF_DEPTH = MAX_SAMPLES_LOG2-1u;
+		// how much memory the trees generated at once by `sampleBatch` may take, that's two trees of the maximum sample count
+		_NBL_STATIC_INLINE_CONSTEXPR size_t MAX_BATCH_TREE_BYTES = size_t(sizeof(uint32_t))<<(LEAF_DEPTH+1u);
+
+		static inline uint32_t getTreeDepth(uint32_t sampleNum)
 		{
 			return hlsl::findMSB(sampleNum+1u);
 		}
+		// inner nodes decide a single bit, the leaves scramble all the remaining ones
+		static inline uint32_t getFlipMask(const uint32_t depth)
+		{
+			return (depth<LEAF_DEPTH ? 0x80000000u:0xffffffffu)>>depth;
+		}
+
+		inline void seedTreeGenerator(std::mt19937& generator, const uint32_t dimension) const
+		{
+			std::seed_seq seq = {seed,dimension};
+			generator.seed(seq);
+		}
+
+		// Draws the same random numbers as `resetDimensionCounter` but only keeps every `2^(LEAF_DEPTH-levels)`-th leaf and its ancestors,
+		// leaf `q` of the output equals `cachedFlip[MAX_SAMPLES/2u-1u+(q<<(LEAF_DEPTH-levels))]`
+		inline void generateLeafFlips(const uint32_t dimension, const uint32_t levels, uint32_t* leaves) const
+		{
+			std::mt19937 generator;
+			seedTreeGenerator(generator,dimension);
+			const uint32_t leafCount = 0x1u<<levels;
+			// every level gets built right in front of its parent level at the end of `leaves`, a node only overwrites
+			// parents whose children have all been done, which leaves the full level `levels` taking up the whole array
+			leaves[leafCount-1u] = generator()&getFlipMask(0u);
+			for (uint32_t depth=1u; depth<=levels; depth++)
+			{
+				const uint32_t levelSize = 0x1u<<depth;
+				const uint32_t mask = getFlipMask(depth);
+				const uint32_t* const parents = leaves+leafCount-levelSize/2u;
+				uint32_t* const level = leaves+leafCount-levelSize;
+				for (uint32_t j=0u; j<levelSize; j++)
+				{
+					const uint32_t parent = parents[j>>1u];
+					level[j] = (generator()&mask)|parent;
+				}
+			}
+			// below that a kept node is the first of every `stride` nodes, and its parent is the kept node with the same index
+			for (uint32_t depth=levels+1u; depth<=LEAF_DEPTH; depth++)
+			{
+				const uint32_t stride = 0x1u<<(depth-levels);
+				const uint32_t mask = getFlipMask(depth);
+				for (uint32_t q=0u; q<leafCount; q++)
+				{
+					leaves[q] |= generator()&mask;
+					generator.discard(stride-1u);
+				}
+			}
+		}
 
+		uint32_t seed;
 		std::mt19937 mersenneTwister;
 		uint32_t lastDim;
 		core::vector<uint32_t> cachedFlip;
@@ -6,6 +6,10 @@
 #define __NBL_CORE_SOBOL_SAMPLER_H_
 
 #include "nbl/core/decl/Types.h"
+#include "nbl/core/execution.h"
+
+#include <bit>
+#include <thread>
 
 namespace nbl::core
 {
@@ -77,7 +81,7 @@ class SobolSampler
 		}
 		
 		// Idea for optimization, do PoT samples per pass, then can precompute most of the `retval`
-		inline uint32_t sample(uint32_t dim, uint32_t sampleNum)
+		inline uint32_t sample(uint32_t dim, uint32_t sampleNum) const
 		{
 			#ifdef _DEBUG
 				assert(dim<dimensions);
@@ -91,7 +95,105 @@ class SobolSampler
 			return retval;
 		}
 
+		//! samples which differ only in the lowest `log2(BATCH_WIDTH)` bits of their index get produced together by `sampleBatch`
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t BATCH_WIDTH = 16u;
+		//! below this many samples per thread `sampleBatch` won't bother splitting the work
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t MIN_SAMPLES_PER_CHUNK = 0x1u<<12u;
+
+		//! Fills `out[(s-firstSample)*dimCount+d-firstDim]` with `sample(d,s)` for `sampleCount` samples and `dimCount` dimensions.
+		/** Instead of XOR-ing together up to 32 direction numbers for every value, the samples get enumerated in order like a Gray code:
+		going from sample `i` to `i+1` flips index bits `0` through `std::countr_one(i)`, so the previous value only needs XOR-ing with
+		a precomputed prefix XOR of that dimension's direction numbers.
+		On top of that aligned runs of `BATCH_WIDTH` samples share everything but their lowest index bits, each of their rows is then
+		just the XOR of the run's first row with a precomputed row, two contiguous arrays which the compiler vectorizes across dimensions.
+		With a parallel policy the samples get split into chunks of whole batches which get enumerated independently. */
+		template<class ExecutionPolicy>
+		inline void sampleBatch(ExecutionPolicy&& policy, uint32_t* out, const uint32_t firstSample, const uint32_t sampleCount, const uint32_t firstDim, const uint32_t dimCount) const
+		{
+			assert(firstDim+dimCount<=dimensions);
+			assert(sampleCount==0u || firstSample+(sampleCount-1u)>=firstSample);
+			if (sampleCount==0u || dimCount==0u)
+				return;
+
+			auto vectors = *reinterpret_cast<uint32_t(*)[][SOBOL_BITS]>(directions);
+			// row `i` holds the XOR of direction numbers `0` through `i` of every dimension
+			core::vector<uint32_t> prefixXor(SOBOL_BITS*dimCount);
+			// row `j` holds sample `j` of every dimension
+			core::vector<uint32_t> batchRows(BATCH_WIDTH*dimCount,0u);
+			for (uint32_t d=0u; d<dimCount; d++)
+			{
+				uint32_t accumulator = 0u;
+				for (uint32_t i=0u; i<SOBOL_BITS; i++)
+					prefixXor[i*dimCount+d] = accumulator ^= vectors[firstDim+d][i];
+				for (uint32_t j=1u; j<BATCH_WIDTH; j++)
+					batchRows[j*dimCount+d] = batchRows[(j-1u)*dimCount+d]^prefixXor[std::countr_one(j-1u)*dimCount+d];
+			}
+
+			const uint32_t maxChunks = std::max(std::thread::hardware_concurrency(),1u);
+			const uint32_t chunkCount = std::clamp(sampleCount/MIN_SAMPLES_PER_CHUNK,1u,maxChunks);
+			const uint32_t chunkSize = (((sampleCount-1u)/chunkCount)/BATCH_WIDTH+1u)*BATCH_WIDTH;
+			core::vector<uint32_t> chunks(chunkCount);
+			std::iota(chunks.begin(),chunks.end(),0u);
+			core::for_each(policy,chunks.begin(),chunks.end(),[&](const uint32_t chunk)->void
+			{
+				const uint32_t offset = chunk*chunkSize;
+				if (offset<sampleCount)
+					sampleBatch_impl(out+size_t(offset)*dimCount,firstSample+offset,firstSample+std::min(sampleCount-offset,chunkSize)+offset-1u,firstDim,dimCount,prefixXor.data(),batchRows.data());
+			});
+		}
+		inline void sampleBatch(uint32_t* out, const uint32_t firstSample, const uint32_t sampleCount, const uint32_t firstDim, const uint32_t dimCount) const
+		{
+			sampleBatch(core::execution::seq,out,firstSample,sampleCount,firstDim,dimCount);
+		}
+
 	protected:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t BATCH_WIDTH_LOG2 = std::countr_zero(BATCH_WIDTH);
+
+		// enumerates samples `first` through `last` inclusive, so that a range ending at the very last sample index needs no special casing
+		inline void sampleBatch_impl(uint32_t* out, const uint32_t first, const uint32_t last, const uint32_t firstDim, const uint32_t dimCount, const uint32_t* prefixXor, const uint32_t* batchRows) const
+		{
+			core::vector<uint32_t> current(dimCount);
+			for (uint32_t d=0u; d<dimCount; d++)
+				current[d] = sample(firstDim+d,first);
+			uint32_t* const x = current.data();
+
+			uint32_t s = first;
+			// writes out sample `s` and moves on to the next one
+			auto single = [&]() -> void
+			{
+				std::copy_n(x,dimCount,out);
+				out += dimCount;
+				if (s!=last)
+				{
+					const uint32_t* const flip = prefixXor+std::countr_one(s)*dimCount;
+					for (uint32_t d=0u; d<dimCount; d++)
+						x[d] ^= flip[d];
+				}
+			};
+			for (; s!=last && (s&(BATCH_WIDTH-1u)); s++)
+				single();
+			for (; (s&(BATCH_WIDTH-1u))==0u && last-s>=BATCH_WIDTH-1u; s+=BATCH_WIDTH)
+			{
+				for (uint32_t j=0u; j<BATCH_WIDTH; j++)
+				{
+					const uint32_t* const row = batchRows+j*dimCount;
+					for (uint32_t d=0u; d<dimCount; d++)
+						out[d] = x[d]^row[d];
+					out += dimCount;
+				}
+				if (last-s==BATCH_WIDTH-1u)
+					return;
+				// the next batch flips index bits `BATCH_WIDTH_LOG2` through the lowest zero bit above them
+				const uint32_t* const flipUpTo = prefixXor+(BATCH_WIDTH_LOG2+std::countr_one(s>>BATCH_WIDTH_LOG2))*dimCount;
+				const uint32_t* const flipBelow = prefixXor+(BATCH_WIDTH_LOG2-1u)*dimCount;
+				for (uint32_t d=0u; d<dimCount; d++)
+					x[d] ^= flipUpTo[d]^flipBelow[d];
+			}
+			for (; s!=last; s++)
+				single();
+			single();
+		}
+
 		typedef struct SobolDirectionNumbers {
 			uint32_t d, s, a;
 			uint32_t m[SOBOL_BITS];
@@ -8,94 +8,176 @@
 #include <cstdint>
 #include <cstring>
 #include <array>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
 
 namespace nbl::core
 {
-constexpr std::array<uint64_t, 4> XXHash_256(const uint8_t* input, const size_t len)
+
+//! Incremental version of `XXHash_256`, feed it the input in as many pieces as you like and get the same digest.
+// The algorithm seeds its state with the total length and only treats the last bytes differently, so the length
+// has to be known up front, but the data doesn't need to be in one contiguous buffer (or in memory at all) anymore.
+class XXHash256Hasher
 {
-#define _rotl(x,r) ((x << r) | (x >> (64 - r)))
-    constexpr uint64_t PRIME = 11400714819323198393ULL;
+    public:
+        using digest_t = std::array<uint64_t,4>;
 
-    uint64_t out[4] = { 0,0,0,0 }; // must be initialized to 0s
+        constexpr XXHash256Hasher(const size_t totalLength) :
+            m_bigLoopLimit(totalLength>=BigLoopRequiredLength ? (totalLength-BigLoopRequiredLength):0ull),
+            m_smallLoopLimit(totalLength>=SmallLoopStep ? (totalLength-SmallLoopStep):0ull)
+        {
+            m_v[0] = m_v[1] = m_v[2] = m_v[3] = totalLength*Prime;
+        }
 
-    const uint8_t* p = input;
-    const uint8_t* const bEnd = p + len;
+        constexpr void update(const uint8_t* input, size_t size)
+        {
+            // top up a partial block from a previous `update` first
+            while (size && m_buffered)
+            {
+                const size_t blockSize = getBlockSize(m_processed);
+                const size_t count = blockSize ? std::min(blockSize-m_buffered,size):size;
+                for (size_t i=0; i<count; i++)
+                    m_buffer[m_buffered+i] = input[i];
+                m_buffered += count;
+                input += count;
+                size -= count;
+                if (!blockSize)
+                    break;
+                if (m_buffered==blockSize)
+                {
+                    processBlock(m_buffer,blockSize);
+                    m_buffered = 0;
+                }
+            }
+            // bulk of the data gets hashed straight from the input
+            while (size>=BigLoopStep && m_processed<m_bigLoopLimit)
+            {
+                bigLoopStep(input);
+                input += BigLoopStep;
+                size -= BigLoopStep;
+            }
+            if (m_processed>=m_bigLoopLimit)
+            while (size>=SmallLoopStep && m_processed<m_smallLoopLimit)
+            {
+                smallLoopStep(input);
+                input += SmallLoopStep;
+                size -= SmallLoopStep;
+            }
+            // whatever is left is less than a block, or the tail which only gets mixed in at the very end
+            for (size_t i=0; i<size; i++)
+                m_buffer[m_buffered+i] = input[i];
+            m_buffered += size;
+        }
 
-    uint64_t v1 = len * PRIME;
-    uint64_t v2 = v1;
-    uint64_t v3 = v1;
-    uint64_t v4 = v1;
+        //! Must have been given exactly `totalLength` bytes by now
+        constexpr digest_t finalize() const
+        {
+            // tail is never longer than a small loop step
+            digest_t out = {0,0,0,0};
+            for (size_t i=0; i<m_buffered; ++i)
+                out[i/8] |= static_cast<uint64_t>(m_buffer[i])<<((i%8)*8);
+            for (auto i=0; i<4; i++)
+                out[i] += m_v[i];
+            return out;
+        }
 
-    constexpr size_t small_loop_step = 4 * sizeof(uint64_t);
-    if (len >= small_loop_step)
-    {
-        const uint8_t* const small_loop_limit = bEnd - small_loop_step;
+    private:
+        constexpr static inline uint64_t Prime = 11400714819323198393ULL;
+        constexpr static inline size_t SmallLoopStep = 4*sizeof(uint64_t);
+        constexpr static inline size_t BigLoopStep = 4*SmallLoopStep;
+        // Set the big loop limit early enough, so the well-mixing small loop can be executed twice after it
+        constexpr static inline size_t BigLoopRequiredLength = BigLoopStep+2*SmallLoopStep;
 
-        constexpr auto getU64 = [](const uint8_t* in)
+        static constexpr uint64_t rotl(const uint64_t x, const int r)
+        {
+            return (x<<r)|(x>>(64-r));
+        }
+        static constexpr uint64_t getU64(const uint8_t* in)
         {
+            // assembling the bytes one by one is only needed at compile time, a plain load is the same thing on little endian
+            if (!std::is_constant_evaluated())
+            if constexpr (std::endian::native==std::endian::little)
+            {
+                uint64_t u64;
+                std::memcpy(&u64,in,sizeof(u64));
+                return u64;
+            }
             uint64_t u64 = 0;
-
             for (int i = 0; i < 8; ++i)
                 u64 |= static_cast<uint64_t>(in[i]) << (i * 8);
             return u64;
-        };
+        }
 
-        const size_t big_loop_step = 4 * 4 * sizeof(uint64_t);
-        // Set the big loop limit early enough, so the well-mixing small loop can be executed twice after it
-        const size_t big_loop_req_len = big_loop_step + 2 * small_loop_step;
-        if (len >= big_loop_req_len)
+        constexpr size_t getBlockSize(const size_t offset) const
         {
-            const uint8_t* const big_loop_limit = bEnd - big_loop_req_len;
-            while (p < big_loop_limit)
-            {
-                v1 = _rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
-                v2 = _rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
-                v3 = _rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
-                v4 = _rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
-                v1 += v2 *= PRIME;
-                v1 = _rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
-                v2 = _rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
-                v3 = _rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
-                v4 = _rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
-                v2 += v3 *= PRIME;
-                v1 = _rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
-                v2 = _rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
-                v3 = _rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
-                v4 = _rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
-                v3 += v4 *= PRIME;
-                v1 = _rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
-                v2 = _rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
-                v3 = _rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
-                v4 = _rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
-                v4 += v1 *= PRIME;
-            }
+            if (offset<m_bigLoopLimit)
+                return BigLoopStep;
+            if (offset<m_smallLoopLimit)
+                return SmallLoopStep;
+            return 0;
         }
-
-        while (p < small_loop_limit)
+        constexpr void processBlock(const uint8_t* p, const size_t blockSize)
         {
-            v1 = _rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
-            v2 += v1 *= PRIME;
-            v2 = _rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
-            v3 += v2 *= PRIME;
-            v3 = _rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
-            v4 += v3 *= PRIME;
-            v4 = _rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
-            v1 += v4 *= PRIME;
+            if (blockSize==BigLoopStep)
+                bigLoopStep(p);
+            else
+                smallLoopStep(p);
         }
-    }
-#undef _rotl
-
-    size_t leftOverBytes = bEnd - p;
 
-    for (size_t i = 0; i < leftOverBytes; ++i)
-        out[i / 8] |= (static_cast<uint64_t>(p[i]) << ((i % 8) * 8));
+        constexpr void bigLoopStep(const uint8_t* p)
+        {
+            auto& [v1,v2,v3,v4] = m_v;
+            v1 = rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
+            v2 = rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
+            v3 = rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
+            v4 = rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
+            v1 += v2 *= Prime;
+            v1 = rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
+            v2 = rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
+            v3 = rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
+            v4 = rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
+            v2 += v3 *= Prime;
+            v1 = rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
+            v2 = rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
+            v3 = rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
+            v4 = rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
+            v3 += v4 *= Prime;
+            v1 = rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
+            v2 = rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
+            v3 = rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
+            v4 = rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
+            v4 += v1 *= Prime;
+            m_processed += BigLoopStep;
+        }
+        constexpr void smallLoopStep(const uint8_t* p)
+        {
+            auto& [v1,v2,v3,v4] = m_v;
+            v1 = rotl(v1, 29) + getU64(p); p += sizeof(uint64_t);
+            v2 += v1 *= Prime;
+            v2 = rotl(v2, 31) + getU64(p); p += sizeof(uint64_t);
+            v3 += v2 *= Prime;
+            v3 = rotl(v3, 33) + getU64(p); p += sizeof(uint64_t);
+            v4 += v3 *= Prime;
+            v4 = rotl(v4, 35) + getU64(p); p += sizeof(uint64_t);
+            v1 += v4 *= Prime;
+            m_processed += SmallLoopStep;
+        }
 
-    out[0] += v1;
-    out[1] += v2;
-    out[2] += v3;
-    out[3] += v4;
+        size_t m_bigLoopLimit;
+        size_t m_smallLoopLimit;
+        size_t m_processed = 0;
+        std::array<uint64_t,4> m_v = {};
+        // a partial block, or the tail
+        uint8_t m_buffer[BigLoopStep] = {};
+        size_t m_buffered = 0;
+};
 
-    return { out[0],out[1],out[2],out[3] };
+constexpr std::array<uint64_t, 4> XXHash_256(const uint8_t* input, const size_t len)
+{
+    XXHash256Hasher hasher(len);
+    hasher.update(input,len);
+    return hasher.finalize();
 }
 
 /*
@@ -96,6 +96,8 @@ class ParserManager
 
 		//
 		core::vector<std::pair<CElementShape*,std::string> > shapegroups;
+		//! mesh and bitmap files the scene refers to, as written in the XML, so they can be prefetched before being loaded
+		core::vector<system::path> referencedFiles;
 		//
 		core::smart_refctd_ptr<CMitsubaMetadata> m_metadata;
 
@@ -0,0 +1,83 @@
+#ifndef _NBL_SYSTEM_C_ASYNC_FILE_LOGGER_INCLUDED_
+#define _NBL_SYSTEM_C_ASYNC_FILE_LOGGER_INCLUDED_
+
+#include "nbl/system/ILogger.h"
+#include "nbl/system/IFile.h"
+
+#include <atomic>
+#include <thread>
+
+namespace nbl::system
+{
+
+//! File logger which never takes a lock nor touches the file on the logging thread.
+// The message gets formatted straight into a slot of a bounded lock-free multi-producer single-consumer ring,
+// the timestamp is just a monotonic clock read and turning it into a date string is left to the flusher thread,
+// which drains the ring in batches and issues one write per batch.
+class NBL_API2 CAsyncFileLogger final : public ILogger
+{
+	public:
+		enum E_OVERFLOW_POLICY : uint8_t
+		{
+			//! logging thread waits for the flusher to free up space, nothing gets lost
+			EOP_BLOCK = 0,
+			//! message gets thrown away and counted in `getDroppedCount()`
+			EOP_DROP
+		};
+		//! in records, rounded up to a power of two
+		constexpr static inline uint32_t DefaultCapacity = 4096u;
+
+		CAsyncFileLogger(
+			core::smart_refctd_ptr<IFile>&& _file, const bool append, const core::bitflag<E_LOG_LEVEL> logLevelMask=ILogger::DefaultLogMask(),
+			const E_OVERFLOW_POLICY overflowPolicy=EOP_BLOCK, const uint32_t capacity=DefaultCapacity
+		);
+
+		//! Blocks until everything logged before the call has been written to the file
+		void flush();
+
+		//
+		inline uint64_t getDroppedCount() const {return m_dropped.load(std::memory_order_relaxed);}
+
+	protected:
+		// logs everything still in the ring before returning
+		~CAsyncFileLogger();
+
+		void log_impl(const std::string_view& fmtString, E_LOG_LEVEL logLevel, va_list args) override;
+
+	private:
+		// messages which don't fit `message` get a heap allocation, so make the common case fit
+		struct alignas(64) SRecord
+		{
+			// Vyukov's bounded queue: `position+1` when published, `position+capacity` when free again
+			std::atomic_uint64_t sequence;
+			int64_t timestamp;
+			char* longMessage;
+			uint32_t length;
+			E_LOG_LEVEL level;
+			char message[227];
+		};
+		static_assert(sizeof(SRecord)==256);
+
+		// returns nullptr if the message got dropped, `ELL_NONE` is used to tell the flusher to quit and always blocks
+		SRecord* claim(const E_LOG_LEVEL logLevel, uint64_t& position);
+		void publish(SRecord* record, const uint64_t position);
+		void flusherMain();
+
+		core::smart_refctd_ptr<IFile> m_file;
+		size_t m_pos;
+		const E_OVERFLOW_POLICY m_overflowPolicy;
+		const uint32_t m_capacity;
+		std::unique_ptr<SRecord[]> m_records;
+		// producers only ever touch `m_tail`, the flusher only `m_flushed`
+		alignas(64) std::atomic_uint64_t m_tail = 0u;
+		alignas(64) std::atomic_uint64_t m_flushed = 0u;
+		std::atomic_uint64_t m_dropped = 0u;
+		// for turning the monotonic timestamps back into wall clock time
+		const std::chrono::system_clock::time_point m_systemEpoch;
+		const std::chrono::steady_clock::time_point m_steadyEpoch;
+		std::thread m_flusher;
+};
+
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef _NBL_SYSTEM_C_BUFFERED_FILE_READER_H_INCLUDED_
+#define _NBL_SYSTEM_C_BUFFERED_FILE_READER_H_INCLUDED_
+
+#include "nbl/system/IFile.h"
+
+#include <span>
+
+namespace nbl::system
+{
+
+//! Forward-only reader for parsers which consume a file a few bytes or a token at a time.
+// A mapped file is read straight out of the mapping, no copies and no requests.
+// Otherwise the reader owns two chunks, while one is being parsed the next one is already in flight on the ISystem worker.
+class CBufferedFileReader final
+{
+	public:
+		constexpr static inline size_t DefaultChunkSize = 0x1ull<<20u;
+		constexpr static inline int EndOfFile = -1;
+
+		inline CBufferedFileReader(IFile* _file, const size_t _offset=0ull, const size_t _chunkSize=DefaultChunkSize) : m_file(_file), m_fileSize(_file ? _file->getSize():0ull), m_chunkSize(_chunkSize)
+		{
+			const IFile* constFile = m_file;
+			m_mapped = m_file ? reinterpret_cast<const std::byte*>(constFile->getMappedPointer()):nullptr;
+			if (!m_mapped && m_file)
+				m_storage = std::make_unique<std::byte[]>(m_chunkSize<<1u);
+			seek(_offset);
+		}
+		// the future's destructor waits for any read still in flight, and it goes out of scope before `m_storage`
+		~CBufferedFileReader() = default;
+
+		CBufferedFileReader(const CBufferedFileReader&) = delete;
+		CBufferedFileReader& operator=(const CBufferedFileReader&) = delete;
+
+		//
+		inline IFile* getFile() const {return m_file;}
+		inline bool isZeroCopy() const {return m_mapped;}
+
+		//! Offset in the file of the next byte `get()` will return
+		inline size_t tell() const {return m_windowOffset+(m_cursor-m_begin);}
+		inline bool eof()
+		{
+			return m_cursor==m_end && !nextChunk();
+		}
+
+		//!
+		inline int peek()
+		{
+			if (m_cursor==m_end && !nextChunk())
+				return EndOfFile;
+			return static_cast<int>(*m_cursor);
+		}
+		inline int get()
+		{
+			if (m_cursor==m_end && !nextChunk())
+				return EndOfFile;
+			return static_cast<int>(*(m_cursor++));
+		}
+
+		//! Returns number of bytes actually copied, less than `size` only at the end of the file
+		inline size_t read(void* dst, size_t size)
+		{
+			auto* out = reinterpret_cast<std::byte*>(dst);
+			while (size && !eof())
+			{
+				const size_t count = std::min<size_t>(m_end-m_cursor,size);
+				memcpy(out,m_cursor,count);
+				m_cursor += count;
+				out += count;
+				size -= count;
+			}
+			return out-reinterpret_cast<std::byte*>(dst);
+		}
+		//! Returns number of bytes actually skipped
+		inline size_t skip(const size_t size)
+		{
+			const size_t start = tell();
+			seek(start+size);
+			return tell()-start;
+		}
+		//! Cheap within the current window, otherwise throws away the read-ahead and restarts it at `offset`
+		inline void seek(size_t offset)
+		{
+			offset = std::min(offset,m_fileSize);
+			if (m_begin && offset>=m_windowOffset && offset<=m_windowOffset+(m_end-m_begin))
+			{
+				m_cursor = m_begin+(offset-m_windowOffset);
+				return;
+			}
+			if (m_mapped)
+			{
+				m_windowOffset = 0ull;
+				m_begin = m_mapped;
+				m_end = m_mapped+m_fileSize;
+				m_cursor = m_mapped+offset;
+				return;
+			}
+			if (!m_file)
+				return;
+			waitForPending();
+			m_windowOffset = m_nextOffset = offset;
+			m_begin = m_cursor = m_end = m_storage.get();
+			m_pendingChunk = 0u;
+			requestChunk();
+		}
+
+		//! Skips bytes while `pred(char)` holds, returns how many were skipped
+		template<typename Pred>
+		inline size_t skipWhile(Pred&& pred)
+		{
+			size_t count = 0ull;
+			while (!eof())
+			{
+				const auto* const start = m_cursor;
+				while (m_cursor!=m_end && pred(static_cast<char>(*m_cursor)))
+					m_cursor++;
+				count += m_cursor-start;
+				if (m_cursor!=m_end)
+					break;
+			}
+			return count;
+		}
+		//! Appends bytes to `out` while `pred(char)` holds, returns how many were appended
+		template<typename Pred>
+		inline size_t appendWhile(std::string& out, Pred&& pred)
+		{
+			size_t count = 0ull;
+			while (!eof())
+			{
+				const auto* const start = m_cursor;
+				while (m_cursor!=m_end && pred(static_cast<char>(*m_cursor)))
+					m_cursor++;
+				out.append(reinterpret_cast<const char*>(start),m_cursor-start);
+				count += m_cursor-start;
+				if (m_cursor!=m_end)
+					break;
+			}
+			return count;
+		}
+
+		//! For consumers which can take whole blocks (e.g. streaming parsers), the unconsumed bytes of the current window
+		// NOTE: the memory stays valid only until the next call which may need more data (`nextChunk`, `get`, `read`, etc.)
+		inline std::span<const std::byte> window() const {return {m_cursor,m_end};}
+		inline void consume(const size_t size)
+		{
+			m_cursor += std::min<size_t>(size,m_end-m_cursor);
+		}
+		//! Discards the current window and moves onto the next chunk, returns false if there's nothing left
+		inline bool nextChunk()
+		{
+			if (m_pendingSize==0ull)
+				return false;
+
+			size_t bytesRead = 0ull;
+			if (auto lock=m_pending.acquire())
+			{
+				bytesRead = *lock;
+				lock.discard();
+			}
+			const size_t requested = m_pendingSize;
+			m_pendingSize = 0ull;
+
+			m_windowOffset = m_nextOffset;
+			m_begin = m_cursor = m_storage.get()+m_chunkSize*m_pendingChunk;
+			m_end = m_begin+bytesRead;
+			m_nextOffset += bytesRead;
+			// short read means we either hit the end or an error, either way stop reading ahead
+			if (bytesRead==requested)
+			{
+				m_pendingChunk ^= 0x1u;
+				requestChunk();
+			}
+			return bytesRead;
+		}
+
+	private:
+		inline void requestChunk()
+		{
+			if (m_nextOffset>=m_fileSize)
+				return;
+			m_pendingSize = std::min(m_chunkSize,m_fileSize-m_nextOffset);
+			m_file->read(m_pending,m_storage.get()+m_chunkSize*m_pendingChunk,m_nextOffset,m_pendingSize);
+		}
+		inline void waitForPending()
+		{
+			if (m_pendingSize==0ull)
+				return;
+			if (auto lock=m_pending.acquire())
+				lock.discard();
+			m_pendingSize = 0ull;
+		}
+
+		IFile* const m_file;
+		const size_t m_fileSize;
+		const size_t m_chunkSize;
+		const std::byte* m_mapped = nullptr;
+		std::unique_ptr<std::byte[]> m_storage;
+		// current window
+		const std::byte* m_begin = nullptr;
+		const std::byte* m_cursor = nullptr;
+		const std::byte* m_end = nullptr;
+		size_t m_windowOffset = 0ull;
+		// read-ahead
+		size_t m_nextOffset = 0ull;
+		size_t m_pendingSize = 0ull;
+		uint8_t m_pendingChunk = 0u;
+		ISystem::future_t<size_t> m_pending;
+};
+
+}
+
+#endif
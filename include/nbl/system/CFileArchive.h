@@ -10,6 +10,11 @@
 #include "nbl/system/CFileView.h"
 #include "nbl/system/IFileViewAllocator.h"
 
+#include "nbl/core/containers/LRUCache.h"
+
+#include <mutex>
+#include <optional>
+
 #ifdef _NBL_PLATFORM_ANDROID_
 #include "nbl/system/CFileViewAPKAllocator.h"
 #endif
@@ -67,11 +72,97 @@ class CInnerArchiveFile : public CFileView<T>
 };
 
 
+// a decompressed entry held by the archive's cache, outlives the `CInnerArchiveFile` which was created over it
+class CArchiveCachedBuffer final : public core::IReferenceCounted
+{
+	public:
+		inline CArchiveCachedBuffer(void* _buffer, const size_t _size, void* _allocatorState, const IFileArchive::E_ALLOCATOR_TYPE _allocatorType) :
+			m_buffer(_buffer), m_size(_size), m_allocatorState(_allocatorState), m_allocatorType(_allocatorType) {}
+
+		inline void* getPointer() const {return m_buffer;}
+		inline size_t getSize() const {return m_size;}
+
+	protected:
+		inline ~CArchiveCachedBuffer()
+		{
+			if (!m_buffer)
+				return;
+			switch (m_allocatorType)
+			{
+				case IFileArchive::EAT_MALLOC:
+					CPlainHeapAllocator(m_allocatorState).dealloc(m_buffer,m_size);
+					break;
+				case IFileArchive::EAT_VIRTUAL_ALLOC:
+					VirtualMemoryAllocator(m_allocatorState).dealloc(m_buffer,m_size);
+					break;
+				default:
+					assert(false);
+					break;
+			}
+		}
+
+		void* const m_buffer;
+		const size_t m_size;
+		void* const m_allocatorState;
+		const IFileArchive::E_ALLOCATOR_TYPE m_allocatorType;
+};
+
+// doesn't own any memory, the state is a `CArchiveCachedBuffer` which got grabbed for the file view, dealloc just drops it
+class CArchiveCachedBufferAllocator : public IFileViewAllocator
+{
+	public:
+		using IFileViewAllocator::IFileViewAllocator;
+
+		void* alloc(size_t size) override
+		{
+			return nullptr;
+		}
+		bool dealloc(void* data, size_t size) override
+		{
+			if (m_state)
+				static_cast<CArchiveCachedBuffer*>(m_state)->drop();
+			return true;
+		}
+};
+
+
 //!
 class CFileArchive : public IFileArchive
 {
-		static inline constexpr size_t SIZEOF_INNER_ARCHIVE_FILE = std::max(sizeof(CInnerArchiveFile<CPlainHeapAllocator>), sizeof(CInnerArchiveFile<VirtualMemoryAllocator>));
-		static inline constexpr size_t ALIGNOF_INNER_ARCHIVE_FILE = std::max(alignof(CInnerArchiveFile<CPlainHeapAllocator>), alignof(CInnerArchiveFile<VirtualMemoryAllocator>));
+		static inline constexpr size_t SIZEOF_INNER_ARCHIVE_FILE = std::max({sizeof(CInnerArchiveFile<CPlainHeapAllocator>), sizeof(CInnerArchiveFile<VirtualMemoryAllocator>), sizeof(CInnerArchiveFile<CArchiveCachedBufferAllocator>)});
+		static inline constexpr size_t ALIGNOF_INNER_ARCHIVE_FILE = std::max({alignof(CInnerArchiveFile<CPlainHeapAllocator>), alignof(CInnerArchiveFile<VirtualMemoryAllocator>), alignof(CInnerArchiveFile<CArchiveCachedBufferAllocator>)});
+
+	public:
+		inline void setDecompressedCacheBudget(const size_t byteBudget) override
+		{
+			std::unique_lock lock(m_cacheMutex);
+			if (byteBudget && !m_cache.has_value())
+				m_cache.emplace(std::max<uint32_t>(m_fileCount,2u));
+			m_cacheStats.byteBudget = byteBudget;
+			if (m_cache.has_value())
+				evictDecompressed(0ull);
+			if (!byteBudget)
+				m_cache.reset();
+		}
+
+		//! Decompresses the entry straight into the decompressed cache, without the cache there's nowhere to keep the result
+		inline void prefetch(const path& pathRelativeToArchive) override
+		{
+			if (!isDecompressedCacheEnabled())
+				return;
+			const auto found = getItemFromPath(pathRelativeToArchive);
+			if (!found || (found->allocatorType!=EAT_MALLOC && found->allocatorType!=EAT_VIRTUAL_ALLOC))
+				return;
+			const auto fileBuffer = getCachedFileBuffer(found);
+			if (fileBuffer.allocatorState)
+				static_cast<CArchiveCachedBuffer*>(fileBuffer.allocatorState)->drop();
+		}
+
+		inline SDecompressedCacheStats getDecompressedCacheStats() const override
+		{
+			std::unique_lock lock(m_cacheMutex);
+			return m_cacheStats;
+		}
 
 	protected:
 		inline CFileArchive(path&& _defaultAbsolutePath, system::logger_opt_smart_ptr&& logger, std::shared_ptr<core::vector<SFileList::SEntry>> _items) :
@@ -80,6 +171,7 @@ class CFileArchive : public IFileArchive
 			setItemList(_items);
 
 			const auto fileCount = _items->size();
+			m_fileCount = fileCount;
 			m_filesBuffer = (std::byte*)_NBL_ALIGNED_MALLOC(fileCount*SIZEOF_INNER_ARCHIVE_FILE, ALIGNOF_INNER_ARCHIVE_FILE);
 			m_fileFlags = (std::atomic_flag*)_NBL_ALIGNED_MALLOC(fileCount*sizeof(std::atomic_flag), alignof(std::atomic_flag));
 			for (size_t i=0u; i<fileCount; i++)
@@ -100,9 +192,13 @@ class CFileArchive : public IFileArchive
 					return getFile_impl<CNullAllocator>(found,flags);
 					break;
 				case EAT_MALLOC:
+					if (isDecompressedCacheEnabled())
+						return getFile_impl<CArchiveCachedBufferAllocator>(found,flags);
 					return getFile_impl<CPlainHeapAllocator>(found,flags);
 					break;
 				case EAT_VIRTUAL_ALLOC:
+					if (isDecompressedCacheEnabled())
+						return getFile_impl<CArchiveCachedBufferAllocator>(found,flags);
 					return getFile_impl<VirtualMemoryAllocator>(found,flags);
 					break;
 				case EAT_APK_ALLOCATOR:
@@ -137,7 +233,11 @@ class CFileArchive : public IFileArchive
 
 			if (oldRefcount==0) // need to construct (previous refcount was 0)
 			{
-				const auto fileBuffer = getFileBuffer(found);
+				file_buffer_t fileBuffer;
+				if constexpr (std::is_same_v<Allocator,CArchiveCachedBufferAllocator>)
+					fileBuffer = getCachedFileBuffer(found);
+				else
+					fileBuffer = getFileBuffer(found);
 				// Might have barged inbetween a refctr drop and finish of a destructor + delete,
 				// need to wait for the "alive" flag to become `false` which tells us `operator delete` has finished.
 				m_fileFlags[found->ID].wait(true);
@@ -169,6 +269,74 @@ class CFileArchive : public IFileArchive
 
 		std::atomic_flag* m_fileFlags = nullptr;
 		std::byte* m_filesBuffer = nullptr;
+
+		inline bool isDecompressedCacheEnabled() const
+		{
+			std::unique_lock lock(m_cacheMutex);
+			return m_cache.has_value();
+		}
+
+	private:
+
+		// the returned `allocatorState` is a grabbed `CArchiveCachedBuffer` which the file view will drop
+		inline file_buffer_t getCachedFileBuffer(const SFileList::found_t& found)
+		{
+			const uint32_t id = found->ID;
+			{
+				std::unique_lock lock(m_cacheMutex);
+				if (auto* cached=m_cache.has_value() ? m_cache->get(id):nullptr)
+				{
+					m_cacheStats.hits++;
+					auto* buffer = cached->get();
+					buffer->grab();
+					return {buffer->getPointer(),buffer->getSize(),buffer};
+				}
+				m_cacheStats.misses++;
+			}
+
+			// decompress outside the lock, other entries can be served meanwhile
+			const auto fileBuffer = getFileBuffer(found);
+			if (!fileBuffer.buffer)
+				return {nullptr,fileBuffer.size,nullptr,fileBuffer.initialModified};
+			auto buffer = core::make_smart_refctd_ptr<CArchiveCachedBuffer>(fileBuffer.buffer,fileBuffer.size,fileBuffer.allocatorState,found->allocatorType);
+
+			std::unique_lock lock(m_cacheMutex);
+			if (m_cache.has_value() && fileBuffer.size<=m_cacheStats.byteBudget)
+			{
+				// somebody else could have decompressed the same entry while we weren't holding the lock, keep theirs
+				if (auto* cached=m_cache->peek(id))
+					buffer = *cached;
+				else
+				{
+					evictDecompressed(fileBuffer.size);
+					m_cache->insert(id,core::smart_refctd_ptr(buffer));
+					m_cacheStats.bytesCached += fileBuffer.size;
+				}
+			}
+			auto* retval = buffer.get();
+			retval->grab();
+			return {retval->getPointer(),retval->getSize(),retval,fileBuffer.initialModified};
+		}
+		// needs `m_cacheMutex` held, makes room for `extraBytes` more
+		inline void evictDecompressed(const size_t extraBytes)
+		{
+			while (m_cacheStats.bytesCached+extraBytes>m_cacheStats.byteBudget)
+			{
+				const auto* lru = m_cache->peekLeastRecentlyUsed();
+				if (!lru)
+					break;
+				m_cacheStats.bytesCached -= lru->second->getSize();
+				m_cacheStats.evictions++;
+				m_cache->popLeastRecentlyUsed();
+			}
+		}
+
+		using decompressed_cache_t = core::LRUCache<uint32_t,core::smart_refctd_ptr<CArchiveCachedBuffer>>;
+		// `LRUCache` can't be moved (its hash functors point at it), hence the `optional`
+		std::optional<decompressed_cache_t> m_cache;
+		SDecompressedCacheStats m_cacheStats = {};
+		mutable std::mutex m_cacheMutex;
+		uint32_t m_fileCount = 0u;
 };
 
 
@@ -12,11 +12,31 @@ namespace nbl::system
 class CSystemLinux final : public ISystemPOSIX
 {
 	public:
+		struct SCreationParams
+		{
+			// Keep many unmapped reads in flight with io_uring instead of servicing them one by one on the dispatcher thread.
+			// Only files opened without `ECF_WRITE` go through the ring, as it doesn't keep the order of requests against the same file.
+			// Silently falls back to regular POSIX I/O if the kernel is too old or io_uring got disabled (seccomp, sysctl, etc.)
+			bool useIOURing = false;
+			// max amount of requests in flight, gets rounded up to a Power of Two by the kernel
+			uint32_t ioURingQueueDepth = 64u;
+			// Threads servicing the I/O requests, with the plain POSIX backend this is the max amount of blocking reads in flight.
+			// Writes to the same file (and reads of files opened for writing) always land on the same thread to keep their order.
+			uint32_t ioWorkerCount = 1u;
+			// gets told if the io_uring backend hits an unrecoverable error and fails the requests in flight
+			core::smart_refctd_ptr<ILogger> logger = nullptr;
+		};
+
 		inline CSystemLinux() : ISystemPOSIX() {}
+		inline CSystemLinux(const SCreationParams& params) : ISystemPOSIX(createCaller(this,params),params.ioWorkerCount) {}
 
 		NBL_API2 SystemInfo getSystemInfo() const override;
+
+	private:
+		class CCallerIOURing;
+		NBL_API2 static core::smart_refctd_ptr<CCaller> createCaller(ISystemPOSIX* _system, const SCreationParams& params);
 };
 #endif
 }
 
-#endif
\ No newline at end of file
+#endif
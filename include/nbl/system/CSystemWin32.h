@@ -19,11 +19,17 @@ class NBL_API2 CSystemWin32 : public ISystem
             public:
                 CCaller(ISystem* _system) : ICaller(_system) {}
 
-                core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags) override final;
+                core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags, const size_t preallocatedSize) override final;
+                void prefetch(const std::filesystem::path& filename) override final;
+
+            protected:
+                bool invalidateMapping_impl(IFile* file, size_t offset, size_t size) override final;
+                bool flushMapping_impl(IFile* file, size_t offset, size_t size) override final;
         };
         
     public:
-        inline CSystemWin32() : ISystem(core::make_smart_refctd_ptr<CCaller>(this)) {}
+        // `ioWorkerCount` threads service the unmapped reads and writes, see `ISystem::ISystem`
+        inline CSystemWin32(const uint32_t ioWorkerCount=1u) : ISystem(core::make_smart_refctd_ptr<CCaller>(this),ioWorkerCount) {}
 
         SystemInfo getSystemInfo() const override;
 
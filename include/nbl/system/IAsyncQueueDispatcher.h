@@ -45,6 +45,9 @@ class IAsyncQueueDispatcherBase
                 [[nodiscard]] future_base_t* wait();
                 //! WORKER THREAD: to call after request is done being processed, will deadlock if the request was not executed
                 void notify();
+                //! WORKER THREAD: to call instead of `notify()` when the processing got handed off elsewhere, recycles the request
+                // but leaves the future in the EXECUTING state, whoever took it over is responsible for constructing its value and signalling it
+                void defer();
 
                 //! ANY THREAD [except worker]: via cancellable_future_t::cancel
                 inline void cancel()
@@ -393,6 +396,13 @@ inline void IAsyncQueueDispatcherBase::request_base_t::notify()
     // allow to be recycled
     state.exchangeNotify<false>(STATE::INITIAL,STATE::EXECUTING);
 }
+inline void IAsyncQueueDispatcherBase::request_base_t::defer()
+{
+    // the future stays EXECUTING, it can't be cancelled anymore and any waiter will keep waiting till its signalled
+    future = nullptr;
+    // allow to be recycled
+    state.exchangeNotify<false>(STATE::INITIAL,STATE::EXECUTING);
+}
 
 }
 
@@ -406,6 +416,9 @@ inline void IAsyncQueueDispatcherBase::request_base_t::notify()
 * // no `state` parameter in case of no internal state
 * void process_request(future_base_t*, request_metadata_t&, internal_state_t&);
 * 
+* // alternatively `process_request` can return a `bool`, `false` means the request was handed off to be completed asynchronously
+* // and the future will be signalled by someone else later (the request slot gets recycled straight away)
+* 
 * void background_work() // optional, does nothing if not provided
 * 
 * 
@@ -510,8 +523,19 @@ class IAsyncQueueDispatcher : public IThreadHandler<CRTP,InternalStateType>, pro
                 if (future_base_t* future=req.wait())
                 {
                     // if the request supports cancelling and got cancelled, then `wait()` function may return false
-                    static_cast<CRTP*>(this)->process_request(future,req.m_metadata,optional_internal_state...);
-                    req.notify();
+                    using process_retval_t = decltype(static_cast<CRTP*>(this)->process_request(future,req.m_metadata,optional_internal_state...));
+                    if constexpr (std::is_same_v<process_retval_t,bool>)
+                    {
+                        if (static_cast<CRTP*>(this)->process_request(future,req.m_metadata,optional_internal_state...))
+                            req.notify();
+                        else
+                            req.defer();
+                    }
+                    else
+                    {
+                        static_cast<CRTP*>(this)->process_request(future,req.m_metadata,optional_internal_state...);
+                        req.notify();
+                    }
                 }
                 // wake the waiter up
                 cb_begin++;
@@ -6,7 +6,7 @@
 namespace nbl::system
 {
 
-class IFile : public IFileBase, private ISystem::IFutureManipulator
+class IFile : public IFileBase, protected ISystem::IFutureManipulator
 {
 	public:
 		//
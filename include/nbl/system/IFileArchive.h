@@ -129,9 +129,25 @@ class IFileArchive : public core::IReferenceCounted
 			return getFile_impl(item,flags,password);
 		}
 
+		//! Hint that the entry is about to be opened, archives which can do some of the work ahead of time should do it here
+		virtual inline void prefetch(const path& pathRelativeToArchive) {}
+
 		//
 		inline const path& getDefaultAbsolutePath() const {return m_defaultAbsolutePath;}
 
+		//! Opt-in, keeps up to `byteBudget` of decompressed entries around after the last `IFile` referencing them gets dropped,
+		// so re-opening an entry doesn't decompress it again. A budget of 0 disables the cache and frees what's cached.
+		virtual inline void setDecompressedCacheBudget(const size_t byteBudget) {}
+		struct SDecompressedCacheStats
+		{
+			uint64_t hits = 0ull;
+			uint64_t misses = 0ull;
+			uint64_t evictions = 0ull;
+			size_t bytesCached = 0ull;
+			size_t byteBudget = 0ull;
+		};
+		virtual inline SDecompressedCacheStats getDecompressedCacheStats() const {return {};}
+
 	protected:
 		inline IFileArchive(path&& _defaultAbsolutePath, system::logger_opt_smart_ptr&& logger) :
 			m_defaultAbsolutePath(std::move(_defaultAbsolutePath.make_preferred())), m_logger(std::move(logger)) {}
@@ -140,7 +156,8 @@ class IFileArchive : public core::IReferenceCounted
 		//
 		virtual core::smart_refctd_ptr<IFile> getFile_impl(const SFileList::found_t& found, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const std::string_view& password) = 0;
 
-		inline const SFileList::found_t getItemFromPath(const system::path& pathRelativeToArchive) const
+		// archives with their own index can override the binary search over the sorted item list
+		virtual inline const SFileList::found_t getItemFromPath(const system::path& pathRelativeToArchive) const
 		{
             const SFileList::SEntry itemToFind = { pathRelativeToArchive };
 			// calling `listAssets` makes sure any "update list" overload can kick in
@@ -152,6 +169,16 @@ class IFileArchive : public core::IReferenceCounted
 			return SFileList::found_t(std::move(items.m_data),&(*found));
 		}
 
+		// `index` is into the sorted item list
+		inline const SFileList::found_t getItemFromIndex(const uint32_t index) const
+		{
+			auto items = listAssets();
+			const auto span = SFileList::span_t(items);
+			if (index>=span.size())
+				return {};
+			return SFileList::found_t(std::move(items.m_data),span.data()+index);
+		}
+
 		const path m_defaultAbsolutePath;
 		system::logger_opt_smart_ptr m_logger;
 
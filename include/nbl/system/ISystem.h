@@ -6,6 +6,10 @@
 #include "nbl/core/util/bitflag.h"
 
 #include <variant>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <span>
 
 #include "nbl/system/IFileArchive.h"
 #include "nbl/system/IAsyncQueueDispatcher.h"
@@ -38,6 +42,14 @@ class NBL_API2 ISystem : public core::IReferenceCounted
                     base_t::construct(std::forward<Args>(args)...);
                     base_t::notify();
                 }
+                //! for requests which the dispatcher handed off to someone else, the future is already EXECUTING
+                template <typename... Args>
+                inline void set_deferred_result(Args&&... args)
+                {
+                    assert(base_t::state.query()==base_t::STATE::EXECUTING);
+                    base_t::construct(std::forward<Args>(args)...);
+                    base_t::notify();
+                }
         };
         class IFutureManipulator
         {
@@ -112,6 +124,22 @@ class NBL_API2 ISystem : public core::IReferenceCounted
             const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, // access flags (IMPORTANT: files from most archives wont open with ECF_WRITE bit)
             const std::string_view& accessToken="" // usually password for archives, but should be SSH key for URL downloads
         );
+        //! Creates (truncates) a file for writing with `preallocatedSize` bytes already reserved on disk.
+        // With `ECF_MAPPABLE|ECF_WRITE` you get a shared writable mapping of the whole size, so you can encode straight into the page cache
+        // without the data going through the I/O workers. Use `flushMapping` (unless the mapping is coherent) to make the writes durable.
+        void createFile(future_t<core::smart_refctd_ptr<IFile>>& future, path filename, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const size_t preallocatedSize);
+
+        //! Hint that the files are about to be loaded, returns immediately.
+        // Plain files get read ahead into the OS page cache and archive entries get decompressed into their archive's
+        // decompressed cache (if it has one enabled). This happens on a dedicated thread with the lowest CPU priority (and idle I/O priority
+        // on Linux, background mode on Windows), so the I/O workers serving actual reads never queue up behind a prefetch.
+        // Paths which don't exist are silently skipped.
+        void prefetch(std::span<const system::path> paths);
+
+        //! Makes writes through a non-coherent mapping of `file` reach the file, returns false on failure or if the file is not mapped
+        inline bool flushMapping(IFile* file, const size_t offset, const size_t size) {return m_caller->flushMapping(file,offset,size);}
+        //! Makes writes to the file done through other means visible in a non-coherent mapping, throws away any unflushed writes in the range!
+        inline bool invalidateMapping(IFile* file, const size_t offset, const size_t size) {return m_caller->invalidateMapping(file,offset,size);}
         
         // Create a IFileArchive from a IFile
         core::smart_refctd_ptr<IFileArchive> openFileArchive(core::smart_refctd_ptr<IFile>&& file, const std::string_view& password="");
@@ -127,26 +155,18 @@ class NBL_API2 ISystem : public core::IReferenceCounted
         }
 
         // After opening and archive, you must mount it if you want the global path lookup to work seamlessly.
-        inline void mount(core::smart_refctd_ptr<IFileArchive>&& archive, const system::path& pathAlias="")
-        {
-            if (pathAlias.empty())
-                m_cachedArchiveFiles.insert(archive->getDefaultAbsolutePath(),std::move(archive));
-            else
-                m_cachedArchiveFiles.insert(pathAlias,std::move(archive));
-        }
+        void mount(core::smart_refctd_ptr<IFileArchive>&& archive, const system::path& pathAlias="");
 
         //
-        inline void unmount(const IFileArchive* archive, const system::path& pathAlias = "")
-        {
-            auto dummy = reinterpret_cast<const core::smart_refctd_ptr<IFileArchive>&>(archive);
-            if (pathAlias.empty())
-                m_cachedArchiveFiles.removeObject(dummy,archive->getDefaultAbsolutePath());
-            else
-                m_cachedArchiveFiles.removeObject(dummy,pathAlias);
-        }
+        void unmount(const IFileArchive* archive, const system::path& pathAlias = "");
 
         void unmountBuiltins();
 
+        //! Archive lookups of paths are memoised until the next `mount` or `unmount`. The ones which found nothing are only remembered
+        // when no directory mounted with `CMountDirectoryArchive` could have had the file, new files there show up without any action.
+        // Call this if the contents of a mounted archive changed otherwise (e.g. files got removed from a mounted directory).
+        void invalidateArchiveLookupCache();
+
         //
         struct SystemInfo
         {
@@ -165,30 +185,46 @@ class NBL_API2 ISystem : public core::IReferenceCounted
         
 
     protected:
-        // all file operations take place serially on a dedicated thread (to make fibers possible in the future)
+        // all file operations take place on a pool of dedicated threads (to make fibers possible in the future)
         class ICaller : public core::IReferenceCounted
         {
             public:
-                // each per-platform backend must override this function
-                virtual core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags) = 0;
+                // each per-platform backend must override this function, `preallocatedSize` is only non-zero for files created with `ECF_WRITE`
+                virtual core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const size_t preallocatedSize) = 0;
 
                 // these contain some hoisted common sense checks
                 bool invalidateMapping(IFile* file, size_t offset, size_t size);
                 bool flushMapping(IFile* file, size_t offset, size_t size);
 
+                // Backends capable of keeping many requests in flight can take over an unmapped read or write,
+                // return `true` if you did and then complete the future with `signalCompletion` whenever its done.
+                // Returning `false` makes the dispatcher thread service the request synchronously via `ISystemFile::asyncRead/asyncWrite`.
+                // Must decline requests against files opened with `ECF_WRITE` unless completing them in the order they were made, see `dispatch`.
+                virtual bool submitRead(future_t<size_t>* future, ISystemFile* file, void* buffer, size_t offset, size_t size) {return false;}
+                virtual bool submitWrite(future_t<size_t>* future, ISystemFile* file, const void* buffer, size_t offset, size_t size) {return false;}
+
+                // should get the OS started on reading the file into its page cache and return without waiting for it
+                virtual void prefetch(const std::filesystem::path& filename) {}
+
             protected:
                 ICaller(ISystem* _system) : m_system(_system) {}
                 virtual ~ICaller() = default;
 
+                // can be called from any thread, but only once per future taken over by `submitRead` or `submitWrite`
+                static inline void signalCompletion(future_t<size_t>* future, const size_t bytesProcessed)
+                {
+                    future->set_deferred_result(bytesProcessed);
+                }
+
                 // TODO: maybe change the file type to `ISystemFile` ?
-                virtual bool invalidateMapping_impl(IFile* file, size_t offset, size_t size) { assert(false); return false; } // TODO
-                virtual bool flushMapping_impl(IFile* file, size_t offset, size_t size) { assert(false); return false; } // TODO
+                virtual bool invalidateMapping_impl(IFile* file, size_t offset, size_t size) {return false;}
+                virtual bool flushMapping_impl(IFile* file, size_t offset, size_t size) {return false;}
 
                 ISystem* m_system;
         };
 
-        //
-        explicit ISystem(core::smart_refctd_ptr<ICaller>&& caller);
+        // `ioWorkerCount` is the number of dispatcher threads servicing unmapped I/O, more than one lets independent reads overlap
+        explicit ISystem(core::smart_refctd_ptr<ICaller>&& caller, const uint32_t ioWorkerCount=1u);
         virtual ~ISystem() {}
 
         // given an `absolutePath` find the archive it belongs to
@@ -223,11 +259,14 @@ class NBL_API2 ISystem : public core::IReferenceCounted
 
             char filename[MAX_FILENAME_LENGTH] {};
             IFileBase::E_CREATE_FLAGS flags;
+            size_t preallocatedSize = 0ull;
         };
         struct SRequestParams_READ
         {
             using retval_t = size_t;
             void operator()(core::StorageTrivializer<retval_t>* retval, ICaller* _caller);
+            // returns whether the caller took over the completion of the future
+            bool submit(future_t<retval_t>* future, ICaller* _caller);
 
             ISystemFile* file;
             void* buffer;
@@ -238,6 +277,8 @@ class NBL_API2 ISystem : public core::IReferenceCounted
         {
             using retval_t = size_t;
             void operator()(core::StorageTrivializer<retval_t>* retval, ICaller* _caller);
+            // returns whether the caller took over the completion of the future
+            bool submit(future_t<retval_t>* future, ICaller* _caller);
 
             ISystemFile* file;
             const void* buffer;
@@ -266,14 +307,93 @@ class NBL_API2 ISystem : public core::IReferenceCounted
                     //waitForInitComplete(); init is a NOOP
                 }
 
-                void process_request(base_t::future_base_t* _future_base, SRequestType& req);
+                // returns false if the request got handed off to the caller to be completed asynchronously
+                bool process_request(base_t::future_base_t* _future_base, SRequestType& req);
 
                 void init() {}
         };
         // friendship needed to be able to know about the request types
         friend class ISystemFile;
 
-        CAsyncQueue m_dispatcher;
+        // Requests against the same `orderedFile` always go to the same worker, which executes them one after the other in the order they
+        // were made. This relies on `ICaller::submitRead/submitWrite` never taking over a request against a file opened with `ECF_WRITE`,
+        // the only files `ISystemFile` passes as `orderedFile`.
+        // Pass `nullptr` if the request can run concurrently with any other and it will get spread round-robin.
+        template<typename T, typename Params>
+        inline void dispatch(future_t<T>* future, const ISystemFile* orderedFile, Params&& params)
+        {
+            const uint32_t workerCount = m_dispatchers.size();
+            uint32_t workerIx;
+            if (orderedFile)
+            {
+                // pointers are aligned so we need to mix the bits before taking the modulo
+                const uint64_t hash = reinterpret_cast<uintptr_t>(orderedFile)*0x9E3779B97F4A7C15ull;
+                workerIx = (hash>>32u)%workerCount;
+            }
+            else
+                workerIx = m_nextDispatcher.fetch_add(1u,std::memory_order_relaxed)%workerCount;
+            m_dispatchers[workerIx]->request(future,std::forward<Params>(params));
+        }
+
+        core::smart_refctd_ptr<ICaller> m_caller;
+        std::atomic_uint32_t m_nextDispatcher = 0u;
+
+        // Prefix trie over the components of the mount aliases, resolving a path against it doesn't touch the filesystem
+        class CMountTrie
+        {
+            public:
+                void insert(const system::path& alias, IFileArchive* archive);
+                void remove(const system::path& alias, const IFileArchive* archive);
+
+                // only the lexical form of `normalPath` is considered, archives mounted deeper take precedence,
+                // `underDirectoryMount` gets set if a `CMountDirectoryArchive` was searched
+                FoundArchiveFile find(const system::path& normalPath, bool& underDirectoryMount) const;
+
+            private:
+                struct SNode
+                {
+                    core::unordered_map<std::string,uint32_t> children;
+                    // in order of mounting
+                    core::vector<IFileArchive*> archives;
+                };
+                // root is the empty path, nodes never get removed so indices stay stable
+                core::vector<SNode> m_nodes = core::vector<SNode>(1);
+        };
+
+        // whatever can't keep up gets dropped, prefetching is only ever a hint
+        class CPrefetchQueue final
+        {
+            public:
+                constexpr static inline size_t MaxPending = 0x1ull<<12u;
+
+                inline CPrefetchQueue(ISystem* _system) : m_system(_system) {}
+                ~CPrefetchQueue();
+
+                void push(std::span<const system::path> paths);
+
+            private:
+                void workerMain();
+
+                ISystem* const m_system;
+                std::mutex m_mutex;
+                std::condition_variable m_cv;
+                core::deque<system::path> m_pending;
+                // started on first use
+                std::thread m_thread;
+                bool m_quit = false;
+        };
+        void prefetch_impl(const system::path& filename);
+
+        mutable std::shared_mutex m_mountMutex;
+        CMountTrie m_mountTrie;
+        // memoised `findFileInArchive` keyed by the path as it was asked for
+        mutable core::unordered_map<std::string,FoundArchiveFile> m_archiveLookupCache;
+        // bumped whenever the cache gets cleared, so lookups resolved before then don't get memoised
+        uint64_t m_mountGeneration = 0ull;
+        // needs to be destroyed (threads joined) before anything else
+        core::vector<std::unique_ptr<CAsyncQueue>> m_dispatchers;
+        // prefetches can go through archives which need the dispatchers, so this goes first
+        CPrefetchQueue m_prefetchQueue = CPrefetchQueue(this);
 };
 
 }
@@ -31,7 +31,8 @@ class ISystemFile : public IFile
 			params.file = this;
 			params.offset = offset;
 			params.size = sizeToRead;
-			m_system->m_dispatcher.request(&fut,params);
+			// reads from a file nobody can write to can be serviced in any order
+			m_system->dispatch(&fut,(getFlags()&ECF_WRITE) ? this:nullptr,params);
 		}
 		inline void unmappedWrite(ISystem::future_t<size_t>& fut, const void* buffer, size_t offset, size_t sizeToWrite) override final
 		{
@@ -40,7 +41,7 @@ class ISystemFile : public IFile
 			params.file = this;
 			params.offset = offset;
 			params.size = sizeToWrite;
-			m_system->m_dispatcher.request(&fut,params);
+			m_system->dispatch(&fut,this,params);
 		}
 
 		//
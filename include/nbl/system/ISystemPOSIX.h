@@ -13,15 +13,22 @@ namespace nbl::system
 class ISystemPOSIX : public ISystem
 {
     protected:
-        class CCaller final : public ISystem::ICaller
+        class CCaller : public ISystem::ICaller
         {
             public:
                 inline CCaller(ISystemPOSIX* _system) : ICaller(_system) {}
 
-                NBL_API2 core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags) override;
+                NBL_API2 core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags, const size_t preallocatedSize) override;
+                NBL_API2 void prefetch(const std::filesystem::path& filename) override;
+
+            protected:
+                NBL_API2 bool invalidateMapping_impl(IFile* file, size_t offset, size_t size) override;
+                NBL_API2 bool flushMapping_impl(IFile* file, size_t offset, size_t size) override;
         };
 
-        inline ISystemPOSIX() : ISystem(core::make_smart_refctd_ptr<CCaller>(this)) {}
+        inline ISystemPOSIX(const uint32_t ioWorkerCount=1u) : ISystem(core::make_smart_refctd_ptr<CCaller>(this),ioWorkerCount) {}
+        // for platforms which can provide a better I/O backend than the plain synchronous POSIX one
+        inline ISystemPOSIX(core::smart_refctd_ptr<CCaller>&& caller, const uint32_t ioWorkerCount=1u) : ISystem(std::move(caller),ioWorkerCount) {}
 };
 #endif
 
@@ -0,0 +1,79 @@
+#ifndef _NBL_SYSTEM_S_LZ4_PACK_FORMAT_H_INCLUDED_
+#define _NBL_SYSTEM_S_LZ4_PACK_FORMAT_H_INCLUDED_
+
+#include <cstdint>
+#include <string_view>
+
+// On-disk layout of the LZ4 block compressed asset pack, shared between `CArchiveLoaderLZ4Pack` and `tools/lz4pack`,
+// so this header must stay self-contained.
+//
+// Everything is little endian and 8 byte aligned, the table of contents gets used straight out of the mapped file:
+//		[SHeader][SEntry x entryCount][uint32_t x bucketCount][path characters][entry data ...]
+// Buckets are an open addressing hash table (linear probing) of entry indices, keyed by `hashPath` of the entry's path.
+// A stored entry's data is just its bytes. A compressed entry's data starts with `uint64_t blockEnd[blockCount]`
+// (offsets relative to the end of that table), followed by independently compressed blocks of `blockSize` bytes each,
+// a block whose compressed size equals its uncompressed size is stored raw.
+namespace nbl::system::lz4pack
+{
+
+constexpr inline char Magic[8] = {'N','B','L','L','Z','4','P','K'};
+constexpr inline uint32_t Version = 1u;
+constexpr inline uint32_t DefaultBlockSize = 0x1u<<16u;
+constexpr inline uint32_t InvalidEntry = ~0u;
+
+struct SHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t blockSize;
+	uint32_t entryCount;
+	// always a power of two
+	uint32_t bucketCount;
+	uint64_t stringsOffset;
+	uint64_t stringsSize;
+};
+static_assert(sizeof(SHeader)==40);
+
+struct SEntry
+{
+	enum E_FLAGS : uint32_t
+	{
+		EF_NONE = 0,
+		EF_LZ4_BLOCKS = 0x1u
+	};
+
+	uint64_t pathHash;
+	// relative to the start of the pack file
+	uint64_t dataOffset;
+	// bytes on disk, including the block table if compressed
+	uint64_t dataSize;
+	// uncompressed
+	uint64_t size;
+	// relative to `SHeader::stringsOffset`, not null terminated, always uses '/' as separator
+	uint32_t pathOffset;
+	uint32_t pathLength;
+	uint32_t flags;
+	uint32_t padding;
+};
+static_assert(sizeof(SEntry)==48);
+
+// FNV-1a, good enough for a hash table of file paths and trivial to reimplement in any tooling
+constexpr inline uint64_t hashPath(const std::string_view path)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const char c : path)
+	{
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+constexpr inline uint64_t getBlockCount(const uint64_t size, const uint32_t blockSize)
+{
+	return (size+blockSize-1ull)/blockSize;
+}
+
+}
+
+#endif
@@ -5,6 +5,10 @@
 #include <thread>
 #include <mutex> // for std::adopt_lock_t
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#endif
+
 namespace nbl::system
 {
 
@@ -20,11 +24,21 @@ namespace impl
         std::atomic_uint32_t m_lock = 0u;
     };
 
+    // tells the core (or its hyperthread sibling) that we're spinning
+    inline void cpu_relax()
+    {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
 }
 
-template <std::memory_order, std::memory_order>
+template <std::memory_order, std::memory_order, class>
 class read_lock_guard;
-template <std::memory_order, std::memory_order>
+template <std::memory_order, std::memory_order, class>
 class write_lock_guard;
 
 class SReadWriteSpinLock : protected impl::SReadWriteSpinLockBase
@@ -43,10 +57,20 @@ class SReadWriteSpinLock : protected impl::SReadWriteSpinLockBase
         }
     }
 
+    // for the guards' conversion constructors
+    void downgrade_write_to_read(std::memory_order rmw_order)
+    {
+        m_lock.fetch_sub(impl::SReadWriteSpinLockBase::LockWriteVal - 1u, rmw_order);
+    }
+    void upgrade_read_to_write(std::memory_order rmw_order)
+    {
+        lock_write_impl(1u, rmw_order);
+    }
+
 public:
-    template <std::memory_order, std::memory_order>
+    template <std::memory_order, std::memory_order, class>
     friend class read_lock_guard;
-    template <std::memory_order, std::memory_order>
+    template <std::memory_order, std::memory_order, class>
     friend class write_lock_guard;
 
     void lock_read(std::memory_order rmw_order = std::memory_order_seq_cst, std::memory_order ld_order = std::memory_order_seq_cst)
@@ -76,8 +100,112 @@ public:
     }
 };
 
+//! Drop-in replacement for `SReadWriteSpinLock` for locks which may be held for a while or by more threads than there are cores.
+/** Waiters spin with exponential backoff for a bit, then park on `std::atomic::wait` (a futex on Linux, `WaitOnAddress` on Windows)
+instead of burning their time slice. A writer announces itself as soon as it starts waiting, and no new readers get in while any writer
+is waiting, so a steady stream of readers cannot starve writers, but also a thread must not take a read lock it already holds again.
+Unlocking only issues a wake-up syscall if somebody actually parked. Use it with the same `read_lock_guard` and `write_lock_guard`. */
+class SReadWriteParkingLock
+{
+    // 20 bits of readers, 10 bits of waiting writers, a flag for anyone parked and the writer bit on top
+    static inline constexpr uint32_t ReaderMask = (1u << 20) - 1u;
+    static inline constexpr uint32_t WaitingWriterVal = (1u << 20);
+    static inline constexpr uint32_t WaitingWriterMask = ((1u << 10) - 1u) << 20;
+    static inline constexpr uint32_t ParkedVal = (1u << 30);
+    static inline constexpr uint32_t LockWriteVal = (1u << 31);
+    // doubles every round, after the last one we park
+    static inline constexpr uint32_t MaxBackoffSpins = 1u << 10;
+
+    std::atomic_uint32_t m_lock = 0u;
+
+    // spins with backoff while `blocked(state)`, then parks, returns the first state which is not blocked
+    template<typename Blocked>
+    uint32_t wait_while(Blocked&& blocked, std::memory_order ld_order)
+    {
+        uint32_t state = m_lock.load(ld_order);
+        for (uint32_t spins=1u; blocked(state); state=m_lock.load(ld_order))
+        {
+            if (spins <= MaxBackoffSpins)
+            {
+                for (uint32_t i=0u; i<spins; i++)
+                    impl::cpu_relax();
+                spins <<= 1u;
+                continue;
+            }
+            // an unlock in between makes the CAS or the `wait` itself fail, so no wake-up can get lost
+            if ((state & ParkedVal) || m_lock.compare_exchange_weak(state, state | ParkedVal, std::memory_order_relaxed))
+                m_lock.wait(state | ParkedVal, std::memory_order_relaxed);
+        }
+        return state;
+    }
+
+    void wake_parked(const uint32_t prevState)
+    {
+        if (prevState & ParkedVal)
+        {
+            m_lock.fetch_and(~ParkedVal, std::memory_order_relaxed);
+            m_lock.notify_all();
+        }
+    }
+
+    // `readers` is the number of read locks the caller itself holds
+    void lock_write_impl(const uint32_t readers, std::memory_order rmw_order, std::memory_order ld_order)
+    {
+        m_lock.fetch_add(WaitingWriterVal, std::memory_order_relaxed);
+        uint32_t state;
+        do
+        {
+            state = wait_while([readers](const uint32_t s) -> bool {return (s & LockWriteVal) || (s & ReaderMask) != readers;}, ld_order);
+        } while (!m_lock.compare_exchange_weak(state, (state - WaitingWriterVal - readers) | LockWriteVal, rmw_order, std::memory_order_relaxed));
+    }
+
+    void downgrade_write_to_read(std::memory_order rmw_order)
+    {
+        wake_parked(m_lock.fetch_sub(LockWriteVal - 1u, rmw_order));
+    }
+    void upgrade_read_to_write(std::memory_order rmw_order)
+    {
+        lock_write_impl(1u, rmw_order, std::memory_order_relaxed);
+    }
+
+public:
+    template <std::memory_order, std::memory_order, class>
+    friend class read_lock_guard;
+    template <std::memory_order, std::memory_order, class>
+    friend class write_lock_guard;
+
+    void lock_read(std::memory_order rmw_order = std::memory_order_seq_cst, std::memory_order ld_order = std::memory_order_seq_cst)
+    {
+        uint32_t state;
+        do
+        {
+            state = wait_while([](const uint32_t s) -> bool {return s & (LockWriteVal | WaitingWriterMask);}, ld_order);
+        } while (!m_lock.compare_exchange_weak(state, state + 1u, rmw_order, std::memory_order_relaxed));
+    }
+
+    void unlock_read(std::memory_order rmw_order = std::memory_order_seq_cst)
+    {
+        const uint32_t prevState = m_lock.fetch_sub(1u, rmw_order);
+        // the last reader out lets writers in, the second to last an upgrader (which waits for its own read lock to be the only one left)
+        const uint32_t prevReaders = prevState & ReaderMask;
+        if (prevReaders == 1u || (prevReaders == 2u && (prevState & WaitingWriterMask)))
+            wake_parked(prevState);
+    }
+
+    void lock_write(std::memory_order rmw_order = std::memory_order_seq_cst)
+    {
+        lock_write_impl(0u, rmw_order, std::memory_order_relaxed);
+    }
+
+    void unlock_write(std::memory_order rmw_order = std::memory_order_seq_cst)
+    {
+        wake_parked(m_lock.fetch_sub(LockWriteVal, rmw_order));
+    }
+};
+
 namespace impl
 {
+    template <class Lock>
     class rw_lock_guard_base
     {
         rw_lock_guard_base() : m_lock(nullptr) {}
@@ -97,22 +225,24 @@ namespace impl
         }
 
     protected:
-        rw_lock_guard_base(SReadWriteSpinLock& lk) noexcept : m_lock(&lk) {}
+        rw_lock_guard_base(Lock& lk) noexcept : m_lock(&lk) {}
 
-        SReadWriteSpinLock* m_lock;
+        Lock* m_lock;
     };
 }
 
-template <std::memory_order LoadOrder = std::memory_order_seq_cst, std::memory_order ReadModWriteOrder = std::memory_order_seq_cst>
-class read_lock_guard : public impl::rw_lock_guard_base
+template <std::memory_order LoadOrder = std::memory_order_seq_cst, std::memory_order ReadModWriteOrder = std::memory_order_seq_cst, class Lock = SReadWriteSpinLock>
+class read_lock_guard : public impl::rw_lock_guard_base<Lock>
 {
+    using impl::rw_lock_guard_base<Lock>::m_lock;
+
 public:
-    read_lock_guard(SReadWriteSpinLock& lk, std::adopt_lock_t) : impl::rw_lock_guard_base(lk) {}
-    explicit read_lock_guard(SReadWriteSpinLock& lk) : read_lock_guard(lk, std::adopt_lock_t())
+    read_lock_guard(Lock& lk, std::adopt_lock_t) : impl::rw_lock_guard_base<Lock>(lk) {}
+    explicit read_lock_guard(Lock& lk) : read_lock_guard(lk, std::adopt_lock_t())
     {
         m_lock->lock_read(ReadModWriteOrder, LoadOrder);
     }
-    explicit read_lock_guard(write_lock_guard<LoadOrder, ReadModWriteOrder>&& wl);
+    explicit read_lock_guard(write_lock_guard<LoadOrder, ReadModWriteOrder, Lock>&& wl);
 
     ~read_lock_guard()
     {
@@ -121,16 +251,18 @@ public:
     }
 };
 
-template <std::memory_order LoadOrder = std::memory_order_seq_cst, std::memory_order ReadModWriteOrder = std::memory_order_seq_cst>
-class write_lock_guard : public impl::rw_lock_guard_base
+template <std::memory_order LoadOrder = std::memory_order_seq_cst, std::memory_order ReadModWriteOrder = std::memory_order_seq_cst, class Lock = SReadWriteSpinLock>
+class write_lock_guard : public impl::rw_lock_guard_base<Lock>
 {
+    using impl::rw_lock_guard_base<Lock>::m_lock;
+
 public:
-    write_lock_guard(SReadWriteSpinLock& lk, std::adopt_lock_t) : impl::rw_lock_guard_base(lk) {}
-    explicit write_lock_guard(SReadWriteSpinLock& lk) : write_lock_guard(lk, std::adopt_lock_t())
+    write_lock_guard(Lock& lk, std::adopt_lock_t) : impl::rw_lock_guard_base<Lock>(lk) {}
+    explicit write_lock_guard(Lock& lk) : write_lock_guard(lk, std::adopt_lock_t())
     {
         m_lock->lock_write(ReadModWriteOrder);
     }
-    explicit write_lock_guard(read_lock_guard<LoadOrder, ReadModWriteOrder>&& rl);
+    explicit write_lock_guard(read_lock_guard<LoadOrder, ReadModWriteOrder, Lock>&& rl);
 
     ~write_lock_guard()
     {
@@ -139,16 +271,16 @@ public:
     }
 };
 
-template <std::memory_order LoadOrder, std::memory_order ReadModWriteOrder>
-inline read_lock_guard<LoadOrder, ReadModWriteOrder>::read_lock_guard(write_lock_guard<LoadOrder, ReadModWriteOrder>&& wl) : impl::rw_lock_guard_base(std::move(wl))
+template <std::memory_order LoadOrder, std::memory_order ReadModWriteOrder, class Lock>
+inline read_lock_guard<LoadOrder, ReadModWriteOrder, Lock>::read_lock_guard(write_lock_guard<LoadOrder, ReadModWriteOrder, Lock>&& wl) : impl::rw_lock_guard_base<Lock>(std::move(wl))
 {
-    m_lock->m_lock.fetch_sub(impl::SReadWriteSpinLockBase::LockWriteVal - 1u, ReadModWriteOrder);
+    m_lock->downgrade_write_to_read(ReadModWriteOrder);
 }
 
-template <std::memory_order LoadOrder, std::memory_order ReadModWriteOrder>
-inline write_lock_guard<LoadOrder, ReadModWriteOrder>::write_lock_guard(read_lock_guard<LoadOrder, ReadModWriteOrder>&& rl) : impl::rw_lock_guard_base(std::move(rl))
+template <std::memory_order LoadOrder, std::memory_order ReadModWriteOrder, class Lock>
+inline write_lock_guard<LoadOrder, ReadModWriteOrder, Lock>::write_lock_guard(read_lock_guard<LoadOrder, ReadModWriteOrder, Lock>&& rl) : impl::rw_lock_guard_base<Lock>(std::move(rl))
 {
-    m_lock->lock_write_impl(1u, ReadModWriteOrder);
+    m_lock->upgrade_read_to_write(ReadModWriteOrder);
 }
 
 }
@@ -10,14 +10,37 @@
 #include "nbl/asset/utils/CDerivativeMapCreator.h"
 #include "nbl/asset/utils/IMeshManipulator.h"
 
+#include "nbl/system/CFileView.h"
+
 #include "simdjson/singleheader/simdjson.h"
 #include <algorithm>
+#include <atomic>
 
 #include "nbl/core/execution.h"
 
 using namespace nbl;
 using namespace nbl::asset;
 
+namespace
+{
+
+// the "memory" of a buffer aliasing a mapped file is the file, this keeps it alive for as long as the buffer is
+class CMappedFileAllocator : public core::AllocatorTrivialBase<uint8_t>
+{
+	public:
+		CMappedFileAllocator(core::smart_refctd_ptr<system::IFile>&& _file) : m_file(std::move(_file)) {}
+
+		inline void deallocate(pointer p, size_t n) noexcept
+		{
+			m_file = nullptr;
+		}
+
+	private:
+		core::smart_refctd_ptr<system::IFile> m_file;
+};
+
+}
+
 		enum WEIGHT_ENCODING
 		{
 			WE_UNORM8,
@@ -113,29 +136,41 @@ using namespace nbl::asset;
 		
 		bool CGLTFLoader::isALoadableFileFormat(system::IFile* _file, const system::logger_opt_ptr logger) const
 		{
-			simdjson::dom::parser parser;
-
-			auto jsonBuffer = core::make_smart_refctd_ptr<ICPUBuffer>(_file->getSize());
+			// only a prefix gets looked at, `loadAsset` is the one which parses and validates the whole document
+			char prefix[SniffPrefixSize];
+			const size_t prefixSize = core::min<size_t>(_file->getSize(),sizeof(prefix));
 			{
 				system::IFile::success_t success;
-				_file->read(success, jsonBuffer->getPointer(), 0u, jsonBuffer->getSize());
+				_file->read(success, prefix, 0u, prefixSize);
 				if (!success)
 					return false;
 			}
 
-			simdjson::dom::object tweets;
-			auto error = parser.parse(reinterpret_cast<uint8_t*>(jsonBuffer->getPointer()), jsonBuffer->getSize()).get(tweets);
-
-			if (error)
+			if (prefixSize>=sizeof(glb::SHeader))
 			{
-				logger.log("Could not parse '" + _file->getFileName().string() + "' file!");
-				return false;
+				glb::SHeader header;
+				memcpy(&header,prefix,sizeof(header));
+				if (header.magic==glb::Magic)
+					return header.version==glb::Version;
 			}
 
-			simdjson::dom::element element;
-			if (tweets.at_key("asset").get(element) == simdjson::error_code::SUCCESS)
-				if (element.at_key("version").get(element) == simdjson::error_code::SUCCESS)
-					return true;
+			std::string_view json(prefix,prefixSize);
+
+			constexpr std::string_view UTF8BOM = "\xEF\xBB\xBF";
+			if (json.starts_with(UTF8BOM))
+				json.remove_prefix(UTF8BOM.size());
+			const auto objectBegin = json.find_first_not_of(" \t\r\n");
+			if (objectBegin==std::string_view::npos || json[objectBegin]!='{')
+				return false;
+
+			// `asset` is the only required top-level property, but nothing forces exporters to write it first
+			if (json.find("\"asset\"")!=std::string_view::npos)
+				return true;
+			if (prefixSize==_file->getSize())
+				return false;
+			for (const auto key : {"\"accessors\"","\"bufferViews\"","\"buffers\"","\"extensionsUsed\"","\"meshes\"","\"nodes\"","\"scenes\""})
+			if (json.find(key)!=std::string_view::npos)
+				return true;
 
 			return false;
 		}
@@ -151,87 +186,218 @@ using namespace nbl::asset;
 			*/
 			SContext context(overrideAssetLoadParams, _file, _override, _hierarchyLevel);
 
+			// a .glb is a JSON chunk and an optional BIN chunk, a .gltf is just the JSON
+			size_t jsonOffset = 0ull;
+			size_t jsonSize = _file->getSize();
+			core::smart_refctd_ptr<ICPUBuffer> glbBinBuffer;
+			{
+				glb::SHeader header = {};
+				if (_file->getSize()>=sizeof(header))
+				{
+					system::IFile::success_t success;
+					_file->read(success, &header, 0u, sizeof(header));
+					if (!success)
+						return {};
+				}
+				if (header.magic==glb::Magic)
+				{
+					if (!readGLBChunks(context,header,jsonOffset,jsonSize,glbBinBuffer))
+						return {};
+				}
+			}
+
 			SGLTF glTF;
-			if(!loadAndGetGLTF(glTF, context))
+			if(!loadAndGetGLTF(glTF, context, jsonOffset, jsonSize))
 				return {};
 
-			core::vector<core::smart_refctd_ptr<ICPUBuffer>> cpuBuffers;
-			for (auto& glTFBuffer : glTF.buffers)
+			// the buffers and images are all listed up front, get them read ahead while they get loaded one by one
 			{
-				// FarFuture TODO: handle buffer embedded in glTF
-				auto buffer_bundle = interm_getAssetInHierarchy(assetManager,glTFBuffer.uri.value(),context.loadContext.params,_hierarchyLevel+ICPUMesh::BUFFER_HIERARCHYLEVELS_BELOW,_override);
-				if (buffer_bundle.getContents().empty())
-					return {};
-
-				auto cpuBuffer = core::smart_refctd_ptr_static_cast<ICPUBuffer>(buffer_bundle.getContents().begin()[0]);
-				cpuBuffers.emplace_back() = core::smart_refctd_ptr<ICPUBuffer>(cpuBuffer);
+				core::vector<system::path> dependencies;
+				auto addDependency = [&](const std::optional<std::string>& uri) -> void
+				{
+					// embedded data has nothing to prefetch
+					if (uri.has_value() && !uri->starts_with("data:"))
+						dependencies.push_back(context.loadContext.params.workingDirectory/uri.value());
+				};
+				for (const auto& glTFBuffer : glTF.buffers)
+					addDependency(glTFBuffer.uri);
+				for (const auto& glTFImage : glTF.images)
+					addDependency(glTFImage.uri);
+				assetManager->getSystem()->prefetch(dependencies);
 			}
 
+			const auto bufferHierarchyLevel = _hierarchyLevel+ICPUMesh::BUFFER_HIERARCHYLEVELS_BELOW;
 			const auto imageViewHierarchyLevel = _hierarchyLevel+ICPUMesh::IMAGEVIEW_HIERARCHYLEVELS_BELOW;
-			core::vector<core::smart_refctd_ptr<ICPUImageView>> cpuImageViews;
+			core::vector<core::smart_refctd_ptr<ICPUBuffer>> cpuBuffers(glTF.buffers.size());
+			core::vector<core::smart_refctd_ptr<ICPUImageView>> cpuImageViews(glTF.images.size());
 			{
-				for (auto& glTFImage : glTF.images)
+				// all of the buffers and images which are not cached yet get loaded at once, each of them is another file to read and decode
+				struct Fetch
 				{
-					auto& cpuImageView = cpuImageViews.emplace_back();
-
-					// FarFuture TODO: handle image embedded in glTF 
+					std::string name;
+					uint32_t hierarchyLevel;
+					// images stored in a buffer view get decoded from memory, once the buffers are there
+					std::optional<size_t> bufferView = {};
+					SAssetBundle bundle = {};
+				};
+				core::vector<Fetch> fetches;
+				core::unordered_map<std::string_view,uint32_t> bufferFetchIDs;
+				core::vector<uint32_t> bufferFetches(glTF.buffers.size(),~0u);
+				for (auto i=0u; i<glTF.buffers.size(); i++)
+				{
+					const auto& glTFBuffer = glTF.buffers[i];
+					if (!glTFBuffer.uri.has_value())
+					{
+						// only the first buffer can refer to the BIN chunk of a .glb
+						if (i!=0u || !glbBinBuffer || glTFBuffer.byteLength.value_or(0u)>glbBinBuffer->getSize())
+						{
+							context.loadContext.params.logger.log("GLTF: BUFFER WITHOUT URI WHICH IS NOT THE BIN CHUNK OF A GLB!",system::ILogger::ELL_ERROR);
+							return {};
+						}
+						cpuBuffers[i] = glbBinBuffer;
+						continue;
+					}
+					// FarFuture TODO: handle buffer embedded in glTF as a data uri
+					const auto& uri = glTFBuffer.uri.value();
+					// the same file requested twice at once would get loaded twice, the asset cache only catches that when loading one by one
+					const auto found = bufferFetchIDs.try_emplace(uri,fetches.size());
+					if (found.second)
+						fetches.push_back({uri,bufferHierarchyLevel});
+					bufferFetches[i] = found.first->second;
+				}
+				core::vector<std::string> imageNames(glTF.images.size());
+				core::unordered_map<std::string_view,uint32_t> imageFetchIDs;
+				core::vector<uint32_t> imageFetches(glTF.images.size(),~0u);
+				for (auto i=0u; i<glTF.images.size(); i++)
+				{
+					const auto& glTFImage = glTF.images[i];
 					// TODO: factor this out to be common for all PipelineLoaders https://github.com/Devsh-Graphics-Programming/Nabla/issues/270
+					std::optional<size_t> bufferView;
 					if (glTFImage.uri.has_value())
+						imageNames[i] = glTFImage.uri.value();
+					else
 					{
-						// TODO: THIS IS AN ABSOLUTELY WRONG CACHE PRE-PATH KEY TO USE!
-						const std::string cpuImageViewCacheKey = getImageViewCacheKey(glTFImage.uri.value());
-
-						cpuImageView = _override->findDefaultAsset<ICPUImageView>(cpuImageViewCacheKey,context.loadContext,imageViewHierarchyLevel).first;
-						if (!cpuImageView)
+						if (!glTFImage.mimeType.has_value() || !glTFImage.bufferView.has_value())
+						{
+							context.loadContext.params.logger.log("GLTF: IMAGE WITHOUT URI NEEDS A MIME TYPE AND A BUFFER VIEW!",system::ILogger::ELL_ERROR);
+							return {};
+						}
+						bufferView = glTFImage.bufferView;
+						if (bufferView.value()>=glTF.bufferViews.size())
 						{
-							auto image_bundle = interm_getAssetInHierarchy(assetManager,glTFImage.uri.value(),context.loadContext.params,imageViewHierarchyLevel,_override);
-							if (image_bundle.getContents().empty())
-								return {};
+							context.loadContext.params.logger.log("GLTF: INVALID BUFFER VIEW OF AN EMBEDDED IMAGE!",system::ILogger::ELL_ERROR);
+							return {};
+						}
+						// made up, but unique to the file and with an extension the image loaders will recognise
+						const auto& mimeType = glTFImage.mimeType.value();
+						const char* extension = mimeType==SGLTF::SGLTFImage::SMIMEType::PNG ? ".png":(mimeType==SGLTF::SGLTFImage::SMIMEType::JPEG ? ".jpg":"");
+						imageNames[i] = _file->getFileName().string()+"#images["+std::to_string(i)+"]"+extension;
+					}
 
-							auto cpuAsset = image_bundle.getContents().begin()[0];
+					// TODO: THIS IS AN ABSOLUTELY WRONG CACHE PRE-PATH KEY TO USE!
+					cpuImageViews[i] = _override->findDefaultAsset<ICPUImageView>(getImageViewCacheKey(imageNames[i]),context.loadContext,imageViewHierarchyLevel).first;
+					if (cpuImageViews[i])
+						continue;
+					const auto found = imageFetchIDs.try_emplace(imageNames[i],fetches.size());
+					if (found.second)
+						fetches.push_back({imageNames[i],imageViewHierarchyLevel,bufferView});
+					imageFetches[i] = found.first->second;
+				}
 
-							switch (cpuAsset->getAssetType())
-							{
-								case IAsset::ET_IMAGE:
-								{
-									ICPUImageView::SCreationParams viewParams;
-									viewParams.flags = static_cast<ICPUImageView::E_CREATE_FLAGS>(0u);
-									viewParams.image = core::smart_refctd_ptr_static_cast<asset::ICPUImage>(cpuAsset);
-									viewParams.format = viewParams.image->getCreationParameters().format;
-									viewParams.viewType = IImageView<ICPUImage>::ET_2D;
-									viewParams.subresourceRange.baseArrayLayer = 0u;
-									viewParams.subresourceRange.layerCount = 1u;
-									viewParams.subresourceRange.baseMipLevel = 0u;
-									viewParams.subresourceRange.levelCount = 1u;
-
-									cpuImageView = ICPUImageView::create(std::move(viewParams));
-								} break;
+				// the embedded images need the buffers, so they go in a second round
+				core::vector<uint32_t> fetchIDs[2];
+				for (auto fetchID=0u; fetchID<fetches.size(); fetchID++)
+					fetchIDs[fetches[fetchID].bufferView.has_value()].push_back(fetchID);
+				core::for_each(core::execution::par,fetchIDs[0].begin(),fetchIDs[0].end(),[&](const uint32_t fetchID) -> void
+				{
+					auto& fetch = fetches[fetchID];
+					fetch.bundle = interm_getAssetInHierarchy(assetManager,fetch.name,context.loadContext.params,fetch.hierarchyLevel,_override);
+				});
 
-								case IAsset::ET_IMAGE_VIEW:
-								{
-									cpuImageView = core::smart_refctd_ptr_static_cast<asset::ICPUImageView>(cpuAsset);
-								} break;
+				for (auto i=0u; i<glTF.buffers.size(); i++)
+				{
+					// the BIN chunk
+					if (bufferFetches[i]==~0u)
+						continue;
+					const auto& buffer_bundle = fetches[bufferFetches[i]].bundle;
+					if (buffer_bundle.getContents().empty())
+						return {};
 
-								default:
-								{
-									context.loadContext.params.logger.log("GLTF: EXPECTED IMAGE ASSET TYPE!",system::ILogger::ELL_ERROR);
-									return {};
-								}
-							}
+					cpuBuffers[i] = core::smart_refctd_ptr_static_cast<ICPUBuffer>(buffer_bundle.getContents().begin()[0]);
+				}
 
-							// TODO: this is wrong, it adds a loaded image view (the second switch case) to the cache again, move this insertion to the first switch case
-							SAssetBundle samplerBundle = SAssetBundle(nullptr, { core::smart_refctd_ptr(cpuImageView) });
-							_override->insertAssetIntoCache(samplerBundle,cpuImageViewCacheKey,context.loadContext,imageViewHierarchyLevel);
-						}	
+				for (const auto fetchID : fetchIDs[1])
+				{
+					const auto& glTFBufferView = glTF.bufferViews[fetches[fetchID].bufferView.value()];
+					const size_t byteOffset = glTFBufferView.byteOffset.value_or(0ull);
+					const size_t byteLength = glTFBufferView.byteLength.value_or(0ull);
+					if (!glTFBufferView.buffer.has_value() || glTFBufferView.buffer.value()>=cpuBuffers.size() || byteOffset+byteLength>cpuBuffers[glTFBufferView.buffer.value()]->getSize())
+					{
+						context.loadContext.params.logger.log("GLTF: INVALID BUFFER VIEW OF AN EMBEDDED IMAGE!",system::ILogger::ELL_ERROR);
+						return {};
 					}
-					else
+				}
+				core::for_each(core::execution::par,fetchIDs[1].begin(),fetchIDs[1].end(),[&](const uint32_t fetchID) -> void
+				{
+					auto& fetch = fetches[fetchID];
+					const auto& glTFBufferView = glTF.bufferViews[fetch.bufferView.value()];
+					const ICPUBuffer* buffer = cpuBuffers[glTFBufferView.buffer.value()].get();
+					// only ever read from
+					auto* data = const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(buffer->getPointer()))+glTFBufferView.byteOffset.value_or(0ull);
+					auto file = core::make_smart_refctd_ptr<system::CFileView<system::CNullAllocator>>(system::path(fetch.name),system::IFile::ECF_READ,_file->getLastWriteTime(),data,glTFBufferView.byteLength.value_or(0ull));
+					fetch.bundle = interm_getAssetInHierarchy(assetManager,file.get(),fetch.name,context.loadContext.params,fetch.hierarchyLevel,_override);
+				});
+
+				for (auto i=0u; i<glTF.images.size(); i++)
+				{
+					// cached already
+					if (imageFetches[i]==~0u)
+						continue;
+					auto& cpuImageView = cpuImageViews[i];
+					// an earlier image with the same uri has already made the view
+					const std::string cpuImageViewCacheKey = getImageViewCacheKey(imageNames[i]);
+					cpuImageView = _override->findDefaultAsset<ICPUImageView>(cpuImageViewCacheKey,context.loadContext,imageViewHierarchyLevel).first;
+					if (cpuImageView)
+						continue;
+
+					const auto& image_bundle = fetches[imageFetches[i]].bundle;
+					if (image_bundle.getContents().empty())
+						return {};
+
+					auto cpuAsset = image_bundle.getContents().begin()[0];
+
+					switch (cpuAsset->getAssetType())
 					{
-						if (!glTFImage.mimeType.has_value() || !glTFImage.bufferView.has_value())
+						case IAsset::ET_IMAGE:
+						{
+							ICPUImageView::SCreationParams viewParams;
+							viewParams.flags = static_cast<ICPUImageView::E_CREATE_FLAGS>(0u);
+							viewParams.image = core::smart_refctd_ptr_static_cast<asset::ICPUImage>(cpuAsset);
+							viewParams.format = viewParams.image->getCreationParameters().format;
+							viewParams.viewType = IImageView<ICPUImage>::ET_2D;
+							viewParams.subresourceRange.baseArrayLayer = 0u;
+							viewParams.subresourceRange.layerCount = 1u;
+							viewParams.subresourceRange.baseMipLevel = 0u;
+							viewParams.subresourceRange.levelCount = 1u;
+
+							cpuImageView = ICPUImageView::create(std::move(viewParams));
+						} break;
+
+						case IAsset::ET_IMAGE_VIEW:
+						{
+							cpuImageView = core::smart_refctd_ptr_static_cast<asset::ICPUImageView>(cpuAsset);
+						} break;
+
+						default:
+						{
+							context.loadContext.params.logger.log("GLTF: EXPECTED IMAGE ASSET TYPE!",system::ILogger::ELL_ERROR);
 							return {};
-						
-						_NBL_DEBUG_BREAK_IF(true);
-						return {}; // TODO FUTURE: load image where it's data is embeded in memory
+						}
 					}
+
+					// TODO: this is wrong, it adds a loaded image view (the second switch case) to the cache again, move this insertion to the first switch case
+					SAssetBundle samplerBundle = SAssetBundle(nullptr, { core::smart_refctd_ptr(cpuImageView) });
+					_override->insertAssetIntoCache(samplerBundle,cpuImageViewCacheKey,context.loadContext,imageViewHierarchyLevel);
 				}
 			}
 			
@@ -690,11 +856,23 @@ using namespace nbl::asset;
 			core::vector<core::smart_refctd_ptr<ICPUMesh>> cpuMeshes;
 			{
 				// go over all meshes and create ICPUMeshes & ICPUMeshBuffers but without skins attached
-				core::vector<core::smart_refctd_ptr<ICPUMesh>> meshesView;
+				core::vector<core::smart_refctd_ptr<ICPUMesh>> meshesView(glTF.meshes.size());
 				{
-					for (const auto& glTFMesh : glTF.meshes)
+					// the pipelines get looked up and cached after all meshes are done, so the cache sees them in the same order as before
+					struct PipelineRequest
+					{
+						SVertexInputParams vertexInputParams;
+						E_PRIMITIVE_TOPOLOGY primitiveTopology;
+						bool skinningEnabled;
+						bool hasUV;
+						bool hasColor;
+					};
+					core::vector<core::vector<PipelineRequest>> pipelineRequests(glTF.meshes.size());
+					// meshes only ever read the buffers and materials, so they get assembled in parallel
+					auto assembleMesh = [&](const uint32_t meshID) -> bool
 					{
-						auto& cpuMesh = meshesView.emplace_back() = core::make_smart_refctd_ptr<ICPUMesh>();
+						const auto& glTFMesh = glTF.meshes[meshID];
+						auto& cpuMesh = meshesView[meshID] = core::make_smart_refctd_ptr<ICPUMesh>();
 
 						for (const auto& glTFprimitive : glTFMesh.primitives)
 						{
@@ -1534,12 +1712,33 @@ using namespace nbl::asset;
 								memcpy(cpuMeshBuffer->getPushConstantsDataPtr(),&material.pushConstants,sizeof(material.pushConstants));
 								cpuMeshBuffer->setAttachedDescriptorSet(core::smart_refctd_ptr(material.descriptorSet));
 							}
-							auto pipeline = getPipeline(context,primitiveTopology,vertexInputParams,skinningEnabled,hasUV,hasColor);
-							pipelineSet.insert(pipeline.get());
-							cpuMeshBuffer->setPipeline(std::move(pipeline));
+							pipelineRequests[meshID].push_back({vertexInputParams,primitiveTopology,skinningEnabled,hasUV,hasColor});
 
 							cpuMesh->getMeshBufferVector().push_back(std::move(cpuMeshBuffer));
 						}
+						return true;
+					};
+					core::vector<uint32_t> meshIDs(glTF.meshes.size());
+					std::iota(meshIDs.begin(),meshIDs.end(),0u);
+					std::atomic_bool failed = false;
+					core::for_each(core::execution::par,meshIDs.begin(),meshIDs.end(),[&](const uint32_t meshID) -> void
+					{
+						if (!failed.load(std::memory_order_relaxed) && !assembleMesh(meshID))
+							failed.store(true,std::memory_order_relaxed);
+					});
+					if (failed)
+						return {};
+
+					for (auto meshID=0u; meshID<glTF.meshes.size(); meshID++)
+					{
+						auto& meshBuffers = meshesView[meshID]->getMeshBufferVector();
+						for (auto i=0u; i<meshBuffers.size(); i++)
+						{
+							const auto& request = pipelineRequests[meshID][i];
+							auto pipeline = getPipeline(context,request.primitiveTopology,request.vertexInputParams,request.skinningEnabled,request.hasUV,request.hasColor);
+							pipelineSet.insert(pipeline.get());
+							meshBuffers[i]->setPipeline(std::move(pipeline));
+						}
 					}
 				}
 
@@ -1653,21 +1852,91 @@ using namespace nbl::asset;
 			return SAssetBundle(std::move(glTFMetadata), cpuMeshes);
 		}
 
-		bool CGLTFLoader::loadAndGetGLTF(SGLTF& glTF, SContext& context)
+		bool CGLTFLoader::readGLBChunks(SContext& context, const glb::SHeader& header, size_t& jsonOffset, size_t& jsonSize, core::smart_refctd_ptr<ICPUBuffer>& binBuffer) const
+		{
+			auto* _file = context.loadContext.mainFile;
+			const auto& logger = context.loadContext.params.logger;
+			if (header.version!=glb::Version || header.length>_file->getSize())
+			{
+				logger.log("GLTF: '%s' is not a valid glTF 2.0 binary container!",system::ILogger::ELL_ERROR,_file->getFileName().string().c_str());
+				return false;
+			}
+
+			// the length in the header is what counts, not the size of the file
+			auto readChunkHeader = [&](const size_t offset, glb::SChunkHeader& chunk) -> bool
+			{
+				if (offset+sizeof(chunk)>header.length)
+					return false;
+				system::IFile::success_t success;
+				_file->read(success, &chunk, offset, sizeof(chunk));
+				return success && offset+sizeof(chunk)+chunk.length<=header.length;
+			};
+
+			glb::SChunkHeader chunk;
+			size_t offset = sizeof(glb::SHeader);
+			if (!readChunkHeader(offset,chunk) || chunk.type!=glb::ECT_JSON)
+			{
+				logger.log("GLTF: '%s' does not start with a JSON chunk!",system::ILogger::ELL_ERROR,_file->getFileName().string().c_str());
+				return false;
+			}
+			jsonOffset = offset+sizeof(chunk);
+			jsonSize = chunk.length;
+
+			// chunks of unknown types have to be skipped
+			for (offset=jsonOffset+jsonSize; readChunkHeader(offset,chunk); offset+=sizeof(chunk)+chunk.length)
+			{
+				if (chunk.type!=glb::ECT_BIN)
+					continue;
+
+				const size_t binOffset = offset+sizeof(chunk);
+				if (const auto* mapped = reinterpret_cast<const uint8_t*>(static_cast<const system::IFile*>(_file)->getMappedPointer()))
+				{
+					// `ICPUBuffer` has no notion of read only memory, nothing in the loader writes to it though
+					auto* binData = const_cast<uint8_t*>(mapped)+binOffset;
+					binBuffer = core::make_smart_refctd_ptr<CCustomAllocatorCPUBuffer<CMappedFileAllocator,true>>(chunk.length,binData,core::adopt_memory,CMappedFileAllocator(core::smart_refctd_ptr<system::IFile>(_file)));
+				}
+				else
+				{
+					binBuffer = core::make_smart_refctd_ptr<ICPUBuffer>(chunk.length);
+					system::IFile::success_t success;
+					_file->read(success, binBuffer->getPointer(), binOffset, chunk.length);
+					if (!success)
+						return false;
+				}
+				break;
+			}
+			return true;
+		}
+
+		bool CGLTFLoader::loadAndGetGLTF(SGLTF& glTF, SContext& context, const size_t jsonOffset, const size_t jsonSize)
 		{
 			simdjson::dom::parser parser;
 			auto* _file = context.loadContext.mainFile;
 
-			auto jsonBuffer = core::make_smart_refctd_ptr<ICPUBuffer>(_file->getSize());
+			// read straight into a padded buffer, otherwise simdjson makes a padded copy of the whole document on its own
+			auto jsonBuffer = core::make_smart_refctd_ptr<ICPUBuffer>(jsonSize+simdjson::SIMDJSON_PADDING);
 			{
 				system::IFile::success_t success;
-				_file->read(success, jsonBuffer->getPointer(), 0u, jsonBuffer->getSize());
+				_file->read(success, jsonBuffer->getPointer(), jsonOffset, jsonSize);
 				if (!success)
 					return false;
 			}
+			memset(reinterpret_cast<uint8_t*>(jsonBuffer->getPointer())+jsonSize,0,simdjson::SIMDJSON_PADDING);
 
-			simdjson::dom::object tweets = parser.parse(reinterpret_cast<uint8_t*>(jsonBuffer->getPointer()), jsonBuffer->getSize());
+			simdjson::dom::object tweets;
+			constexpr bool ReallocIfNeeded = false;
+			if (parser.parse(reinterpret_cast<const uint8_t*>(jsonBuffer->getPointer()),jsonSize,ReallocIfNeeded).get(tweets))
+			{
+				context.loadContext.params.logger.log("GLTF: Could not parse '%s' file!",system::ILogger::ELL_ERROR,_file->getFileName().string().c_str());
+				return false;
+			}
 			simdjson::dom::element element;
+			// the format detection only sniffed a prefix, this is the validation it used to do
+			if (tweets.at_key("asset").get(element) || element.at_key("version").get(element))
+			{
+				context.loadContext.params.logger.log("GLTF: '%s' has no asset version, it is not a glTF file!",system::ILogger::ELL_ERROR,_file->getFileName().string().c_str());
+				return false;
+			}
 
 			//std::filesystem::path filePath(_file->getFileName().c_str());
 			//const std::string rootAssetDirectory = std::filesystem::absolute(filePath.remove_filename()).u8string();
@@ -1717,6 +1986,7 @@ using namespace nbl::asset;
 					auto& glTFBuffer = glTF.buffers.emplace_back();
 
 					const auto& uri = jsonBuffer.at_key("uri");
+					const auto& byteLength = jsonBuffer.at_key("byteLength");
 					const auto& name = jsonBuffer.at_key("name");
 					const auto& extensions = jsonBuffer.at_key("extensions");
 					const auto& extras = jsonBuffer.at_key("extras");
@@ -1724,6 +1994,9 @@ using namespace nbl::asset;
 					if (uri.error() != simdjson::error_code::NO_SUCH_FIELD)
 						glTFBuffer.uri = uri.get_string().value().data();
 
+					if (byteLength.error() != simdjson::error_code::NO_SUCH_FIELD)
+						glTFBuffer.byteLength = static_cast<uint32_t>(byteLength.get_uint64().value());
+
 					if (name.error() != simdjson::error_code::NO_SUCH_FIELD)
 						glTFBuffer.name = name.get_string().value();
 				}
@@ -1783,10 +2056,10 @@ using namespace nbl::asset;
 						glTFImage.uri = uri.get_string().value();
 
 					if (mimeType.error() != simdjson::error_code::NO_SUCH_FIELD)
-						glTFImage.mimeType = uri.get_string().value();
+						glTFImage.mimeType = mimeType.get_string().value();
 
 					if (bufferViewId.error() != simdjson::error_code::NO_SUCH_FIELD)
-						glTFImage.bufferView = uri.get_uint64().value();
+						glTFImage.bufferView = bufferViewId.get_uint64().value();
 
 					if (name.error() != simdjson::error_code::NO_SUCH_FIELD)
 						glTFImage.name = name.get_string().value();
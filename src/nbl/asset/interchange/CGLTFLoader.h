@@ -15,13 +15,18 @@
 #include "nbl/asset/interchange/IRenderpassIndependentPipelineLoader.h"
 #include "nbl/asset/metadata/CGLTFMetadata.h"
 
+#include "SGLBFormat.h"
+
 namespace nbl::asset
 {
 
-//! glTF Loader capable of loading .gltf files
+//! glTF Loader capable of loading .gltf and .glb files
 /*
 	glTF bridges the gap between 3D content creation tools and modern 3D applications 
 	by providing an efficient, extensible, interoperable format for the transmission and loading of 3D content.
+
+	When a .glb file is mapped, the buffer of its BIN chunk aliases the mapping instead of being copied,
+	it keeps the file alive and must not be written to, `clone()` it first if you need to.
 */	
 class CGLTFLoader final : public IRenderpassIndependentPipelineLoader
 {
@@ -32,7 +37,7 @@ class CGLTFLoader final : public IRenderpassIndependentPipelineLoader
 
 		const char** getAssociatedFileExtensions() const override
 		{
-			static const char* extensions[]{ "gltf", nullptr };
+			static const char* extensions[]{ "gltf", "glb", nullptr };
 			return extensions;
 		}
 
@@ -61,7 +66,10 @@ class CGLTFLoader final : public IRenderpassIndependentPipelineLoader
 
 	private:
 		virtual void initialize() override;
-		
+
+		//! How much of the file `isALoadableFileFormat` looks at
+		static inline constexpr size_t SniffPrefixSize = 4096ull;
+
 
 		using VertexShaderUVCacheKey = NBL_CORE_UNIQUE_STRING_LITERAL_TYPE("nbl/builtin/shader/loader/gltf/uv.vert");
 		using VertexShaderColorCacheKey = NBL_CORE_UNIQUE_STRING_LITERAL_TYPE("nbl/builtin/shader/loader/gltf/color.vert");
@@ -812,7 +820,10 @@ class CGLTFLoader final : public IRenderpassIndependentPipelineLoader
 			std::vector<SGLTFAnimation> animations;
 		};
 
-		bool loadAndGetGLTF(SGLTF& glTF, SContext& context);
+		//! Validates the chunks of a .glb, the BIN chunk gets aliased when the file is mapped and read otherwise
+		bool readGLBChunks(SContext& context, const glb::SHeader& header, size_t& jsonOffset, size_t& jsonSize, core::smart_refctd_ptr<ICPUBuffer>& binBuffer) const;
+		//! Parses the JSON document found at `[jsonOffset,jsonOffset+jsonSize)` of the main file, which is all of it for a .gltf
+		bool loadAndGetGLTF(SGLTF& glTF, SContext& context, const size_t jsonOffset, const size_t jsonSize);
 
 		asset::IAssetManager* const assetManager;
 };
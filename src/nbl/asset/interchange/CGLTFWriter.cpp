@@ -3,17 +3,588 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CGLTFWriter.h"
-	 
+
 #ifdef _NBL_COMPILE_WITH_GLTF_WRITER_
 
+#include "nbl/asset/ICPUMesh.h"
+#include "nbl/asset/utils/IMeshManipulator.h"
+#include "nbl/core/execution.h"
+
+#include "SGLBFormat.h"
+
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <numeric>
+
 namespace nbl
 {
 	namespace asset
 	{
+		namespace
+		{
+			using json = nlohmann::json;
+
+			enum E_COMPONENT_TYPE : uint32_t
+			{
+				ECT_BYTE = 5120,
+				ECT_UNSIGNED_BYTE = 5121,
+				ECT_SHORT = 5122,
+				ECT_UNSIGNED_SHORT = 5123,
+				ECT_UNSIGNED_INT = 5125,
+				ECT_FLOAT = 5126
+			};
+
+			constexpr uint32_t ARRAY_BUFFER = 34962u;
+			constexpr uint32_t ELEMENT_ARRAY_BUFFER = 34963u;
+			// glTF wants vertex strides 4 byte aligned and no larger than this
+			constexpr uint32_t MaxByteStride = 252u;
+
+			enum E_SEMANTIC
+			{
+				ES_POSITION,
+				ES_NORMAL,
+				ES_TEXCOORD,
+				ES_JOINTS,
+				ES_WEIGHTS,
+				ES_CUSTOM
+			};
+
+			struct SAccessorFormat
+			{
+				E_COMPONENT_TYPE componentType;
+				uint32_t componentCount;
+				bool normalized;
+			};
+
+			//! only formats with equally sized components in RGBA order have a glTF accessor counterpart
+			std::optional<SAccessorFormat> getAccessorFormat(const E_FORMAT format)
+			{
+				const uint32_t channels = getFormatChannelCount(format);
+				switch (format)
+				{
+					case EF_R8_UNORM: case EF_R8G8_UNORM: case EF_R8G8B8_UNORM: case EF_R8G8B8A8_UNORM:
+						return SAccessorFormat{ ECT_UNSIGNED_BYTE,channels,true };
+					case EF_R8_SNORM: case EF_R8G8_SNORM: case EF_R8G8B8_SNORM: case EF_R8G8B8A8_SNORM:
+						return SAccessorFormat{ ECT_BYTE,channels,true };
+					case EF_R8_UINT: case EF_R8G8_UINT: case EF_R8G8B8_UINT: case EF_R8G8B8A8_UINT:
+						return SAccessorFormat{ ECT_UNSIGNED_BYTE,channels,false };
+					case EF_R8_SINT: case EF_R8G8_SINT: case EF_R8G8B8_SINT: case EF_R8G8B8A8_SINT:
+						return SAccessorFormat{ ECT_BYTE,channels,false };
+					case EF_R16_UNORM: case EF_R16G16_UNORM: case EF_R16G16B16_UNORM: case EF_R16G16B16A16_UNORM:
+						return SAccessorFormat{ ECT_UNSIGNED_SHORT,channels,true };
+					case EF_R16_SNORM: case EF_R16G16_SNORM: case EF_R16G16B16_SNORM: case EF_R16G16B16A16_SNORM:
+						return SAccessorFormat{ ECT_SHORT,channels,true };
+					case EF_R16_UINT: case EF_R16G16_UINT: case EF_R16G16B16_UINT: case EF_R16G16B16A16_UINT:
+						return SAccessorFormat{ ECT_UNSIGNED_SHORT,channels,false };
+					case EF_R16_SINT: case EF_R16G16_SINT: case EF_R16G16B16_SINT: case EF_R16G16B16A16_SINT:
+						return SAccessorFormat{ ECT_SHORT,channels,false };
+					case EF_R32_UINT: case EF_R32G32_UINT: case EF_R32G32B32_UINT: case EF_R32G32B32A32_UINT:
+						return SAccessorFormat{ ECT_UNSIGNED_INT,channels,false };
+					case EF_R32_SFLOAT: case EF_R32G32_SFLOAT: case EF_R32G32B32_SFLOAT: case EF_R32G32B32A32_SFLOAT:
+						return SAccessorFormat{ ECT_FLOAT,channels,false };
+					default:
+						return std::nullopt;
+				}
+			}
+
+			//! whether the glTF spec lets an attribute with given semantic be stored with the format
+			bool isAllowed(const E_SEMANTIC semantic, const std::optional<SAccessorFormat>& format)
+			{
+				if (!format.has_value())
+					return false;
+
+				const auto& f = format.value();
+				const bool normalizedUnsigned = f.normalized && (f.componentType==ECT_UNSIGNED_BYTE||f.componentType==ECT_UNSIGNED_SHORT);
+				switch (semantic)
+				{
+					case ES_POSITION:
+					case ES_NORMAL:
+						return f.componentType==ECT_FLOAT && f.componentCount==3u;
+					case ES_TEXCOORD:
+						return f.componentCount==2u && (f.componentType==ECT_FLOAT||normalizedUnsigned);
+					case ES_JOINTS:
+						return f.componentCount==4u && !f.normalized && (f.componentType==ECT_UNSIGNED_BYTE||f.componentType==ECT_UNSIGNED_SHORT);
+					case ES_WEIGHTS:
+						return f.componentCount==4u && (f.componentType==ECT_FLOAT||normalizedUnsigned);
+					default:
+						return f.componentType!=ECT_UNSIGNED_INT;
+				}
+			}
+
+			//! what an attribute gets converted to when glTF does not allow its own format
+			E_FORMAT getConversionFormat(const E_SEMANTIC semantic, const E_FORMAT format)
+			{
+				switch (semantic)
+				{
+					case ES_POSITION:
+					case ES_NORMAL:
+						return EF_R32G32B32_SFLOAT;
+					case ES_TEXCOORD:
+						return EF_R32G32_SFLOAT;
+					case ES_JOINTS:
+						return isIntegerFormat(format)||isScaledFormat(format) ? EF_R16G16B16A16_UINT:EF_UNKNOWN;
+					case ES_WEIGHTS:
+						return EF_R32G32B32A32_SFLOAT;
+					default:
+						break;
+				}
+				if (!isIntegerFormat(format) && !isScaledFormat(format) && !isNormalizedFormat(format) && !isFloatingPointFormat(format))
+					return EF_UNKNOWN;
+
+				constexpr E_FORMAT floatFormats[] = { EF_R32_SFLOAT,EF_R32G32_SFLOAT,EF_R32G32B32_SFLOAT,EF_R32G32B32A32_SFLOAT };
+				const uint32_t channels = getFormatChannelCount(format);
+				return channels>=1u&&channels<=4u ? floatFormats[channels-1u]:EF_UNKNOWN;
+			}
+
+			//! `dstFormat` is always one of the `getConversionFormat` outputs
+			bool convertAttribute(uint8_t* dst, const uint8_t* src, const E_FORMAT srcFormat, const E_FORMAT dstFormat)
+			{
+				const uint32_t channels = getFormatChannelCount(dstFormat);
+				if (isIntegerFormat(dstFormat))
+				{
+					uint32_t value[4] = { 0u,0u,0u,0u };
+					if (!ICPUMeshBuffer::getAttribute(value,src,srcFormat))
+						return false;
+					for (uint32_t i=0u; i<channels; i++)
+						reinterpret_cast<uint16_t*>(dst)[i] = static_cast<uint16_t>(value[i]);
+					return true;
+				}
+
+				core::vectorSIMDf value;
+				if (isIntegerFormat(srcFormat))
+				{
+					uint32_t ivalue[4] = { 0u,0u,0u,0u };
+					if (!ICPUMeshBuffer::getAttribute(ivalue,src,srcFormat))
+						return false;
+					const bool isSigned = isSignedFormat(srcFormat);
+					for (uint32_t i=0u; i<4u; i++)
+						value[i] = isSigned ? static_cast<float>(static_cast<int32_t>(ivalue[i])):static_cast<float>(ivalue[i]);
+				}
+				else if (!ICPUMeshBuffer::getAttribute(value,src,srcFormat))
+					return false;
+
+				memcpy(dst,value.pointer,channels*sizeof(float));
+				return true;
+			}
+
+			const char* getAccessorType(const uint32_t componentCount)
+			{
+				constexpr const char* types[] = { "SCALAR","VEC2","VEC3","VEC4" };
+				return types[componentCount-1u];
+			}
+
+			//! one bufferView of the BIN chunk
+			struct SBufferView
+			{
+				// bytes which go into the file, when the source had to be repacked they point into `repacked`
+				const uint8_t* data = nullptr;
+				size_t byteLength = 0ull;
+				uint32_t byteStride = 0u;
+				uint32_t target = 0u;
+				size_t byteOffset = 0ull;
+
+				// repacking of a single strided attribute into `count` elements of `format` spaced `byteStride` apart
+				const uint8_t* src = nullptr;
+				uint32_t srcStride = 0u;
+				E_FORMAT srcFormat = EF_UNKNOWN;
+				E_FORMAT format = EF_UNKNOWN;
+				uint32_t count = 0u;
+				core::vector<uint8_t> repacked;
+			};
+
+			struct SAccessor
+			{
+				uint32_t bufferView;
+				uint32_t byteOffset;
+				SAccessorFormat format;
+				uint32_t count;
+				// POSITION accessors must have the bounds
+				bool needsBounds;
+				float min[3];
+				float max[3];
+			};
+		}
+
 		bool CGLTFWriter::writeAsset(system::IFile* _file, const SAssetWriteParams& _params, IAssetWriterOverride* _override)
 		{
-			// TODO: implementation
-			return false;
+			if (!_override)
+				getDefaultOverride(_override);
+
+			SAssetWriteContext inCtx{_params, _file};
+
+			const asset::ICPUMesh* mesh =
+			#ifndef _NBL_DEBUG
+				static_cast<const asset::ICPUMesh*>(_params.rootAsset);
+			#else
+				dynamic_cast<const asset::ICPUMesh*>(_params.rootAsset);
+			#endif
+			assert(mesh);
+
+			system::IFile* file = _override->getOutputFile(_file, inCtx, {mesh, 0u});
+
+			if (!file)
+				return false;
+
+			_params.logger.log("WRITING GLB: writing the file %s", system::ILogger::ELL_INFO, file->getFileName().string().c_str());
+
+			core::vector<SBufferView> views;
+			core::vector<SAccessor> accessors;
+			json primitives = json::array();
+
+			auto addAccessor = [&accessors](const uint32_t bufferView, const uint32_t byteOffset, const SAccessorFormat& format, const uint32_t count, const bool needsBounds) -> uint32_t
+			{
+				accessors.push_back({ bufferView,byteOffset,format,count,needsBounds,{},{} });
+				return static_cast<uint32_t>(accessors.size()-1u);
+			};
+
+			for (const auto* meshBuffer : mesh->getMeshBuffers())
+			{
+				const auto& creationParams = meshBuffer->getPipeline()->getCachedCreationParams();
+				const auto& vertexInput = creationParams.vertexInput;
+
+				uint32_t mode;
+				switch (creationParams.primitiveAssembly.primitiveType)
+				{
+					case EPT_POINT_LIST:
+						mode = 0u;
+						break;
+					case EPT_LINE_LIST:
+						mode = 1u;
+						break;
+					case EPT_LINE_STRIP:
+						mode = 3u;
+						break;
+					case EPT_TRIANGLE_LIST:
+						mode = 4u;
+						break;
+					case EPT_TRIANGLE_STRIP:
+						mode = 5u;
+						break;
+					case EPT_TRIANGLE_FAN:
+						mode = 6u;
+						break;
+					default:
+						_params.logger.log("GLB Writer: skipping a meshbuffer with a primitive topology glTF does not have", system::ILogger::ELL_WARNING);
+						continue;
+				}
+
+				const uint32_t vertexCount = IMeshManipulator::upperBoundVertexID(meshBuffer);
+				if (!vertexCount)
+					continue;
+
+				json attributes = json::object();
+				uint32_t texcoordCount = 0u;
+				const auto* bindings = meshBuffer->getVertexBufferBindings();
+				for (uint32_t binding=0u; binding<SVertexInputParams::MAX_ATTR_BUF_BINDING_COUNT; binding++)
+				{
+					if (!meshBuffer->isVertexAttribBufferBindingEnabled(binding) || !bindings[binding].buffer)
+						continue;
+
+					struct SAttribute
+					{
+						uint32_t id;
+						E_SEMANTIC semantic;
+						E_FORMAT format;
+						std::optional<SAccessorFormat> accessorFormat;
+					};
+					core::vector<SAttribute> bindingAttributes;
+					for (uint32_t id=0u; id<SVertexInputParams::MAX_VERTEX_ATTRIB_COUNT; id++)
+					{
+						if (!meshBuffer->isAttributeEnabled(id) || meshBuffer->getBindingNumForAttribute(id)!=binding)
+							continue;
+
+						const E_FORMAT format = meshBuffer->getAttribFormat(id);
+						E_SEMANTIC semantic = ES_CUSTOM;
+						if (id==meshBuffer->getPositionAttributeIx())
+							semantic = ES_POSITION;
+						else if (id==meshBuffer->getNormalAttributeIx())
+							semantic = ES_NORMAL;
+						else if (id==meshBuffer->getJointIDAttributeIx())
+							semantic = ES_JOINTS;
+						else if (id==meshBuffer->getJointWeightAttributeIx())
+							semantic = ES_WEIGHTS;
+						else if (getFormatChannelCount(format)==2u)
+							semantic = ES_TEXCOORD;
+						bindingAttributes.push_back({ id,semantic,format,getAccessorFormat(format) });
+					}
+					if (bindingAttributes.empty())
+						continue;
+
+					if (vertexInput.bindings[binding].inputRate!=SVertexInputBindingParams::EVIR_PER_VERTEX)
+					{
+						_params.logger.log("GLB Writer: skipping per instance vertex attributes of binding %d", system::ILogger::ELL_WARNING, binding);
+						continue;
+					}
+
+					const uint32_t stride = vertexInput.bindings[binding].stride;
+					const auto* buffer = bindings[binding].buffer.get();
+					const int64_t start = static_cast<int64_t>(bindings[binding].offset)+static_cast<int64_t>(meshBuffer->getBaseVertex())*stride;
+					if (start<0 || static_cast<uint64_t>(start)>buffer->getSize())
+					{
+						_params.logger.log("GLB Writer: vertex buffer binding %d starts outside of its buffer", system::ILogger::ELL_ERROR, binding);
+						return false;
+					}
+					const uint8_t* source = reinterpret_cast<const uint8_t*>(buffer->getPointer())+start;
+
+					// the binding goes in as it is, interleaved, when glTF can read every attribute straight out of it
+					bool verbatim = stride%glb::ChunkAlignment==0u && stride>=glb::ChunkAlignment && stride<=MaxByteStride;
+					verbatim = verbatim && static_cast<uint64_t>(start)+static_cast<uint64_t>(vertexCount)*stride<=buffer->getSize();
+					for (const auto& attribute : bindingAttributes)
+					{
+						const uint32_t relativeOffset = vertexInput.attributes[attribute.id].relativeOffset;
+						verbatim = verbatim && isAllowed(attribute.semantic,attribute.accessorFormat) && relativeOffset%glb::ChunkAlignment==0u;
+						verbatim = verbatim && relativeOffset+getTexelOrBlockBytesize(attribute.format)<=stride;
+					}
+
+					uint32_t texcoord = texcoordCount;
+					auto getAttributeName = [&texcoord](const SAttribute& attribute) -> std::string
+					{
+						switch (attribute.semantic)
+						{
+							case ES_POSITION:
+								return "POSITION";
+							case ES_NORMAL:
+								return "NORMAL";
+							case ES_TEXCOORD:
+								return "TEXCOORD_"+std::to_string(texcoord++);
+							case ES_JOINTS:
+								return "JOINTS_0";
+							case ES_WEIGHTS:
+								return "WEIGHTS_0";
+							default:
+								return "_ATTRIBUTE_"+std::to_string(attribute.id);
+						}
+					};
+
+					if (verbatim)
+					{
+						auto& view = views.emplace_back();
+						view.data = source;
+						view.byteLength = static_cast<size_t>(vertexCount)*stride;
+						view.byteStride = stride;
+						view.target = ARRAY_BUFFER;
+
+						const uint32_t viewID = static_cast<uint32_t>(views.size()-1u);
+						for (const auto& attribute : bindingAttributes)
+							attributes[getAttributeName(attribute)] = addAccessor(viewID,vertexInput.attributes[attribute.id].relativeOffset,attribute.accessorFormat.value(),vertexCount,attribute.semantic==ES_POSITION);
+					}
+					else for (const auto& attribute : bindingAttributes)
+					{
+						// repacked attributes get a view each, so glTF's stride limit can never get in the way
+						const E_FORMAT format = isAllowed(attribute.semantic,attribute.accessorFormat) ? attribute.format:getConversionFormat(attribute.semantic,attribute.format);
+						if (format==EF_UNKNOWN)
+						{
+							_params.logger.log("GLB Writer: skipping vertex attribute %d, its format cannot be converted to one glTF allows", system::ILogger::ELL_WARNING, attribute.id);
+							continue;
+						}
+
+						const uint32_t relativeOffset = vertexInput.attributes[attribute.id].relativeOffset;
+						const uint64_t end = static_cast<uint64_t>(start)+static_cast<uint64_t>(vertexCount-1u)*stride+relativeOffset+getTexelOrBlockBytesize(attribute.format);
+						if (end>buffer->getSize())
+						{
+							_params.logger.log("GLB Writer: vertex attribute %d reads past the end of its buffer", system::ILogger::ELL_ERROR, attribute.id);
+							return false;
+						}
+
+						auto& view = views.emplace_back();
+						view.byteStride = core::roundUp<uint32_t>(getTexelOrBlockBytesize(format),glb::ChunkAlignment);
+						view.byteLength = static_cast<size_t>(vertexCount)*view.byteStride;
+						view.target = ARRAY_BUFFER;
+						view.src = source+relativeOffset;
+						view.srcStride = stride;
+						view.srcFormat = attribute.format;
+						view.format = format;
+						view.count = vertexCount;
+
+						const uint32_t viewID = static_cast<uint32_t>(views.size()-1u);
+						attributes[getAttributeName(attribute)] = addAccessor(viewID,0u,getAccessorFormat(format).value(),vertexCount,attribute.semantic==ES_POSITION);
+					}
+					texcoordCount = texcoord;
+				}
+
+				if (!attributes.contains("POSITION"))
+				{
+					_params.logger.log("GLB Writer: skipping a meshbuffer without positions", system::ILogger::ELL_WARNING);
+					continue;
+				}
+
+				json primitive = json::object();
+				primitive["attributes"] = std::move(attributes);
+				primitive["mode"] = mode;
+
+				const void* indices = meshBuffer->getIndices();
+				const auto indexType = meshBuffer->getIndexType();
+				if (indices && indexType!=EIT_UNKNOWN)
+				{
+					const uint32_t indexSize = indexType==EIT_32BIT ? sizeof(uint32_t):sizeof(uint16_t);
+					const auto& indexBinding = meshBuffer->getIndexBufferBinding();
+					const size_t byteLength = static_cast<size_t>(meshBuffer->getIndexCount())*indexSize;
+					if (indexBinding.offset+byteLength>indexBinding.buffer->getSize())
+					{
+						_params.logger.log("GLB Writer: index count reads past the end of the index buffer", system::ILogger::ELL_ERROR);
+						return false;
+					}
+
+					auto& view = views.emplace_back();
+					view.data = reinterpret_cast<const uint8_t*>(indices);
+					view.byteLength = byteLength;
+					view.target = ELEMENT_ARRAY_BUFFER;
+
+					const SAccessorFormat format = { indexType==EIT_32BIT ? ECT_UNSIGNED_INT:ECT_UNSIGNED_SHORT,1u,false };
+					primitive["indices"] = addAccessor(static_cast<uint32_t>(views.size()-1u),0u,format,meshBuffer->getIndexCount(),false);
+				}
+
+				primitives.push_back(std::move(primitive));
+			}
+
+			if (primitives.empty())
+			{
+				_params.logger.log("GLB Writer: the mesh has no meshbuffer glTF can represent", system::ILogger::ELL_ERROR);
+				return false;
+			}
+
+			// repack and compute the POSITION bounds, both only read from the mesh so every view and accessor can go in parallel
+			{
+				std::atomic_bool failed = false;
+				core::vector<uint32_t> viewIDs(views.size());
+				std::iota(viewIDs.begin(),viewIDs.end(),0u);
+				core::for_each(core::execution::par,viewIDs.begin(),viewIDs.end(),[&](const uint32_t viewID) -> void
+				{
+					auto& view = views[viewID];
+					if (!view.src)
+						return;
+
+					view.repacked.resize(view.byteLength);
+					const size_t elementSize = getTexelOrBlockBytesize(view.format);
+					for (uint32_t i=0u; i<view.count; i++)
+					{
+						if (view.format==view.srcFormat)
+							memcpy(view.repacked.data()+static_cast<size_t>(i)*view.byteStride,view.src+static_cast<size_t>(i)*view.srcStride,elementSize);
+						else if (!convertAttribute(view.repacked.data()+static_cast<size_t>(i)*view.byteStride,view.src+static_cast<size_t>(i)*view.srcStride,view.srcFormat,view.format))
+						{
+							failed = true;
+							return;
+						}
+					}
+					view.data = view.repacked.data();
+				});
+				if (failed)
+				{
+					_params.logger.log("GLB Writer: failed to convert a vertex attribute", system::ILogger::ELL_ERROR);
+					return false;
+				}
+
+				core::vector<uint32_t> accessorIDs(accessors.size());
+				std::iota(accessorIDs.begin(),accessorIDs.end(),0u);
+				core::for_each(core::execution::par,accessorIDs.begin(),accessorIDs.end(),[&](const uint32_t accessorID) -> void
+				{
+					auto& accessor = accessors[accessorID];
+					if (!accessor.needsBounds)
+						return;
+
+					const auto& view = views[accessor.bufferView];
+					std::fill_n(accessor.min,3u,std::numeric_limits<float>::max());
+					std::fill_n(accessor.max,3u,-std::numeric_limits<float>::max());
+					for (uint32_t i=0u; i<accessor.count; i++)
+					{
+						float position[3];
+						memcpy(position,view.data+static_cast<size_t>(i)*view.byteStride+accessor.byteOffset,sizeof(position));
+						for (uint32_t c=0u; c<3u; c++)
+						{
+							accessor.min[c] = std::min(accessor.min[c],position[c]);
+							accessor.max[c] = std::max(accessor.max[c],position[c]);
+						}
+					}
+				});
+			}
+
+			size_t binLength = 0ull;
+			json bufferViews = json::array();
+			for (auto& view : views)
+			{
+				view.byteOffset = binLength;
+				binLength = core::roundUp<size_t>(binLength+view.byteLength,glb::ChunkAlignment);
+
+				json bufferView = json::object();
+				bufferView["buffer"] = 0u;
+				bufferView["byteOffset"] = view.byteOffset;
+				bufferView["byteLength"] = view.byteLength;
+				if (view.byteStride)
+					bufferView["byteStride"] = view.byteStride;
+				bufferView["target"] = view.target;
+				bufferViews.push_back(std::move(bufferView));
+			}
+
+			json accessorsJSON = json::array();
+			for (const auto& accessor : accessors)
+			{
+				json accessorJSON = json::object();
+				accessorJSON["bufferView"] = accessor.bufferView;
+				if (accessor.byteOffset)
+					accessorJSON["byteOffset"] = accessor.byteOffset;
+				accessorJSON["componentType"] = static_cast<uint32_t>(accessor.format.componentType);
+				if (accessor.format.normalized)
+					accessorJSON["normalized"] = true;
+				accessorJSON["count"] = accessor.count;
+				accessorJSON["type"] = getAccessorType(accessor.format.componentCount);
+				if (accessor.needsBounds)
+				{
+					accessorJSON["min"] = { accessor.min[0],accessor.min[1],accessor.min[2] };
+					accessorJSON["max"] = { accessor.max[0],accessor.max[1],accessor.max[2] };
+				}
+				accessorsJSON.push_back(std::move(accessorJSON));
+			}
+
+			json glTF = json::object();
+			glTF["asset"] = { {"version","2.0"},{"generator","Nabla"} };
+			glTF["scene"] = 0u;
+			glTF["scenes"] = json::array({ { {"nodes",json::array({0u})} } });
+			glTF["nodes"] = json::array({ { {"mesh",0u} } });
+			glTF["meshes"] = json::array({ { {"primitives",std::move(primitives)} } });
+			glTF["accessors"] = std::move(accessorsJSON);
+			glTF["bufferViews"] = std::move(bufferViews);
+			glTF["buffers"] = json::array({ { {"byteLength",binLength} } });
+
+			std::string jsonChunk = glTF.dump();
+			jsonChunk.resize(core::roundUp<size_t>(jsonChunk.size(),glb::ChunkAlignment),' ');
+
+			const size_t totalLength = sizeof(glb::SHeader)+sizeof(glb::SChunkHeader)+jsonChunk.size()+sizeof(glb::SChunkHeader)+binLength;
+			if (totalLength>std::numeric_limits<uint32_t>::max())
+			{
+				_params.logger.log("GLB Writer: the mesh does not fit in the 4GB a .glb file can address", system::ILogger::ELL_ERROR);
+				return false;
+			}
+
+			size_t fileOffset = 0ull;
+			auto write = [file,&fileOffset](const void* data, const size_t size) -> bool
+			{
+				if (!size)
+					return true;
+				system::IFile::success_t success;
+				file->write(success,data,fileOffset,size);
+				fileOffset += size;
+				return bool(success);
+			};
+
+			const glb::SHeader header = { glb::Magic,glb::Version,static_cast<uint32_t>(totalLength) };
+			const glb::SChunkHeader jsonHeader = { static_cast<uint32_t>(jsonChunk.size()),glb::ECT_JSON };
+			const glb::SChunkHeader binHeader = { static_cast<uint32_t>(binLength),glb::ECT_BIN };
+			bool success = write(&header,sizeof(header)) && write(&jsonHeader,sizeof(jsonHeader)) && write(jsonChunk.data(),jsonChunk.size()) && write(&binHeader,sizeof(binHeader));
+
+			// the views which did not need repacking get written straight from the mesh's buffers
+			constexpr uint8_t zeros[glb::ChunkAlignment] = {};
+			for (const auto& view : views)
+			{
+				if (!success)
+					break;
+				success = write(zeros,view.byteOffset+sizeof(header)+sizeof(jsonHeader)+jsonChunk.size()+sizeof(binHeader)-fileOffset) && write(view.data,view.byteLength);
+			}
+			success = success && write(zeros,totalLength-fileOffset);
+
+			if (!success)
+				_params.logger.log("GLB Writer: failed to write the file %s", system::ILogger::ELL_ERROR, file->getFileName().string().c_str());
+			return success;
 		}
 	}
 }
@@ -18,10 +18,16 @@ namespace nbl
 {
 	namespace asset
 	{
-		//! glTF Writer capable of writing .gltf files
+		//! glTF Writer capable of writing .glb files
 		/*
 			glTF bridges the gap between 3D content creation tools and modern 3D applications
 			by providing an efficient, extensible, interoperable format for the transmission and loading of 3D content.
+
+			Every meshbuffer becomes a primitive of a single mesh. The vertex bindings go into the BIN chunk byte for byte
+			(interleaved, as they are) whenever glTF allows it, that is when the stride and attribute offsets are multiples of 4
+			and glTF has the formats, otherwise the binding gets repacked. Position, normal, joint and weight attributes get
+			their glTF semantics, the other two component ones become texture coordinates and the rest is written as
+			application specific `_ATTRIBUTE_<id>`. Per instance attributes and materials are not written.
 		*/
 
 		class CGLTFWriter final : public asset::IAssetWriter
@@ -34,15 +40,15 @@ namespace nbl
 
 				virtual const char** getAssociatedFileExtensions() const override
 				{
-					static const char* extensions[]{ "gltf", nullptr };
+					static const char* extensions[]{ "glb", nullptr };
 					return extensions;
 				}
 
 				uint64_t getSupportedAssetTypesBitfield() const override { return asset::IAsset::ET_MESH; }
 
-				uint32_t getSupportedFlags() override { return asset::EWF_NONE; }
+				uint32_t getSupportedFlags() override { return asset::EWF_BINARY; }
 
-				uint32_t getForcedFlags() override { return asset::EWF_NONE; }
+				uint32_t getForcedFlags() override { return asset::EWF_BINARY; }
 
 				bool writeAsset(system::IFile* _file, const SAssetWriteParams& _params, IAssetWriterOverride* _override = nullptr) override;
 		};
@@ -4,6 +4,7 @@
 // See the original file in irrlicht source for authors
 
 #include "nbl/core/declarations.h"
+#include "nbl/core/execution.h"
 
 #include "nbl/asset/IAssetManager.h"
 #include "nbl/asset/utils/IMeshManipulator.h"
@@ -19,6 +20,10 @@
 #include "COBJMeshFileLoader.h"
 
 #include <filesystem>
+#include <bit>
+#include <charconv>
+#include <numeric>
+#include <thread>
 
 namespace nbl
 {
@@ -36,6 +41,205 @@ constexpr uint32_t UV = 2u;
 constexpr uint32_t NORMAL = 3u;
 constexpr uint32_t BND_NUM = 0u;
 
+// which index of a face's corner refers to what
+constexpr uint32_t POSITION_IX = 0u;
+constexpr uint32_t UV_IX = 1u;
+constexpr uint32_t NORMAL_IX = 2u;
+
+// files smaller than this don't get split up for the parallel parse
+constexpr size_t MIN_CHUNK_SIZE = 0x1ull<<20ull;
+
+struct COBJMeshFileLoader::SParsedChunk
+{
+	struct vec3 { float data[3]; };
+	struct vec2 { float data[2]; };
+	struct SCorner
+	{
+		// 0-based, -1 if the index was not present, relative to the first declaration of the chunk if its bit in `relativeMask` is set
+		int32_t idx[3];
+		uint32_t relativeMask;
+	};
+	// `mtllib`, `g`, `s`, `usemtl` and vertex declarations change what the faces after them go into, `type` is the first character of the statement
+	struct SStatement
+	{
+		char type;
+		// number of faces parsed before the statement
+		uint32_t faceCount;
+		std::string word;
+	};
+
+	inline uint32_t getFaceCount() const { return faceEnds.size(); }
+
+	core::vector<vec3> positions;
+	core::vector<vec3> normals;
+	core::vector<vec2> uvs;
+	core::vector<SCorner> corners;
+	// one past the last corner of every face
+	core::vector<uint32_t> faceEnds;
+	core::vector<SStatement> statements;
+};
+
+namespace
+{
+
+// `sscanf(word,"%f",&out)` with `word` being the copy `copyWord` would have made into a 256 character buffer
+inline void parseFloat(const char* const word, const char* const wordEnd, float& out)
+{
+	const auto result = std::from_chars(word,wordEnd,out);
+	// `from_chars` doesn't take a leading plus or hexadecimal floats without a flag, and leaves `out` alone when the value is out of range
+	if (result.ec!=std::errc() || (word!=wordEnd && *word=='+') || (result.ptr!=wordEnd && (*result.ptr=='x' || *result.ptr=='X')))
+	{
+		char tmp[256];
+		const size_t length = wordEnd-word;
+		memcpy(tmp,word,length);
+		tmp[length] = '\0';
+		sscanf(tmp,"%f",&out);
+	}
+}
+
+// `sscanf(word,"%d",&out)` for a word made up of at most 15 digits and minus signs
+inline void parseIndex(const char* p, const char* const wordEnd, int32_t& out)
+{
+	const bool negative = p!=wordEnd && *p=='-';
+	if (negative)
+		++p;
+	if (p==wordEnd || !core::isdigit(*p))
+		return;
+	int64_t value = 0;
+	for (; p!=wordEnd && core::isdigit(*p); ++p)
+		value = value*10+(*p-'0');
+	out = static_cast<int32_t>(negative ? -value:value);
+}
+
+// reads the vertex indices of a face's corner, indices are changed to 0-based instead of 1-based, -1 if the index doesn't exist
+// negative indices are relative to the declarations so far, only the ones in the chunk are known at this point so the indices
+// which still need the declarations of the preceding chunks added get their bit set in the returned mask
+inline uint32_t parseCorner(const char* p, const char* const wordEnd, const int32_t localCounts[3], int32_t idx[3])
+{
+	// an index without any number keeps its last value
+	int32_t raw[3] = {-1,-1,-1};
+	bool present[3] = {false,false,false};
+	uint32_t idxType = 0u;
+	char word[16];
+	uint32_t length = 0u;
+	for (;; ++p)
+	{
+		const char c = p!=wordEnd ? *p:'\0';
+		if (core::isdigit(c) || c=='-')
+		{
+			if (length<15u)
+				word[length++] = c;
+		}
+		else if (c=='/' || c=='\0')
+		{
+			parseIndex(word,word+length,raw[idxType]);
+			present[idxType] = true;
+			length = 0u;
+			if (c=='\0')
+				break;
+			// error checking, shouldn't wrap around unless file is wrong
+			if (++idxType>2u)
+				idxType = 0u;
+		}
+	}
+	// set all missing values to disable (=-1)
+	while (++idxType<3u)
+		present[idxType] = false;
+
+	uint32_t relativeMask = 0u;
+	for (uint32_t i=0u; i<3u; i++)
+	{
+		if (!present[i])
+			idx[i] = -1;
+		else if (raw[i]<0)
+		{
+			idx[i] = localCounts[i]+raw[i];
+			relativeMask |= 0x1u<<i;
+		}
+		else
+			idx[i] = raw[i]-1;
+	}
+	return relativeMask;
+}
+
+// Open addressing with linear probing over indices into the vertex array, a drop-in for the `core::map<SObjVertex,uint32_t>` used before,
+// including `SObjVertex::operator<` treating a NaN texcoord as equivalent to anything and only the first of several equivalent vertices going in.
+// Hence only the positions get hashed.
+class CObjVertexHashTable
+{
+	public:
+		_NBL_STATIC_INLINE_CONSTEXPR uint32_t InvalidIndex = ~0u;
+
+		inline void reserve(const size_t vertexCount)
+		{
+			if (vertexCount*2ull>slots.size())
+				rehash(core::roundUpToPoT(vertexCount*2ull),{});
+		}
+
+		inline uint32_t find(const SObjVertex& v, const core::vector<SObjVertex>& vertices) const
+		{
+			if (slots.empty())
+				return InvalidIndex;
+			for (size_t i=hash(v)&mask; slots[i]!=InvalidIndex; i=(i+1ull)&mask)
+			if (isEquivalent(vertices[slots[i]],v))
+				return slots[i];
+			return InvalidIndex;
+		}
+
+		//! `vertices[ix]` must not be equivalent to any vertex already in the table
+		inline void insert(const uint32_t ix, const core::vector<SObjVertex>& vertices)
+		{
+			// keep the load factor at most a half
+			if ((size+1ull)*2ull>slots.size())
+				rehash(core::max<size_t>(slots.size()*2ull,64ull),vertices);
+			place(ix,vertices[ix]);
+			size++;
+		}
+
+	private:
+		static inline uint64_t hash(const SObjVertex& v)
+		{
+			// -0 and 0 are equivalent
+			auto bits = [](const float x) -> uint64_t { return x!=0.f ? std::bit_cast<uint32_t>(x):0u; };
+			uint64_t h = (bits(v.pos[0])|(bits(v.pos[1])<<32ull))*0x9E3779B97F4A7C15ull;
+			h = (h^(h>>29ull)^bits(v.pos[2]))*0xBF58476D1CE4E5B9ull;
+			return h^(h>>32ull);
+		}
+		// `!(a<b) && !(b<a)`, the lexicographic `SObjVertex::operator<` decides on the first member which isn't equal
+		static inline bool isEquivalent(const SObjVertex& a, const SObjVertex& b)
+		{
+			const float lhs[5] = {a.pos[0],a.pos[1],a.pos[2],a.uv[0],a.uv[1]};
+			const float rhs[5] = {b.pos[0],b.pos[1],b.pos[2],b.uv[0],b.uv[1]};
+			for (uint32_t i=0u; i<5u; i++)
+			if (!(lhs[i]==rhs[i]))
+				return !(lhs[i]<rhs[i]) && !(rhs[i]<lhs[i]);
+			return !(a.normal32bit<b.normal32bit) && !(b.normal32bit<a.normal32bit);
+		}
+
+		inline void place(const uint32_t ix, const SObjVertex& v)
+		{
+			size_t i = hash(v)&mask;
+			while (slots[i]!=InvalidIndex)
+				i = (i+1ull)&mask;
+			slots[i] = ix;
+		}
+		inline void rehash(const size_t slotCount, const core::vector<SObjVertex>& vertices)
+		{
+			core::vector<uint32_t> oldSlots(slotCount,InvalidIndex);
+			slots.swap(oldSlots);
+			mask = slotCount-1ull;
+			for (const auto ix : oldSlots)
+			if (ix!=InvalidIndex)
+				place(ix,vertices[ix]);
+		}
+
+		core::vector<uint32_t> slots;
+		size_t mask = 0ull;
+		size_t size = 0ull;
+};
+
+}
+
 //! Constructor
 COBJMeshFileLoader::COBJMeshFileLoader(IAssetManager* _manager) : AssetManager(_manager), System(_manager->getSystem())
 {
@@ -70,9 +274,6 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 	if (!filesize)
         return {};
 
-	const uint32_t WORD_BUFFER_LENGTH = 512u;
-    char tmpbuf[WORD_BUFFER_LENGTH]{};
-
 	uint32_t smoothingGroup=0;
 
 	const std::filesystem::path fullName = _file->getFileName();
@@ -100,19 +301,19 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 	};
     core::unordered_multiset<pipeline_meta_pair_t,hash_t,key_equal_t> pipelines;
 
-	// TODO: map the file whenever possible
-    std::string fileContents;
-    fileContents.resize(filesize);
-	char* const buf = fileContents.data();
-
-	system::IFile::success_t success;
-	_file->read(success, buf, 0, filesize);
-	if (!success)
-		return {};
-
+	// map the file whenever possible
+	const char* buf = reinterpret_cast<const char*>(static_cast<const system::IFile*>(_file)->getMappedPointer());
+	std::string fileContents;
+	if (!buf)
+	{
+		fileContents.resize(filesize);
+		system::IFile::success_t success;
+		_file->read(success, fileContents.data(), 0, filesize);
+		if (!success)
+			return {};
+		buf = fileContents.data();
+	}
 	const char* const bufEnd = buf+filesize;
-	// Process obj information
-	const char* bufPtr = buf;
 	std::string grpName, mtlName;
 
 	auto performActionBasedOnOrientationSystem = [&](auto performOnRightHanded, auto performOnLeftHanded)
@@ -123,191 +324,243 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 			performOnLeftHanded();
 	};
 
+	// split at line boundaries into more chunks than there are threads, a chunk of faces takes longer to parse than one of vertices
+	core::vector<SParsedChunk> chunks;
+	{
+		const size_t maxChunks = std::max<size_t>(std::thread::hardware_concurrency(),1ull)*4ull;
+		chunks.resize(std::clamp<size_t>(filesize/MIN_CHUNK_SIZE,1ull,maxChunks));
+		core::vector<const char*> chunkBegins(chunks.size()+1ull);
+		chunkBegins.front() = buf;
+		chunkBegins.back() = bufEnd;
+		for (size_t i=1ull; i<chunks.size(); i++)
+		{
+			const char* const splitPoint = std::max(buf+filesize*i/chunks.size(),chunkBegins[i-1ull]);
+			// same line ends as `parseChunk`, files with old Mac line endings have no '\n' at all
+			const char* const lineEnd = std::find_if(splitPoint,bufEnd,[](const char c)->bool{return c=='\n' || c=='\r';});
+			chunkBegins[i] = lineEnd!=bufEnd ? (lineEnd+1):bufEnd;
+		}
+
+		const bool rightHanded = _params.loaderFlags&E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES;
+		core::vector<uint32_t> chunkIndices(chunks.size());
+		std::iota(chunkIndices.begin(),chunkIndices.end(),0u);
+		core::for_each(core::execution::par,chunkIndices.begin(),chunkIndices.end(),[&](const uint32_t i)->void
+		{
+			// the very first statement is wherever the file starts, even if that's whitespace
+			const char* const firstStatement = i ? goFirstWord(chunkBegins[i],bufEnd):buf;
+			parseChunk(chunks[i],firstStatement,chunkBegins[i+1u],bufEnd,rightHanded);
+		});
+	}
 
-    struct vec3 {
-        float data[3];
-    };
-    struct vec2 {
-        float data[2];
-    };
-    core::vector<vec3> vertexBuffer;
-    core::vector<vec3> normalsBuffer;
-    core::vector<vec2> textureCoordBuffer;
+	// the relative indices of a chunk are missing everything declared in the chunks before it
+	core::vector<std::array<uint32_t,3>> chunkOffsets(chunks.size()+1ull,{0u,0u,0u});
+	for (size_t i=0ull; i<chunks.size(); i++)
+	{
+		chunkOffsets[i+1ull][POSITION_IX] = chunkOffsets[i][POSITION_IX]+chunks[i].positions.size();
+		chunkOffsets[i+1ull][UV_IX] = chunkOffsets[i][UV_IX]+chunks[i].uvs.size();
+		chunkOffsets[i+1ull][NORMAL_IX] = chunkOffsets[i][NORMAL_IX]+chunks[i].normals.size();
+	}
+	const auto& totalCounts = chunkOffsets.back();
+	core::vector<SParsedChunk::vec3> vertexBuffer(totalCounts[POSITION_IX]);
+	core::vector<SParsedChunk::vec3> normalsBuffer(totalCounts[NORMAL_IX]);
+	core::vector<SParsedChunk::vec2> textureCoordBuffer(totalCounts[UV_IX]);
+	{
+		std::atomic_bool indexOutOfRange = false;
+		core::vector<uint32_t> chunkIndices(chunks.size());
+		std::iota(chunkIndices.begin(),chunkIndices.end(),0u);
+		core::for_each(core::execution::par,chunkIndices.begin(),chunkIndices.end(),[&](const uint32_t i)->void
+		{
+			auto& chunk = chunks[i];
+			const auto& offsets = chunkOffsets[i];
+			std::copy(chunk.positions.begin(),chunk.positions.end(),vertexBuffer.begin()+offsets[POSITION_IX]);
+			std::copy(chunk.uvs.begin(),chunk.uvs.end(),textureCoordBuffer.begin()+offsets[UV_IX]);
+			std::copy(chunk.normals.begin(),chunk.normals.end(),normalsBuffer.begin()+offsets[NORMAL_IX]);
+			core::vector<SParsedChunk::vec3>().swap(chunk.positions);
+			core::vector<SParsedChunk::vec2>().swap(chunk.uvs);
+			core::vector<SParsedChunk::vec3>().swap(chunk.normals);
+
+			bool outOfRange = false;
+			for (auto& corner : chunk.corners)
+			{
+				for (uint32_t j=0u; j<3u; j++)
+				{
+					if (corner.relativeMask&(0x1u<<j))
+						corner.idx[j] += offsets[j];
+					// only the texcoord and normal may be missing
+					const int32_t lowerBound = j!=POSITION_IX ? -1:0;
+					outOfRange = outOfRange || corner.idx[j]<lowerBound || corner.idx[j]>=static_cast<int64_t>(totalCounts[j]);
+				}
+			}
+			if (outOfRange)
+				indexOutOfRange.store(true,std::memory_order_relaxed);
+		});
+		if (indexOutOfRange.load())
+		{
+			_params.logger.log("Face in %s references a vertex, texcoord or normal that was never declared", system::ILogger::ELL_ERROR, _file->getFileName().string().c_str());
+			return {};
+		}
+	}
 
     core::vector<core::smart_refctd_ptr<ICPUMeshBuffer>> submeshes;
     core::vector<core::vector<uint32_t>> indices;
     core::vector<SObjVertex> vertices;
-    core::map<SObjVertex, uint32_t> map_vtx2ix;
+    CObjVertexHashTable vertexTable;
     core::vector<bool> recalcNormals;
     core::vector<bool> submeshWasLoadedFromCache;
     core::vector<std::string> submeshCacheKeys;
     core::vector<std::string> submeshMaterialNames;
     core::vector<uint32_t> vtxSmoothGrp;
 
+	// replay the statements which change what the faces after them go into, in file order
+	struct SFaceRun
+	{
+		uint32_t chunk;
+		uint32_t firstFace;
+		uint32_t endFace;
+		uint32_t submesh;
+		uint32_t smoothingGroup;
+	};
+	core::vector<SFaceRun> faceRuns;
 	// TODO: handle failures much better!
 	constexpr const char* NO_MATERIAL_MTL_NAME = "#";
 	bool noMaterial = true;
 	bool dummyMaterialCreated = false;
-	while(bufPtr != bufEnd)
+	for (uint32_t i=0u; i<chunks.size(); i++)
 	{
-		switch(bufPtr[0])
-		{
-		case 'm':	// mtllib (material)
+		const auto& chunk = chunks[i];
+		uint32_t face = 0u;
+		auto addFaces = [&](const uint32_t endFace) -> void
 		{
-			if (ctx.useMaterials)
+			if (face==endFace)
+				return;
+			if (noMaterial && !dummyMaterialCreated)
 			{
-				bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-				_params.logger.log("Reading material _file %s", system::ILogger::ELL_DEBUG, tmpbuf);
-
-                std::string mtllib = tmpbuf;
-                std::replace(mtllib.begin(), mtllib.end(), '\\', '/');
-                SAssetLoadParams loadParams(_params);
-				loadParams.workingDirectory = _file->getFileName().parent_path();
-                auto bundle = interm_getAssetInHierarchy(AssetManager, mtllib, loadParams, _hierarchyLevel+ICPUMesh::PIPELINE_HIERARCHYLEVELS_BELOW, _override);
-                
-				if (bundle.getContents().empty())
-					break;
+				dummyMaterialCreated = true;
 
-				if (bundle.getMetadata())
+				submeshes.push_back(core::make_smart_refctd_ptr<ICPUMeshBuffer>());
+				indices.emplace_back();
+				recalcNormals.push_back(false);
+				submeshWasLoadedFromCache.push_back(false);
+				submeshCacheKeys.push_back(genKeyForMeshBuf(ctx, _file->getFileName().string(), NO_MATERIAL_MTL_NAME, grpName));
+				submeshMaterialNames.push_back(NO_MATERIAL_MTL_NAME);
+			}
+			faceRuns.push_back({i,face,endFace,static_cast<uint32_t>(submeshes.size()-1ull),smoothingGroup});
+			face = endFace;
+		};
+
+		for (const auto& statement : chunk.statements)
+		{
+			addFaces(statement.faceCount);
+			const char* const word = statement.word.c_str();
+			switch (statement.type)
+			{
+			case 'm':	// mtllib (material)
+			{
+				if (ctx.useMaterials)
 				{
-					auto meta = bundle.getMetadata()->selfCast<const CMTLMetadata>();
-					if (bundle.getAssetType()==IAsset::ET_RENDERPASS_INDEPENDENT_PIPELINE)
-					for (auto ass : bundle.getContents())
-					{
-						auto ppln = core::smart_refctd_ptr_static_cast<ICPURenderpassIndependentPipeline>(ass);
-						const auto pplnMeta = meta->getAssetSpecificMetadata(ppln.get());
-						if (!pplnMeta)
-							continue;
+					_params.logger.log("Reading material _file %s", system::ILogger::ELL_DEBUG, word);
+
+	                std::string mtllib = word;
+	                std::replace(mtllib.begin(), mtllib.end(), '\\', '/');
+	                SAssetLoadParams loadParams(_params);
+					loadParams.workingDirectory = _file->getFileName().parent_path();
+	                auto bundle = interm_getAssetInHierarchy(AssetManager, mtllib, loadParams, _hierarchyLevel+ICPUMesh::PIPELINE_HIERARCHYLEVELS_BELOW, _override);
+	                
+					if (bundle.getContents().empty())
+						break;
 
-						pipelines.emplace(std::move(ppln),pplnMeta);
+					if (bundle.getMetadata())
+					{
+						auto meta = bundle.getMetadata()->selfCast<const CMTLMetadata>();
+						if (bundle.getAssetType()==IAsset::ET_RENDERPASS_INDEPENDENT_PIPELINE)
+						for (auto ass : bundle.getContents())
+						{
+							auto ppln = core::smart_refctd_ptr_static_cast<ICPURenderpassIndependentPipeline>(ass);
+							const auto pplnMeta = meta->getAssetSpecificMetadata(ppln.get());
+							if (!pplnMeta)
+								continue;
+
+							pipelines.emplace(std::move(ppln),pplnMeta);
+						}
 					}
 				}
 			}
-		}
-			break;
+				break;
 
-		case 'v':               // v, vn, vt
-			//reset flags
-			noMaterial = true;
-			dummyMaterialCreated = false;
-			switch(bufPtr[1])
-			{
-			case ' ':          // vertex
-				{
-					vec3 vec;
-					bufPtr = readVec3(bufPtr, vec.data, bufEnd);
-					performActionBasedOnOrientationSystem([&]() {vec.data[0] = -vec.data[0];}, [&]() {});
-					vertexBuffer.push_back(vec);
-				}
+			case 'v':               // v, vn, vt
+				//reset flags
+				noMaterial = true;
+				dummyMaterialCreated = false;
 				break;
 
-			case 'n':       // normal
+			case 'g': // group name
+	            grpName = word;
+				break;
+			case 's': // smoothing can be a group or off (equiv. to 0)
 				{
-					vec3 vec;
-					bufPtr = readVec3(bufPtr, vec.data, bufEnd);
-					performActionBasedOnOrientationSystem([&]() {vec.data[0] = -vec.data[0]; }, [&]() {});
-					normalsBuffer.push_back(vec);
+					_params.logger.log("Loaded smoothing group start %s",system::ILogger::ELL_DEBUG, word);
+					if (strcmp("off", word)==0)
+						smoothingGroup=0u;
+					else
+	                    sscanf(word,"%u",&smoothingGroup);
 				}
 				break;
 
-			case 't':       // texcoord
+			case 'u': // usemtl
+				// get name of material
 				{
-					vec2 vec;
-					bufPtr = readUV(bufPtr, vec.data, bufEnd);
-					textureCoordBuffer.push_back(vec);
+					noMaterial = false;
+					_params.logger.log("Loaded material start %s", system::ILogger::ELL_DEBUG, word);
+					mtlName=word;
+
+	                if (ctx.useMaterials && !ctx.useGroups)
+	                {
+	                    asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
+	                    auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().string(), mtlName, grpName), types, ctx.inner, _hierarchyLevel+ICPUMesh::MESHBUFFER_HIERARCHYLEVELS_BELOW);
+	                    auto mbs = mb_bundle.getContents();
+						bool notempty = mbs.size()!=0ull;
+	                    {
+	                        auto mb = notempty ? core::smart_refctd_ptr_static_cast<ICPUMeshBuffer>(*mbs.begin()) : core::make_smart_refctd_ptr<ICPUMeshBuffer>();
+	                        submeshes.push_back(std::move(mb));
+	                    }
+	                    indices.emplace_back();
+	                    recalcNormals.push_back(false);
+	                    submeshWasLoadedFromCache.push_back(notempty);
+	                    //if submesh was loaded from cache - insert empty "cache key" (submesh loaded from cache won't be added to cache again)
+	                    submeshCacheKeys.push_back(submeshWasLoadedFromCache.back() ? "" : genKeyForMeshBuf(ctx, _file->getFileName().string(), mtlName, grpName));
+	                    submeshMaterialNames.push_back(mtlName);
+	                }
 				}
 				break;
 			}
-			break;
-
-		case 'g': // group name
-            bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-            grpName = tmpbuf;
-			break;
-		case 's': // smoothing can be a group or off (equiv. to 0)
-			{
-				bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-				_params.logger.log("Loaded smoothing group start %s",system::ILogger::ELL_DEBUG, tmpbuf);
-				if (strcmp("off", tmpbuf)==0)
-					smoothingGroup=0u;
-				else
-                    sscanf(tmpbuf,"%u",&smoothingGroup);
-			}
-			break;
-
-		case 'u': // usemtl
-			// get name of material
-			{
-				noMaterial = false;
-				bufPtr = goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-				_params.logger.log("Loaded material start %s", system::ILogger::ELL_DEBUG, tmpbuf);
-				mtlName=tmpbuf;
+		}
+		addFaces(chunk.getFaceCount());
+	}
 
-                if (ctx.useMaterials && !ctx.useGroups)
-                {
-                    asset::IAsset::E_TYPE types[] {asset::IAsset::ET_SUB_MESH, (asset::IAsset::E_TYPE)0u };
-                    auto mb_bundle = _override->findCachedAsset(genKeyForMeshBuf(ctx, _file->getFileName().string(), mtlName, grpName), types, ctx.inner, _hierarchyLevel+ICPUMesh::MESHBUFFER_HIERARCHYLEVELS_BELOW);
-                    auto mbs = mb_bundle.getContents();
-					bool notempty = mbs.size()!=0ull;
-                    {
-                        auto mb = notempty ? core::smart_refctd_ptr_static_cast<ICPUMeshBuffer>(*mbs.begin()) : core::make_smart_refctd_ptr<ICPUMeshBuffer>();
-                        submeshes.push_back(std::move(mb));
-                    }
-                    indices.emplace_back();
-                    recalcNormals.push_back(false);
-                    submeshWasLoadedFromCache.push_back(notempty);
-                    //if submesh was loaded from cache - insert empty "cache key" (submesh loaded from cache won't be added to cache again)
-                    submeshCacheKeys.push_back(submeshWasLoadedFromCache.back() ? "" : genKeyForMeshBuf(ctx, _file->getFileName().string(), mtlName, grpName));
-                    submeshMaterialNames.push_back(mtlName);
-                }
-			}
-			break;
-		case 'f':               // face
+	// deduplicate the face corners in file order, each normal gets quantized the first time it's used which keeps the cache's contents the same as per corner quantization would
+	core::vector<CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>> quantizedNormals(normalsBuffer.size());
+	core::vector<bool> normalQuantized(normalsBuffer.size(),false);
+	vertexTable.reserve(vertexBuffer.size());
+	core::vector<uint32_t> faceCorners;
+	faceCorners.reserve(32ull);
+	for (const auto& run : faceRuns)
+	{
+		const auto& chunk = chunks[run.chunk];
+		for (uint32_t face=run.firstFace; face<run.endFace; face++)
 		{
-			if (noMaterial && !dummyMaterialCreated)
+			faceCorners.clear();
+			for (uint32_t c=face ? chunk.faceEnds[face-1u]:0u; c<chunk.faceEnds[face]; c++)
 			{
-				dummyMaterialCreated = true;
-
-				submeshes.push_back(core::make_smart_refctd_ptr<ICPUMeshBuffer>());
-				indices.emplace_back();
-				recalcNormals.push_back(false);
-				submeshWasLoadedFromCache.push_back(false);
-				submeshCacheKeys.push_back(genKeyForMeshBuf(ctx, _file->getFileName().string(), NO_MATERIAL_MTL_NAME, grpName));
-				submeshMaterialNames.push_back(NO_MATERIAL_MTL_NAME);
-			}
-
-			SObjVertex v;
+				const int32_t* const Idx = chunk.corners[c].idx;
 
-			// get all vertices data in this face (current line of obj _file)
-			const std::string wordBuffer = copyLine(bufPtr, bufEnd);
-			const char* linePtr = wordBuffer.c_str();
-			const char* const endPtr = linePtr + wordBuffer.size();
-
-			core::vector<uint32_t> faceCorners;
-			faceCorners.reserve(32ull);
-
-			// read in all vertices
-			linePtr = goNextWord(linePtr, endPtr);
-			while (0 != linePtr[0])
-			{
-				// Array to communicate with retrieveVertexIndices()
-				// sends the buffer sizes and gets the actual indices
-				// if index not set returns -1
-				int32_t Idx[3];
-				Idx[1] = Idx[2] = -1;
-
-				// read in next vertex's data
-				uint32_t wlength = copyWord(tmpbuf, linePtr, WORD_BUFFER_LENGTH, endPtr);
-				// this function will also convert obj's 1-based index to c++'s 0-based index
-				retrieveVertexIndices(tmpbuf, Idx, tmpbuf+wlength+1, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
-				v.pos[0] = vertexBuffer[Idx[0]].data[0];
-				v.pos[1] = vertexBuffer[Idx[0]].data[1];
-				v.pos[2] = vertexBuffer[Idx[0]].data[2];
+				SObjVertex v;
+				v.pos[0] = vertexBuffer[Idx[POSITION_IX]].data[0];
+				v.pos[1] = vertexBuffer[Idx[POSITION_IX]].data[1];
+				v.pos[2] = vertexBuffer[Idx[POSITION_IX]].data[2];
 				//set texcoord
-				if ( -1 != Idx[1] )
+				if ( -1 != Idx[UV_IX] )
                 {
-					v.uv[0] = textureCoordBuffer[Idx[1]].data[0];
-					v.uv[1] = textureCoordBuffer[Idx[1]].data[1];
+					v.uv[0] = textureCoordBuffer[Idx[UV_IX]].data[0];
+					v.uv[1] = textureCoordBuffer[Idx[UV_IX]].data[1];
                 }
 				else
                 {
@@ -315,67 +568,65 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 					v.uv[1] = core::nan<float>();
                 }
                 //set normal
-				if ( -1 != Idx[2] )
+				if ( -1 != Idx[NORMAL_IX] )
                 {
-					core::vectorSIMDf simdNormal;
-					simdNormal.set(normalsBuffer[Idx[2]].data);
-                    simdNormal.makeSafe3D();
-					v.normal32bit = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(simdNormal);
+					if (!normalQuantized[Idx[NORMAL_IX]])
+					{
+						core::vectorSIMDf simdNormal;
+						simdNormal.set(normalsBuffer[Idx[NORMAL_IX]].data);
+						simdNormal.makeSafe3D();
+						quantizedNormals[Idx[NORMAL_IX]] = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(simdNormal);
+						normalQuantized[Idx[NORMAL_IX]] = true;
+					}
+					v.normal32bit = quantizedNormals[Idx[NORMAL_IX]];
                 }
 				else
 				{
 					v.normal32bit = core::vectorSIMDu32(0u);
-                    recalcNormals.back() = true;
+                    recalcNormals[run.submesh] = true;
 				}
 
 				uint32_t ix;
-				auto vtx_ix = map_vtx2ix.find(v);
-				if (vtx_ix != map_vtx2ix.end() && smoothingGroup==vtxSmoothGrp[vtx_ix->second])
-					ix = vtx_ix->second;
+				const uint32_t found = vertexTable.find(v,vertices);
+				if (found!=CObjVertexHashTable::InvalidIndex && run.smoothingGroup==vtxSmoothGrp[found])
+					ix = found;
 				else
 				{
 					ix = vertices.size();
 					vertices.push_back(v);
-                    vtxSmoothGrp.push_back(smoothingGroup);
-					map_vtx2ix.insert({v, ix});
+                    vtxSmoothGrp.push_back(run.smoothingGroup);
+					// the first vertex with the same key stays the one that gets found
+					if (found==CObjVertexHashTable::InvalidIndex)
+						vertexTable.insert(ix,vertices);
 				}
 
 				faceCorners.push_back(ix);
-
-				// go to next vertex
-				linePtr = goNextWord(linePtr, endPtr);
 			}
 
             // triangulate the face
-            for (uint32_t i = 1u; i < faceCorners.size()-1u; ++i)
+            auto& submeshIndices = indices[run.submesh];
+            for (uint32_t i = 1u; i+1u < faceCorners.size(); ++i)
             {
                 // Add a triangle
                 performActionBasedOnOrientationSystem
                 (
                 [&]()
                 {
-                    indices.back().push_back(faceCorners[0]);
-                    indices.back().push_back(faceCorners[i]);
-                    indices.back().push_back(faceCorners[i + 1]);
+                    submeshIndices.push_back(faceCorners[0]);
+                    submeshIndices.push_back(faceCorners[i]);
+                    submeshIndices.push_back(faceCorners[i + 1]);
                 },
                 [&]()
                 {
-                    indices.back().push_back(faceCorners[i + 1]);
-                    indices.back().push_back(faceCorners[i]);
-                    indices.back().push_back(faceCorners[0]);
+                    submeshIndices.push_back(faceCorners[i + 1]);
+                    submeshIndices.push_back(faceCorners[i]);
+                    submeshIndices.push_back(faceCorners[0]);
                 }
                 );
             }
 		}
-		break;
-
-		case '#': // comment
-		default:
-			break;
-		}	// end switch(bufPtr[0])
-		// eat up rest of line
-		bufPtr = goNextLine(bufPtr, bufEnd);
-	}	// end while(bufPtr && (bufPtr-buf<filesize))
+	}
+	core::vector<SParsedChunk>().swap(chunks);
 
 	// prune out invalid empty shape groups (TODO: convert to AoS and use an erase_if)
 	for (size_t i = 0ull; i < submeshes.size(); ++i)
@@ -528,37 +779,98 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 }
 
 
-//! Read 3d vector of floats
-const char* COBJMeshFileLoader::readVec3(const char* bufPtr, float vec[3], const char* const bufEnd)
+//! Read N floats from the words following the current one
+template<uint32_t N>
+const char* COBJMeshFileLoader::readFloats(const char* bufPtr, float vec[N], const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+1);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+2);
-
-    vec[0] = -vec[0]; // change handedness
+	for (uint32_t i=0u; i<N; i++)
+	{
+		bufPtr = goNextWord(bufPtr, bufEnd, false);
+		// no longer than what `copyWord` would put in a 256 character buffer
+		const char* wordEnd = bufPtr;
+		while (wordEnd!=bufEnd && *wordEnd && !core::isspace(*wordEnd) && wordEnd-bufPtr<255)
+			++wordEnd;
+		parseFloat(bufPtr, wordEnd, vec[i]);
+	}
 	return bufPtr;
 }
 
 
-//! Read 2d vector of floats
-const char* COBJMeshFileLoader::readUV(const char* bufPtr, float vec[2], const char* const bufEnd)
+void COBJMeshFileLoader::parseChunk(SParsedChunk& chunk, const char* bufPtr, const char* const chunkEnd, const char* const bufEnd, const bool rightHanded)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
+	char tmpbuf[WORD_BUFFER_LENGTH];
+	while (bufPtr<chunkEnd)
+	{
+		const char* lineEnd = bufPtr;
+		while (lineEnd!=bufEnd && *lineEnd!='\n' && *lineEnd!='\r')
+			++lineEnd;
 
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+1);
+		switch (bufPtr[0])
+		{
+		case 'm':	// mtllib (material)
+		case 'g':	// group name
+		case 's':	// smoothing can be a group or off (equiv. to 0)
+		case 'u':	// usemtl
+			goAndCopyNextWord(tmpbuf, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
+			chunk.statements.push_back({bufPtr[0],chunk.getFaceCount(),tmpbuf});
+			break;
 
-	vec[1] = 1.f-vec[1]; // change handedness
-	return bufPtr;
+		case 'v':	// v, vn, vt
+			// resets the material flags, doing that once between two faces is enough
+			if (chunk.statements.empty() || chunk.statements.back().type!='v' || chunk.statements.back().faceCount!=chunk.getFaceCount())
+				chunk.statements.push_back({'v',chunk.getFaceCount(),{}});
+			switch ((bufPtr+1!=bufEnd) ? bufPtr[1]:'\0')
+			{
+			case ' ':	// vertex
+			case 'n':	// normal
+				{
+					SParsedChunk::vec3 vec = {};
+					readFloats<3u>(bufPtr, vec.data, bufEnd);
+					vec.data[0] = -vec.data[0]; // change handedness
+					if (rightHanded)
+						vec.data[0] = -vec.data[0];
+					(bufPtr[1]==' ' ? chunk.positions:chunk.normals).push_back(vec);
+				}
+				break;
+			case 't':	// texcoord
+				{
+					SParsedChunk::vec2 vec = {};
+					readFloats<2u>(bufPtr, vec.data, bufEnd);
+					vec.data[1] = 1.f-vec.data[1]; // change handedness
+					chunk.uvs.push_back(vec);
+				}
+				break;
+			}
+			break;
+
+		case 'f':	// face
+			{
+				const int32_t localCounts[3] = {
+					static_cast<int32_t>(chunk.positions.size()),
+					static_cast<int32_t>(chunk.uvs.size()),
+					static_cast<int32_t>(chunk.normals.size())
+				};
+				// read in all vertices
+				for (const char* wordPtr=goNextWord(bufPtr, lineEnd); wordPtr!=lineEnd; wordPtr=goNextWord(wordPtr, lineEnd))
+				{
+					// words used to get copied into a buffer of `WORD_BUFFER_LENGTH`
+					const char* wordEnd = wordPtr;
+					while (wordEnd!=lineEnd && !core::isspace(*wordEnd) && wordEnd-wordPtr<WORD_BUFFER_LENGTH-1u)
+						++wordEnd;
+					SParsedChunk::SCorner corner;
+					corner.relativeMask = parseCorner(wordPtr, wordEnd, localCounts, corner.idx);
+					chunk.corners.push_back(corner);
+				}
+				chunk.faceEnds.push_back(chunk.corners.size());
+			}
+			break;
+
+		default:
+			break;
+		}	// end switch(bufPtr[0])
+		// eat up rest of line
+		bufPtr = goFirstWord(lineEnd, bufEnd);
+	}
 }
 
 
@@ -625,9 +937,10 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 	}
 
 	uint32_t i = 0;
-	while(inBuf[i])
+	// the buffer may be a mapping of the file, so don't look past its end
+	while(&(inBuf[i]) != bufEnd && inBuf[i])
 	{
-		if (core::isspace(inBuf[i]) || &(inBuf[i]) == bufEnd)
+		if (core::isspace(inBuf[i]))
 			break;
 		++i;
 	}
@@ -641,23 +954,6 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 }
 
 
-std::string COBJMeshFileLoader::copyLine(const char* inBuf, const char* bufEnd)
-{
-	if (!inBuf)
-		return std::string();
-
-	const char* ptr = inBuf;
-	while (ptr<bufEnd)
-	{
-		if (*ptr=='\n' || *ptr=='\r')
-			break;
-		++ptr;
-	}
-	// we must avoid the +1 in case the array is used up
-	return std::string(inBuf, (uint32_t)(ptr-inBuf+((ptr < bufEnd) ? 1 : 0)));
-}
-
-
 const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* bufEnd)
 {
 	inBuf = goNextWord(inBuf, bufEnd, false);
@@ -666,74 +962,6 @@ const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBu
 }
 
 
-bool COBJMeshFileLoader::retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize)
-{
-	char word[16] = "";
-	const char* p = goFirstWord(vertexData, bufEnd);
-	uint32_t idxType = 0;	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
-
-	uint32_t i = 0;
-	while ( p != bufEnd )
-	{
-		if ( ( core::isdigit(*p)) || (*p == '-') )
-		{
-			// build up the number
-			word[i++] = *p;
-		}
-		else if ( *p == '/' || *p == ' ' || *p == '\0' )
-		{
-			// number is completed. Convert and store it
-			word[i] = '\0';
-			// if no number was found index will become 0 and later on -1 by decrement
-			sscanf(word,"%d",idx+idxType);
-			if (idx[idxType]<0)
-			{
-				switch (idxType)
-				{
-					case 0:
-						idx[idxType] += vbsize;
-						break;
-					case 1:
-						idx[idxType] += vtsize;
-						break;
-					case 2:
-						idx[idxType] += vnsize;
-						break;
-				}
-			}
-			else
-				idx[idxType]-=1;
-
-			// reset the word
-			word[0] = '\0';
-			i = 0;
-
-			// go to the next kind of index type
-			if (*p == '/')
-			{
-				if ( ++idxType > 2 )
-				{
-					// error checking, shouldn't reach here unless file is wrong
-					idxType = 0;
-				}
-			}
-			else
-			{
-				// set all missing values to disable (=-1)
-				while (++idxType < 3)
-					idx[idxType]=-1;
-				++p;
-				break; // while
-			}
-		}
-
-		// go to the next char
-		++p;
-	}
-
-	return true;
-}
-
 std::string COBJMeshFileLoader::genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const
 {
     return _baseKey + "?" + _grpName + "?" + _mtlName;
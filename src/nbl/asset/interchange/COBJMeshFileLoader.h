@@ -104,23 +104,21 @@ private:
 	const char* goNextLine(const char* buf, const char* const bufEnd);
 	// copies the current word from the inBuf to the outBuf
 	uint32_t copyWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
-	// copies the current line from the inBuf to the outBuf
-	std::string copyLine(const char* inBuf, const char* const bufEnd);
 
 	// combination of goNextWord followed by copyWord
 	const char* goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
 
-	//! Read 3d vector of floats
-	const char* readVec3(const char* bufPtr, float vec[3], const char* const pBufEnd);
-	//! Read 2d vector of floats
-	const char* readUV(const char* bufPtr, float vec[2], const char* const pBufEnd);
+	//! Read N floats from the words following the current one
+	template<uint32_t N>
+	const char* readFloats(const char* bufPtr, float vec[N], const char* const pBufEnd);
 	//! Read boolean value represented as 'on' or 'off'
 	const char* readBool(const char* bufPtr, bool& tf, const char* const bufEnd);
 
-	// reads and convert to integer the vertex indices in a line of obj file's face statement
-	// -1 for the index if it doesn't exist
-	// indices are changed to 0-based index instead of 1-based from the obj file
-	bool retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize);
+	// The file gets split at line boundaries into chunks which get parsed in parallel, everything which depends on the statements
+	// before it (relative indices, materials, groups, smoothing groups and the vertex deduplication) gets resolved afterwards in file order.
+	struct SParsedChunk;
+	// parses every statement starting in [bufPtr,chunkEnd), `bufPtr` needs to point at the first statement
+	void parseChunk(SParsedChunk& chunk, const char* bufPtr, const char* const chunkEnd, const char* const bufEnd, const bool rightHanded);
 
     std::string genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const;
 
@@ -9,6 +9,8 @@
 
 #include <numeric>
 
+#include "nbl/core/execution.h"
+#include "nbl/core/SCPUFeatures.h"
 #include "nbl/asset/IAssetManager.h"
 #include "nbl/system/ISystem.h"
 #include "nbl/system/IFile.h"
@@ -19,6 +21,119 @@ namespace nbl
 namespace asset
 {
 
+namespace
+{
+
+inline uint32_t getPropertyTypeSize(const E_PLY_PROPERTY_TYPE t)
+{
+	switch (t)
+	{
+	case EPLYPT_INT8:
+		return 1;
+	case EPLYPT_INT16:
+		return 2;
+	case EPLYPT_INT32:
+	case EPLYPT_FLOAT32:
+		return 4;
+	case EPLYPT_FLOAT64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+template<typename T>
+inline T loadBinary(const uint8_t* src, const bool wrongEndian)
+{
+	T value;
+	memcpy(&value, src, sizeof(T));
+	return wrongEndian ? core::Byteswap::byteswap(value) : value;
+}
+
+inline double loadBinaryDouble(const uint8_t* src, const bool wrongEndian)
+{
+	uint8_t tmp[8];
+	memcpy(tmp, src, 8);
+	if (wrongEndian)
+		std::reverse(tmp, tmp + 8);
+	double value;
+	memcpy(&value, tmp, 8);
+	return value;
+}
+
+// binary conversions of `getFloat` and `getInt`, the types without a size make them step over one byte
+inline float decodeFloat(const uint8_t* src, const E_PLY_PROPERTY_TYPE t, const bool wrongEndian)
+{
+	switch (t)
+	{
+	case EPLYPT_INT8:
+		return static_cast<int8_t>(*src);
+	case EPLYPT_INT16:
+		return loadBinary<int16_t>(src, wrongEndian);
+	case EPLYPT_INT32:
+		return float(loadBinary<int32_t>(src, wrongEndian));
+	case EPLYPT_FLOAT32:
+		return loadBinary<float>(src, wrongEndian);
+	case EPLYPT_FLOAT64:
+		return float(loadBinaryDouble(src, wrongEndian));
+	default:
+		return 0.0f;
+	}
+}
+
+inline uint32_t decodeInt(const uint8_t* src, const E_PLY_PROPERTY_TYPE t, const bool wrongEndian)
+{
+	switch (t)
+	{
+	case EPLYPT_INT8:
+		return *src;
+	case EPLYPT_INT16:
+		return loadBinary<uint16_t>(src, wrongEndian);
+	case EPLYPT_INT32:
+		return loadBinary<int32_t>(src, wrongEndian);
+	case EPLYPT_FLOAT32:
+		return (uint32_t)loadBinary<float>(src, wrongEndian);
+	case EPLYPT_FLOAT64:
+		return (uint32_t)loadBinaryDouble(src, wrongEndian);
+	default:
+		return 0;
+	}
+}
+
+#ifdef _NBL_CPU_X86_64_
+_NBL_CPU_TARGET("avx2") void byteswapCopy32AVX2(const uint8_t* src, uint8_t* dst, const size_t count)
+{
+	const __m256i shuffle = _mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+	size_t i = 0u;
+	for (; i+8u<=count; i+=8u)
+	{
+		const __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src+i*4u));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i*4u), _mm256_shuffle_epi8(words, shuffle));
+	}
+	for (; i<count; i++)
+	{
+		const uint32_t word = loadBinary<uint32_t>(src+i*4u, true);
+		memcpy(dst+i*4u, &word, 4u);
+	}
+}
+#endif
+
+// copies `count` 32bit words while swapping their byte order
+inline void byteswapCopy32(const uint8_t* src, uint8_t* dst, const size_t count)
+{
+	#ifdef _NBL_CPU_X86_64_
+	if (core::impl::getCPUFeatures().avx2)
+		return byteswapCopy32AVX2(src, dst, count);
+	#endif
+	for (size_t i = 0u; i<count; i++)
+	{
+		const uint32_t word = loadBinary<uint32_t>(src+i*4u, true);
+		memcpy(dst+i*4u, &word, 4u);
+	}
+}
+
+}
+
 CPLYMeshFileLoader::CPLYMeshFileLoader(IAssetManager* _am) 
 	: IRenderpassIndependentPipelineLoader(_am)
 {
@@ -183,7 +298,8 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 			_file
 		},
 		_hierarchyLevel,
-		_override
+		_override,
+		system::CBufferedFileReader(_file)
 	};
 
 	// attempt to allocate the buffer and fill with data
@@ -356,6 +472,20 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 
 			bool hasNormals = true;
 
+			if (ctx.IsBinaryFile && ctx.reader.isZeroCopy())
+				ctx.MappedData = reinterpret_cast<const uint8_t*>(static_cast<const system::IFile*>(_file)->getMappedPointer());
+			// an element the fast paths can't handle goes through the line buffer starting where they stopped
+			auto tryReadBinary = [&](auto readElement) -> bool
+			{
+				if (!ctx.MappedData)
+					return false;
+				size_t offset = getBinaryOffset(ctx);
+				if (!readElement(offset))
+					return false;
+				seekBinary(ctx, offset);
+				return true;
+			};
+
 			// loop through each of the elements
 			for (uint32_t i=0; i<ctx.ElementList.size(); ++i)
 			{
@@ -402,12 +532,18 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 						}			
 					}
 
+					if (tryReadBinary([&](size_t& offset) { return readVerticesBinary(ctx, plyVertexElement, attributes, offset, _params); }))
+						continue;
+
 					// loop through vertex properties
 					for (uint32_t j=0; j<ctx.ElementList[i]->Count; ++j)
 						hasNormals &= readVertex(ctx, plyVertexElement, attributes, j, _params);
 				}
 				else if (ctx.ElementList[i]->Name == "face")
 				{
+					if (tryReadBinary([&](size_t& offset) { return readFacesBinary(ctx, *ctx.ElementList[i], &indices, offset); }))
+						continue;
+
 					const size_t indicesCount = ctx.ElementList[i]->Count;
 
 					// read faces
@@ -416,6 +552,9 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 				}
 				else
 				{
+					if (tryReadBinary([&](size_t& offset) { return readFacesBinary(ctx, *ctx.ElementList[i], nullptr, offset); }))
+						continue;
+
 					// skip these elements
 					for (uint32_t j=0; j < ctx.ElementList[i]->Count; ++j)
 						skipElement(ctx, *ctx.ElementList[i]);
@@ -670,6 +809,271 @@ bool CPLYMeshFileLoader::readFace(SContext& _ctx, const SPLYElement& Element, co
 }
 
 
+bool CPLYMeshFileLoader::readVerticesBinary(SContext& _ctx, const SPLYElement& Element, asset::SBufferBinding<asset::ICPUBuffer> outAttributes[4], size_t& offset, const IAssetLoader::SAssetLoadParams& _params)
+{
+	const size_t stride = Element.KnownSize;
+	if (!Element.IsFixedWidth || !stride || (_ctx.inner.mainFile->getSize()-offset)/stride < Element.Count)
+		return false;
+
+	// where every property we care about goes, same mapping of names as in `readVertex`
+	struct SPropertyCopy
+	{
+		uint32_t srcOffset;
+		E_PLY_PROPERTY_TYPE type;
+		E_TYPE attribute;
+		uint32_t component;
+		// colors stored as integers get normalized
+		bool normalize;
+		bool flip;
+	};
+	core::vector<SPropertyCopy> copies;
+	const bool rightHanded = _params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES;
+	bool allFloat32 = true, allWords = true;
+	{
+		uint32_t srcOffset = 0u;
+		for (const auto& property : Element.Properties)
+		{
+			const auto& name = property.Name;
+			auto addCopy = [&](const E_TYPE attribute, const uint32_t component, const bool flip=false) -> void
+			{
+				copies.push_back({srcOffset,property.Type,attribute,component,attribute==ET_COL && !property.isFloat(),flip && rightHanded});
+				allFloat32 = allFloat32 && property.Type==EPLYPT_FLOAT32;
+			};
+			if (name == "x")
+				addCopy(ET_POS, 0u, true);
+			else if (name == "y")
+				addCopy(ET_POS, 1u);
+			else if (name == "z")
+				addCopy(ET_POS, 2u);
+			else if (name == "nx")
+				addCopy(ET_NORM, 0u, true);
+			else if (name == "ny")
+				addCopy(ET_NORM, 1u);
+			else if (name == "nz")
+				addCopy(ET_NORM, 2u);
+			else if (name == "u" || name == "s")
+				addCopy(ET_UV, 0u);
+			else if (name == "v" || name == "t")
+				addCopy(ET_UV, 1u);
+			else if (name == "red")
+				addCopy(ET_COL, 0u);
+			else if (name == "green")
+				addCopy(ET_COL, 1u);
+			else if (name == "blue")
+				addCopy(ET_COL, 2u);
+			else if (name == "alpha")
+				addCopy(ET_COL, 3u);
+			allWords = allWords && property.size() == 4u;
+			srcOffset += property.size();
+		}
+	}
+	offset += stride * Element.Count;
+	if (copies.empty())
+		return true;
+
+	constexpr uint32_t AttributeComponents[4] = { 3u, 4u, 2u, 3u };
+	uint8_t* dstAttributes[4] = {};
+	for (const auto& copy : copies)
+		dstAttributes[copy.attribute] = reinterpret_cast<uint8_t*>(outAttributes[copy.attribute].buffer->getPointer());
+	// the element is exactly the components of one attribute in order, so it can get copied as a whole
+	const bool bulkCopy = allFloat32 && copies.size() == Element.Properties.size() && copies.size() == AttributeComponents[copies[0].attribute] && [&]() -> bool
+	{
+		for (uint32_t i = 0u; i < copies.size(); ++i)
+			if (copies[i].attribute != copies[0].attribute || copies[i].component != i)
+				return false;
+		return true;
+	}();
+
+	constexpr size_t VerticesPerChunk = 0x1ull << 14u;
+	const uint8_t* const src = _ctx.MappedData + offset - stride * Element.Count;
+	const bool wrongEndian = _ctx.IsWrongEndian;
+	core::vector<uint32_t> chunks((Element.Count + VerticesPerChunk - 1ull) / VerticesPerChunk);
+	std::iota(chunks.begin(), chunks.end(), 0u);
+	core::for_each(core::execution::par, chunks.begin(), chunks.end(), [&](const uint32_t chunk) -> void
+	{
+		const size_t begin = chunk * VerticesPerChunk;
+		const size_t count = core::min<size_t>(Element.Count - begin, VerticesPerChunk);
+		const uint8_t* chunkSrc = src + begin * stride;
+		if (bulkCopy)
+		{
+			uint8_t* const dst = dstAttributes[copies[0].attribute] + begin * stride;
+			if (wrongEndian)
+				byteswapCopy32(chunkSrc, dst, count * copies.size());
+			else
+				memcpy(dst, chunkSrc, count * stride);
+			if (copies[0].flip)
+			for (size_t j = 0u; j < count; ++j)
+			{
+				float* const value = reinterpret_cast<float*>(dst + j * stride);
+				*value = -*value;
+			}
+			return;
+		}
+
+		// the floats of records made of 32bit words only get swapped all at once before getting scattered into the attributes
+		core::vector<uint8_t> swapped;
+		if (allFloat32 && allWords && wrongEndian)
+		{
+			swapped.resize(count * stride);
+			byteswapCopy32(chunkSrc, swapped.data(), count * stride / 4u);
+			chunkSrc = swapped.data();
+		}
+		const bool swapEach = wrongEndian && swapped.empty();
+		for (size_t j = 0u; j < count; ++j)
+		{
+			const uint8_t* const record = chunkSrc + j * stride;
+			for (const auto& copy : copies)
+			{
+				float value;
+				if (copy.normalize)
+					value = float(decodeInt(record + copy.srcOffset, copy.type, swapEach)) / 255.f;
+				else
+					value = decodeFloat(record + copy.srcOffset, copy.type, swapEach);
+				if (copy.flip)
+					value = -value;
+				const size_t dstOffset = ((begin + j) * AttributeComponents[copy.attribute] + copy.component) * sizeof(float);
+				memcpy(dstAttributes[copy.attribute] + dstOffset, &value, sizeof(float));
+			}
+		}
+	});
+	return true;
+}
+
+
+bool CPLYMeshFileLoader::readFacesBinary(SContext& _ctx, const SPLYElement& Element, core::vector<uint32_t>* _outIndices, size_t& offset)
+{
+	const uint8_t* const data = _ctx.MappedData;
+	const size_t dataSize = _ctx.inner.mainFile->getSize();
+	const bool wrongEndian = _ctx.IsWrongEndian;
+	auto isIndexList = [_outIndices](const SPLYProperty& property) -> bool
+	{
+		return _outIndices && (property.Name == "vertex_indices" || property.Name == "vertex_index") && property.Type == EPLYPT_LIST;
+	};
+
+	if (Element.IsFixedWidth)
+	{
+		if ((dataSize - offset) / core::max(Element.KnownSize, 1u) < Element.Count)
+			return false;
+		offset += size_t(Element.KnownSize) * Element.Count;
+		return true;
+	}
+
+	// the lists make the faces variable width, so one pass to find out where every chunk of faces starts and how many indices come before it
+	constexpr uint32_t FacesPerChunk = 0x1u << 14u;
+	struct SChunk
+	{
+		size_t srcOffset;
+		size_t firstIndex;
+	};
+	core::vector<SChunk> chunks;
+	chunks.reserve((Element.Count + FacesPerChunk - 1u) / FacesPerChunk);
+	size_t pos = offset;
+	size_t indexCount = 0u;
+	for (uint32_t j = 0u; j < Element.Count; ++j)
+	{
+		if (j % FacesPerChunk == 0u)
+			chunks.push_back({ pos,indexCount });
+		for (const auto& property : Element.Properties)
+		{
+			if (property.Type != EPLYPT_LIST)
+			{
+				pos += property.size();
+				if (pos > dataSize)
+					return false;
+				continue;
+			}
+			const uint32_t countSize = getPropertyTypeSize(property.Data.List.CountType);
+			if (dataSize - pos < countSize)
+				return false;
+			const uint32_t count = decodeInt(data + pos, property.Data.List.CountType, wrongEndian);
+			pos += countSize;
+			if (isIndexList(property))
+			{
+				// `readFace` reads 3 indices no matter what
+				if (count < 3u)
+					return false;
+				indexCount += 3ull * (count - 2u);
+			}
+			const size_t listSize = size_t(count) * getPropertyTypeSize(property.Data.List.ItemType);
+			if (dataSize - pos < listSize)
+				return false;
+			pos += listSize;
+		}
+	}
+	offset = pos;
+	if (!indexCount)
+		return true;
+
+	const size_t firstIndex = _outIndices->size();
+	_outIndices->resize(firstIndex + indexCount);
+	uint32_t* const outIndices = _outIndices->data() + firstIndex;
+	core::vector<uint32_t> chunkIndices(chunks.size());
+	std::iota(chunkIndices.begin(), chunkIndices.end(), 0u);
+	core::for_each(core::execution::par, chunkIndices.begin(), chunkIndices.end(), [&](const uint32_t chunk) -> void
+	{
+		size_t pos = chunks[chunk].srcOffset;
+		uint32_t* out = outIndices + chunks[chunk].firstIndex;
+		const uint32_t faceEnd = core::min(Element.Count, (chunk + 1u) * FacesPerChunk);
+		for (uint32_t j = chunk * FacesPerChunk; j < faceEnd; ++j)
+		for (const auto& property : Element.Properties)
+		{
+			if (property.Type != EPLYPT_LIST)
+			{
+				pos += property.size();
+				continue;
+			}
+			const uint32_t count = decodeInt(data + pos, property.Data.List.CountType, wrongEndian);
+			pos += getPropertyTypeSize(property.Data.List.CountType);
+			const E_PLY_PROPERTY_TYPE itemType = property.Data.List.ItemType;
+			const uint32_t itemSize = getPropertyTypeSize(itemType);
+			if (!isIndexList(property))
+			{
+				pos += size_t(count) * itemSize;
+				continue;
+			}
+
+			// same fan triangulation as `readFace`
+			auto nextIndex = [&]() -> uint32_t
+			{
+				const uint32_t index = decodeInt(data + pos, itemType, wrongEndian);
+				pos += itemSize;
+				return index;
+			};
+			const uint32_t a = nextIndex();
+			uint32_t b = nextIndex(), c = nextIndex();
+			*(out++) = a;
+			*(out++) = b;
+			*(out++) = c;
+			for (uint32_t k = 3u; k < count; ++k)
+			{
+				b = c;
+				c = nextIndex();
+				*(out++) = a;
+				*(out++) = c;
+				*(out++) = b;
+			}
+		}
+	});
+	return true;
+}
+
+
+size_t CPLYMeshFileLoader::getBinaryOffset(const SContext& _ctx) const
+{
+	return _ctx.reader.tell() - (_ctx.EndPointer - _ctx.StartPointer);
+}
+
+
+void CPLYMeshFileLoader::seekBinary(SContext& _ctx, const size_t offset)
+{
+	_ctx.reader.seek(offset);
+	_ctx.StartPointer = _ctx.Buffer;
+	_ctx.EndPointer = _ctx.Buffer;
+	_ctx.EndOfFile = false;
+	fillBuffer(_ctx);
+}
+
+
 // skips an element and all properties. return false on EOF
 void CPLYMeshFileLoader::skipElement(SContext& _ctx, const SPLYElement& Element)
 {
@@ -691,7 +1095,7 @@ void CPLYMeshFileLoader::skipProperty(SContext& _ctx, const SPLYProperty &Proper
 		int32_t count = getInt(_ctx, Property.Data.List.CountType);
 
 		for (int32_t i=0; i < count; ++i)
-			getInt(_ctx, Property.Data.List.CountType);
+			getInt(_ctx, Property.Data.List.ItemType);
 	}
 	else
 	{
@@ -747,18 +1151,15 @@ void CPLYMeshFileLoader::fillBuffer(SContext& _ctx)
 	_ctx.StartPointer = _ctx.Buffer;
 	_ctx.EndPointer = _ctx.StartPointer + length;
 
-	if (_ctx.fileOffset >= _ctx.inner.mainFile->getSize() - 1) // TODO: check it
+	if (_ctx.reader.eof())
 	{
 		_ctx.EndOfFile = true;
 	}
 	else
 	{
-		// read data from the file
-		system::IFile::success_t success;
-		_ctx.inner.mainFile->read(success, _ctx.EndPointer, _ctx.fileOffset, PLY_INPUT_BUFFER_SIZE - length);
-		const size_t bytesRead = success.getBytesProcessed();
+		// read data from the file, the next chunk is already being read ahead in the background
+		const size_t bytesRead = _ctx.reader.read(_ctx.EndPointer, PLY_INPUT_BUFFER_SIZE - length);
 
-		_ctx.fileOffset += bytesRead;
 		// increment the end pointer by the number of bytes read
 		_ctx.EndPointer += bytesRead;
 
@@ -1010,48 +1411,8 @@ float CPLYMeshFileLoader::getFloat(SContext& _ctx, E_PLY_PROPERTY_TYPE t)
 
 		if (_ctx.EndPointer - _ctx.StartPointer > 0)
 		{
-			switch (t)
-			{
-			case EPLYPT_INT8:
-				retVal = *_ctx.StartPointer;
-				_ctx.StartPointer++;
-				break;
-			case EPLYPT_INT16:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<int16_t*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<int16_t*>(_ctx.StartPointer));
-				_ctx.StartPointer += 2;
-				break;
-			case EPLYPT_INT32:
-				if (_ctx.IsWrongEndian)
-					retVal = float(core::Byteswap::byteswap(*(reinterpret_cast<int32_t*>(_ctx.StartPointer))));
-				else
-					retVal = float(*(reinterpret_cast<int32_t*>(_ctx.StartPointer)));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT32:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<float*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<float*>(_ctx.StartPointer));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT64:
-				char tmp[8];
-				memcpy(tmp, _ctx.StartPointer, 8);
-				if (_ctx.IsWrongEndian)
-					for (size_t i = 0u; i < 4u; ++i)
-						std::swap(tmp[i], tmp[7u - i]);
-				retVal = float(*(reinterpret_cast<double*>(tmp)));
-				_ctx.StartPointer += 8;
-				break;
-			case EPLYPT_LIST:
-			case EPLYPT_UNKNOWN:
-			default:
-				retVal = 0.0f;
-				_ctx.StartPointer++; // ouch!
-			}
+			retVal = decodeFloat(reinterpret_cast<const uint8_t*>(_ctx.StartPointer), t, _ctx.IsWrongEndian);
+			_ctx.StartPointer += core::max(getPropertyTypeSize(t), 1u); // ouch for lists and unknown types!
 		}
 		else
 			retVal = 0.0f;
@@ -1093,44 +1454,8 @@ uint32_t CPLYMeshFileLoader::getInt(SContext& _ctx, E_PLY_PROPERTY_TYPE t)
 
 		if (_ctx.EndPointer - _ctx.StartPointer)
 		{
-			switch (t)
-			{
-			case EPLYPT_INT8:
-				retVal = *_ctx.StartPointer;
-				_ctx.StartPointer++;
-				break;
-			case EPLYPT_INT16:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<uint16_t*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<uint16_t*>(_ctx.StartPointer));
-				_ctx.StartPointer += 2;
-				break;
-			case EPLYPT_INT32:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<int32_t*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<int32_t*>(_ctx.StartPointer));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT32:
-				if (_ctx.IsWrongEndian)
-					retVal = (uint32_t)core::Byteswap::byteswap(*(reinterpret_cast<float*>(_ctx.StartPointer)));
-				else
-					retVal = (uint32_t)(*(reinterpret_cast<float*>(_ctx.StartPointer)));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT64:
-				// todo: byteswap 64-bit
-				retVal = (uint32_t)(*(reinterpret_cast<double*>(_ctx.StartPointer)));
-				_ctx.StartPointer += 8;
-				break;
-			case EPLYPT_LIST:
-			case EPLYPT_UNKNOWN:
-			default:
-				retVal = 0;
-				_ctx.StartPointer++; // ouch!
-			}
+			retVal = decodeInt(reinterpret_cast<const uint8_t*>(_ctx.StartPointer), t, _ctx.IsWrongEndian);
+			_ctx.StartPointer += core::max(getPropertyTypeSize(t), 1u); // ouch for lists and unknown types!
 		}
 		else
 			retVal = 0;
@@ -12,6 +12,8 @@
 #include "nbl/asset/interchange/IRenderpassIndependentPipelineLoader.h"
 #include "nbl/asset/metadata/CPLYMetadata.h"
 
+#include "nbl/system/CBufferedFileReader.h"
+
 namespace nbl
 {
 namespace asset
@@ -178,14 +180,17 @@ private:
 		IAssetLoader::SAssetLoadContext inner;
 		uint32_t topHierarchyLevel;
 		IAssetLoader::IAssetLoaderOverride* loaderOverride;
+		// does the read-ahead, `Buffer` is still needed because the lines get null terminated in place
+		system::CBufferedFileReader reader;
 
         core::vector<std::unique_ptr<SPLYElement>> ElementList;
 	
 		char* Buffer = nullptr;
+		// set for binary files which are mapped, the elements get read straight out of the mapping whenever possible
+		const uint8_t* MappedData = nullptr;
         bool IsBinaryFile = false, IsWrongEndian = false, EndOfFile = false;
         int32_t LineLength = 0, WordLength = 0;
 		char* StartPointer = nullptr, *EndPointer = nullptr, *LineEndPointer = nullptr;
-		size_t fileOffset = {};
     };
 
 	bool allocateBuffer(SContext& _ctx);
@@ -197,6 +202,15 @@ private:
  	bool readVertex(SContext& _ctx, const SPLYElement &Element, asset::SBufferBinding<asset::ICPUBuffer> outAttributes[4], const uint32_t& currentVertexIndex, const IAssetLoader::SAssetLoadParams& _params);
 	bool readFace(SContext& _ctx, const SPLYElement &Element, core::vector<uint32_t>& _outIndices);
 
+	// fast paths for mapped binary files, `offset` is where the element starts in the file and gets moved past it on success
+	// on failure nothing has been read, the element needs to go through the line buffer instead
+	bool readVerticesBinary(SContext& _ctx, const SPLYElement& Element, asset::SBufferBinding<asset::ICPUBuffer> outAttributes[4], size_t& offset, const IAssetLoader::SAssetLoadParams& _params);
+	// skips the element if `_outIndices` is null
+	bool readFacesBinary(SContext& _ctx, const SPLYElement& Element, core::vector<uint32_t>* _outIndices, size_t& offset);
+	// offset in the file of the next byte the binary getters will read, and moving it
+	size_t getBinaryOffset(const SContext& _ctx) const;
+	void seekBinary(SContext& _ctx, const size_t offset);
+
 	void skipElement(SContext& _ctx, const SPLYElement &Element);
 	void skipProperty(SContext& _ctx, const SPLYProperty &Property);
 	float getFloat(SContext& _ctx, E_PLY_PROPERTY_TYPE t);
@@ -9,6 +9,9 @@
 
 #include "nbl/asset/asset.h"
 #include "nbl/asset/utils/CQuantNormalCache.h"
+#include "nbl/core/algorithm/radix_sort.h"
+
+#include <atomic>
 
 #include "nbl/asset/IAssetManager.h"
 
@@ -23,6 +26,125 @@ constexpr auto COLOR_ATTRIBUTE = 1;
 constexpr auto UV_ATTRIBUTE = 2;
 constexpr auto NORMAL_ATTRIBUTE = 3;
 
+// 80 byte header and the facet count
+constexpr size_t BINARY_HEADER_SIZE = 84ull;
+// normal, 3 vertices and the attribute word
+constexpr size_t BINARY_FACET_SIZE = 50ull;
+
+namespace
+{
+
+// splits [0,count) into chunks of `chunkSize`, one task each
+template<typename F>
+inline void forEachChunk(const size_t count, const size_t chunkSize, F&& f)
+{
+	core::vector<size_t> chunks((count+chunkSize-1ull)/chunkSize);
+	std::iota(chunks.begin(),chunks.end(),0ull);
+	core::for_each(core::execution::par,chunks.begin(),chunks.end(),[&](const size_t chunk) -> void
+	{
+		const size_t begin = chunk*chunkSize;
+		f(begin,core::min(begin+chunkSize,count));
+	});
+}
+
+// a facet without a normal gets the one of its plane, `p` is in the order of the file
+inline void finishFacetNormal(core::vectorSIMDf& normal, const core::vectorSIMDf p[3])
+{
+	if ((normal == core::vectorSIMDf()).all())
+		normal = core::plane3dSIMDf(p[2], p[1], p[0]).getNormal();
+	else
+		normal = core::normalize(normal);
+}
+
+//! Merges the vertices which are identical in every byte, the first occurrences are kept in their original order.
+// The vertices get sorted by a 64bit hash together with their indices, so equal vertices only need to be looked for among the ones with the same hash.
+core::smart_refctd_ptr<ICPUBuffer> weldVertices(const uint8_t* const vertices, const size_t vertexSize, const uint32_t vertexCount, core::vector<uint32_t>& outIndices)
+{
+	auto getVertex = [&](const uint32_t i) -> const uint8_t* { return vertices + size_t(i) * vertexSize; };
+
+	core::vector<uint64_t> keys(size_t(vertexCount) << 1u);
+	core::vector<uint32_t> values(size_t(vertexCount) << 1u);
+	forEachChunk(vertexCount, 0x1ull << 16u, [&](const size_t begin, const size_t end) -> void
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint8_t* const vertex = getVertex(i);
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (size_t offset = 0u; offset < vertexSize; offset += sizeof(uint32_t))
+			{
+				uint32_t word;
+				memcpy(&word, vertex + offset, sizeof(uint32_t));
+				hash = (hash ^ word) * 0x100000001b3ull;
+			}
+			hash = (hash ^ (hash >> 29u)) * 0xbf58476d1ce4e5b9ull;
+			keys[i] = hash ^ (hash >> 32u);
+			values[i] = i;
+		}
+	});
+	const auto sorted = core::radix_sort_by_key(core::execution::par, keys.begin(), keys.begin() + vertexCount, values.begin(), values.begin() + vertexCount, vertexCount);
+	const auto sortedKeys = sorted.first;
+	const auto sortedValues = sorted.second;
+
+	// the sort is stable so every run of equal hashes starts with the lowest index, chunks must not split runs
+	core::vector<uint32_t> firstOccurrence(vertexCount);
+	{
+		const size_t chunkCount = std::clamp<size_t>(vertexCount >> 16u, 1ull, std::max<size_t>(std::thread::hardware_concurrency(), 1ull) * 4ull);
+		core::vector<size_t> chunkBegins(chunkCount + 1ull, vertexCount);
+		chunkBegins[0] = 0ull;
+		for (size_t i = 1ull; i < chunkCount; ++i)
+		{
+			size_t begin = std::max<size_t>(vertexCount * i / chunkCount, chunkBegins[i - 1ull]);
+			while (begin < vertexCount && begin && sortedKeys[begin] == sortedKeys[begin - 1ull])
+				++begin;
+			chunkBegins[i] = begin;
+		}
+		core::vector<size_t> chunks(chunkCount);
+		std::iota(chunks.begin(), chunks.end(), 0ull);
+		core::for_each(core::execution::par, chunks.begin(), chunks.end(), [&](const size_t chunk) -> void
+		{
+			size_t runBegin = chunkBegins[chunk];
+			for (size_t j = runBegin; j < chunkBegins[chunk + 1ull]; ++j)
+			{
+				if (sortedKeys[j] != sortedKeys[runBegin])
+					runBegin = j;
+				const uint32_t v = sortedValues[j];
+				firstOccurrence[v] = v;
+				for (size_t k = runBegin; k < j; ++k)
+				{
+					const uint32_t u = sortedValues[k];
+					if (firstOccurrence[u] == u && memcmp(getVertex(u), getVertex(v), vertexSize) == 0)
+					{
+						firstOccurrence[v] = u;
+						break;
+					}
+				}
+			}
+		});
+	}
+
+	core::vector<uint32_t> remap(vertexCount);
+	uint32_t uniqueCount = 0u;
+	for (uint32_t i = 0u; i < vertexCount; ++i)
+	if (firstOccurrence[i] == i)
+		remap[i] = uniqueCount++;
+
+	auto welded = core::make_smart_refctd_ptr<ICPUBuffer>(size_t(uniqueCount) * vertexSize);
+	uint8_t* const weldedVertices = reinterpret_cast<uint8_t*>(welded->getPointer());
+	outIndices.resize(vertexCount);
+	forEachChunk(vertexCount, 0x1ull << 16u, [&](const size_t begin, const size_t end) -> void
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			outIndices[i] = remap[firstOccurrence[i]];
+			if (firstOccurrence[i] == i)
+				memcpy(weldedVertices + size_t(remap[i]) * vertexSize, getVertex(i), vertexSize);
+		}
+	});
+	return welded;
+}
+
+}
+
 CSTLMeshFileLoader::CSTLMeshFileLoader(asset::IAssetManager* _m_assetMgr)
 	: IRenderpassIndependentPipelineLoader(_m_assetMgr), m_assetMgr(_m_assetMgr)
 {
@@ -134,7 +256,8 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 			_file
 		},
 		_hierarchyLevel,
-		_override
+		_override,
+		system::CBufferedFileReader(_file)
 	};
 
 	if (_params.meshManipulatorOverride == nullptr)
@@ -165,32 +288,19 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 	core::vector<uint32_t> colors;
 	if (binary)
 	{
-		if (_file->getSize() < 80)
-			return {};
-
-		constexpr size_t headerOffset = 80; 
-		context.fileOffset = headerOffset; //! skip header
-
-		uint32_t vertexCount = 0u;
-
-		system::IFile::success_t success;
-		context.inner.mainFile->read(success, &vertexCount, context.fileOffset, sizeof(vertexCount));
-		if (!success)
+		if (!readBinaryFacets(&context, positions, normals, colors))
 			return {};
-		context.fileOffset += sizeof(vertexCount);
-
-		positions.reserve(3 * vertexCount);
-		normals.reserve(vertexCount);
-		colors.reserve(vertexCount);
+		// assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute, only if every facet has one
+		hasColor = colors.size() == normals.size();
+		if (!hasColor)
+			colors.clear();
 	}
 	else
+	{
 		goNextLine(&context); // skip header
 
-	uint16_t attrib = 0u;
-	token.reserve(32);
-	while (context.fileOffset < filesize) // TODO: check it
-	{
-		if (!binary)
+		token.reserve(32);
+		while (context.reader.tell() < filesize) // TODO: check it
 		{
 			if (getNextToken(&context, token) != "facet")
 			{
@@ -202,95 +312,67 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 			{
 				return {};
 			}
-		}
 
-		{
 			core::vectorSIMDf n;
-			getNextVector(&context, n, binary);
+			getNextVector(&context, n);
 			if(_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
 				performActionBasedOnOrientationSystem<float>(n.x, [](float& varToFlip) {varToFlip = -varToFlip;});
-			normals.push_back(core::normalize(n));
-		}
 
-		if (!binary)
-		{
 			if (getNextToken(&context, token) != "outer" || getNextToken(&context, token) != "loop")
 				return {};
-		}
 
-		{
 			core::vectorSIMDf p[3];
 			for (uint32_t i = 0u; i < 3u; ++i)
 			{
-				if (!binary)
-				{
-					if (getNextToken(&context, token) != "vertex")
-						return {};
-				}
-				getNextVector(&context, p[i], binary);
+				if (getNextToken(&context, token) != "vertex")
+					return {};
+				getNextVector(&context, p[i]);
 				if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
 					performActionBasedOnOrientationSystem<float>(p[i].x, [](float& varToFlip){varToFlip = -varToFlip; });
 			}
 			for (uint32_t i = 0u; i < 3u; ++i) // seems like in STL format vertices are ordered in clockwise manner...
 				positions.push_back(p[2u - i]);
-		}
 
-		if (!binary)
-		{
+			finishFacetNormal(n, p);
+			normals.push_back(n);
+
 			if (getNextToken(&context, token) != "endloop" || getNextToken(&context, token) != "endfacet")
 				return {};
-		}
-		else
-		{
-			system::IFile::success_t success;
-			context.inner.mainFile->read(success, &attrib, context.fileOffset, sizeof(attrib));
-			if (!success)
-				return {};
-			context.fileOffset += sizeof(attrib);
-		}
-
-		if (hasColor && (attrib & 0x8000u)) // assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute
-		{
-			const void* srcColor[1]{ &attrib };
-			uint32_t color{};
-			convertColor<EF_A1R5G5B5_UNORM_PACK16, EF_B8G8R8A8_UNORM>(srcColor, &color, 0u, 0u);
-			colors.push_back(color);
-		}
-		else
-		{
-			hasColor = false;
-			colors.clear();
-		}
-
-		if ((normals.back() == core::vectorSIMDf()).all())
-		{
-			normals.back().set(
-				core::plane3dSIMDf(
-					*(positions.rbegin() + 2),
-					*(positions.rbegin() + 1),
-					*(positions.rbegin() + 0)).getNormal()
-			);
-		}
-	} // end while (_file->getPos() < filesize)
+		} // end while (_file->getPos() < filesize)
+	}
 
 	const size_t vtxSize = hasColor ? (3 * sizeof(float) + 4 + 4) : (3 * sizeof(float) + 4);
 	auto vertexBuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(vtxSize * positions.size());
 
 	using quant_normal_t = CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>;
 
-	quant_normal_t normal;
-	for (size_t i = 0u; i < positions.size(); ++i)
+	// the cache isn't thread safe, but neighbouring facets of CAD models mostly have the same normal anyway
+	core::vector<quant_normal_t> quantizedNormals(normals.size());
+	for (size_t i = 0u; i < normals.size(); ++i)
 	{
-		if (i % 3 == 0)
-			normal = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(normals[i / 3]);
-		uint8_t* ptr = ((uint8_t*)(vertexBuf->getPointer())) + i * vtxSize;
-		memcpy(ptr, positions[i].pointer, 3 * 4);
+		if (i && (normals[i] == normals[i - 1u]).all())
+			quantizedNormals[i] = quantizedNormals[i - 1u];
+		else
+			quantizedNormals[i] = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(normals[i]);
+	}
 
-		*reinterpret_cast<quant_normal_t*>(ptr + 12) = normal;
+	forEachChunk(positions.size(), 0x1ull << 16u, [&](const size_t begin, const size_t end) -> void
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			uint8_t* ptr = ((uint8_t*)(vertexBuf->getPointer())) + i * vtxSize;
+			memcpy(ptr, positions[i].pointer, 3 * 4);
 
-		if (hasColor)
-			memcpy(ptr + 16, colors.data() + i / 3, 4);
-	}
+			*reinterpret_cast<quant_normal_t*>(ptr + 12) = quantizedNormals[i / 3];
+
+			if (hasColor)
+				memcpy(ptr + 16, colors.data() + i / 3, 4);
+		}
+	});
+
+	core::vector<uint32_t> indices;
+	if ((_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_WELD_VERTICES) && positions.size() <= std::numeric_limits<uint32_t>::max())
+		vertexBuf = weldVertices(reinterpret_cast<const uint8_t*>(vertexBuf->getPointer()), vtxSize, positions.size(), indices);
 
 	const IAssetLoader::SAssetLoadContext fakeContext(IAssetLoader::SAssetLoadParams{}, nullptr);
 	const asset::IAsset::E_TYPE types[]{ asset::IAsset::ET_RENDERPASS_INDEPENDENT_PIPELINE, (asset::IAsset::E_TYPE)0u };
@@ -307,7 +389,15 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 
 	meshbuffer->setPipeline(std::move(mbPipeline));
 	meshbuffer->setIndexCount(positions.size());
-	meshbuffer->setIndexType(asset::EIT_UNKNOWN);
+	if (indices.empty())
+		meshbuffer->setIndexType(asset::EIT_UNKNOWN);
+	else
+	{
+		auto indexBuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(indices.size() * sizeof(uint32_t));
+		memcpy(indexBuf->getPointer(), indices.data(), indexBuf->getSize());
+		meshbuffer->setIndexBufferBinding({ 0ul, std::move(indexBuf) });
+		meshbuffer->setIndexType(asset::EIT_32BIT);
+	}
 
 	meshbuffer->setVertexBufferBinding({ 0ul, vertexBuf }, 0);
 	mesh->getMeshBufferVector().emplace_back(std::move(meshbuffer));
@@ -348,41 +438,89 @@ bool CSTLMeshFileLoader::isALoadableFileFormat(system::IFile* _file, const syste
 	}
 }
 
-//! Read 3d vector of floats
-void CSTLMeshFileLoader::getNextVector(SContext* context, core::vectorSIMDf& vec, bool binary) const
+bool CSTLMeshFileLoader::readBinaryFacets(SContext* context, core::vector<core::vectorSIMDf>& positions, core::vector<core::vectorSIMDf>& normals, core::vector<uint32_t>& colors) const
 {
-	if (binary)
-	{
-		{
-			system::IFile::success_t success;
-			context->inner.mainFile->read(success, &vec.X, context->fileOffset, 4);
-			context->fileOffset += success.getBytesProcessed();
-		}
-		
-		{
-			system::IFile::success_t success;
-			context->inner.mainFile->read(success, &vec.Y, context->fileOffset, 4);
-			context->fileOffset += success.getBytesProcessed();
-		}
+	system::IFile* const file = context->inner.mainFile;
+	const size_t filesize = file->getSize();
+	// the facet count in the header is not to be trusted, the file size is
+	if (filesize < BINARY_HEADER_SIZE || (filesize - BINARY_HEADER_SIZE) % BINARY_FACET_SIZE)
+		return false;
+	const size_t facetCount = (filesize - BINARY_HEADER_SIZE) / BINARY_FACET_SIZE;
 
-		{
-			system::IFile::success_t success;
-			context->inner.mainFile->read(success, &vec.Z, context->fileOffset, 4);
-			context->fileOffset += success.getBytesProcessed();
-		}
-	}
+	// straight out of the mapping, or one read for all the facets
+	const uint8_t* facets;
+	core::vector<uint8_t> storage;
+	if (context->reader.isZeroCopy())
+		facets = reinterpret_cast<const uint8_t*>(static_cast<const system::IFile*>(file)->getMappedPointer()) + BINARY_HEADER_SIZE;
 	else
 	{
-		goNextWord(context);
-		std::string tmp;
-
-		getNextToken(context, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.X);
-		getNextToken(context, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.Y);
-		getNextToken(context, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.Z);
+		storage.resize(filesize - BINARY_HEADER_SIZE);
+		system::IFile::success_t success;
+		file->read(success, storage.data(), BINARY_HEADER_SIZE, storage.size());
+		if (!success)
+			return false;
+		facets = storage.data();
 	}
+
+	positions.resize(facetCount * 3u);
+	normals.resize(facetCount);
+	colors.resize(facetCount);
+	// `getNextVector` changes the handedness, which the right handed meshes change back
+	const bool flipX = !(context->inner.params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES);
+	std::atomic_bool allColored = true;
+	forEachChunk(facetCount, 0x1ull << 14u, [&](const size_t begin, const size_t end) -> void
+	{
+		bool colored = true;
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint8_t* const facet = facets + i * BINARY_FACET_SIZE;
+			float xyz[12];
+			memcpy(xyz, facet, sizeof(xyz));
+			if (flipX)
+			for (uint32_t j = 0u; j < 12u; j += 3u)
+				xyz[j] = -xyz[j];
+
+			core::vectorSIMDf n(xyz[0], xyz[1], xyz[2]);
+			const core::vectorSIMDf p[3] = {
+				core::vectorSIMDf(xyz[3], xyz[4], xyz[5]),
+				core::vectorSIMDf(xyz[6], xyz[7], xyz[8]),
+				core::vectorSIMDf(xyz[9], xyz[10], xyz[11])
+			};
+			for (uint32_t j = 0u; j < 3u; ++j) // seems like in STL format vertices are ordered in clockwise manner...
+				positions[i * 3u + j] = p[2u - j];
+			finishFacetNormal(n, p);
+			normals[i] = n;
+
+			uint16_t attrib;
+			memcpy(&attrib, facet + 48u, sizeof(attrib));
+			if (attrib & 0x8000u)
+			{
+				const void* srcColor[1]{ &attrib };
+				convertColor<EF_A1R5G5B5_UNORM_PACK16, EF_B8G8R8A8_UNORM>(srcColor, colors.data() + i, 0u, 0u);
+			}
+			else
+				colored = false;
+		}
+		if (!colored)
+			allColored.store(false, std::memory_order_relaxed);
+	});
+	if (!allColored.load())
+		colors.clear();
+	return true;
+}
+
+//! Read 3d vector of floats
+void CSTLMeshFileLoader::getNextVector(SContext* context, core::vectorSIMDf& vec) const
+{
+	goNextWord(context);
+	std::string tmp;
+
+	getNextToken(context, tmp);
+	sscanf(tmp.c_str(), "%f", &vec.X);
+	getNextToken(context, tmp);
+	sscanf(tmp.c_str(), "%f", &vec.Y);
+	getNextToken(context, tmp);
+	sscanf(tmp.c_str(), "%f", &vec.Z);
 	vec.X = -vec.X;
 }
 
@@ -390,57 +528,26 @@ void CSTLMeshFileLoader::getNextVector(SContext* context, core::vectorSIMDf& vec
 const std::string& CSTLMeshFileLoader::getNextToken(SContext* context, std::string& token) const
 {
 	goNextWord(context);
-	char c;
-	token = "";
-
-	while (context->fileOffset != context->inner.mainFile->getSize())
-	{
-		system::IFile::success_t success;
-		context->inner.mainFile->read(success, &c, context->fileOffset, sizeof(c));
-		context->fileOffset += success.getBytesProcessed();
-
-		// found it, so leave
-		if (core::isspace(c))
-			break;
-		token += c;
-	}
+	token.clear();
+	context->reader.appendWhile(token, [](const char c) -> bool { return !core::isspace(c); });
+	// eat the separator
+	context->reader.get();
 	return token;
 }
 
 //! skip to next word
 void CSTLMeshFileLoader::goNextWord(SContext* context) const
 {
-	uint8_t c;
-	while (context->fileOffset != context->inner.mainFile->getSize()) // TODO: check it
-	{
-		system::IFile::success_t success;
-		context->inner.mainFile->read(success, &c, context->fileOffset, sizeof(c));
-		context->fileOffset += success.getBytesProcessed();
-
-		// found it, so leave
-		if (!core::isspace(c))
-		{
-			context->fileOffset -= success.getBytesProcessed();
-			break;
-		}
-	}
+	context->reader.skipWhile([](const char c) -> bool { return core::isspace(c); });
 }
 
 //! Read until line break is reached and stop at the next non-space character
 void CSTLMeshFileLoader::goNextLine(SContext* context) const
 {
-	uint8_t c;
 	// look for newline characters
-	while (context->fileOffset != context->inner.mainFile->getSize()) // TODO: check it
-	{
-		system::IFile::success_t success;
-		context->inner.mainFile->read(success, &c, context->fileOffset, sizeof(c));
-		context->fileOffset += success.getBytesProcessed();
-
-		// found it, so leave
-		if (c == '\n' || c == '\r')
-			break;
-	}
+	context->reader.skipWhile([](const char c) -> bool { return c != '\n' && c != '\r'; });
+	// found it, so leave
+	context->reader.get();
 }
 
 
@@ -12,6 +12,8 @@
 #include "nbl/asset/interchange/IRenderpassIndependentPipelineLoader.h"
 #include "nbl/asset/metadata/CSTLMetadata.h"
 
+#include "nbl/system/CBufferedFileReader.h"
+
 namespace nbl
 {
 namespace asset
@@ -44,7 +46,7 @@ class CSTLMeshFileLoader final : public IRenderpassIndependentPipelineLoader
 			uint32_t topHierarchyLevel;
 			IAssetLoader::IAssetLoaderOverride* loaderOverride;
 
-			size_t fileOffset = {};
+			system::CBufferedFileReader reader;
 		};
 
 		virtual void initialize() override;
@@ -54,12 +56,13 @@ class CSTLMeshFileLoader final : public IRenderpassIndependentPipelineLoader
 		// skips to the first non-space character available
 		void goNextWord(SContext* context) const;
 		// returns the next word
-
 		const std::string& getNextToken(SContext* context, std::string& token) const;
 		// skip to next printable character after the first line break
 		void goNextLine(SContext* context) const;
 		//! Read 3d vector of floats
-		void getNextVector(SContext* context, core::vectorSIMDf& vec, bool binary) const;
+		void getNextVector(SContext* context, core::vectorSIMDf& vec) const;
+		// decodes the fixed size facet records of a binary file all at once, returns false if the file is malformed
+		bool readBinaryFacets(SContext* context, core::vector<core::vectorSIMDf>& positions, core::vector<core::vectorSIMDf>& normals, core::vector<uint32_t>& colors) const;
 
 		template<typename aType>
 		static inline void performActionBasedOnOrientationSystem(aType& varToHandle, void (*performOnCertainOrientation)(aType& varToHandle))
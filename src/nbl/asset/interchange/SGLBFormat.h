@@ -0,0 +1,47 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef _NBL_ASSET_S_GLB_FORMAT_H_INCLUDED_
+#define _NBL_ASSET_S_GLB_FORMAT_H_INCLUDED_
+
+#include <cstdint>
+
+// Layout of the binary glTF container, shared between `CGLTFLoader` and `CGLTFWriter`.
+//
+// Everything is little endian, chunks start and end on 4 byte boundaries:
+//		[SHeader][SChunkHeader][JSON, padded with spaces][SChunkHeader][BIN, padded with zeros]
+// The JSON chunk always comes first, the BIN chunk is optional and is what the first buffer without an `uri` refers to.
+namespace nbl::asset::glb
+{
+
+constexpr inline uint32_t Magic = 0x46546C67u; // "glTF"
+constexpr inline uint32_t Version = 2u;
+constexpr inline uint32_t ChunkAlignment = 4u;
+
+enum E_CHUNK_TYPE : uint32_t
+{
+	ECT_JSON = 0x4E4F534Au, // "JSON"
+	ECT_BIN = 0x004E4942u // "BIN\0"
+};
+
+struct SHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	// of the whole file, including this header
+	uint32_t length;
+};
+static_assert(sizeof(SHeader)==12);
+
+struct SChunkHeader
+{
+	// of the chunk data which follows, already padded
+	uint32_t length;
+	uint32_t type;
+};
+static_assert(sizeof(SChunkHeader)==8);
+
+}
+
+#endif
@@ -67,13 +67,15 @@ void COverdrawMeshOptimizer::createOptimized(asset::ICPUMeshBuffer* _outbuffer,
 		genSoftBoundaries(softClusters, inIndices16, idxCount, vertexCount, hardClusters, hardClusterCount, _threshold) :
 		genSoftBoundaries(softClusters, inIndices32, idxCount, vertexCount, hardClusters, hardClusterCount, _threshold);
 
-	ClusterSortData* sortedData = (ClusterSortData*)_NBL_ALIGNED_MALLOC(softClusterCount*sizeof(ClusterSortData),_NBL_SIMD_ALIGNMENT);
+	// second half is scratch for the radix sort
+	ClusterSortData* const sortData = (ClusterSortData*)_NBL_ALIGNED_MALLOC(2*softClusterCount*sizeof(ClusterSortData),_NBL_SIMD_ALIGNMENT);
 	if (indexType == asset::EIT_16BIT)
-		calcSortData(sortedData, inIndices16, idxCount, vertexPositions, softClusters, softClusterCount);
+		calcSortData(sortData, inIndices16, idxCount, vertexPositions, softClusters, softClusterCount);
 	else
-		calcSortData(sortedData, inIndices32, idxCount, vertexPositions, softClusters, softClusterCount);
+		calcSortData(sortData, inIndices32, idxCount, vertexPositions, softClusters, softClusterCount);
 
-	std::stable_sort(sortedData, sortedData+softClusterCount, std::greater<ClusterSortData>()); // TODO: use core::radix_sort
+	// stable and descending
+	const ClusterSortData* const sortedData = core::radix_sort(sortData, sortData+softClusterCount, softClusterCount, ClusterSortData::KeyAccessor());
 
 	auto reorderIndices = [&](auto* out, const auto* in)
 	{
@@ -101,7 +103,7 @@ void COverdrawMeshOptimizer::createOptimized(asset::ICPUMeshBuffer* _outbuffer,
 		_NBL_ALIGNED_FREE(indexCopy);
 	_NBL_ALIGNED_FREE(hardClusters);
 	_NBL_ALIGNED_FREE(softClusters);
-	_NBL_ALIGNED_FREE(sortedData);
+	_NBL_ALIGNED_FREE(sortData);
 }
 
 template<typename IdxT>
@@ -23,11 +23,17 @@ class COverdrawMeshOptimizer
 			uint32_t cluster;
 			float dot;
 
-			bool operator>(const ClusterSortData& other) const
+			// high product = possible occluder, render early
+			struct KeyAccessor
 			{
-				// high product = possible occluder, render early
-				return dot > other.dot;
-			}
+				_NBL_STATIC_INLINE_CONSTEXPR size_t key_bit_count = core::FloatKeyAdaptor<float,true>::key_bit_count;
+
+				template<auto bit_offset, auto radix_mask>
+				inline decltype(radix_mask) operator()(const ClusterSortData& item) const
+				{
+					return core::FloatKeyAdaptor<float,true>().template operator()<bit_offset,radix_mask>(item.dot);
+				}
+			};
 		};
 
 		// private, undefined constructor
@@ -0,0 +1,92 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_CORE_S_CPU_FEATURES_H_INCLUDED__
+#define __NBL_CORE_S_CPU_FEATURES_H_INCLUDED__
+
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define _NBL_CPU_X86_64_
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+	// MSVC lets any function use any intrinsic, GCC and Clang need to be told which functions may
+	// the flattening variant also compiles everything the function calls for `ISA`, so ISA agnostic templates can get instantiated once per target
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define _NBL_CPU_TARGET(ISA)
+		#define _NBL_CPU_TARGET_FLATTEN(ISA)
+	#else
+		#define _NBL_CPU_TARGET(ISA) __attribute__((target(ISA)))
+		#define _NBL_CPU_TARGET_FLATTEN(ISA) __attribute__((target(ISA),flatten))
+	#endif
+#endif
+
+#ifdef _NBL_CPU_X86_64_
+namespace nbl::core::impl
+{
+
+//! Instruction set extensions the runtime dispatch of the SIMD batch kernels cares about, SSE2 is always there on x86-64
+struct SCPUFeatures
+{
+	SCPUFeatures()
+	{
+		std::array<uint32_t,4> regs; // eax, ebx, ecx, edx
+		cpuid(0u,regs);
+		const uint32_t maxLeaf = regs[0];
+		const bool amd = regs[1]==0x68747541u && regs[3]==0x69746E65u && regs[2]==0x444D4163u; // "AuthenticAMD"
+		cpuid(1u,regs);
+		const uint32_t baseFamily = (regs[0]>>8u)&0xFu;
+		const uint32_t family = baseFamily==0xFu ? (baseFamily+((regs[0]>>20u)&0xFFu)):baseFamily;
+		// the OS has to save the YMM registers too
+		const bool osAVX = (regs[2]&(0x1u<<27u)) && (regs[2]&(0x1u<<28u)) && (xgetbv0()&0x6u)==0x6u;
+		f16c = osAVX && (regs[2]&(0x1u<<29u));
+		if (maxLeaf<7u)
+			return;
+		cpuid(7u,regs);
+		avx2 = osAVX && (regs[1]&(0x1u<<5u));
+		// before Zen 3 `pdep` and `pext` are microcoded, taking up to hundreds of cycles depending on the mask
+		fastBMI2 = (regs[1]&(0x1u<<8u)) && !(amd && family<0x19u);
+	}
+
+	bool f16c = false;
+	bool avx2 = false;
+	bool fastBMI2 = false;
+
+	private:
+		static inline void cpuid(const uint32_t leaf, std::array<uint32_t,4>& regs)
+		{
+			#ifdef _MSC_VER
+				__cpuidex(reinterpret_cast<int*>(regs.data()),leaf,0);
+			#else
+				__cpuid_count(leaf,0u,regs[0],regs[1],regs[2],regs[3]);
+			#endif
+		}
+		static inline uint64_t xgetbv0()
+		{
+			#ifdef _MSC_VER
+				return _xgetbv(0);
+			#else
+				uint32_t eax, edx;
+				__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0u));
+				return (uint64_t(edx)<<32ull)|eax;
+			#endif
+		}
+};
+
+//! Detected once, on first use
+inline const SCPUFeatures& getCPUFeatures()
+{
+	static const SCPUFeatures features;
+	return features;
+}
+
+}
+#endif
+
+#endif
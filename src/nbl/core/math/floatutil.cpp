@@ -0,0 +1,496 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "nbl/core/math/floatutil.h"
+#include "nbl/core/math/glslFunctions.h"
+#include "nbl/core/SCPUFeatures.h"
+
+#include <cassert>
+
+// the SIMD kernels are templates shared by SSE2 and AVX2 which always get inlined into a function of the right target,
+// so GCC's warnings about `__m256` being passed around without AVX enabled don't apply
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+using namespace nbl;
+using namespace nbl::core;
+
+namespace
+{
+
+// Everything the shared exponent kernels need to know about a format, the scalar functions are the reference the kernels have to match bit for bit
+struct SRGB9E5
+{
+	using code_t = uint32_t;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t MantissaBits = RGB9E5_MANTISSA_BITS;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t ExpBits = RGB9E5_EXP_BITS;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t ExpBias = RGB9E5_EXP_BIAS;
+	_NBL_STATIC_INLINE_CONSTEXPR float MaxValue = MAX_RGB9E5;
+	_NBL_STATIC_INLINE_CONSTEXPR bool Signed = false;
+
+	static inline code_t encode(const rgb32f& rgb, const E_ROUNDING_DIRECTION) {return rgb32f_to_rgb9e5(rgb.x,rgb.y,rgb.z);}
+	static inline rgb32f decode(const code_t code) {return rgb9e5_to_rgb32f(code);}
+};
+struct SRGB19E7
+{
+	using code_t = uint64_t;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t MantissaBits = RGB19E7_MANTISSA_BITS;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t ExpBits = RGB19E7_EXP_BITS;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t ExpBias = RGB19E7_EXP_BIAS;
+	_NBL_STATIC_INLINE_CONSTEXPR float MaxValue = MAX_RGB19E7;
+	_NBL_STATIC_INLINE_CONSTEXPR bool Signed = false;
+
+	static inline code_t encode(const rgb32f& rgb, const E_ROUNDING_DIRECTION) {return rgb32f_to_rgb19e7(rgb.x,rgb.y,rgb.z);}
+	static inline rgb32f decode(const code_t code) {return rgb19e7_to_rgb32f(code);}
+};
+struct SRGB18E7S3
+{
+	using code_t = uint64_t;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t MantissaBits = RGB18E7S3_MANTISSA_BITS;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t ExpBits = RGB18E7S3_EXP_BITS;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t ExpBias = RGB18E7S3_EXP_BIAS;
+	_NBL_STATIC_INLINE_CONSTEXPR float MaxValue = MAX_RGB18E7S3;
+	_NBL_STATIC_INLINE_CONSTEXPR bool Signed = true;
+
+	static inline code_t encode(const rgb32f& rgb, const E_ROUNDING_DIRECTION rounding)
+	{
+		const float tmp[3] = {rgb.x,rgb.y,rgb.z};
+		switch (rounding)
+		{
+			case ERD_DOWN:
+				return rgb32f_to_rgb18e7s3<ERD_DOWN>(tmp);
+			case ERD_UP:
+				return rgb32f_to_rgb18e7s3<ERD_UP>(tmp);
+			default:
+				return rgb32f_to_rgb18e7s3<ERD_NEAREST>(tmp);
+		}
+	}
+	static inline rgb32f decode(const code_t code) {return rgb18e7s3_to_rgb32f(code);}
+};
+
+// the fields get packed in order from the lowest bits, same as the bitfields of the scalar code lay them out
+template<class Format>
+inline typename Format::code_t pack(const uint32_t r, const uint32_t g, const uint32_t b, const uint32_t e, const uint32_t s)
+{
+	using code_t = typename Format::code_t;
+	constexpr uint32_t M = Format::MantissaBits;
+	// truncated to the field width just like a bitfield assignment would
+	constexpr code_t MantissaMask = (code_t(1u)<<M)-1u;
+	constexpr code_t ExpMask = (code_t(1u)<<Format::ExpBits)-1u;
+	code_t retval = (r&MantissaMask)|((g&MantissaMask)<<M)|((b&MantissaMask)<<(2u*M))|((e&ExpMask)<<(3u*M));
+	if constexpr (Format::Signed)
+		retval |= code_t(s)<<(3u*M+Format::ExpBits);
+	return retval;
+}
+
+template<class Format>
+inline void unpack(const typename Format::code_t code, int32_t* rgb, int32_t& e, uint32_t& s)
+{
+	constexpr uint32_t M = Format::MantissaBits;
+	constexpr typename Format::code_t MantissaMask = (typename Format::code_t(1u)<<M)-1u;
+	for (uint32_t c=0u; c<3u; c++)
+		rgb[c] = static_cast<int32_t>((code>>(c*M))&MantissaMask);
+	e = static_cast<int32_t>((code>>(3u*M))&((0x1u<<Format::ExpBits)-1u));
+	s = Format::Signed ? static_cast<uint32_t>(code>>(3u*M+Format::ExpBits)):0u;
+}
+
+#ifdef _NBL_CPU_X86_64_
+// Thin wrappers so the shared exponent kernels get written once for 4 and 8 lanes
+struct SSSE2
+{
+	using F = __m128;
+	using I = __m128i;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t Width = 4u;
+
+	static inline F loadf(const float* p) {return _mm_loadu_ps(p);}
+	static inline I loadi(const int32_t* p) {return _mm_loadu_si128(reinterpret_cast<const I*>(p));}
+	static inline void storef(float* p, const F x) {_mm_storeu_ps(p,x);}
+	static inline void storei(int32_t* p, const I x) {_mm_storeu_si128(reinterpret_cast<I*>(p),x);}
+	static inline F setf(const float x) {return _mm_set1_ps(x);}
+	static inline I seti(const int32_t x) {return _mm_set1_epi32(x);}
+	static inline F asf(const I x) {return _mm_castsi128_ps(x);}
+	static inline I asi(const F x) {return _mm_castps_si128(x);}
+
+	static inline F andf(const F a, const F b) {return _mm_and_ps(a,b);}
+	static inline F xorf(const F a, const F b) {return _mm_xor_ps(a,b);}
+	static inline F ltf(const F a, const F b) {return _mm_cmplt_ps(a,b);}
+	static inline F gef(const F a, const F b) {return _mm_cmpge_ps(a,b);}
+	// `mask ? b:a`
+	static inline F selectf(const F mask, const F a, const F b) {return _mm_or_ps(_mm_and_ps(mask,b),_mm_andnot_ps(mask,a));}
+	static inline F addf(const F a, const F b) {return _mm_add_ps(a,b);}
+	static inline F subf(const F a, const F b) {return _mm_sub_ps(a,b);}
+	static inline F mulf(const F a, const F b) {return _mm_mul_ps(a,b);}
+	static inline F maxf(const F a, const F b) {return _mm_max_ps(a,b);}
+	static inline I truncate(const F x) {return _mm_cvttps_epi32(x);}
+	static inline F convert(const I x) {return _mm_cvtepi32_ps(x);}
+
+	static inline I andi(const I a, const I b) {return _mm_and_si128(a,b);}
+	static inline I addi(const I a, const I b) {return _mm_add_epi32(a,b);}
+	static inline I subi(const I a, const I b) {return _mm_sub_epi32(a,b);}
+	static inline I gti(const I a, const I b) {return _mm_cmpgt_epi32(a,b);}
+	static inline I eqi(const I a, const I b) {return _mm_cmpeq_epi32(a,b);}
+	template<int Shift>
+	static inline I slli(const I x) {return _mm_slli_epi32(x,Shift);}
+	template<int Shift>
+	static inline I srli(const I x) {return _mm_srli_epi32(x,Shift);}
+
+	// `floor(x+0.5)` without the rounding error the addition would have in floats, which is what the scalar code gets out of doing it in doubles
+	static inline I roundHalfUp(const F x)
+	{
+		const I truncated = truncate(x);
+		// the fraction is always exact, and the comparison mask is -1 where we need to add one
+		return subi(truncated,asi(gef(subf(x,convert(truncated)),setf(0.5f))));
+	}
+};
+struct SAVX2
+{
+	using F = __m256;
+	using I = __m256i;
+	_NBL_STATIC_INLINE_CONSTEXPR uint32_t Width = 8u;
+
+	_NBL_CPU_TARGET("avx2") static inline F loadf(const float* p) {return _mm256_loadu_ps(p);}
+	_NBL_CPU_TARGET("avx2") static inline I loadi(const int32_t* p) {return _mm256_loadu_si256(reinterpret_cast<const I*>(p));}
+	_NBL_CPU_TARGET("avx2") static inline void storef(float* p, const F x) {_mm256_storeu_ps(p,x);}
+	_NBL_CPU_TARGET("avx2") static inline void storei(int32_t* p, const I x) {_mm256_storeu_si256(reinterpret_cast<I*>(p),x);}
+	_NBL_CPU_TARGET("avx2") static inline F setf(const float x) {return _mm256_set1_ps(x);}
+	_NBL_CPU_TARGET("avx2") static inline I seti(const int32_t x) {return _mm256_set1_epi32(x);}
+	_NBL_CPU_TARGET("avx2") static inline F asf(const I x) {return _mm256_castsi256_ps(x);}
+	_NBL_CPU_TARGET("avx2") static inline I asi(const F x) {return _mm256_castps_si256(x);}
+
+	_NBL_CPU_TARGET("avx2") static inline F andf(const F a, const F b) {return _mm256_and_ps(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline F xorf(const F a, const F b) {return _mm256_xor_ps(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline F ltf(const F a, const F b) {return _mm256_cmp_ps(a,b,_CMP_LT_OQ);}
+	_NBL_CPU_TARGET("avx2") static inline F gef(const F a, const F b) {return _mm256_cmp_ps(a,b,_CMP_GE_OQ);}
+	_NBL_CPU_TARGET("avx2") static inline F selectf(const F mask, const F a, const F b) {return _mm256_blendv_ps(a,b,mask);}
+	_NBL_CPU_TARGET("avx2") static inline F addf(const F a, const F b) {return _mm256_add_ps(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline F subf(const F a, const F b) {return _mm256_sub_ps(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline F mulf(const F a, const F b) {return _mm256_mul_ps(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline F maxf(const F a, const F b) {return _mm256_max_ps(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline I truncate(const F x) {return _mm256_cvttps_epi32(x);}
+	_NBL_CPU_TARGET("avx2") static inline F convert(const I x) {return _mm256_cvtepi32_ps(x);}
+
+	_NBL_CPU_TARGET("avx2") static inline I andi(const I a, const I b) {return _mm256_and_si256(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline I addi(const I a, const I b) {return _mm256_add_epi32(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline I subi(const I a, const I b) {return _mm256_sub_epi32(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline I gti(const I a, const I b) {return _mm256_cmpgt_epi32(a,b);}
+	_NBL_CPU_TARGET("avx2") static inline I eqi(const I a, const I b) {return _mm256_cmpeq_epi32(a,b);}
+	template<int Shift>
+	_NBL_CPU_TARGET("avx2") static inline I slli(const I x) {return _mm256_slli_epi32(x,Shift);}
+	template<int Shift>
+	_NBL_CPU_TARGET("avx2") static inline I srli(const I x) {return _mm256_srli_epi32(x,Shift);}
+
+	_NBL_CPU_TARGET("avx2") static inline I roundHalfUp(const F x)
+	{
+		const I truncated = truncate(x);
+		return subi(truncated,asi(gef(subf(x,convert(truncated)),setf(0.5f))));
+	}
+};
+
+// The scalar code divides by a power of two in doubles, multiplying floats by its reciprocal gives the same results because
+// that's exact until the result goes subnormal, and then it gets rounded the same way as the cast of the double quotient to float.
+template<class ISA, class Format>
+inline void encodeSharedExponent_impl(const rgb32f* in, typename Format::code_t* out, const size_t count, const E_ROUNDING_DIRECTION rounding)
+{
+	using F = typename ISA::F;
+	using I = typename ISA::I;
+	constexpr uint32_t W = ISA::Width;
+	constexpr uint32_t M = Format::MantissaBits;
+
+	const F zero = ISA::setf(0.f);
+	const F maxValue = ISA::setf(Format::MaxValue);
+	const I absMask = ISA::seti(0x7fffffff);
+	const I expMask = ISA::seti(0xff);
+	const I mantissaOverflow = ISA::seti(0x1<<M);
+	const I floatExpOne = ISA::seti(0x1<<23);
+	// for the RGB18E7S3 rounding directions
+	const F roundAway = ISA::setf(rounding==ERD_NEAREST ? 0.5f:FR(0x3f7fffffu));
+	const F roundTowards = ISA::setf(rounding==ERD_NEAREST ? 0.5f:0.f);
+
+	size_t i = 0u;
+	for (; i+W<=count; i+=W)
+	{
+		float soa[3][W];
+		for (uint32_t j=0u; j<W; j++)
+		{
+			soa[0][j] = in[i+j].x;
+			soa[1][j] = in[i+j].y;
+			soa[2][j] = in[i+j].z;
+		}
+
+		F rgb[3];
+		I negative[3];
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			F x = ISA::loadf(soa[c]);
+			if constexpr (Format::Signed)
+			{
+				negative[c] = ISA::template srli<31>(ISA::asi(x));
+				x = ISA::asf(ISA::andi(ISA::asi(x),absMask));
+			}
+			// `std::max(0.f,std::min(x,MaxValue))` which turns NaN into 0
+			x = ISA::selectf(ISA::ltf(maxValue,x),x,maxValue);
+			rgb[c] = ISA::andf(ISA::ltf(zero,x),x);
+		}
+
+		// `max(f32_exp(maxrgb),-Bias-1)+1+Bias` is the same as `max(f32_exp(maxrgb)+1+Bias,0)`
+		const F maxrgb = ISA::maxf(ISA::maxf(rgb[0],rgb[1]),rgb[2]);
+		I expShared = ISA::addi(ISA::andi(ISA::template srli<23>(ISA::asi(maxrgb)),expMask),ISA::seti(1-127+static_cast<int32_t>(Format::ExpBias)));
+		expShared = ISA::andi(expShared,ISA::gti(expShared,ISA::seti(0)));
+		// reciprocal of `denom` assembled straight from its exponent
+		I scaleBits = ISA::template slli<23>(ISA::subi(ISA::seti(127+Format::ExpBias+M),expShared));
+
+		// the mask is -1 where the maximum rounds up to the next power of two
+		const I bump = ISA::eqi(ISA::roundHalfUp(ISA::mulf(maxrgb,ISA::asf(scaleBits))),mantissaOverflow);
+		expShared = ISA::subi(expShared,bump);
+		scaleBits = ISA::subi(scaleBits,ISA::andi(bump,floatExpOne));
+		const F scale = ISA::asf(scaleBits);
+
+		int32_t mantissas[3][W];
+		int32_t exps[W];
+		int32_t signs[3][W];
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			const F x = ISA::mulf(rgb[c],scale);
+			I m;
+			if constexpr (Format::Signed)
+			{
+				// the RGB18E7S3 code rounds with a float addition
+				const F towardsMask = rounding==ERD_DOWN ? ISA::asf(ISA::eqi(negative[c],ISA::seti(0))):ISA::asf(ISA::gti(negative[c],ISA::seti(0)));
+				m = ISA::truncate(ISA::addf(x,ISA::selectf(towardsMask,roundAway,roundTowards)));
+				ISA::storei(signs[c],negative[c]);
+			}
+			else
+				m = ISA::roundHalfUp(x);
+			ISA::storei(mantissas[c],m);
+		}
+		ISA::storei(exps,expShared);
+
+		for (uint32_t j=0u; j<W; j++)
+		{
+			const uint32_t s = Format::Signed ? (signs[0][j]|(signs[1][j]<<1)|(signs[2][j]<<2)):0u;
+			out[i+j] = pack<Format>(mantissas[0][j],mantissas[1][j],mantissas[2][j],exps[j],s);
+		}
+	}
+	for (; i<count; i++)
+		out[i] = Format::encode(in[i],rounding);
+}
+
+template<class ISA, class Format>
+inline void decodeSharedExponent_impl(const typename Format::code_t* in, rgb32f* out, const size_t count)
+{
+	using F = typename ISA::F;
+	constexpr uint32_t W = ISA::Width;
+
+	size_t i = 0u;
+	for (; i+W<=count; i+=W)
+	{
+		int32_t mantissas[3][W];
+		int32_t exps[W];
+		int32_t signs[3][W];
+		for (uint32_t j=0u; j<W; j++)
+		{
+			int32_t rgb[3];
+			uint32_t s;
+			unpack<Format>(in[i+j],rgb,exps[j],s);
+			for (uint32_t c=0u; c<3u; c++)
+			{
+				mantissas[c][j] = rgb[c];
+				signs[c][j] = static_cast<int32_t>(((s>>c)&0x1u)<<31u);
+			}
+		}
+
+		const F scale = ISA::asf(ISA::template slli<23>(ISA::addi(ISA::loadi(exps),ISA::seti(127-static_cast<int32_t>(Format::ExpBias+Format::MantissaBits)))));
+		float soa[3][W];
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			F x = ISA::mulf(ISA::convert(ISA::loadi(mantissas[c])),scale);
+			if constexpr (Format::Signed)
+				x = ISA::xorf(x,ISA::asf(ISA::loadi(signs[c])));
+			ISA::storef(soa[c],x);
+		}
+		for (uint32_t j=0u; j<W; j++)
+			out[i+j] = {soa[0][j],soa[1][j],soa[2][j]};
+	}
+	for (; i<count; i++)
+		out[i] = Format::decode(in[i]);
+}
+
+// the kernels get inlined into these, which is what compiles them for AVX2
+template<class Format>
+_NBL_CPU_TARGET_FLATTEN("avx2") void encodeSharedExponentAVX2(const rgb32f* in, typename Format::code_t* out, const size_t count, const E_ROUNDING_DIRECTION rounding)
+{
+	encodeSharedExponent_impl<SAVX2,Format>(in,out,count,rounding);
+}
+template<class Format>
+_NBL_CPU_TARGET_FLATTEN("avx2") void decodeSharedExponentAVX2(const typename Format::code_t* in, rgb32f* out, const size_t count)
+{
+	decodeSharedExponent_impl<SAVX2,Format>(in,out,count);
+}
+#endif
+
+template<class Format>
+void encodeSharedExponent(const std::span<const rgb32f> in, const std::span<typename Format::code_t> out, const E_ROUNDING_DIRECTION rounding)
+{
+	assert(in.size()==out.size());
+	#ifdef _NBL_CPU_X86_64_
+		if (core::impl::getCPUFeatures().avx2)
+			return encodeSharedExponentAVX2<Format>(in.data(),out.data(),in.size(),rounding);
+		return encodeSharedExponent_impl<SSSE2,Format>(in.data(),out.data(),in.size(),rounding);
+	#else
+		for (size_t i=0u; i<in.size(); i++)
+			out[i] = Format::encode(in[i],rounding);
+	#endif
+}
+
+template<class Format>
+void decodeSharedExponent(const std::span<const typename Format::code_t> in, const std::span<rgb32f> out)
+{
+	assert(in.size()==out.size());
+	#ifdef _NBL_CPU_X86_64_
+		if (core::impl::getCPUFeatures().avx2)
+			return decodeSharedExponentAVX2<Format>(in.data(),out.data(),in.size());
+		return decodeSharedExponent_impl<SSSE2,Format>(in.data(),out.data(),in.size());
+	#else
+		for (size_t i=0u; i<in.size(); i++)
+			out[i] = Format::decode(in[i]);
+	#endif
+}
+
+}
+
+namespace nbl::core
+{
+
+#ifdef _NBL_CPU_X86_64_
+// F16C converts with the same truncation but saturates finite overflow and quiets NaNs, those few lanes get patched afterwards
+_NBL_CPU_TARGET("avx2,f16c") static void compressF16C(const float* in, uint16_t* out, const size_t count, const int32_t maxN, const int32_t infN)
+{
+	size_t i = 0u;
+	for (; i+8u<=count; i+=8u)
+	{
+		const __m256 x = _mm256_loadu_ps(in+i);
+		const __m256i bits = _mm256_castps_si256(x);
+		const __m256i absBits = _mm256_and_si256(bits,_mm256_set1_epi32(0x7fffffff));
+		__m128i half = _mm256_cvtps_ph(x,_MM_FROUND_TO_ZERO);
+		// squash the 32bit lane mask down to a 16bit one
+		const __m256i overflowMask = _mm256_cmpgt_epi32(absBits,_mm256_set1_epi32(maxN));
+		const __m128i overflow = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(overflowMask,overflowMask),0x08));
+		const __m128i inf = _mm_or_si128(_mm_and_si128(half,_mm_set1_epi16(static_cast<int16_t>(0x8000))),_mm_set1_epi16(0x7c00));
+		half = _mm_or_si128(_mm_and_si128(overflow,inf),_mm_andnot_si128(overflow,half));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out+i),half);
+		if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(absBits,_mm256_set1_epi32(infN))))
+		for (size_t j=i; j<i+8u; j++)
+			out[j] = Float16Compressor::compress(in[j]);
+	}
+	for (; i<count; i++)
+		out[i] = Float16Compressor::compress(in[i]);
+}
+
+// F16C would quiet signalling NaNs which the scalar code passes through
+_NBL_CPU_TARGET("avx2,f16c") static void decompressF16C(const uint16_t* in, float* out, const size_t count)
+{
+	size_t i = 0u;
+	for (; i+8u<=count; i+=8u)
+	{
+		const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+		_mm256_storeu_ps(out+i,_mm256_cvtph_ps(half));
+		const __m128i absHalf = _mm_and_si128(half,_mm_set1_epi16(0x7fff));
+		if (_mm_movemask_epi8(_mm_cmpgt_epi16(absHalf,_mm_set1_epi16(0x7c00))))
+		for (size_t j=i; j<i+8u; j++)
+			out[j] = Float16Compressor::decompress(in[j]);
+	}
+	for (; i<count; i++)
+		out[i] = Float16Compressor::decompress(in[i]);
+}
+#endif
+
+void Float16Compressor::compress(std::span<const float> in, std::span<uint16_t> out)
+{
+	assert(in.size()==out.size());
+	size_t i = 0u;
+	#ifdef _NBL_CPU_X86_64_
+		const auto& features = core::impl::getCPUFeatures();
+		if (features.avx2 && features.f16c)
+			return compressF16C(in.data(),out.data(),in.size(),maxN,infN);
+		// the scalar code, 4 lanes at a time
+		auto select = [](const __m128i mask, const __m128i a, const __m128i b) -> __m128i {return _mm_or_si128(_mm_and_si128(mask,b),_mm_andnot_si128(mask,a));};
+		for (; i+4u<=in.size(); i+=4u)
+		{
+			__m128i v = _mm_castps_si128(_mm_loadu_ps(in.data()+i));
+			__m128i sign = _mm_and_si128(v,_mm_set1_epi32(signN));
+			v = _mm_xor_si128(v,sign);
+			sign = _mm_srli_epi32(sign,shiftSign);
+			const __m128i s = _mm_cvttps_epi32(_mm_mul_ps(_mm_castsi128_ps(_mm_set1_epi32(mulN)),_mm_castsi128_ps(v)));
+			v = select(_mm_cmpgt_epi32(_mm_set1_epi32(minN),v),v,s);
+			v = select(_mm_and_si128(_mm_cmpgt_epi32(_mm_set1_epi32(infN),v),_mm_cmpgt_epi32(v,_mm_set1_epi32(maxN))),v,_mm_set1_epi32(infN));
+			v = select(_mm_and_si128(_mm_cmpgt_epi32(_mm_set1_epi32(nanN),v),_mm_cmpgt_epi32(v,_mm_set1_epi32(infN))),v,_mm_set1_epi32(nanN));
+			v = _mm_srli_epi32(v,shift);
+			v = select(_mm_cmpgt_epi32(v,_mm_set1_epi32(maxC)),v,_mm_sub_epi32(v,_mm_set1_epi32(maxD)));
+			v = select(_mm_cmpgt_epi32(v,_mm_set1_epi32(subC)),v,_mm_sub_epi32(v,_mm_set1_epi32(minD)));
+			v = _mm_or_si128(v,sign);
+			// sign extend so the saturating pack keeps the low 16 bits as they are
+			v = _mm_srai_epi32(_mm_slli_epi32(v,16),16);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out.data()+i),_mm_packs_epi32(v,v));
+		}
+	#endif
+	for (; i<in.size(); i++)
+		out[i] = compress(in[i]);
+}
+
+void Float16Compressor::decompress(std::span<const uint16_t> in, std::span<float> out)
+{
+	assert(in.size()==out.size());
+	size_t i = 0u;
+	#ifdef _NBL_CPU_X86_64_
+		const auto& features = core::impl::getCPUFeatures();
+		if (features.avx2 && features.f16c)
+			return decompressF16C(in.data(),out.data(),in.size());
+		auto select = [](const __m128i mask, const __m128i a, const __m128i b) -> __m128i {return _mm_or_si128(_mm_and_si128(mask,b),_mm_andnot_si128(mask,a));};
+		for (; i+4u<=in.size(); i+=4u)
+		{
+			__m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in.data()+i)),_mm_setzero_si128());
+			__m128i sign = _mm_and_si128(v,_mm_set1_epi32(signC));
+			v = _mm_xor_si128(v,sign);
+			sign = _mm_slli_epi32(sign,shiftSign);
+			v = select(_mm_cmpgt_epi32(v,_mm_set1_epi32(subC)),v,_mm_add_epi32(v,_mm_set1_epi32(minD)));
+			v = select(_mm_cmpgt_epi32(v,_mm_set1_epi32(maxC)),v,_mm_add_epi32(v,_mm_set1_epi32(maxD)));
+			const __m128i s = _mm_castps_si128(_mm_mul_ps(_mm_castsi128_ps(_mm_set1_epi32(mulC)),_mm_cvtepi32_ps(v)));
+			const __m128i mask = _mm_cmpgt_epi32(_mm_set1_epi32(norC),v);
+			v = select(mask,_mm_slli_epi32(v,shift),s);
+			_mm_storeu_ps(out.data()+i,_mm_castsi128_ps(_mm_or_si128(v,sign)));
+		}
+	#endif
+	for (; i<in.size(); i++)
+		out[i] = decompress(in[i]);
+}
+
+void rgb32f_to_rgb9e5(std::span<const rgb32f> in, std::span<uint32_t> out)
+{
+	encodeSharedExponent<SRGB9E5>(in,out,ERD_NEAREST);
+}
+void rgb9e5_to_rgb32f(std::span<const uint32_t> in, std::span<rgb32f> out)
+{
+	decodeSharedExponent<SRGB9E5>(in,out);
+}
+
+void rgb32f_to_rgb19e7(std::span<const rgb32f> in, std::span<uint64_t> out)
+{
+	encodeSharedExponent<SRGB19E7>(in,out,ERD_NEAREST);
+}
+void rgb19e7_to_rgb32f(std::span<const uint64_t> in, std::span<rgb32f> out)
+{
+	decodeSharedExponent<SRGB19E7>(in,out);
+}
+
+void impl::rgb32f_to_rgb18e7s3(std::span<const rgb32f> in, std::span<uint64_t> out, const E_ROUNDING_DIRECTION rounding)
+{
+	encodeSharedExponent<SRGB18E7S3>(in,out,rounding);
+}
+void rgb18e7s3_to_rgb32f(std::span<const uint64_t> in, std::span<rgb32f> out)
+{
+	decodeSharedExponent<SRGB18E7S3>(in,out);
+}
+
+}
@@ -0,0 +1,251 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "nbl/core/math/morton.h"
+#include "nbl/core/SCPUFeatures.h"
+
+#include <array>
+#include <cassert>
+
+using namespace nbl;
+using namespace nbl::core;
+
+namespace
+{
+
+template<typename T, uint32_t D>
+inline T encodeOne(const T* const* coords, const size_t i)
+{
+	if constexpr (D==2u)
+		return core::morton2d_encode<T>(coords[0][i],coords[1][i]);
+	else if constexpr (D==3u)
+		return core::morton3d_encode<T>(coords[0][i],coords[1][i],coords[2][i]);
+	else
+		return core::morton4d_encode<T>(coords[0][i],coords[1][i],coords[2][i],coords[3][i]);
+}
+
+template<typename T, uint32_t D>
+inline void encodeGeneric(const T* const* coords, T* out, const size_t begin, const size_t end)
+{
+	for (size_t i=begin; i<end; i++)
+		out[i] = encodeOne<T,D>(coords,i);
+}
+
+template<typename T>
+inline void decode3dGeneric(const T* codes, T* const* coords, const size_t count)
+{
+	for (size_t i=0u; i<count; i++)
+	{
+		coords[0][i] = core::morton3d_decode_x<T>(codes[i]);
+		coords[1][i] = core::morton3d_decode_y<T>(codes[i]);
+		coords[2][i] = core::morton3d_decode_z<T>(codes[i]);
+	}
+}
+
+#ifdef _NBL_CPU_X86_64_
+// mirror `impl::separate_bits_Nd` step for step, which is what keeps out of range coordinates bit-identical
+template<typename T>
+struct SAVX2Lanes
+{
+	_NBL_STATIC_INLINE_CONSTEXPR size_t Count = 32u/sizeof(T);
+
+	template<int Shift>
+	_NBL_CPU_TARGET("avx2") static inline __m256i spread(const __m256i x, const T mask)
+	{
+		if constexpr (sizeof(T)==4u)
+			return _mm256_and_si256(_mm256_or_si256(x,_mm256_slli_epi32(x,Shift)),_mm256_set1_epi32(static_cast<int32_t>(mask)));
+		else
+			return _mm256_and_si256(_mm256_or_si256(x,_mm256_slli_epi64(x,Shift)),_mm256_set1_epi64x(static_cast<int64_t>(mask)));
+	}
+	_NBL_CPU_TARGET("avx2") static inline __m256i shiftLeft(const __m256i x, const int shift)
+	{
+		if constexpr (sizeof(T)==4u)
+			return _mm256_sll_epi32(x,_mm_cvtsi32_si128(shift));
+		else
+			return _mm256_sll_epi64(x,_mm_cvtsi32_si128(shift));
+	}
+
+	template<uint32_t D>
+	_NBL_CPU_TARGET("avx2") static inline __m256i separateBits(__m256i x)
+	{
+		constexpr bool Has64Bits = sizeof(T)==8u;
+		if constexpr (D==2u)
+		{
+			if constexpr (Has64Bits)
+				x = spread<16>(x,impl::morton2d_mask<T>(4));
+			x = spread<8>(x,impl::morton2d_mask<T>(3));
+			x = spread<4>(x,impl::morton2d_mask<T>(2));
+			x = spread<2>(x,impl::morton2d_mask<T>(1));
+			return spread<1>(x,impl::morton2d_mask<T>(0));
+		}
+		else if constexpr (D==3u)
+		{
+			if constexpr (Has64Bits)
+				x = spread<32>(x,impl::morton3d_mask<T>(4));
+			x = spread<16>(x,impl::morton3d_mask<T>(3));
+			x = spread<8>(x,impl::morton3d_mask<T>(2));
+			x = spread<4>(x,impl::morton3d_mask<T>(1));
+			return spread<2>(x,impl::morton3d_mask<T>(0));
+		}
+		else
+		{
+			if constexpr (Has64Bits)
+				x = spread<24>(x,impl::morton4d_mask<T>(3));
+			x = spread<12>(x,impl::morton4d_mask<T>(2));
+			x = spread<6>(x,impl::morton4d_mask<T>(1));
+			return spread<3>(x,impl::morton4d_mask<T>(0));
+		}
+	}
+};
+
+template<typename T, uint32_t D>
+_NBL_CPU_TARGET("avx2") void encodeAVX2(const T* const* coords, T* out, const size_t count)
+{
+	using lanes_t = SAVX2Lanes<T>;
+	size_t i = 0u;
+	for (; i+lanes_t::Count<=count; i+=lanes_t::Count)
+	{
+		__m256i code = lanes_t::template separateBits<D>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(coords[0]+i)));
+		for (uint32_t axis=1u; axis<D; axis++)
+		{
+			const __m256i separated = lanes_t::template separateBits<D>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(coords[axis]+i)));
+			code = _mm256_or_si256(code,lanes_t::shiftLeft(separated,axis));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out+i),code);
+	}
+	encodeGeneric<T,D>(coords,out,i,count);
+}
+
+template<typename T>
+_NBL_CPU_TARGET("bmi2") inline T pdep(const T x, const T mask)
+{
+	if constexpr (sizeof(T)==4u)
+		return _pdep_u32(x,mask);
+	else
+		return _pdep_u64(x,mask);
+}
+template<typename T>
+_NBL_CPU_TARGET("bmi2") inline T pext(const T x, const T mask)
+{
+	if constexpr (sizeof(T)==4u)
+		return _pext_u32(x,mask);
+	else
+		return _pext_u64(x,mask);
+}
+
+template<typename T, uint32_t D>
+constexpr T getFirstAxisMask()
+{
+	if constexpr (D==2u)
+		return impl::morton2d_mask<T>(0);
+	else if constexpr (D==3u)
+		return impl::morton3d_mask<T>(0);
+	else
+		return impl::morton4d_mask<T>(0);
+}
+
+template<typename T, uint32_t D>
+_NBL_CPU_TARGET("bmi2") void encodeBMI2(const T* const* coords, T* out, const size_t count)
+{
+	// the bit spreading mixes extra bits of a coordinate into the code, `pdep` would just drop them
+	constexpr T OutOfRange = ~((T(0x1u)<<T(sizeof(T)*8u/D))-T(0x1u));
+	constexpr T AxisMask = getFirstAxisMask<T,D>();
+	for (size_t i=0u; i<count; i++)
+	{
+		T code = 0u;
+		T allBits = 0u;
+		for (uint32_t axis=0u; axis<D; axis++)
+		{
+			const T coord = coords[axis][i];
+			code |= pdep<T>(coord,AxisMask<<axis);
+			allBits |= coord;
+		}
+		out[i] = (allBits&OutOfRange) ? encodeOne<T,D>(coords,i):code;
+	}
+}
+
+template<typename T>
+_NBL_CPU_TARGET("bmi2") void decode3dBMI2(const T* codes, T* const* coords, const size_t count)
+{
+	constexpr T AxisMask = impl::morton3d_mask<T>(0);
+	for (size_t i=0u; i<count; i++)
+	for (uint32_t axis=0u; axis<3u; axis++)
+		coords[axis][i] = pext<T>(codes[i]>>axis,AxisMask);
+}
+#endif
+
+template<typename T, uint32_t D>
+void encode(const std::array<std::span<const T>,D>& coords, const std::span<T> out)
+{
+	std::array<const T*,D> pointers;
+	for (uint32_t axis=0u; axis<D; axis++)
+	{
+		assert(coords[axis].size()==out.size());
+		pointers[axis] = coords[axis].data();
+	}
+	#ifdef _NBL_CPU_X86_64_
+		if (impl::getCPUFeatures().avx2)
+			return encodeAVX2<T,D>(pointers.data(),out.data(),out.size());
+		if (impl::getCPUFeatures().fastBMI2)
+			return encodeBMI2<T,D>(pointers.data(),out.data(),out.size());
+	#endif
+	encodeGeneric<T,D>(pointers.data(),out.data(),0u,out.size());
+}
+
+template<typename T>
+void decode3d(const std::span<const T> codes, const std::array<std::span<T>,3>& coords)
+{
+	std::array<T*,3> pointers;
+	for (uint32_t axis=0u; axis<3u; axis++)
+	{
+		assert(coords[axis].size()==codes.size());
+		pointers[axis] = coords[axis].data();
+	}
+	#ifdef _NBL_CPU_X86_64_
+		if (impl::getCPUFeatures().fastBMI2)
+			return decode3dBMI2<T>(codes.data(),pointers.data(),codes.size());
+	#endif
+	decode3dGeneric<T>(codes.data(),pointers.data(),codes.size());
+}
+
+}
+
+namespace nbl::core
+{
+
+void morton2d_encode(std::span<const uint32_t> x, std::span<const uint32_t> y, std::span<uint32_t> out)
+{
+	encode<uint32_t,2u>({x,y},out);
+}
+void morton2d_encode(std::span<const uint64_t> x, std::span<const uint64_t> y, std::span<uint64_t> out)
+{
+	encode<uint64_t,2u>({x,y},out);
+}
+void morton3d_encode(std::span<const uint32_t> x, std::span<const uint32_t> y, std::span<const uint32_t> z, std::span<uint32_t> out)
+{
+	encode<uint32_t,3u>({x,y,z},out);
+}
+void morton3d_encode(std::span<const uint64_t> x, std::span<const uint64_t> y, std::span<const uint64_t> z, std::span<uint64_t> out)
+{
+	encode<uint64_t,3u>({x,y,z},out);
+}
+void morton4d_encode(std::span<const uint32_t> x, std::span<const uint32_t> y, std::span<const uint32_t> z, std::span<const uint32_t> w, std::span<uint32_t> out)
+{
+	encode<uint32_t,4u>({x,y,z,w},out);
+}
+void morton4d_encode(std::span<const uint64_t> x, std::span<const uint64_t> y, std::span<const uint64_t> z, std::span<const uint64_t> w, std::span<uint64_t> out)
+{
+	encode<uint64_t,4u>({x,y,z,w},out);
+}
+
+void morton3d_decode(std::span<const uint32_t> codes, std::span<uint32_t> x, std::span<uint32_t> y, std::span<uint32_t> z)
+{
+	decode3d<uint32_t>(codes,{x,y,z});
+}
+void morton3d_decode(std::span<const uint64_t> codes, std::span<uint64_t> x, std::span<uint64_t> y, std::span<uint64_t> z)
+{
+	decode3d<uint64_t>(codes,{x,y,z});
+}
+
+}
@@ -493,6 +493,14 @@ asset::SAssetBundle CMitsubaLoader::loadAsset(system::IFile* _file, const asset:
 	else
 	{
 		auto currentDir = _file->getFileName().parent_path()/"";
+		// the whole list of meshes and bitmaps is known now, get it read ahead while they get loaded one by one
+		{
+			core::vector<system::path> dependencies;
+			dependencies.reserve(parserManager.referencedFiles.size());
+			for (const auto& filename : parserManager.referencedFiles)
+				dependencies.push_back(currentDir/filename);
+			m_assetMgr->getSystem()->prefetch(dependencies);
+		}
 
 		SContext ctx(
 			m_assetMgr->getGeometryCreator(),
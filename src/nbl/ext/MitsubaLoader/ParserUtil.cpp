@@ -4,10 +4,15 @@
 
 #include "nbl/ext/MitsubaLoader/ParserUtil.h"
 #include "nbl/ext/MitsubaLoader/CElementFactory.h"
+#include "nbl/ext/MitsubaLoader/CElementTexture.h"
+#include "nbl/ext/MitsubaLoader/CElementEmitter.h"
+
+#include "nbl/system/CBufferedFileReader.h"
 
 #include "expat/lib/expat.h"
 
 #include <memory>
+#include <limits>
 
 namespace nbl
 {
@@ -59,14 +64,23 @@ bool ParserManager::parse(system::IFile* _file, const system::logger_opt_ptr& _l
 	XML_SetUserData(parser, &ctx);
 
 
-	char* buff = (char*)_NBL_ALIGNED_MALLOC(_file->getSize(), 4096u);
-
-	system::future<size_t> future;
-	_file->read(future, (void*)buff, 0u, _file->getSize());
-	future.get();
-
-	XML_Status parseStatus = XML_Parse(parser, buff, _file->getSize(), 0);
-	_NBL_ALIGNED_FREE(buff);
+	// feed expat chunk by chunk while the next one is being read, or the whole mapping at once if the file is mapped
+	XML_Status parseStatus = XML_STATUS_OK;
+	{
+		system::CBufferedFileReader reader(_file);
+		do
+		{
+			// expat takes an `int` length, a mapping can be larger than that so it gets fed in pieces, only the empty call below is final
+			for (auto chunk=reader.window(); parseStatus==XML_STATUS_OK && !chunk.empty(); )
+			{
+				const size_t pieceSize = std::min<size_t>(chunk.size(),std::numeric_limits<int>::max());
+				parseStatus = XML_Parse(parser, reinterpret_cast<const char*>(chunk.data()), static_cast<int>(pieceSize), 0);
+				chunk = chunk.subspan(pieceSize);
+			}
+		} while (parseStatus==XML_STATUS_OK && reader.nextChunk());
+	}
+	if (parseStatus==XML_STATUS_OK)
+		parseStatus = XML_Parse(parser, nullptr, 0, 1);
 	XML_ParserFree(parser);
 	switch (parseStatus)
 	{
@@ -198,6 +212,47 @@ void ParserManager::processProperty(const Context& ctx, const char* _el, const c
 	return;
 }
 
+// the files an element will need loaded later on, if any
+static const SPropertyElementData* getReferencedFilename(const IElement* element)
+{
+	switch (element->getType())
+	{
+		case IElement::Type::SHAPE:
+		{
+			const auto* shape = static_cast<const CElementShape*>(element);
+			switch (shape->type)
+			{
+				case CElementShape::Type::OBJ:
+					return &shape->obj.filename;
+				case CElementShape::Type::PLY:
+					return &shape->ply.filename;
+				case CElementShape::Type::SERIALIZED:
+					return &shape->serialized.filename;
+				default:
+					break;
+			}
+			break;
+		}
+		case IElement::Type::TEXTURE:
+		{
+			const auto* texture = static_cast<const CElementTexture*>(element);
+			if (texture->type==CElementTexture::Type::BITMAP)
+				return &texture->bitmap.filename;
+			break;
+		}
+		case IElement::Type::EMITTER:
+		{
+			const auto* emitter = static_cast<const CElementEmitter*>(element);
+			if (emitter->type==CElementEmitter::Type::ENVMAP)
+				return &emitter->envmap.filename;
+			break;
+		}
+		default:
+			break;
+	}
+	return nullptr;
+}
+
 void ParserManager::onEnd(const Context& ctx, const char* _el)
 {
 	if (propertyElements.find(_el) != propertyElements.end())
@@ -221,6 +276,9 @@ void ParserManager::onEnd(const Context& ctx, const char* _el)
 		killParseWithError(ctx,element.first->getLogName() + " could not onEndTag");
 		return;
 	}
+	if (const auto* filename=element.first ? getReferencedFilename(element.first):nullptr)
+	if (filename->type==SPropertyElementData::Type::STRING && filename->svalue)
+		referencedFiles.emplace_back(filename->svalue);
 
 	if (!elements.empty())
 	{
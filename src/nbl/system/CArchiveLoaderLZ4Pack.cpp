@@ -0,0 +1,246 @@
+#include "nbl/system/IFileViewAllocator.h"
+#include "nbl/system/CArchiveLoaderLZ4Pack.h"
+
+#include "nbl/core/execution.h"
+
+#include "lz4/lib/lz4.h"
+
+
+using namespace nbl;
+using namespace nbl::system;
+
+
+namespace
+{
+// Compressed entry opened without `ECF_MAPPABLE`, nothing gets decompressed until it's read and then only the blocks covering the read.
+class CLZ4PackFile final : public IFile
+{
+	public:
+		inline CLZ4PackFile(core::smart_refctd_ptr<const CArchiveLoaderLZ4Pack::CArchive>&& _archive, const lz4pack::SEntry& _entry, path&& _name, const core::bitflag<E_CREATE_FLAGS> _flags) :
+			IFile(std::move(_name),_flags,std::chrono::utc_clock::now()), m_archive(std::move(_archive)), m_entry(_entry) {}
+
+		inline size_t getSize() const override {return m_entry.size;}
+
+	protected:
+		inline const void* getMappedPointer_impl() const override {return nullptr;}
+		inline void* getMappedPointer_impl() override {return nullptr;}
+
+		inline void unmappedRead(ISystem::future_t<size_t>& fut, void* buffer, size_t offset, size_t sizeToRead) override
+		{
+			if (offset>=m_entry.size)
+			{
+				set_result(fut,0ull);
+				return;
+			}
+			sizeToRead = core::min<size_t>(sizeToRead,m_entry.size-offset);
+			set_result(fut,m_archive->decompressRange(m_entry,buffer,offset,sizeToRead) ? sizeToRead:0ull);
+		}
+
+	private:
+		const core::smart_refctd_ptr<const CArchiveLoaderLZ4Pack::CArchive> m_archive;
+		// lives in the archive's mapping
+		const lz4pack::SEntry& m_entry;
+};
+}
+
+
+CArchiveLoaderLZ4Pack::CArchive::CArchive(core::smart_refctd_ptr<IFile>&& _file, system::logger_opt_smart_ptr&& logger, std::shared_ptr<core::vector<IFileArchive::SFileList::SEntry>> _items) :
+	CFileArchive(path(_file->getFileName()),std::move(logger),_items), m_file(std::move(_file))
+{
+	const auto* base = getBasePointer();
+	m_header = reinterpret_cast<const lz4pack::SHeader*>(base);
+	m_entries = reinterpret_cast<const lz4pack::SEntry*>(m_header+1);
+	m_buckets = reinterpret_cast<const uint32_t*>(m_entries+m_header->entryCount);
+	m_strings = reinterpret_cast<const char*>(base+m_header->stringsOffset);
+
+	// items got sorted by `CFileArchive`, remember where each one went
+	const auto items = SFileList::span_t(listAssets());
+	m_itemIndex.resize(items.size());
+	for (uint32_t i=0u; i<items.size(); i++)
+		m_itemIndex[items[i].ID] = i;
+}
+
+bool CArchiveLoaderLZ4Pack::CArchive::decompressRange(const lz4pack::SEntry& entry, void* dst, const size_t offset, const size_t size) const
+{
+	if (size==0ull)
+		return true;
+
+	const uint32_t blockSize = m_header->blockSize;
+	const auto* const dataPtr = getBasePointer()+entry.dataOffset;
+	const auto* const blockEnd = reinterpret_cast<const uint64_t*>(dataPtr);
+	const auto* const blocks = reinterpret_cast<const char*>(blockEnd+lz4pack::getBlockCount(entry.size,blockSize));
+
+	const uint64_t firstBlock = offset/blockSize;
+	const uint64_t lastBlock = (offset+size-1ull)/blockSize;
+	auto decompressBlock = [&](const uint64_t block) -> bool
+	{
+		const uint64_t blockBegin = block*blockSize;
+		const uint32_t uncompressedSize = core::min<uint64_t>(entry.size-blockBegin,blockSize);
+		const uint64_t compressedBegin = block ? blockEnd[block-1u]:0ull;
+		const int compressedSize = static_cast<int>(blockEnd[block]-compressedBegin);
+		const char* const src = blocks+compressedBegin;
+
+		// the part of this block which the read wants
+		const uint64_t copyBegin = core::max<uint64_t>(offset,blockBegin);
+		const uint64_t copyEnd = core::min<uint64_t>(offset+size,blockBegin+uncompressedSize);
+		char* const out = reinterpret_cast<char*>(dst)+(copyBegin-offset);
+		if (compressedSize==uncompressedSize)
+		{
+			memcpy(out,src+(copyBegin-blockBegin),copyEnd-copyBegin);
+			return true;
+		}
+		// whole block wanted, no need to bounce through scratch memory
+		if (copyBegin==blockBegin && copyEnd==blockBegin+uncompressedSize)
+			return LZ4_decompress_safe(src,out,compressedSize,uncompressedSize)==uncompressedSize;
+		auto scratch = std::make_unique<char[]>(uncompressedSize);
+		if (LZ4_decompress_safe(src,scratch.get(),compressedSize,uncompressedSize)!=uncompressedSize)
+			return false;
+		memcpy(out,scratch.get()+(copyBegin-blockBegin),copyEnd-copyBegin);
+		return true;
+	};
+
+	if (firstBlock==lastBlock)
+		return decompressBlock(firstBlock);
+
+	core::vector<uint64_t> blockIndices(lastBlock-firstBlock+1ull);
+	std::iota(blockIndices.begin(),blockIndices.end(),firstBlock);
+	std::atomic_bool success = true;
+	core::for_each(core::execution::par_unseq,blockIndices.begin(),blockIndices.end(),[&](const uint64_t block)->void
+	{
+		if (!decompressBlock(block))
+			success.store(false,std::memory_order_relaxed);
+	});
+	return success.load();
+}
+
+core::smart_refctd_ptr<IFile> CArchiveLoaderLZ4Pack::CArchive::getFile_impl(const SFileList::found_t& found, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const std::string_view& password)
+{
+	// stored entries are views of the mapping, and someone wanting a mapping or having the cache on needs the whole thing decompressed
+	if (found->allocatorType==EAT_NULL || flags.hasFlags(IFileBase::ECF_MAPPABLE) || isDecompressedCacheEnabled())
+		return CFileArchive::getFile_impl(found,flags,password);
+	return core::make_smart_refctd_ptr<CLZ4PackFile>(
+		core::smart_refctd_ptr<const CArchive>(this),
+		m_entries[found->ID],
+		getDefaultAbsolutePath()/found->pathRelativeToArchive,
+		flags
+	);
+}
+
+const IFileArchive::SFileList::found_t CArchiveLoaderLZ4Pack::CArchive::getItemFromPath(const system::path& pathRelativeToArchive) const
+{
+	const std::string pathString = pathRelativeToArchive.generic_string();
+	const uint64_t hash = lz4pack::hashPath(pathString);
+	const uint32_t mask = m_header->bucketCount-1u;
+	for (uint32_t bucket=hash&mask; m_buckets[bucket]!=lz4pack::InvalidEntry; bucket=(bucket+1u)&mask)
+	{
+		const auto& entry = m_entries[m_buckets[bucket]];
+		if (entry.pathHash!=hash || std::string_view(m_strings+entry.pathOffset,entry.pathLength)!=pathString)
+			continue;
+		return getItemFromIndex(m_itemIndex[m_buckets[bucket]]);
+	}
+	return {};
+}
+
+CFileArchive::file_buffer_t CArchiveLoaderLZ4Pack::CArchive::getFileBuffer(const IFileArchive::SFileList::found_t& item)
+{
+	const auto& entry = m_entries[item->ID];
+	if (item->allocatorType==EAT_NULL)
+		return {const_cast<std::byte*>(getBasePointer())+entry.dataOffset,entry.size,nullptr};
+
+	void* decompressed = VirtualMemoryAllocator(nullptr).alloc(entry.size);
+	if (!decompressed)
+	{
+		m_logger.log("Not enough memory for decompressing %s",ILogger::ELL_ERROR,item->pathRelativeToArchive.string().c_str());
+		return {nullptr,entry.size,nullptr};
+	}
+	if (!decompressRange(entry,decompressed,0ull,entry.size))
+	{
+		m_logger.log("Error decompressing %s",ILogger::ELL_ERROR,item->pathRelativeToArchive.string().c_str());
+		VirtualMemoryAllocator(nullptr).dealloc(decompressed,entry.size);
+		return {nullptr,entry.size,nullptr};
+	}
+	return {decompressed,entry.size,nullptr};
+}
+
+
+bool CArchiveLoaderLZ4Pack::isALoadableFileFormat(IFile* file) const
+{
+	lz4pack::SHeader header;
+	IFile::success_t success;
+	file->read(success,&header,0ull,sizeof(header));
+	if (!success)
+		return false;
+	return memcmp(header.magic,lz4pack::Magic,sizeof(lz4pack::Magic))==0 && header.version==lz4pack::Version;
+}
+
+core::smart_refctd_ptr<IFileArchive> CArchiveLoaderLZ4Pack::createArchive_impl(core::smart_refctd_ptr<system::IFile>&& file, const std::string_view& password) const
+{
+	if (!file || !(file->getFlags()&IFileBase::ECF_MAPPABLE))
+		return nullptr;
+
+	const IFile* constFile = file.get();
+	const auto* base = reinterpret_cast<const std::byte*>(constFile->getMappedPointer());
+	const size_t fileSize = file->getSize();
+	if (!base || fileSize<sizeof(lz4pack::SHeader))
+		return nullptr;
+
+	// validate everything the archive will later read straight out of the mapping
+	const auto* header = reinterpret_cast<const lz4pack::SHeader*>(base);
+	if (memcmp(header->magic,lz4pack::Magic,sizeof(lz4pack::Magic)) || header->version!=lz4pack::Version)
+		return nullptr;
+	if (header->blockSize==0u || header->blockSize>LZ4_MAX_INPUT_SIZE || !core::isPoT(header->bucketCount) || header->bucketCount<=header->entryCount)
+	{
+		m_logger.log("LZ4 pack %s has a malformed header",ILogger::ELL_ERROR,file->getFileName().string().c_str());
+		return nullptr;
+	}
+	const size_t tocEnd = sizeof(lz4pack::SHeader)+sizeof(lz4pack::SEntry)*size_t(header->entryCount)+sizeof(uint32_t)*size_t(header->bucketCount);
+	if (tocEnd>fileSize || header->stringsOffset<tocEnd || header->stringsOffset+header->stringsSize>fileSize)
+	{
+		m_logger.log("LZ4 pack %s has a truncated table of contents",ILogger::ELL_ERROR,file->getFileName().string().c_str());
+		return nullptr;
+	}
+
+	const auto* entries = reinterpret_cast<const lz4pack::SEntry*>(header+1);
+	const auto* buckets = reinterpret_cast<const uint32_t*>(entries+header->entryCount);
+	for (uint32_t b=0u; b<header->bucketCount; b++)
+	if (buckets[b]!=lz4pack::InvalidEntry && buckets[b]>=header->entryCount)
+		return nullptr;
+
+	std::shared_ptr<core::vector<IFileArchive::SFileList::SEntry>> items = std::make_shared<core::vector<IFileArchive::SFileList::SEntry>>();
+	items->reserve(header->entryCount);
+	for (uint32_t i=0u; i<header->entryCount; i++)
+	{
+		const auto& entry = entries[i];
+		const bool compressed = entry.flags&lz4pack::SEntry::EF_LZ4_BLOCKS;
+		const uint64_t minDataSize = compressed ? lz4pack::getBlockCount(entry.size,header->blockSize)*sizeof(uint64_t):entry.size;
+		if (uint64_t(entry.pathOffset)+entry.pathLength>header->stringsSize || entry.dataOffset+entry.dataSize>fileSize || entry.dataSize<minDataSize || entry.dataOffset%alignof(uint64_t))
+		{
+			m_logger.log("LZ4 pack %s has a corrupt entry %d",ILogger::ELL_ERROR,file->getFileName().string().c_str(),i);
+			return nullptr;
+		}
+		if (compressed)
+		{
+			// block ends have to be monotonic and within the entry's data
+			const auto* blockEnd = reinterpret_cast<const uint64_t*>(base+entry.dataOffset);
+			const uint64_t blockCount = lz4pack::getBlockCount(entry.size,header->blockSize);
+			const uint64_t compressedBytes = entry.dataSize-blockCount*sizeof(uint64_t);
+			for (uint64_t b=0ull; b<blockCount; b++)
+			if (blockEnd[b]<(b ? blockEnd[b-1ull]:0ull) || blockEnd[b]>compressedBytes)
+			{
+				m_logger.log("LZ4 pack %s has a corrupt block table for entry %d",ILogger::ELL_ERROR,file->getFileName().string().c_str(),i);
+				return nullptr;
+			}
+		}
+
+		auto& item = items->emplace_back();
+		item.pathRelativeToArchive = std::string_view(reinterpret_cast<const char*>(base+header->stringsOffset+entry.pathOffset),entry.pathLength);
+		item.size = entry.size;
+		item.offset = entry.dataOffset;
+		item.ID = i;
+		item.allocatorType = compressed ? IFileArchive::EAT_VIRTUAL_ALLOC:IFileArchive::EAT_NULL;
+	}
+	if (items->empty())
+		return nullptr;
+
+	return core::make_smart_refctd_ptr<CArchive>(std::move(file),core::smart_refctd_ptr(m_logger.get()),items);
+}
@@ -0,0 +1,65 @@
+#ifndef _NBL_SYSTEM_C_ARCHIVE_LOADER_LZ4_PACK_H_INCLUDED_
+#define _NBL_SYSTEM_C_ARCHIVE_LOADER_LZ4_PACK_H_INCLUDED_
+
+
+#include "nbl/system/CFileArchive.h"
+#include "nbl/system/SLZ4PackFormat.h"
+
+
+namespace nbl::system
+{
+
+//! Loads packs written by `tools/lz4pack`, see `SLZ4PackFormat.h` for the layout.
+// Stored entries are zero-copy views of the mapped pack, compressed ones are decompressed a 64kb block at a time,
+// only the blocks a read touches get decompressed and they get decompressed in parallel.
+class CArchiveLoaderLZ4Pack final : public IArchiveLoader
+{
+	public:
+		class CArchive final : public CFileArchive
+		{
+			public:
+				CArchive(core::smart_refctd_ptr<IFile>&& _file, system::logger_opt_smart_ptr&& logger, std::shared_ptr<core::vector<IFileArchive::SFileList::SEntry>> _items);
+
+				// decompresses `[offset,offset+size)` of a compressed entry into `dst`, returns false on corrupt data
+				bool decompressRange(const lz4pack::SEntry& entry, void* dst, const size_t offset, const size_t size) const;
+
+				inline const lz4pack::SEntry& getTOCEntry(const uint32_t id) const {return m_entries[id];}
+
+			protected:
+				core::smart_refctd_ptr<IFile> getFile_impl(const SFileList::found_t& found, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const std::string_view& password) override;
+				// the hashed table of contents gets used instead of a binary search over the sorted item list
+				const SFileList::found_t getItemFromPath(const system::path& pathRelativeToArchive) const override;
+				file_buffer_t getFileBuffer(const IFileArchive::SFileList::found_t& item) override;
+
+			private:
+				inline const std::byte* getBasePointer() const
+				{
+					const IFile* file = m_file.get();
+					return reinterpret_cast<const std::byte*>(file->getMappedPointer());
+				}
+
+				core::smart_refctd_ptr<IFile> m_file;
+				const lz4pack::SHeader* m_header;
+				const lz4pack::SEntry* m_entries;
+				const uint32_t* m_buckets;
+				const char* m_strings;
+				// TOC entry index to index in the sorted item list
+				core::vector<uint32_t> m_itemIndex;
+		};
+
+		CArchiveLoaderLZ4Pack(system::logger_opt_smart_ptr&& logger) : IArchiveLoader(std::move(logger)) {}
+
+		bool isALoadableFileFormat(IFile* file) const override;
+
+		inline const char** getAssociatedFileExtensions() const override
+		{
+			static const char* ext[]{ "nbpak", nullptr };
+			return ext;
+		}
+
+	private:
+		core::smart_refctd_ptr<IFileArchive> createArchive_impl(core::smart_refctd_ptr<system::IFile>&& file, const std::string_view& password) const override;
+};
+
+}
+#endif
@@ -0,0 +1,194 @@
+#include "nbl/system/CAsyncFileLogger.h"
+
+#include <bit>
+#include <ctime>
+
+using namespace nbl;
+using namespace nbl::system;
+
+CAsyncFileLogger::CAsyncFileLogger(
+	core::smart_refctd_ptr<IFile>&& _file, const bool append, const core::bitflag<E_LOG_LEVEL> logLevelMask,
+	const E_OVERFLOW_POLICY overflowPolicy, const uint32_t capacity
+) : ILogger(logLevelMask), m_file(std::move(_file)), m_pos(append ? m_file->getSize():0ull), m_overflowPolicy(overflowPolicy),
+	m_capacity(std::bit_ceil(core::max(capacity,2u))), m_records(std::make_unique<SRecord[]>(m_capacity)),
+	m_systemEpoch(std::chrono::system_clock::now()), m_steadyEpoch(std::chrono::steady_clock::now())
+{
+	for (uint32_t i=0u; i<m_capacity; i++)
+		m_records[i].sequence.store(i,std::memory_order_relaxed);
+	m_flusher = std::thread(&CAsyncFileLogger::flusherMain,this);
+}
+
+CAsyncFileLogger::~CAsyncFileLogger()
+{
+	uint64_t position;
+	auto* record = claim(ELL_NONE,position);
+	record->length = 0u;
+	record->longMessage = nullptr;
+	publish(record,position);
+	m_flusher.join();
+}
+
+void CAsyncFileLogger::flush()
+{
+	const uint64_t target = m_tail.load(std::memory_order_acquire);
+	for (auto flushed=m_flushed.load(std::memory_order_acquire); flushed<target; flushed=m_flushed.load(std::memory_order_acquire))
+		m_flushed.wait(flushed,std::memory_order_acquire);
+}
+
+void CAsyncFileLogger::log_impl(const std::string_view& fmtString, E_LOG_LEVEL logLevel, va_list args)
+{
+	uint64_t position;
+	auto* record = claim(logLevel,position);
+	if (!record)
+		return;
+
+	// one formatting pass for the common case, the rare long message pays for a second one
+	va_list argsCopy;
+	va_copy(argsCopy,args);
+	const int length = vsnprintf(record->message,sizeof(record->message),fmtString.data(),argsCopy);
+	va_end(argsCopy);
+	record->longMessage = nullptr;
+	if (length>=static_cast<int>(sizeof(record->message)))
+	{
+		record->longMessage = new char[length+1];
+		vsnprintf(record->longMessage,length+1,fmtString.data(),args);
+	}
+	record->length = core::max(length,0);
+	publish(record,position);
+}
+
+CAsyncFileLogger::SRecord* CAsyncFileLogger::claim(const E_LOG_LEVEL logLevel, uint64_t& position)
+{
+	const int64_t timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+	position = m_tail.load(std::memory_order_relaxed);
+	while (true)
+	{
+		auto& record = m_records[position&(m_capacity-1u)];
+		const int64_t diff = static_cast<int64_t>(record.sequence.load(std::memory_order_acquire)-position);
+		if (diff==0)
+		{
+			if (m_tail.compare_exchange_weak(position,position+1ull,std::memory_order_relaxed))
+			{
+				record.timestamp = timestamp;
+				record.level = logLevel;
+				return &record;
+			}
+		}
+		else if (diff<0)
+		{
+			// ring is full
+			if (m_overflowPolicy==EOP_DROP && logLevel!=ELL_NONE)
+			{
+				m_dropped.fetch_add(1ull,std::memory_order_relaxed);
+				return nullptr;
+			}
+			// the slot gets freed before the flusher moves `m_flushed` past its previous occupant
+			const uint64_t flushed = m_flushed.load(std::memory_order_acquire);
+			if (flushed+m_capacity<=position)
+				m_flushed.wait(flushed,std::memory_order_acquire);
+			position = m_tail.load(std::memory_order_relaxed);
+		}
+		else
+			position = m_tail.load(std::memory_order_relaxed);
+	}
+}
+
+void CAsyncFileLogger::publish(SRecord* record, const uint64_t position)
+{
+	record->sequence.store(position+1ull,std::memory_order_release);
+	m_tail.notify_one();
+}
+
+void CAsyncFileLogger::flusherMain()
+{
+	constexpr size_t MaxBatchSize = 0x1ull<<18u;
+
+	std::string batch;
+	batch.reserve(MaxBatchSize+sizeof(SRecord::message)+64u);
+	// `localtime` is the expensive part of the timestamp, only redo it when the second changes
+	std::time_t cachedSecond = -1;
+	char cachedDate[32] = {};
+
+	uint64_t head = 0ull;
+	bool quit = false;
+	while (!quit)
+	{
+		m_tail.wait(head,std::memory_order_acquire);
+		while (batch.size()<MaxBatchSize)
+		{
+			auto& record = m_records[head&(m_capacity-1u)];
+			if (record.sequence.load(std::memory_order_acquire)!=head+1ull)
+			{
+				// either nothing left, or a producer is still formatting, don't hold back what we already have for it
+				if (head==m_tail.load(std::memory_order_acquire) || !batch.empty())
+					break;
+				std::this_thread::yield();
+				continue;
+			}
+
+			if (record.level==ELL_NONE)
+				quit = true;
+			else
+			{
+				using namespace std::chrono;
+				const auto sinceStart = steady_clock::duration(record.timestamp)-m_steadyEpoch.time_since_epoch();
+				const auto now = m_systemEpoch+duration_cast<system_clock::duration>(sinceStart);
+				const std::time_t second = system_clock::to_time_t(now);
+				if (second!=cachedSecond)
+				{
+					const auto* time = std::localtime(&second);
+					snprintf(cachedDate,sizeof(cachedDate),"[%02d.%02d.%d %02d:%02d:%02d:",time->tm_mday,time->tm_mon+1,1900+time->tm_year,time->tm_hour,time->tm_min,time->tm_sec);
+					cachedSecond = second;
+				}
+				const auto microseconds = duration_cast<std::chrono::microseconds>(now-system_clock::from_time_t(second)).count();
+
+				char prefix[64];
+				const char* levelStr = "";
+				switch (record.level)
+				{
+					case ELL_DEBUG:
+						levelStr = "[DEBUG]";
+						break;
+					case ELL_INFO:
+						levelStr = "[INFO]";
+						break;
+					case ELL_WARNING:
+						levelStr = "[WARNING]";
+						break;
+					case ELL_PERFORMANCE:
+						levelStr = "[PERFORMANCE]";
+						break;
+					case ELL_ERROR:
+						levelStr = "[ERROR]";
+						break;
+					default:
+						break;
+				}
+				const int prefixLength = snprintf(prefix,sizeof(prefix),"%s%06d]%s: ",cachedDate,static_cast<int>(microseconds),levelStr);
+				batch.append(prefix,core::max(prefixLength,0));
+				if (record.longMessage)
+				{
+					batch.append(record.longMessage,record.length);
+					delete[] record.longMessage;
+				}
+				else
+					batch.append(record.message,record.length);
+				batch += '\n';
+			}
+			record.sequence.store(head+m_capacity,std::memory_order_release);
+			head++;
+			if (quit)
+				break;
+		}
+
+		if (!batch.empty())
+		{
+			IFile::success_t succ;
+			m_file->write(succ,batch.data(),m_pos,batch.size());
+			m_pos += succ.getBytesProcessed();
+			batch.clear();
+		}
+		m_flushed.store(head,std::memory_order_release);
+		m_flushed.notify_all();
+	}
+}
@@ -26,15 +26,14 @@ CFilePOSIX::~CFilePOSIX()
 	close(m_native);
 }
 
+// positional I/O doesn't touch the shared file offset, so multiple I/O workers can service the same file at once
 size_t CFilePOSIX::asyncRead(void* buffer, size_t offset, size_t sizeToRead)
 {
-	lseek(m_native, offset, SEEK_SET);
-	return ::read(m_native, buffer, sizeToRead);
+	return ::pread(m_native, buffer, sizeToRead, offset);
 }
 
 size_t CFilePOSIX::asyncWrite(const void* buffer, size_t offset, size_t sizeToWrite)
 {
-	lseek(m_native, offset, SEEK_SET);
-	return ::write(m_native, buffer, sizeToWrite);
+	return ::pwrite(m_native, buffer, sizeToWrite, offset);
 }
 #endif
\ No newline at end of file
@@ -23,6 +23,9 @@ class CFilePOSIX : public ISystemFile
 		// This is wrong! should re-query every time you call!
 		inline size_t getSize() const override {return m_size;}
 
+		// for I/O backends which don't go through `asyncRead`/`asyncWrite`
+		inline native_file_handle_t getNativeHandle() const {return m_native;}
+
 	protected:
 		~CFilePOSIX();
 
@@ -31,8 +34,6 @@ class CFilePOSIX : public ISystemFile
 		size_t asyncWrite(const void* buffer, size_t offset, size_t sizeToWrite) override;
 
 	private:
-		void seek(const size_t bytesFromBeginningOfFile);
-
 		const size_t m_size; // this is wrong!
 		const native_file_handle_t m_native;
 };
@@ -55,25 +55,24 @@ inline size_t CFileWin32::getSize() const
 	return (size_t(hi)<<32ull)|lo;
 }
 
+// an OVERLAPPED with an offset on a synchronous handle is the Win32 `pread`/`pwrite`, the shared file pointer is not used
+// so multiple I/O workers can service the same file at once
 size_t CFileWin32::asyncRead(void* buffer, size_t offset, size_t sizeToRead)
 {
-	seek(offset);
-	DWORD numOfBytesRead;
-	ReadFile(m_native, buffer, sizeToRead, &numOfBytesRead, nullptr);
+	OVERLAPPED position = {};
+	position.Offset = LODWORD(offset);
+	position.OffsetHigh = HIDWORD(offset);
+	DWORD numOfBytesRead = 0;
+	ReadFile(m_native, buffer, sizeToRead, &numOfBytesRead, &position);
 	return numOfBytesRead;
 }
 size_t CFileWin32::asyncWrite(const void* buffer, size_t offset, size_t sizeToWrite)
 {
-	seek(offset);
-	DWORD numOfBytesWritten;
-	WriteFile(m_native, buffer, sizeToWrite, &numOfBytesWritten, nullptr);
+	OVERLAPPED position = {};
+	position.Offset = LODWORD(offset);
+	position.OffsetHigh = HIDWORD(offset);
+	DWORD numOfBytesWritten = 0;
+	WriteFile(m_native, buffer, sizeToWrite, &numOfBytesWritten, &position);
 	return numOfBytesWritten;
 }
-
-
-void CFileWin32::seek(size_t position)
-{
-	LONG hiDword = HIDWORD(position);
-	SetFilePointer(m_native,position,&hiDword,FILE_BEGIN);
-}
 #endif
\ No newline at end of file
@@ -25,6 +25,9 @@ class CFileWin32 : public ISystemFile
 		//
 		size_t getSize() const override;
 
+		// for flushing the file buffers after the mapped view got written back
+		inline HANDLE getNativeHandle() const {return m_native;}
+
 	protected:
 		~CFileWin32();
 		
@@ -32,8 +35,6 @@ class CFileWin32 : public ISystemFile
 		size_t asyncWrite(const void* buffer, size_t offset, size_t sizeToWrite) override;
 
 	private:
-		void seek(const size_t bytesFromBeginningOfFile);
-
 		HANDLE m_native;
 		HANDLE m_fileMappingObj;
 };
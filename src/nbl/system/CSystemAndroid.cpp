@@ -16,12 +16,12 @@ using namespace nbl::system;
 CSystemAndroid::CSystemAndroid(ANativeActivity* activity, JNIEnv* jni, const path& APKResourcesPath) :
 	ISystemPOSIX(), m_nativeActivity(activity), m_jniEnv(jni)
 {
-	m_cachedArchiveFiles.insert(APKResourcesPath,core::make_smart_refctd_ptr<CAPKResourcesArchive>(
+	mount(core::make_smart_refctd_ptr<CAPKResourcesArchive>(
 		path(APKResourcesPath),
 		nullptr, // for now no logger
 		m_nativeActivity,
 		m_jniEnv
-	));
+	),APKResourcesPath);
 }
 
 ISystem::SystemInfo CSystemAndroid::getSystemInfo() const
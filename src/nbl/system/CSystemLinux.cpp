@@ -1,4 +1,5 @@
 #include "nbl/system/CSystemLinux.h"
+#include "nbl/system/CFilePOSIX.h"
 
 using namespace nbl;
 using namespace nbl::system;
@@ -26,4 +27,299 @@ ISystem::SystemInfo CSystemLinux::getSystemInfo() const
 
     return info;
 }
-#endif
\ No newline at end of file
+
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <condition_variable>
+
+// we talk to the kernel directly, the ring protocol is tiny and this way we don't need `liburing`
+class CSystemLinux::CCallerIOURing final : public ISystemPOSIX::CCaller
+{
+        // the sentinel we submit as a NOP to wake up the completion thread when shutting down
+        constexpr static inline uint64_t QuitUserData = 0ull;
+        // Linux never transfers more than this in a single read or write, and the SQE length is 32bit anyway
+        constexpr static inline size_t MaxSingleTransfer = 0x7ffff000ull;
+
+    public:
+        static inline core::smart_refctd_ptr<CCallerIOURing> create(ISystemPOSIX* _system, const uint32_t queueDepth, system::logger_opt_smart_ptr&& logger)
+        {
+            io_uring_params params = {};
+            const int ringFD = syscall(__NR_io_uring_setup,queueDepth,&params);
+            if (ringFD<0)
+                return nullptr;
+            // need at least Linux 5.6 for `IORING_OP_READ` and `IORING_OP_WRITE`, the RW_CUR_POS feature was introduced at the same time
+            if (!(params.features&IORING_FEAT_RW_CUR_POS))
+            {
+                close(ringFD);
+                return nullptr;
+            }
+
+            SRing ring = {};
+            ring.fd = ringFD;
+            ring.sqRingSize = params.sq_off.array+params.sq_entries*sizeof(uint32_t);
+            ring.cqRingSize = params.cq_off.cqes+params.cq_entries*sizeof(io_uring_cqe);
+            const bool singleMmap = params.features&IORING_FEAT_SINGLE_MMAP;
+            if (singleMmap)
+                ring.sqRingSize = ring.cqRingSize = std::max(ring.sqRingSize,ring.cqRingSize);
+            ring.sqRing = mmap(nullptr,ring.sqRingSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ringFD,IORING_OFF_SQ_RING);
+            if (ring.sqRing==MAP_FAILED)
+            {
+                close(ringFD);
+                return nullptr;
+            }
+            if (singleMmap)
+                ring.cqRing = ring.sqRing;
+            else
+            {
+                ring.cqRing = mmap(nullptr,ring.cqRingSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ringFD,IORING_OFF_CQ_RING);
+                if (ring.cqRing==MAP_FAILED)
+                {
+                    munmap(ring.sqRing,ring.sqRingSize);
+                    close(ringFD);
+                    return nullptr;
+                }
+            }
+            ring.sqesSize = params.sq_entries*sizeof(io_uring_sqe);
+            ring.sqes = reinterpret_cast<io_uring_sqe*>(mmap(nullptr,ring.sqesSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ringFD,IORING_OFF_SQES));
+            if (ring.sqes==MAP_FAILED)
+            {
+                if (!singleMmap)
+                    munmap(ring.cqRing,ring.cqRingSize);
+                munmap(ring.sqRing,ring.sqRingSize);
+                close(ringFD);
+                return nullptr;
+            }
+
+            auto* const sqBase = reinterpret_cast<uint8_t*>(ring.sqRing);
+            ring.sqHead = reinterpret_cast<uint32_t*>(sqBase+params.sq_off.head);
+            ring.sqTail = reinterpret_cast<uint32_t*>(sqBase+params.sq_off.tail);
+            ring.sqMask = *reinterpret_cast<const uint32_t*>(sqBase+params.sq_off.ring_mask);
+            ring.sqArray = reinterpret_cast<uint32_t*>(sqBase+params.sq_off.array);
+            ring.sqEntries = params.sq_entries;
+            auto* const cqBase = reinterpret_cast<uint8_t*>(ring.cqRing);
+            ring.cqHead = reinterpret_cast<uint32_t*>(cqBase+params.cq_off.head);
+            ring.cqTail = reinterpret_cast<uint32_t*>(cqBase+params.cq_off.tail);
+            ring.cqMask = *reinterpret_cast<const uint32_t*>(cqBase+params.cq_off.ring_mask);
+            ring.cqes = reinterpret_cast<io_uring_cqe*>(cqBase+params.cq_off.cqes);
+
+            return core::smart_refctd_ptr<CCallerIOURing>(new CCallerIOURing(_system,ring,std::move(logger)),core::dont_grab);
+        }
+
+        bool submitRead(future_t<size_t>* future, ISystemFile* file, void* buffer, size_t offset, size_t size) override
+        {
+            return submit(IORING_OP_READ,future,file,buffer,offset,size);
+        }
+        bool submitWrite(future_t<size_t>* future, ISystemFile* file, const void* buffer, size_t offset, size_t size) override
+        {
+            return submit(IORING_OP_WRITE,future,file,const_cast<void*>(buffer),offset,size);
+        }
+
+    protected:
+        ~CCallerIOURing()
+        {
+            {
+                std::unique_lock lock(m_submitMutex);
+                // after a fatal error of its own the completion thread is already gone
+                if (m_reaping && pushSQE(IORING_OP_NOP,-1,nullptr,0ull,0u,QuitUserData)!=0)
+                {
+                    // Can't wake it, once submitting failed it only quits after reaping the last request in flight. With none left it
+                    // sleeps in the kernel for good and no more completions can ever wake it up, so let it be.
+                    if (!m_inFlight)
+                        m_completionThread.detach();
+                }
+            }
+            if (m_completionThread.joinable())
+                m_completionThread.join();
+
+            munmap(m_ring.sqes,m_ring.sqesSize);
+            if (m_ring.cqRing!=m_ring.sqRing)
+                munmap(m_ring.cqRing,m_ring.cqRingSize);
+            munmap(m_ring.sqRing,m_ring.sqRingSize);
+            close(m_ring.fd);
+        }
+
+    private:
+        struct SRing
+        {
+            int fd;
+            void* sqRing;
+            size_t sqRingSize;
+            void* cqRing;
+            size_t cqRingSize;
+            io_uring_sqe* sqes;
+            size_t sqesSize;
+            // submission queue
+            uint32_t* sqHead;
+            uint32_t* sqTail;
+            uint32_t* sqArray;
+            uint32_t sqMask;
+            uint32_t sqEntries;
+            // completion queue
+            uint32_t* cqHead;
+            uint32_t* cqTail;
+            io_uring_cqe* cqes;
+            uint32_t cqMask;
+        };
+
+        inline CCallerIOURing(ISystemPOSIX* _system, const SRing& _ring, system::logger_opt_smart_ptr&& _logger) : CCaller(_system), m_ring(_ring), m_logger(std::move(_logger))
+        {
+            m_completionThread = std::thread(&CCallerIOURing::reapCompletions,this);
+        }
+
+        inline bool submit(const uint8_t opcode, future_t<size_t>* future, ISystemFile* file, void* buffer, const size_t offset, const size_t size)
+        {
+            // let the dispatcher thread deal with the odd huge request
+            if (size>MaxSingleTransfer)
+                return false;
+            // The ring completes requests in any order and `IOSQE_IO_LINK` only chains SQEs submitted together, so a write could overtake
+            // an earlier write or read of the same range. Files which can be written to stay on the dispatcher thread they're pinned to.
+            if (file->getFlags()&IFileBase::ECF_WRITE)
+                return false;
+            // every file we create is a `CFilePOSIX`
+            const int fd = static_cast<const CFilePOSIX*>(file)->getNativeHandle();
+
+            std::unique_lock lock(m_submitMutex);
+            // The CQ is twice as big as the SQ, as long as we keep at most `sqEntries` in flight it will never overflow.
+            // Blocking here means the dispatcher's request ring stops being consumed, giving back-pressure to the requesting threads.
+            m_slotFreed.wait(lock,[this]()->bool{return m_failed||m_inFlight<m_ring.sqEntries;});
+            // the ring is dead, everything goes through the dispatcher threads from now on
+            if (m_failed)
+                return false;
+            // the completion thread can't reap it before we release `m_submitMutex`, so we can start tracking it after submitting
+            if (const int error=pushSQE(opcode,fd,buffer,offset,static_cast<uint32_t>(size),reinterpret_cast<uint64_t>(future)); error)
+            {
+                // the kernel never saw the request, fail it and send everything after it through the dispatcher threads
+                m_failed = true;
+                m_slotFreed.notify_all();
+                lock.unlock();
+                m_logger.log("io_uring_enter failed to submit with \"%s\", failing the request and falling back to POSIX I/O",ILogger::ELL_ERROR,strerror(error));
+                signalCompletion(future,0ull);
+                return true;
+            }
+            m_inFlight++;
+            m_pending.insert(future);
+            return true;
+        }
+
+        // call with `m_submitMutex` locked, returns the `errno` if the kernel didn't take the SQE
+        inline int pushSQE(const uint8_t opcode, const int fd, void* buffer, const size_t offset, const uint32_t size, const uint64_t userData)
+        {
+            // we're the only producer, so our own tail needs no ordering
+            const uint32_t tail = *m_ring.sqTail;
+            const uint32_t index = tail&m_ring.sqMask;
+            // kernel consumes SQEs at submit time (we don't use SQPOLL) so a slot is always free after `io_uring_enter` returned
+            assert(tail-std::atomic_ref<uint32_t>(*m_ring.sqHead).load(std::memory_order_acquire)<m_ring.sqEntries);
+
+            io_uring_sqe& sqe = m_ring.sqes[index];
+            memset(&sqe,0,sizeof(io_uring_sqe));
+            sqe.opcode = opcode;
+            sqe.fd = fd;
+            sqe.off = offset;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer);
+            sqe.len = size;
+            sqe.user_data = userData;
+            m_ring.sqArray[index] = index;
+            std::atomic_ref<uint32_t>(*m_ring.sqTail).store(tail+1u,std::memory_order_release);
+
+            // retry a transient lack of resources
+            while (syscall(__NR_io_uring_enter,m_ring.fd,1u,0u,0u,nullptr,0ull)<0)
+            {
+                if (errno==EINTR || errno==EAGAIN || errno==EBUSY)
+                    continue;
+                // nothing got consumed if it failed, take the SQE back so it can't get submitted along with a later one
+                const int error = errno;
+                std::atomic_ref<uint32_t>(*m_ring.sqTail).store(tail,std::memory_order_release);
+                return error;
+            }
+            return 0;
+        }
+
+        void reapCompletions()
+        {
+            core::vector<std::pair<future_t<size_t>*,size_t>> completions;
+            bool quit = false;
+            // once submitting failed nothing sends us the quit NOP anymore
+            while (!(quit || m_failed) || m_inFlight)
+            {
+                const int waited = syscall(__NR_io_uring_enter,m_ring.fd,0u,1u,IORING_ENTER_GETEVENTS,nullptr,0ull);
+                if (waited<0 && errno!=EINTR && errno!=EAGAIN && errno!=EBUSY)
+                {
+                    // something like EBADF or EFAULT, it will never go away so nothing in flight can be reaped anymore
+                    const int error = errno;
+                    core::unordered_set<future_t<size_t>*> pending;
+                    {
+                        std::unique_lock lock(m_submitMutex);
+                        m_failed = true;
+                        m_reaping = false;
+                        pending.swap(m_pending);
+                        m_inFlight = 0u;
+                        m_slotFreed.notify_all();
+                    }
+                    m_logger.log("io_uring_enter failed with \"%s\", failing %zu requests in flight",ILogger::ELL_ERROR,strerror(error),pending.size());
+                    for (auto* future : pending)
+                        signalCompletion(future,0ull);
+                    break;
+                }
+
+                uint32_t head = *m_ring.cqHead;
+                const uint32_t tail = std::atomic_ref<uint32_t>(*m_ring.cqTail).load(std::memory_order_acquire);
+                for (; head!=tail; head++)
+                {
+                    const io_uring_cqe& cqe = m_ring.cqes[head&m_ring.cqMask];
+                    if (cqe.user_data==QuitUserData)
+                    {
+                        quit = true;
+                        continue;
+                    }
+                    // keep the same semantics as `CFilePOSIX::asyncRead` minus the negative errno turning into a huge `size_t`
+                    completions.emplace_back(reinterpret_cast<future_t<size_t>*>(cqe.user_data),cqe.res>0 ? size_t(cqe.res):0ull);
+                }
+                std::atomic_ref<uint32_t>(*m_ring.cqHead).store(head,std::memory_order_release);
+
+                if (completions.empty())
+                    continue;
+                {
+                    // stop tracking before signalling, a signalled future can get freed and its address reused by the next submit
+                    std::unique_lock lock(m_submitMutex);
+                    for (const auto& completion : completions)
+                        m_pending.erase(completion.first);
+                    m_inFlight -= static_cast<uint32_t>(completions.size());
+                    m_slotFreed.notify_all();
+                }
+                for (const auto& completion : completions)
+                    signalCompletion(completion.first,completion.second);
+                completions.clear();
+            }
+        }
+
+        SRing m_ring;
+        std::mutex m_submitMutex;
+        std::condition_variable m_slotFreed;
+        // only modified under `m_submitMutex`, but read without it on the completion thread's loop condition
+        std::atomic_uint32_t m_inFlight = 0u;
+        // futures taken over and not completed yet, under `m_submitMutex`
+        core::unordered_set<future_t<size_t>*> m_pending;
+        // set under `m_submitMutex` once `io_uring_enter` fails for good, read by the completion thread's loop condition without it
+        std::atomic_bool m_failed = false;
+        // cleared under `m_submitMutex` when the completion thread quits because of an error of its own
+        bool m_reaping = true;
+        system::logger_opt_smart_ptr m_logger;
+        std::thread m_completionThread;
+};
+
+core::smart_refctd_ptr<ISystemPOSIX::CCaller> CSystemLinux::createCaller(ISystemPOSIX* _system, const SCreationParams& params)
+{
+    if (params.useIOURing)
+    {
+        if (auto caller=CCallerIOURing::create(_system,params.ioURingQueueDepth,core::smart_refctd_ptr(params.logger)); caller)
+            return std::move(caller);
+    }
+    return core::make_smart_refctd_ptr<CCaller>(_system);
+}
+#endif
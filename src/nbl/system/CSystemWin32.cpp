@@ -7,6 +7,13 @@ using namespace nbl::system;
 #ifdef _NBL_PLATFORM_WINDOWS_
 #include <powerbase.h>
 
+#ifndef LODWORD
+#	define LODWORD(_qw)    ((DWORD)(_qw))
+#endif
+#ifndef HIDWORD
+#	define HIDWORD(_qw)    ((DWORD)(((_qw) >> 32u) & 0xffffffffu))
+#endif
+
 //LOL the struct definition wasn't added to winapi headers do they ask to declare them yourself
 typedef struct _PROCESSOR_POWER_INFORMATION {
     ULONG Number;
@@ -39,10 +46,12 @@ ISystem::SystemInfo CSystemWin32::getSystemInfo() const
 }
 
 
-core::smart_refctd_ptr<ISystemFile> CSystemWin32::CCaller::createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags)
+core::smart_refctd_ptr<ISystemFile> CSystemWin32::CCaller::createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags, const size_t preallocatedSize)
 {
     const bool writeAccess = flags.value&IFile::ECF_WRITE;
-	const DWORD fileAccess = ((flags.value&IFile::ECF_READ) ? FILE_GENERIC_READ:0)|(writeAccess ? FILE_GENERIC_WRITE:0);
+	// a `PAGE_READWRITE` mapping needs the handle to be readable as well
+	const bool writeMapping = writeAccess && (flags.value&IFile::ECF_MAPPABLE);
+	const DWORD fileAccess = ((flags.value&IFile::ECF_READ)||writeMapping ? FILE_GENERIC_READ:0)|(writeAccess ? FILE_GENERIC_WRITE:0);
 
 	SECURITY_ATTRIBUTES secAttribs{ sizeof(SECURITY_ATTRIBUTES), nullptr, FALSE };
 	
@@ -50,8 +59,8 @@ core::smart_refctd_ptr<ISystemFile> CSystemWin32::CCaller::createFile(const std:
 	if (p.is_absolute()) 
 		p.make_preferred(); // Replace "/" separators with "\"
 
-    // only write access should create new files if they don't exist
-	const auto creationDisposition = writeAccess ? OPEN_ALWAYS:OPEN_EXISTING;
+    // only write access should create new files if they don't exist, preallocation starts over from scratch
+	const auto creationDisposition = writeAccess ? (preallocatedSize ? CREATE_ALWAYS:OPEN_ALWAYS):OPEN_EXISTING;
 	HANDLE _native = CreateFileA(p.string().data(), fileAccess, FILE_SHARE_READ, &secAttribs, creationDisposition, FILE_ATTRIBUTE_NORMAL, nullptr);
     if (_native==INVALID_HANDLE_VALUE)
     {
@@ -68,7 +77,8 @@ core::smart_refctd_ptr<ISystemFile> CSystemWin32::CCaller::createFile(const std:
         For now it equals the size of a file so it'll work fine for archive reading, but if we try to
         write outside those boungs, things will go bad.
         */
-        _fileMappingObj = CreateFileMappingA(_native,nullptr,writeAccess ? PAGE_READWRITE:PAGE_READONLY, 0, 0, filename.string().c_str());
+        // a mapping object bigger than the file grows the file, which is how we preallocate
+        _fileMappingObj = CreateFileMappingA(_native,nullptr,writeAccess ? PAGE_READWRITE:PAGE_READONLY,HIDWORD(preallocatedSize),LODWORD(preallocatedSize),filename.string().c_str());
         if (!_fileMappingObj)
         {
             CloseHandle(_native);
@@ -99,6 +109,52 @@ core::smart_refctd_ptr<ISystemFile> CSystemWin32::CCaller::createFile(const std:
             return nullptr;
         }
     }
+    else if (writeAccess && preallocatedSize)
+    {
+        LARGE_INTEGER end;
+        end.QuadPart = preallocatedSize;
+        if (!SetFilePointerEx(_native,end,nullptr,FILE_BEGIN) || !SetEndOfFile(_native))
+        {
+            CloseHandle(_native);
+            return nullptr;
+        }
+    }
     return core::make_smart_refctd_ptr<CFileWin32>(core::smart_refctd_ptr<ISystem>(m_system),path(filename),flags,_mappedPtr,_native,_fileMappingObj);
 }
+
+void CSystemWin32::CCaller::prefetch(const std::filesystem::path& filename)
+{
+	system::path p = filename;
+	if (p.is_absolute())
+		p.make_preferred();
+
+	HANDLE file = CreateFileA(p.string().data(), FILE_GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file==INVALID_HANDLE_VALUE)
+		return;
+	// There's no `readahead` on Windows. `PrefetchVirtualMemory` on a mapped view only queues the reads, unmapping the view straight after
+	// may cancel them before they were issued. So just read the file through the cache on this (background priority) thread, the pages
+	// stay in the standby list of the file cache afterwards.
+	constexpr DWORD ChunkSize = 0x1u<<20u;
+	auto chunk = std::make_unique<uint8_t[]>(ChunkSize);
+	DWORD bytesRead = 0u;
+	while (ReadFile(file, chunk.get(), ChunkSize, &bytesRead, nullptr) && bytesRead) {}
+	CloseHandle(file);
+}
+
+bool CSystemWin32::CCaller::flushMapping_impl(IFile* file, size_t offset, size_t size)
+{
+    // archive entries and other file views are just memory
+    auto* const win32File = dynamic_cast<CFileWin32*>(file);
+    if (!win32File || !(file->getFlags()&IFile::ECF_WRITE))
+        return false;
+    auto* const mapping = reinterpret_cast<uint8_t*>(win32File->getMappedPointer());
+    // `FlushViewOfFile` only starts writing the dirty pages back, the file buffers need flushing as well to be as durable as `msync(MS_SYNC)`
+    return mapping && FlushViewOfFile(mapping+offset,size) && FlushFileBuffers(win32File->getNativeHandle());
+}
+
+bool CSystemWin32::CCaller::invalidateMapping_impl(IFile* file, size_t offset, size_t size)
+{
+    // views of the same file mapping object are always coherent with the file on Windows
+    return dynamic_cast<CFileWin32*>(file);
+}
 #endif
\ No newline at end of file
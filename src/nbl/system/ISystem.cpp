@@ -9,15 +9,29 @@
 
 #include "nbl/system/CArchiveLoaderZip.h"
 #include "nbl/system/CArchiveLoaderTar.h"
+#include "nbl/system/CArchiveLoaderLZ4Pack.h"
 #include "nbl/system/CMountDirectoryArchive.h"
 
+#if defined(_NBL_PLATFORM_WINDOWS_)
+#include <windows.h>
+#elif defined(_NBL_PLATFORM_LINUX_) || defined(_NBL_PLATFORM_ANDROID_)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 using namespace nbl;
 using namespace nbl::system;
 
-ISystem::ISystem(core::smart_refctd_ptr<ISystem::ICaller>&& caller) : m_dispatcher(std::move(caller))
+ISystem::ISystem(core::smart_refctd_ptr<ISystem::ICaller>&& caller, const uint32_t ioWorkerCount) : m_caller(std::move(caller))
 {
+    m_dispatchers.resize(core::max(ioWorkerCount,1u));
+    for (auto& dispatcher : m_dispatchers)
+        dispatcher = std::make_unique<CAsyncQueue>(core::smart_refctd_ptr(m_caller));
+
     addArchiveLoader(core::make_smart_refctd_ptr<CArchiveLoaderZip>(nullptr));
     addArchiveLoader(core::make_smart_refctd_ptr<CArchiveLoaderTar>(nullptr));
+    addArchiveLoader(core::make_smart_refctd_ptr<CArchiveLoaderLZ4Pack>(nullptr));
     
     #ifdef NBL_EMBED_BUILTIN_RESOURCES
     mount(core::make_smart_refctd_ptr<nbl::builtin::CArchive>(nullptr));
@@ -182,11 +196,7 @@ bool ISystem::copy(const system::path& from, const system::path& to)
 
 void ISystem::createFile(future_t<core::smart_refctd_ptr<IFile>>& future, std::filesystem::path filename, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const std::string_view& accessToken)
 {
-    // canonicalize
-    if (std::filesystem::exists(filename))
-        filename = std::filesystem::canonical(filename);
-
-    // try archives (readonly, for now)
+    // try archives (readonly, for now), the lookup is memoised and resolves the path on its own
     if (!(flags.value&IFile::ECF_WRITE))
     {
         const auto found = findFileInArchive(filename);
@@ -201,9 +211,9 @@ void ISystem::createFile(future_t<core::smart_refctd_ptr<IFile>>& future, std::f
         }
     }
 
-    //
+    // canonicalize
     if (std::filesystem::exists(filename))
-        filename = std::filesystem::absolute(filename).generic_string();
+        filename = std::filesystem::canonical(filename).generic_string();
     if (filename.string().size()>=MAX_FILENAME_LENGTH)
     {
         future.set_result(nullptr);
@@ -214,7 +224,30 @@ void ISystem::createFile(future_t<core::smart_refctd_ptr<IFile>>& future, std::f
     SRequestParams_CREATE_FILE params;
     strcpy(params.filename,filename.string().c_str());
     params.flags = flags.value;
-    m_dispatcher.request(&future,params);
+    dispatch(&future,nullptr,params);
+}
+
+void ISystem::createFile(future_t<core::smart_refctd_ptr<IFile>>& future, std::filesystem::path filename, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const size_t preallocatedSize)
+{
+    // can't preallocate for reading, nor inside archives
+    if (!(flags.value&IFile::ECF_WRITE) || isPathReadOnly(filename))
+    {
+        future.set_result(nullptr);
+        return;
+    }
+
+    filename = std::filesystem::absolute(filename).generic_string();
+    if (filename.string().size()>=MAX_FILENAME_LENGTH)
+    {
+        future.set_result(nullptr);
+        return;
+    }
+
+    SRequestParams_CREATE_FILE params;
+    strcpy(params.filename,filename.string().c_str());
+    params.flags = flags.value;
+    params.preallocatedSize = preallocatedSize;
+    dispatch(&future,nullptr,params);
 }
 
 core::smart_refctd_ptr<IFileArchive> ISystem::openFileArchive(core::smart_refctd_ptr<IFile>&& file, const std::string_view& password)
@@ -242,41 +275,277 @@ core::smart_refctd_ptr<IFileArchive> ISystem::openFileArchive(core::smart_refctd
     return nullptr;
 }
 
+// aliases get matched component by component, so "a/b/" and "a/./b" need to look the same as "a/b"
+static inline system::path normalizeMountPath(const system::path& p)
+{
+    auto retval = p.lexically_normal();
+    if (!retval.empty() && !retval.has_filename() && retval.has_relative_path())
+        retval = retval.parent_path();
+    return retval;
+}
+
+void ISystem::mount(core::smart_refctd_ptr<IFileArchive>&& archive, const system::path& pathAlias)
+{
+    const system::path alias = pathAlias.empty() ? archive->getDefaultAbsolutePath():pathAlias;
+
+    std::unique_lock lock(m_mountMutex);
+    m_mountTrie.insert(normalizeMountPath(alias),archive.get());
+    m_archiveLookupCache.clear();
+    m_mountGeneration++;
+    m_cachedArchiveFiles.insert(alias,std::move(archive));
+}
+
+void ISystem::unmount(const IFileArchive* archive, const system::path& pathAlias)
+{
+    const system::path alias = pathAlias.empty() ? archive->getDefaultAbsolutePath():pathAlias;
+
+    std::unique_lock lock(m_mountMutex);
+    // the lookup cache holds plain pointers, so it has to go before the archive possibly gets dropped
+    m_archiveLookupCache.clear();
+    m_mountGeneration++;
+    m_mountTrie.remove(normalizeMountPath(alias),archive);
+    auto dummy = reinterpret_cast<const core::smart_refctd_ptr<IFileArchive>&>(archive);
+    m_cachedArchiveFiles.removeObject(dummy,alias);
+}
+
+void ISystem::invalidateArchiveLookupCache()
+{
+    std::unique_lock lock(m_mountMutex);
+    m_archiveLookupCache.clear();
+    m_mountGeneration++;
+}
+
+// the path could be going through symlinks or be relative to the working directory, so resolve the deepest ancestor which exists on disk,
+// returns an empty path if that doesn't change anything
+static inline system::path resolveOnDisk(const system::path& normalPath)
+{
+    std::error_code error;
+    auto existing = normalPath.parent_path();
+    while (!existing.empty() && existing.parent_path()!=existing && !std::filesystem::exists(existing,error))
+        existing = existing.parent_path();
+    if (existing.empty() || existing.parent_path()==existing)
+        return {};
+
+    const auto canonical = std::filesystem::canonical(existing,error);
+    if (error)
+        return {};
+    const auto resolved = (canonical/normalPath.lexically_relative(existing)).lexically_normal();
+    if (resolved==normalPath)
+        return {};
+    return resolved;
+}
+
 ISystem::FoundArchiveFile ISystem::findFileInArchive(const system::path& absolutePath) const
 {
-    system::path path = std::filesystem::exists(absolutePath) ? std::filesystem::canonical(absolutePath.parent_path()):absolutePath.parent_path();
-    // going up the directory tree
-    while (!path.empty() && path.parent_path()!=path)
+    // plenty for all the shaders and assets of an application, a runaway working set just starts over
+    constexpr size_t MaxCachedLookups = 0x1ull<<16u;
+
+    const auto key = absolutePath.generic_string();
+    const auto normalPath = absolutePath.lexically_normal();
+    // Resolving takes only the shared lock, so concurrent lookups never wait on each other, and the filesystem is only touched without any lock.
+    uint64_t generation;
+    bool underDirectoryMount = false;
+    FoundArchiveFile found;
     {
-        path = std::filesystem::exists(path) ? std::filesystem::canonical(path):path;
+        std::shared_lock lock(m_mountMutex);
+        const auto cached = m_archiveLookupCache.find(key);
+        if (cached!=m_archiveLookupCache.end())
+            return cached->second;
+        generation = m_mountGeneration;
+        found = m_mountTrie.find(normalPath,underDirectoryMount);
+    }
+    if (!found.archive)
+    {
+        const auto resolved = resolveOnDisk(normalPath);
+        if (!resolved.empty())
+        {
+            std::shared_lock lock(m_mountMutex);
+            found = m_mountTrie.find(resolved,underDirectoryMount);
+        }
+    }
+
+    // Files can show up in a mounted directory at any time, so misses under one are not remembered.
+    if (!found.archive && underDirectoryMount)
+        return found;
+    std::unique_lock lock(m_mountMutex);
+    // something got mounted, unmounted or invalidated in the meantime, the result might already be stale
+    if (generation!=m_mountGeneration)
+        return found;
+    if (m_archiveLookupCache.size()>=MaxCachedLookups)
+        m_archiveLookupCache.clear();
+    m_archiveLookupCache.try_emplace(key,found);
+    return found;
+}
 
-        const auto archives = m_cachedArchiveFiles.findRange(path);
-        for (auto& archive : archives)
+void ISystem::CMountTrie::insert(const system::path& alias, IFileArchive* archive)
+{
+    uint32_t node = 0u;
+    for (const auto& component : alias)
+    {
+        const auto name = component.generic_string();
+        const auto child = m_nodes[node].children.find(name);
+        if (child!=m_nodes[node].children.end())
         {
-            const auto relative = std::filesystem::relative(absolutePath,path);
-            const auto items = static_cast<IFileArchive::SFileList::range_t>(archive.second->listAssets());
+            node = child->second;
+            continue;
+        }
+        const uint32_t newNode = m_nodes.size();
+        m_nodes[node].children.emplace(name,newNode);
+        m_nodes.emplace_back();
+        node = newNode;
+    }
+    m_nodes[node].archives.push_back(archive);
+}
+
+void ISystem::CMountTrie::remove(const system::path& alias, const IFileArchive* archive)
+{
+    uint32_t node = 0u;
+    for (const auto& component : alias)
+    {
+        const auto child = m_nodes[node].children.find(component.generic_string());
+        if (child==m_nodes[node].children.end())
+            return;
+        node = child->second;
+    }
+    auto& archives = m_nodes[node].archives;
+    const auto found = std::find(archives.begin(),archives.end(),archive);
+    if (found!=archives.end())
+        archives.erase(found);
+}
+
+ISystem::FoundArchiveFile ISystem::CMountTrie::find(const system::path& normalPath, bool& underDirectoryMount) const
+{
+    // remember the mount points on the way down and try them deepest first, same as walking up the directory tree would
+    core::vector<std::pair<uint32_t,system::path::const_iterator>> mountPoints;
+    uint32_t node = 0u;
+    for (auto it=normalPath.begin(); it!=normalPath.end();)
+    {
+        const auto child = m_nodes[node].children.find(it->generic_string());
+        if (child==m_nodes[node].children.end())
+            break;
+        node = child->second;
+        // a mount point itself is not a file in the archive
+        if (++it!=normalPath.end() && !m_nodes[node].archives.empty())
+            mountPoints.emplace_back(node,it);
+    }
+
+    for (auto mountPoint=mountPoints.rbegin(); mountPoint!=mountPoints.rend(); mountPoint++)
+    {
+        system::path relative;
+        for (auto it=mountPoint->second; it!=normalPath.end(); it++)
+            relative /= *it;
+
+        for (auto* archive : m_nodes[mountPoint->first].archives)
+        {
+            underDirectoryMount = underDirectoryMount || dynamic_cast<const CMountDirectoryArchive*>(archive);
+            const auto items = static_cast<IFileArchive::SFileList::range_t>(archive->listAssets());
 
             const IFileArchive::SFileList::SEntry itemToFind = { relative };
             auto found = std::lower_bound(items.begin(), items.end(), itemToFind);
             if (found!=items.end() && found->pathRelativeToArchive==relative)
-                return {archive.second.get(),relative};
+                return {archive,relative};
         }
-        path = path.parent_path();
     }
-    return { nullptr,{} };
+    return {nullptr,{}};
+}
+
+
+void ISystem::prefetch(std::span<const system::path> paths)
+{
+    m_prefetchQueue.push(paths);
+}
+
+void ISystem::prefetch_impl(const system::path& filename)
+{
+    const auto found = findFileInArchive(filename);
+    if (found.archive)
+        found.archive->prefetch(found.pathRelativeToArchive);
+    else
+        m_caller->prefetch(filename);
+}
+
+ISystem::CPrefetchQueue::~CPrefetchQueue()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_quit = true;
+        m_pending.clear();
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void ISystem::CPrefetchQueue::push(std::span<const system::path> paths)
+{
+    if (paths.empty())
+        return;
+    {
+        std::unique_lock lock(m_mutex);
+        if (!m_thread.joinable())
+            m_thread = std::thread(&CPrefetchQueue::workerMain,this);
+        for (const auto& path : paths)
+            m_pending.push_back(path);
+        // the newest hints are the most relevant ones
+        while (m_pending.size()>MaxPending)
+            m_pending.pop_front();
+    }
+    m_cv.notify_one();
+}
+
+void ISystem::CPrefetchQueue::workerMain()
+{
+    // prefetching is only a hint, it should take neither CPU time nor disk bandwidth away from the demand reads
+    #if defined(_NBL_PLATFORM_WINDOWS_)
+    // background mode lowers the I/O and memory priority as well
+    SetThreadPriority(GetCurrentThread(),THREAD_MODE_BACKGROUND_BEGIN);
+    #elif defined(_NBL_PLATFORM_LINUX_) || defined(_NBL_PLATFORM_ANDROID_)
+    // the nice value is per thread on Linux
+    const pid_t tid = syscall(SYS_gettid);
+    setpriority(PRIO_PROCESS,tid,19);
+    #ifdef _NBL_PLATFORM_LINUX_
+    // there's neither a libc wrapper nor a userspace header for `ioprio_set`, this is `IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE,0)` for `IOPRIO_WHO_PROCESS`
+    constexpr int WhoProcess = 1;
+    constexpr int ClassIdle = 3;
+    constexpr int ClassShift = 13;
+    syscall(SYS_ioprio_set,WhoProcess,tid,ClassIdle<<ClassShift);
+    #endif
+    #endif
+
+    std::unique_lock lock(m_mutex);
+    while (true)
+    {
+        m_cv.wait(lock,[this]()->bool{return m_quit || !m_pending.empty();});
+        if (m_quit)
+            return;
+        const auto path = std::move(m_pending.front());
+        m_pending.pop_front();
+
+        lock.unlock();
+        m_system->prefetch_impl(path);
+        lock.lock();
+    }
 }
 
 
-void ISystem::CAsyncQueue::process_request(base_t::future_base_t* _future_base, SRequestType& req)
+bool ISystem::CAsyncQueue::process_request(base_t::future_base_t* _future_base, SRequestType& req)
 {
-    std::visit([=](auto& visitor) {
+    return std::visit([=](auto& visitor) -> bool {
         using retval_t = std::remove_reference_t<decltype(visitor)>::retval_t;
+        // only reads and writes can be taken over by the caller, all the futures we get handed are `ISystem::future_t`
+        auto* future = static_cast<ISystem::future_t<retval_t>*>(_future_base);
+        if constexpr (requires {visitor.submit(future,m_caller.get());})
+        {
+            if (visitor.submit(future,m_caller.get()))
+                return false;
+        }
         visitor(base_t::future_storage_cast<retval_t>(_future_base),m_caller.get());
+        return true;
     }, req.params);
 }
 void ISystem::SRequestParams_CREATE_FILE::operator()(core::StorageTrivializer<retval_t>* retval, ICaller* _caller)
 {
-    retval->construct(_caller->createFile(filename,flags));
+    retval->construct(_caller->createFile(filename,flags,preallocatedSize));
 }
 void ISystem::SRequestParams_READ::operator()(core::StorageTrivializer<retval_t>* retval, ICaller* _caller)
 {
@@ -286,11 +555,21 @@ void ISystem::SRequestParams_WRITE::operator()(core::StorageTrivializer<retval_t
 {
     retval->construct(file->asyncWrite(buffer,offset,size));
 }
+bool ISystem::SRequestParams_READ::submit(future_t<retval_t>* future, ICaller* _caller)
+{
+    return _caller->submitRead(future,file,buffer,offset,size);
+}
+bool ISystem::SRequestParams_WRITE::submit(future_t<retval_t>* future, ICaller* _caller)
+{
+    return _caller->submitWrite(future,file,buffer,offset,size);
+}
 
 bool ISystem::ICaller::invalidateMapping(IFile* file, size_t offset, size_t size)
 {
+    if (!file)
+        return false;
     const auto flags = file->getFlags();
-    if (!file || !(flags&IFile::ECF_MAPPABLE))
+    if (!(flags&IFile::ECF_MAPPABLE) || offset+size>file->getSize())
         return false;
     else if (flags&IFile::ECF_COHERENT)
         return true;
@@ -298,8 +577,10 @@ bool ISystem::ICaller::invalidateMapping(IFile* file, size_t offset, size_t size
 }
 bool ISystem::ICaller::flushMapping(IFile* file, size_t offset, size_t size)
 {
+    if (!file)
+        return false;
     const auto flags = file->getFlags();
-    if (!file || !(flags&IFile::ECF_MAPPABLE))
+    if (!(flags&IFile::ECF_MAPPABLE) || offset+size>file->getSize())
         return false;
     else if (flags&IFile::ECF_COHERENT)
         return true;
@@ -320,7 +601,7 @@ void  ISystem::unmountBuiltins() {
         }
         for (size_t i = 0; i < items_to_remove.size(); i++)
         {
-            m_cachedArchiveFiles.removeObject(items_to_remove[i], s);
+            unmount(items_to_remove[i].get(), s);
         }
     };
     removeByKey("nbl/builtin");
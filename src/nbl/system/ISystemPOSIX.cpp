@@ -11,10 +11,13 @@ using namespace nbl::system;
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
-core::smart_refctd_ptr<ISystemFile> ISystemPOSIX::CCaller::createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags)
+core::smart_refctd_ptr<ISystemFile> ISystemPOSIX::CCaller::createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags, const size_t preallocatedSize)
 {	
     const bool writeAccess = flags.value&IFile::ECF_WRITE;
+	// a shared writable mapping needs the descriptor to be open for reading as well
+	const bool writeMapping = writeAccess && (flags.value&IFile::ECF_MAPPABLE);
 	int createFlags = O_LARGEFILE|(writeAccess ? O_CREAT:0);
 	switch (flags.value&IFile::ECF_READ_WRITE)
 	{
@@ -36,9 +39,26 @@ core::smart_refctd_ptr<ISystemFile> ISystemPOSIX::CCaller::createFile(const std:
 	auto filenameStream = filename.string();
 	const char* name_c_str = filenameStream.c_str();
 	// only create a new file if we're going to be writing
-	if (writeAccess)
+	if (writeMapping)
+	{
+		// without a size to preallocate, map the existing file for in-place modification
+		const int truncate = preallocatedSize ? O_TRUNC:0;
+		_native = open(name_c_str, O_LARGEFILE|O_CREAT|O_RDWR|truncate, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+		if (_native>=0 && preallocatedSize)
+		{
+			// reserve the blocks up front so writing through the mapping can't SIGBUS on a full disk, not every filesystem supports it though
+			if (posix_fallocate(_native,0,preallocatedSize)!=0 && ftruncate(_native,preallocatedSize)!=0)
+			{
+				close(_native);
+				return nullptr;
+			}
+		}
+	}
+	else if (writeAccess)
 	{
 		_native = creat(name_c_str, S_IRUSR | S_IRGRP | S_IROTH);//open(name_c_str, createFlags, S_IRUSR | S_IRGRP | S_IROTH);
+		if (_native>=0 && preallocatedSize)
+			posix_fallocate(_native,0,preallocatedSize);
 	}
 	else if (std::filesystem::exists(filename))
 	{
@@ -66,7 +86,8 @@ core::smart_refctd_ptr<ISystemFile> ISystemPOSIX::CCaller::createFile(const std:
 	if (flags.value & IFile::ECF_MAPPABLE)
 	{
 		const int mappingFlags = ((flags.value&IFile::ECF_READ) ? PROT_READ:0)|(writeAccess ? PROT_WRITE:0);
-		_mappedPtr = mmap((caddr_t)0, _size, mappingFlags, MAP_PRIVATE, _native, 0);
+		// writes need to land in the page cache of the file, not in private copies of the pages
+		_mappedPtr = mmap((caddr_t)0, _size, mappingFlags, writeAccess ? MAP_SHARED:MAP_PRIVATE, _native, 0);
 		if (_mappedPtr==MAP_FAILED)
 		{
 			close(_native);
@@ -76,4 +97,47 @@ core::smart_refctd_ptr<ISystemFile> ISystemPOSIX::CCaller::createFile(const std:
 
 	return core::make_smart_refctd_ptr<CFilePOSIX>(core::smart_refctd_ptr<ISystem>(m_system),path(filename),flags,_mappedPtr,_size,_native);
 }
+
+void ISystemPOSIX::CCaller::prefetch(const std::filesystem::path& filename)
+{
+	const int fd = open(filename.string().c_str(),O_RDONLY|O_LARGEFILE);
+	if (fd<0)
+		return;
+	// on Linux this is the same as `readahead`, the reads get queued up and we don't wait for them
+	posix_fadvise(fd,0,0,POSIX_FADV_WILLNEED);
+	close(fd);
+}
+
+// `msync` and `madvise` want page aligned addresses, returns a null pointer if the file is not one of our own mapped files
+static inline std::pair<void*,size_t> getMappedRange(IFile* file, const size_t offset, const size_t size)
+{
+	// Archive entries and other file views are just memory, we can't `madvise` those without zeroing them!
+	auto* const posixFile = dynamic_cast<CFilePOSIX*>(file);
+	if (!posixFile)
+		return {nullptr,0ull};
+	const void* mapping = (file->getFlags()&IFile::ECF_WRITE) ? posixFile->getMappedPointer():static_cast<const IFile*>(posixFile)->getMappedPointer();
+	if (!mapping)
+		return {nullptr,0ull};
+
+	const size_t pageSize = sysconf(_SC_PAGESIZE);
+	const size_t alignedOffset = offset&~(pageSize-1ull);
+	return {const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(mapping))+alignedOffset,size+(offset-alignedOffset)};
+}
+
+bool ISystemPOSIX::CCaller::flushMapping_impl(IFile* file, size_t offset, size_t size)
+{
+	// only writable mappings are shared, private ones never get written back
+	if (!(file->getFlags()&IFile::ECF_WRITE))
+		return false;
+	const auto range = getMappedRange(file,offset,size);
+	return range.first && msync(range.first,range.second,MS_SYNC)==0;
+}
+
+bool ISystemPOSIX::CCaller::invalidateMapping_impl(IFile* file, size_t offset, size_t size)
+{
+	// Dropping the pages makes the next access fault them back in from the page cache. Shared mappings are always coherent
+	// with the page cache so its a no-op for them, but private mappings lose any copy-on-write pages with stale contents.
+	const auto range = getMappedRange(file,offset,size);
+	return range.first && madvise(range.first,range.second,MADV_DONTNEED)==0;
+}
 #endif
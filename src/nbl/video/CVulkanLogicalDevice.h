@@ -42,7 +42,7 @@ class CVulkanLogicalDevice final : public ILogicalDevice
 {
     public:
         // in the future we'll make proper Vulkan allocators and RAII free functions to pass into Vulkan API calls
-        using memory_pool_mt_t = core::CMemoryPool<core::PoolAddressAllocator<uint32_t>,core::default_aligned_allocator,true,uint32_t>;
+        using memory_pool_mt_t = core::CThreadCachedMemoryPool<core::PoolAddressAllocator<uint32_t>,core::default_aligned_allocator,uint32_t>;
         
         CVulkanLogicalDevice(core::smart_refctd_ptr<const IAPIConnection>&& api, renderdoc_api_t* const rdoc, const IPhysicalDevice* const physicalDevice, const VkDevice vkdev, const SCreationParams& params);
 
@@ -0,0 +1,444 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Replays an alloc/free trace against the address allocators and reports their latency percentiles and fragmentation.
+/*
+    A trace is a text file with one operation per line, `#` starts a comment
+        a <id> <bytes> <alignment>  allocate, `id` names the allocation for the free
+        f <id>                      free
+        r                           frame boundary
+    Without `--trace` a synthetic one gets generated, frames of allocations between 16 bytes and 64kB which mostly die
+    within their frame (in random order) while some live on for a few more frames, `--save-trace` writes it out.
+
+    Every allocator gets the same trace, in the way it can be used:
+        GeneralpurposeAddressAllocator  as is
+        PoolAddressAllocator            blocks of the largest allocation rounded up to a power of two, unless `--pool-block-size`
+        LinearAddressAllocator          frees do nothing, it gets reset at every frame boundary like a per-frame transient allocator would be
+        StackAddressAllocator           a free of anything but the top of the stack gets deferred until everything above it is freed
+    Fragmentation gets sampled every `--sample-interval` operations as `1-max_size()/get_free_size()` (external, mind that
+    `GeneralpurposeAddressAllocator::max_size()` is conservative by up to 2x) and the sum of `get_allocated_size()` over the sum of the bytes the trace holds.
+    Every operation gets timed on its own, so the latencies include reading the clock, compare them with each other.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <argparse/argparse.hpp>
+#include <nbl/core/declarations.h>
+#include <nbl/core/alloc/GeneralpurposeAddressAllocator.h>
+#include <nbl/core/alloc/PoolAddressAllocator.h>
+#include <nbl/core/alloc/LinearAddressAllocator.h>
+#include <nbl/core/alloc/StackAddressAllocator.h>
+
+constexpr std::string_view NBL_TRACE_ARG = "--trace";
+constexpr std::string_view NBL_SAVE_TRACE_ARG = "--save-trace";
+constexpr std::string_view NBL_OPS_ARG = "--ops";
+constexpr std::string_view NBL_SEED_ARG = "--seed";
+constexpr std::string_view NBL_BUFFER_SIZE_ARG = "--buffer-size";
+constexpr std::string_view NBL_POOL_BLOCK_SIZE_ARG = "--pool-block-size";
+constexpr std::string_view NBL_SAMPLE_INTERVAL_ARG = "--sample-interval";
+
+using namespace nbl;
+using size_type = uint32_t;
+
+constexpr size_type MaxAlignment = 256u;
+constexpr size_type MinBlockSize = 16u;
+
+struct SOp
+{
+    enum E_TYPE : uint8_t
+    {
+        ET_ALLOC,
+        ET_FREE,
+        ET_FRAME
+    } type;
+    // dense index of the allocation
+    uint32_t id = 0u;
+    size_type bytes = 0u;
+    size_type alignment = 0u;
+};
+
+struct STrace
+{
+    std::vector<SOp> ops;
+    uint32_t allocationCount = 0u;
+    size_type largestAllocation = 0u;
+};
+
+static bool loadTrace(const std::string& path, STrace& trace)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return false;
+    }
+    std::unordered_map<uint64_t,uint32_t> ids;
+    std::string line;
+    for (uint64_t lineNo=1ull; std::getline(file,line); lineNo++)
+    {
+        std::istringstream stream(line.substr(0u,line.find('#')));
+        std::string type;
+        if (!(stream >> type))
+            continue;
+        SOp op = {};
+        uint64_t id;
+        if (type=="a" && stream >> id >> op.bytes >> op.alignment && op.bytes && op.alignment && core::isPoT(op.alignment) && op.alignment<=MaxAlignment)
+        {
+            op.type = SOp::ET_ALLOC;
+            const auto found = ids.insert_or_assign(id,trace.allocationCount++);
+            op.id = found.first->second;
+            trace.largestAllocation = std::max(trace.largestAllocation,op.bytes);
+        }
+        else if (type=="f" && stream >> id && ids.count(id))
+        {
+            op.type = SOp::ET_FREE;
+            op.id = ids[id];
+            ids.erase(id);
+        }
+        else if (type=="r")
+            op.type = SOp::ET_FRAME;
+        else
+        {
+            std::cerr << path << ":" << lineNo << ": invalid operation, or a free of an unknown allocation, or an alignment which isn't a power of two up to " << MaxAlignment << std::endl;
+            return false;
+        }
+        trace.ops.push_back(op);
+    }
+    return true;
+}
+
+static STrace generateTrace(const uint64_t opCount, const uint32_t seed)
+{
+    STrace trace;
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> log2Size(4.0,16.0);
+    std::uniform_int_distribution<uint32_t> log2Alignment(2u,8u);
+    std::uniform_int_distribution<uint32_t> frameAllocations(200u,2000u);
+    std::uniform_int_distribution<uint32_t> framesToLive(1u,8u);
+    std::uniform_real_distribution<double> unit(0.0,1.0);
+
+    // allocations which outlive their frame, by the frame they die in
+    std::vector<std::vector<uint32_t>> survivors(9u);
+    while (trace.ops.size()<opCount)
+    {
+        std::vector<uint32_t> dieThisFrame;
+        const uint32_t allocations = frameAllocations(generator);
+        for (uint32_t i=0u; i<allocations; i++)
+        {
+            SOp op = {SOp::ET_ALLOC,trace.allocationCount++,static_cast<size_type>(std::exp2(log2Size(generator))),0x1u<<log2Alignment(generator)};
+            trace.largestAllocation = std::max(trace.largestAllocation,op.bytes);
+            trace.ops.push_back(op);
+            if (unit(generator)<0.1)
+                survivors[framesToLive(generator)].push_back(op.id);
+            else
+                dieThisFrame.push_back(op.id);
+            // interleave frees with the allocations
+            if (dieThisFrame.size()>16u && unit(generator)<0.5)
+            {
+                const auto victim = dieThisFrame.begin()+std::uniform_int_distribution<size_t>(0u,dieThisFrame.size()-1u)(generator);
+                trace.ops.push_back({SOp::ET_FREE,*victim});
+                std::swap(*victim,dieThisFrame.back());
+                dieThisFrame.pop_back();
+            }
+        }
+        std::shuffle(dieThisFrame.begin(),dieThisFrame.end(),generator);
+        dieThisFrame.insert(dieThisFrame.end(),survivors.front().begin(),survivors.front().end());
+        for (const auto id : dieThisFrame)
+            trace.ops.push_back({SOp::ET_FREE,id});
+        std::rotate(survivors.begin(),survivors.begin()+1u,survivors.end());
+        survivors.back().clear();
+        trace.ops.push_back({SOp::ET_FRAME});
+    }
+    return trace;
+}
+
+static bool saveTrace(const std::string& path, const STrace& trace)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return false;
+    }
+    for (const auto& op : trace.ops)
+    switch (op.type)
+    {
+        case SOp::ET_ALLOC:
+            file << "a " << op.id << " " << op.bytes << " " << op.alignment << "\n";
+            break;
+        case SOp::ET_FREE:
+            file << "f " << op.id << "\n";
+            break;
+        default:
+            file << "r\n";
+            break;
+    }
+    return true;
+}
+
+struct SResult
+{
+    std::vector<uint32_t> allocNs, freeNs;
+    uint64_t failedAllocs = 0ull;
+    double externalFragmentation = 0.0;
+    double overhead = 0.0;
+};
+
+static double percentile(std::vector<uint32_t>& samples, const double p)
+{
+    if (samples.empty())
+        return 0.0;
+    const auto nth = samples.begin()+static_cast<size_t>(p*(samples.size()-1u));
+    std::nth_element(samples.begin(),nth,samples.end());
+    return *nth;
+}
+
+// how the allocator gets used, the default frees straight away and ignores frame boundaries
+struct SDirectUse
+{
+    inline void allocated(const uint32_t id) {}
+    template<typename TimedFree>
+    inline void free(const uint32_t id, TimedFree& timedFree) {timedFree(id);}
+    // returns whether everything the trace held got dropped
+    template<class AddressAllocator>
+    inline bool frame(AddressAllocator& alctr, std::vector<size_type>& addresses) {return false;}
+};
+
+template<class AddressAllocator, class Use>
+static SResult replay(AddressAllocator& alctr, const STrace& trace, const uint32_t sampleInterval, Use&& use)
+{
+    using clock_t = std::chrono::steady_clock;
+    SResult result;
+    result.allocNs.reserve(trace.allocationCount);
+    result.freeNs.reserve(trace.allocationCount);
+
+    std::vector<size_type> addresses(trace.allocationCount,AddressAllocator::invalid_address);
+    std::vector<size_type> sizes(trace.allocationCount,0u);
+    uint64_t liveBytes = 0ull;
+    uint64_t samples = 0ull;
+    double sampledAllocated = 0.0, sampledLive = 0.0;
+    auto timedFree = [&](const uint32_t id) -> void
+    {
+        const auto start = clock_t::now();
+        alctr.free_addr(addresses[id],sizes[id]);
+        result.freeNs.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now()-start).count()));
+        addresses[id] = AddressAllocator::invalid_address;
+    };
+    for (size_t i=0u; i<trace.ops.size(); i++)
+    {
+        const auto& op = trace.ops[i];
+        switch (op.type)
+        {
+            case SOp::ET_ALLOC:
+            {
+                const auto start = clock_t::now();
+                const size_type address = alctr.alloc_addr(op.bytes,op.alignment);
+                result.allocNs.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_t::now()-start).count()));
+                if (address==AddressAllocator::invalid_address)
+                {
+                    result.failedAllocs++;
+                    break;
+                }
+                addresses[op.id] = address;
+                sizes[op.id] = op.bytes;
+                liveBytes += op.bytes;
+                use.allocated(op.id);
+                break;
+            }
+            case SOp::ET_FREE:
+                if (addresses[op.id]==AddressAllocator::invalid_address)
+                    break;
+                liveBytes -= sizes[op.id];
+                use.free(op.id,timedFree);
+                break;
+            default:
+                if (use.frame(alctr,addresses))
+                    liveBytes = 0ull;
+                break;
+        }
+        if (i%sampleInterval==0u && liveBytes)
+        {
+            const auto freeSize = alctr.get_free_size();
+            if (freeSize)
+                result.externalFragmentation += 1.0-static_cast<double>(alctr.max_size())/freeSize;
+            sampledAllocated += alctr.get_allocated_size();
+            sampledLive += liveBytes;
+            samples++;
+        }
+    }
+    if (samples)
+    {
+        result.externalFragmentation /= samples;
+        result.overhead = sampledAllocated/sampledLive;
+    }
+    return result;
+}
+
+// whatever the trace still holds is gone at the end of a frame, as it would be with a per-frame allocator
+struct SPerFrameUse : SDirectUse
+{
+    template<class AddressAllocator>
+    inline bool frame(AddressAllocator& alctr, std::vector<size_type>& addresses)
+    {
+        std::fill(addresses.begin(),addresses.end(),AddressAllocator::invalid_address);
+        alctr.reset();
+        return true;
+    }
+};
+
+// a free of anything but the top of the stack waits until everything above it has been freed
+struct SStackUse : SDirectUse
+{
+    SStackUse(const uint32_t allocationCount) : dead(allocationCount,false) {}
+
+    inline void allocated(const uint32_t id) {stack.push_back(id);}
+    template<typename TimedFree>
+    inline void free(const uint32_t id, TimedFree& timedFree)
+    {
+        dead[id] = true;
+        while (!stack.empty() && dead[stack.back()])
+        {
+            timedFree(stack.back());
+            stack.pop_back();
+        }
+    }
+
+    std::vector<uint32_t> stack;
+    std::vector<bool> dead;
+};
+
+static void report(const char* name, SResult&& result)
+{
+    std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(0)
+        << std::setw(10) << percentile(result.allocNs,0.5) << std::setw(10) << percentile(result.allocNs,0.99)
+        << std::setw(10) << percentile(result.freeNs,0.5) << std::setw(10) << percentile(result.freeNs,0.99)
+        << std::setw(12) << result.failedAllocs << std::setprecision(3)
+        << std::setw(12) << result.externalFragmentation << std::setw(12) << result.overhead << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Replays an alloc/free trace against the address allocators");
+
+    program.add_argument(NBL_TRACE_ARG.data())
+        .default_value(std::string(""))
+        .help("Trace to replay, a synthetic one gets generated when not given");
+
+    program.add_argument(NBL_SAVE_TRACE_ARG.data())
+        .default_value(std::string(""))
+        .help("Where to write the trace out");
+
+    program.add_argument(NBL_OPS_ARG.data())
+        .default_value(uint64_t(4000000ull))
+        .scan<'u', uint64_t>()
+        .help("Operation count of the synthetic trace");
+
+    program.add_argument(NBL_SEED_ARG.data())
+        .default_value(0x45u)
+        .scan<'u', uint32_t>()
+        .help("Seed of the synthetic trace");
+
+    program.add_argument(NBL_BUFFER_SIZE_ARG.data())
+        .default_value(size_type(0x1u<<26u))
+        .scan<'u', size_type>()
+        .help("Size of the address range every allocator manages");
+
+    program.add_argument(NBL_POOL_BLOCK_SIZE_ARG.data())
+        .default_value(size_type(0u))
+        .scan<'u', size_type>()
+        .help("Block size of the pool allocator, 0 picks the largest allocation of the trace rounded up to a power of two");
+
+    program.add_argument(NBL_SAMPLE_INTERVAL_ARG.data())
+        .default_value(256u)
+        .scan<'u', uint32_t>()
+        .help("Operations between fragmentation samples");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const std::string tracePath = program.get<std::string>(NBL_TRACE_ARG.data());
+    const std::string saveTracePath = program.get<std::string>(NBL_SAVE_TRACE_ARG.data());
+    const size_type bufferSize = program.get<size_type>(NBL_BUFFER_SIZE_ARG.data());
+    const uint32_t sampleInterval = std::max(program.get<uint32_t>(NBL_SAMPLE_INTERVAL_ARG.data()),1u);
+
+    STrace trace;
+    if (tracePath.empty())
+        trace = generateTrace(program.get<uint64_t>(NBL_OPS_ARG.data()),program.get<uint32_t>(NBL_SEED_ARG.data()));
+    else if (!loadTrace(tracePath,trace))
+        return 1;
+    if (!saveTracePath.empty() && !saveTrace(saveTracePath,trace))
+        return 1;
+    if (trace.allocationCount==0u)
+    {
+        std::cerr << "The trace has no allocations" << std::endl;
+        return 1;
+    }
+
+    size_type poolBlockSize = program.get<size_type>(NBL_POOL_BLOCK_SIZE_ARG.data());
+    if (poolBlockSize==0u)
+        poolBlockSize = std::max(core::roundUpToPoT(trace.largestAllocation),MaxAlignment);
+    if (bufferSize<poolBlockSize || bufferSize<MinBlockSize)
+    {
+        std::cerr << "Buffer size " << bufferSize << " is too small" << std::endl;
+        return 1;
+    }
+
+    std::cout << trace.ops.size() << " operations, " << trace.allocationCount << " allocations, " << bufferSize << " byte buffer" << std::endl;
+    std::cout << std::left << std::setw(34) << "allocator" << std::right << std::setw(10) << "alloc p50" << std::setw(10) << "alloc p99"
+        << std::setw(10) << "free p50" << std::setw(10) << "free p99" << std::setw(12) << "failed" << std::setw(12) << "ext. frag" << std::setw(12) << "overhead" << std::endl;
+
+    auto reserve = [](const size_t size) -> void* {return size ? _NBL_ALIGNED_MALLOC(size,_NBL_SIMD_ALIGNMENT):nullptr;};
+    {
+        using alctr_t = core::GeneralpurposeAddressAllocator<size_type>;
+        void* reserved = reserve(alctr_t::reserved_size(MaxAlignment,bufferSize,MinBlockSize));
+        alctr_t alctr(reserved,0u,0u,MaxAlignment,bufferSize,MinBlockSize);
+        report("GeneralpurposeAddressAllocator",replay(alctr,trace,sampleInterval,SDirectUse()));
+        _NBL_ALIGNED_FREE(reserved);
+    }
+    {
+        using alctr_t = core::PoolAddressAllocator<size_type>;
+        void* reserved = reserve(alctr_t::reserved_size(MaxAlignment,bufferSize,poolBlockSize));
+        alctr_t alctr(reserved,0u,0u,MaxAlignment,bufferSize,poolBlockSize);
+        const std::string name = "PoolAddressAllocator ("+std::to_string(poolBlockSize)+"B)";
+        report(name.c_str(),replay(alctr,trace,sampleInterval,SDirectUse()));
+        _NBL_ALIGNED_FREE(reserved);
+    }
+    {
+        core::LinearAddressAllocator<size_type> alctr(nullptr,0u,0u,MaxAlignment,bufferSize);
+        report("LinearAddressAllocator",replay(alctr,trace,sampleInterval,SPerFrameUse()));
+    }
+    {
+        using alctr_t = core::StackAddressAllocator<size_type>;
+        void* reserved = reserve(alctr_t::reserved_size(MaxAlignment,bufferSize,MinBlockSize));
+        alctr_t alctr(reserved,0u,0u,MaxAlignment,bufferSize,MinBlockSize);
+        report("StackAddressAllocator",replay(alctr,trace,sampleInterval,SStackUse(trace.allocationCount)));
+        _NBL_ALIGNED_FREE(reserved);
+    }
+    return 0;
+}
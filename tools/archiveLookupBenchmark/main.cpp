@@ -0,0 +1,185 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Rate of `ISystem::exists` on paths inside the builtin archives `ISystem` mounts in its constructor, from one and from many threads
+/*
+    Lists every file of the "nbl/builtin", "spirv" and "boost" builtin archives, and makes as many paths under the same mounts which aren't
+    in them. The cold pass resolves every path against the mount trie after `invalidateArchiveLookupCache`, the warm passes find them
+    memoised, and run on a thread count doubling from 1 up to `--threads` which all look up every path `--passes` times.
+    Misses under archives mounted from a directory (builds without `NBL_EMBED_BUILTIN_RESOURCES`) never get memoised and always end up
+    asking the filesystem. Every hit has to exist and every miss must not, otherwise the run fails.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/system/IApplicationFramework.h>
+#include <nbl/system/CMountDirectoryArchive.h>
+#ifdef NBL_EMBED_BUILTIN_RESOURCES
+#include "nbl/builtin/CArchive.h"
+#include "spirv/builtin/CArchive.h"
+#include "boost/builtin/CArchive.h"
+#endif // NBL_EMBED_BUILTIN_RESOURCES
+
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+constexpr std::string_view NBL_PASSES_ARG = "--passes";
+
+using namespace nbl;
+using namespace nbl::system;
+
+// the same archives `ISystem`'s constructor mounts, only to list their contents, with the aliases they get mounted under
+static std::vector<std::pair<core::smart_refctd_ptr<IFileArchive>,path>> builtinArchives(ISystem* system)
+{
+    std::vector<std::pair<core::smart_refctd_ptr<IFileArchive>,path>> archives;
+    #ifdef NBL_EMBED_BUILTIN_RESOURCES
+        archives.emplace_back(core::make_smart_refctd_ptr<nbl::builtin::CArchive>(nullptr),path());
+        archives.emplace_back(core::make_smart_refctd_ptr<spirv::builtin::CArchive>(nullptr),path());
+        archives.emplace_back(core::make_smart_refctd_ptr<boost::builtin::CArchive>(nullptr),path());
+        for (auto& archive : archives)
+            archive.second = archive.first->getDefaultAbsolutePath();
+    #else
+        archives.emplace_back(core::make_smart_refctd_ptr<CMountDirectoryArchive>(NBL_BUILTIN_RESOURCES_DIRECTORY_PATH,nullptr,system),"nbl/builtin");
+        archives.emplace_back(core::make_smart_refctd_ptr<CMountDirectoryArchive>(SPIRV_BUILTIN_RESOURCES_DIRECTORY_PATH,nullptr,system),"spirv");
+        archives.emplace_back(core::make_smart_refctd_ptr<CMountDirectoryArchive>(BOOST_BUILTIN_RESOURCES_DIRECTORY_PATH,nullptr,system),"boost");
+    #endif
+    return archives;
+}
+
+// returns the number of paths whose existence wasn't `expected`
+static uint64_t lookUp(const ISystem* system, const std::vector<path>& paths, const bool expected, const uint32_t passes)
+{
+    uint64_t wrong = 0ull;
+    for (uint32_t pass=0u; pass<passes; pass++)
+    for (const auto& p : paths)
+        wrong += system->exists(p,IFileBase::ECF_READ)!=expected;
+    return wrong;
+}
+
+// lookups per second of `threadCount` threads each going over all `paths` `passes` times
+static double lookUpConcurrently(const ISystem* system, const std::vector<path>& paths, const bool expected, const uint32_t threadCount, const uint32_t passes, std::atomic_uint64_t& wrong)
+{
+    std::atomic_uint32_t ready = 0u;
+    std::atomic_bool go = false;
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&]() -> void
+        {
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            wrong += lookUp(system,paths,expected,passes);
+        });
+
+    while (ready.load()!=threadCount)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true,std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return double(threadCount)*passes*paths.size()/seconds;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks looking up paths in the builtin archives mounted by ISystem");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u))
+        .scan<'u', uint32_t>()
+        .help("Largest number of threads to look up from");
+
+    program.add_argument(NBL_PASSES_ARG.data())
+        .default_value(64u)
+        .scan<'u', uint32_t>()
+        .help("Number of times every thread looks up every path in a warm run");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t maxThreads = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+    const uint32_t passes = std::max(program.get<uint32_t>(NBL_PASSES_ARG.data()),1u);
+
+    #ifdef _NBL_PLATFORM_LINUX_
+        // `IApplicationFramework::createSystem` has no Linux branch
+        core::smart_refctd_ptr<ISystem> system = core::make_smart_refctd_ptr<CSystemLinux>();
+    #else
+        core::smart_refctd_ptr<ISystem> system = IApplicationFramework::createSystem();
+    #endif
+    if (!system)
+    {
+        std::cerr << "Could not create the system!" << std::endl;
+        return 1;
+    }
+
+    std::vector<path> hits, misses;
+    for (const auto& archive : builtinArchives(system.get()))
+    for (const auto& entry : static_cast<IFileArchive::SFileList::range_t>(archive.first->listAssets()))
+    {
+        hits.push_back(archive.second/entry.pathRelativeToArchive);
+        // same directory and depth, just a name no builtin resource has
+        misses.push_back(archive.second/entry.pathRelativeToArchive.parent_path()/("missing_"+entry.pathRelativeToArchive.filename().string()));
+    }
+    if (hits.empty())
+    {
+        std::cerr << "The builtin archives are empty!" << std::endl;
+        return 1;
+    }
+    std::cout << hits.size() << " builtin resources" << std::endl;
+
+    std::cout << std::left << std::setw(8) << "paths" << std::right << std::setw(8) << "threads"
+        << std::setw(16) << "cold Kl/s" << std::setw(16) << "warm Kl/s" << std::setw(16) << "per thread" << std::endl;
+    std::atomic_uint64_t wrong = 0ull;
+    for (const bool hit : {true,false})
+    {
+        const auto& paths = hit ? hits:misses;
+        system->invalidateArchiveLookupCache();
+        const auto start = std::chrono::steady_clock::now();
+        wrong += lookUp(system.get(),paths,hit,1u);
+        const double cold = paths.size()/std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        for (uint32_t threadCount=1u; ; threadCount=std::min(threadCount*2u,maxThreads))
+        {
+            const double warm = lookUpConcurrently(system.get(),paths,hit,threadCount,passes,wrong);
+            std::cout << std::left << std::setw(8) << (hit ? "hits":"misses") << std::right << std::setw(8) << threadCount << std::fixed << std::setprecision(1);
+            if (threadCount==1u)
+                std::cout << std::setw(16) << cold*1e-3;
+            else
+                std::cout << std::setw(16) << "";
+            std::cout << std::setw(16) << warm*1e-3 << std::setw(16) << warm*1e-3/threadCount << std::endl;
+            if (threadCount==maxThreads)
+                break;
+        }
+    }
+
+    if (wrong)
+    {
+        std::cerr << wrong << " lookups found a file which isn't there or missed one which is!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Throughput of the batch half float and shared exponent conversions of `nbl/core/math/floatutil.h` against loops over the scalar ones
+/*
+    The batch conversions pick F16C, AVX2, SSE2 or the plain code at runtime, so the numbers are for whatever the machine running this has.
+    The inputs are random colours within the range of every format, like the texels and vertex attributes the conversions get used on.
+    Every batch result also gets compared against the scalar one, `floatutilCheck` is the exhaustive check.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <span>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/math/glslFunctions.h>
+
+constexpr std::string_view NBL_COUNT_ARG = "--count";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+constexpr std::string_view NBL_SEED_ARG = "--seed";
+
+using namespace nbl::core;
+
+// median wall time of `repeats` runs of `f`
+template<typename F>
+static double timeMedian(const uint32_t repeats, F&& f)
+{
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+
+// `out` and `outScalar` get compared bit for bit, floats included
+template<typename T, typename Scalar, typename Batch>
+static bool benchmark(const char* name, const size_t count, const uint32_t repeats, std::vector<T>& out, std::vector<T>& outScalar, Scalar&& scalar, Batch&& batch)
+{
+    const double scalarMs = timeMedian(repeats,scalar);
+    const double batchMs = timeMedian(repeats,batch);
+    const bool match = memcmp(out.data(),outScalar.data(),out.size()*sizeof(T))==0;
+    std::cout << std::left << std::setw(20) << name << std::right
+        << std::setw(14) << std::fixed << std::setprecision(2) << count/(scalarMs*1000.0) << std::setw(14) << count/(batchMs*1000.0)
+        << std::setw(10) << scalarMs/batchMs << std::setw(10) << (match ? "yes":"NO") << std::endl;
+    return match;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks the batch floatutil conversions against the scalar ones");
+
+    program.add_argument(NBL_COUNT_ARG.data())
+        .default_value(uint64_t(1ull<<24ull))
+        .scan<'u', uint64_t>()
+        .help("Number of values (or colours) to convert");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(5u)
+        .scan<'u', uint32_t>()
+        .help("Number of runs per conversion, the median gets reported");
+
+    program.add_argument(NBL_SEED_ARG.data())
+        .default_value(0x45u)
+        .scan<'u', uint32_t>()
+        .help("Seed of the random inputs");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const size_t count = std::max<uint64_t>(program.get<uint64_t>(NBL_COUNT_ARG.data()),1ull);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+    const uint32_t seed = program.get<uint32_t>(NBL_SEED_ARG.data());
+
+    // a wide spread of magnitudes, from well below 1 to the largest half float
+    std::vector<float> floats(count);
+    std::vector<rgb32f> colours(count);
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> exponent(-12.f,15.9f);
+        auto random = [&]() -> float {return std::exp2(exponent(generator))*(generator()&0x1u ? -1.f:1.f);};
+        for (auto& f : floats)
+            f = random();
+        for (auto& rgb : colours)
+            rgb = {std::abs(random()),std::abs(random()),random()};
+    }
+
+    std::cout << std::left << std::setw(20) << "conversion" << std::right
+        << std::setw(14) << "scalar Mc/s" << std::setw(14) << "batch Mc/s" << std::setw(10) << "speedup" << std::setw(10) << "match" << std::endl;
+    bool match = true;
+    {
+        std::vector<uint16_t> halves(count), halvesScalar(count);
+        match = benchmark("half compress",count,repeats,halves,halvesScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                halvesScalar[i] = Float16Compressor::compress(floats[i]);
+        },[&]() -> void
+        {
+            Float16Compressor::compress(floats,halves);
+        }) && match;
+
+        std::vector<float> decompressed(count), decompressedScalar(count);
+        match = benchmark("half decompress",count,repeats,decompressed,decompressedScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                decompressedScalar[i] = Float16Compressor::decompress(halvesScalar[i]);
+        },[&]() -> void
+        {
+            Float16Compressor::decompress(halvesScalar,decompressed);
+        }) && match;
+    }
+
+    std::vector<rgb32f> decoded(count), decodedScalar(count);
+    {
+        std::vector<uint32_t> codes(count), codesScalar(count);
+        match = benchmark("rgb9e5 encode",count,repeats,codes,codesScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                codesScalar[i] = rgb32f_to_rgb9e5(&colours[i].x);
+        },[&]() -> void
+        {
+            rgb32f_to_rgb9e5(colours,codes);
+        }) && match;
+        match = benchmark("rgb9e5 decode",count,repeats,decoded,decodedScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                decodedScalar[i] = rgb9e5_to_rgb32f(codesScalar[i]);
+        },[&]() -> void
+        {
+            rgb9e5_to_rgb32f(codesScalar,decoded);
+        }) && match;
+    }
+    {
+        std::vector<uint64_t> codes(count), codesScalar(count);
+        match = benchmark("rgb19e7 encode",count,repeats,codes,codesScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                codesScalar[i] = rgb32f_to_rgb19e7(&colours[i].x);
+        },[&]() -> void
+        {
+            rgb32f_to_rgb19e7(colours,codes);
+        }) && match;
+        match = benchmark("rgb19e7 decode",count,repeats,decoded,decodedScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                decodedScalar[i] = rgb19e7_to_rgb32f(codesScalar[i]);
+        },[&]() -> void
+        {
+            rgb19e7_to_rgb32f(codesScalar,decoded);
+        }) && match;
+
+        match = benchmark("rgb18e7s3 encode",count,repeats,codes,codesScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                codesScalar[i] = rgb32f_to_rgb18e7s3(&colours[i].x);
+        },[&]() -> void
+        {
+            rgb32f_to_rgb18e7s3(colours,codes);
+        }) && match;
+        match = benchmark("rgb18e7s3 decode",count,repeats,decoded,decodedScalar,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+                decodedScalar[i] = rgb18e7s3_to_rgb32f(codesScalar[i]);
+        },[&]() -> void
+        {
+            rgb18e7s3_to_rgb32f(codesScalar,decoded);
+        }) && match;
+    }
+
+    if (!match)
+    {
+        std::cerr << "A batch conversion didn't match the scalar one!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Checks the batch (SIMD) conversions of `nbl/core/math/floatutil.h` against the scalar functions they have to match bit for bit,
+// exhaustively for the half float conversions and with random plus edge case inputs for the shared exponent formats.
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <cstring>
+#include <limits>
+#include <cmath>
+#include <argparse/argparse.hpp>
+#include <nbl/core/math/glslFunctions.h>
+
+constexpr std::string_view NBL_COUNT_ARG = "--count";
+constexpr std::string_view NBL_SEED_ARG = "--seed";
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+
+using namespace nbl::core;
+
+constexpr uint32_t ChunkSize = 0x1u<<20u;
+
+static inline uint32_t bitsOf(const float f)
+{
+    uint32_t retval;
+    memcpy(&retval,&f,sizeof(retval));
+    return retval;
+}
+static inline float floatOf(const uint32_t u)
+{
+    float retval;
+    memcpy(&retval,&u,sizeof(retval));
+    return retval;
+}
+static inline bool sameBits(const rgb32f& a, const rgb32f& b)
+{
+    return bitsOf(a.x)==bitsOf(b.x) && bitsOf(a.y)==bitsOf(b.y) && bitsOf(a.z)==bitsOf(b.z);
+}
+
+// runs `f(chunk)` for every chunk on `threadCount` threads, `f` returns the number of mismatches
+template<typename F>
+static uint64_t forEachChunk(const uint64_t chunkCount, const uint32_t threadCount, F&& f)
+{
+    std::atomic_uint64_t nextChunk = 0ull;
+    std::atomic_uint64_t mismatches = 0ull;
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&]() -> void
+        {
+            for (uint64_t chunk=nextChunk++; chunk<chunkCount; chunk=nextChunk++)
+                mismatches += f(chunk);
+        });
+    for (auto& thread : threads)
+        thread.join();
+    return mismatches;
+}
+
+// every float bit pattern, NaNs and denormals included
+static uint64_t checkHalfCompress(const uint32_t threadCount)
+{
+    return forEachChunk((0x1ull<<32ull)/ChunkSize,threadCount,[](const uint64_t chunk) -> uint64_t
+    {
+        std::vector<float> in(ChunkSize);
+        std::vector<uint16_t> out(ChunkSize);
+        for (uint32_t i=0u; i<ChunkSize; i++)
+            in[i] = floatOf(static_cast<uint32_t>(chunk*ChunkSize+i));
+        Float16Compressor::compress(in,out);
+
+        uint64_t mismatches = 0ull;
+        for (uint32_t i=0u; i<ChunkSize; i++)
+        if (out[i]!=Float16Compressor::compress(in[i]))
+        {
+            if (mismatches++==0ull)
+                std::cerr << "half compress of 0x" << std::hex << bitsOf(in[i]) << " gave 0x" << out[i] << " instead of 0x" << Float16Compressor::compress(in[i]) << std::dec << std::endl;
+        }
+        return mismatches;
+    });
+}
+
+// every half bit pattern
+static uint64_t checkHalfDecompress()
+{
+    std::vector<uint16_t> in(0x1u<<16u);
+    std::vector<float> out(in.size());
+    for (uint32_t i=0u; i<in.size(); i++)
+        in[i] = static_cast<uint16_t>(i);
+    Float16Compressor::decompress(in,out);
+
+    uint64_t mismatches = 0ull;
+    for (uint32_t i=0u; i<in.size(); i++)
+    if (bitsOf(out[i])!=bitsOf(Float16Compressor::decompress(in[i])))
+    {
+        if (mismatches++==0ull)
+            std::cerr << "half decompress of 0x" << std::hex << in[i] << " gave 0x" << bitsOf(out[i]) << " instead of 0x" << bitsOf(Float16Compressor::decompress(in[i])) << std::dec << std::endl;
+    }
+    return mismatches;
+}
+
+// a third of the components are arbitrary bit patterns, the rest come from the ranges where the encoders have to make their decisions
+static float randomComponent(std::mt19937& generator)
+{
+    const uint32_t bits = generator();
+    switch (generator()%6u)
+    {
+        case 0u:
+        case 1u:
+            return floatOf(bits);
+        case 2u:
+            // around 1 and the rounding boundaries of the mantissas
+            return floatOf(0x3f000000u+(bits&0x01ffffffu))*(bits&0x80000000u ? -1.f:1.f);
+        case 3u:
+            // tiny, down to the denormals and below every format's smallest value
+            return floatOf(bits&0x1fffffffu)*(bits&0x80000000u ? -1.f:1.f);
+        case 4u:
+            // huge, up to and past every format's largest value
+            return floatOf(0x46000000u+(bits&0x1fffffffu))*(bits&0x80000000u ? -1.f:1.f);
+        default:
+        {
+            constexpr float special[] = {0.f,-0.f,1.f,-1.f,MAX_RGB9E5,MAX_RGB19E7,MAX_RGB18E7S3,-MAX_RGB18E7S3,EPSILON_RGB18E7S3,
+                std::numeric_limits<float>::infinity(),-std::numeric_limits<float>::infinity(),std::numeric_limits<float>::quiet_NaN(),
+                std::numeric_limits<float>::denorm_min(),std::numeric_limits<float>::max()};
+            return special[bits%(sizeof(special)/sizeof(float))];
+        }
+    }
+}
+
+// The scalar `rgb32f_to_rgb18e7s3` picks the shared exponent as if rounding to nearest, so rounding a component away from zero can carry
+// its mantissa past the maximum, which the scalar function asserts against. It does the same math here to leave such inputs out.
+template<E_ROUNDING_DIRECTION rounding>
+static bool outsideRGB18E7S3Domain(const float* rgb)
+{
+    if constexpr (rounding==ERD_NEAREST)
+        return false;
+    else
+    {
+        float abs[3];
+        for (uint32_t i=0u; i<3u; i++)
+            abs[i] = std::max(0.f,std::min(std::abs(rgb[i]),MAX_RGB18E7S3));
+        const float maxrgb = std::max({abs[0],abs[1],abs[2]});
+        const int32_t exp_shared = std::max(-static_cast<int32_t>(RGB18E7S3_EXP_BIAS)-1,static_cast<int32_t>((bitsOf(maxrgb)>>23u)&0xffu)-127)+1+RGB18E7S3_EXP_BIAS;
+        double denom = std::pow(2.0,static_cast<int32_t>(exp_shared-RGB18E7S3_EXP_BIAS-RGB18E7S3_MANTISSA_BITS));
+        if (static_cast<uint32_t>(maxrgb/denom+0.5)==MAX_RGB18E7S3_MANTISSA+1u)
+            denom *= 2.0;
+        for (uint32_t i=0u; i<3u; i++)
+        {
+            const bool negative = bitsOf(rgb[i])&0x80000000u;
+            if (negative!=(rounding==ERD_DOWN))
+                continue;
+            float scaled = abs[i];
+            scaled /= denom;
+            if (static_cast<int32_t>(scaled+floatOf(0x3f7fffffu))>static_cast<int32_t>(MAX_RGB18E7S3_MANTISSA))
+                return true;
+        }
+        return false;
+    }
+}
+
+template<typename code_t, typename Batch, typename Scalar, typename Skip>
+static uint64_t checkEncode(const char* name, const uint64_t count, const uint32_t seed, const uint32_t threadCount, Batch&& batch, Scalar&& scalar, Skip&& skip)
+{
+    std::atomic_uint64_t skipped = 0ull;
+    const uint64_t mismatches = forEachChunk((count+ChunkSize-1ull)/ChunkSize,threadCount,[&](const uint64_t chunk) -> uint64_t
+    {
+        std::mt19937 generator(seed^static_cast<uint32_t>(chunk*0x9e3779b9ull));
+        std::vector<rgb32f> in(ChunkSize);
+        std::vector<code_t> out(ChunkSize);
+        for (auto& rgb : in)
+            rgb = {randomComponent(generator),randomComponent(generator),randomComponent(generator)};
+        batch(in,out);
+
+        uint64_t mismatches = 0ull;
+        for (uint32_t i=0u; i<ChunkSize; i++)
+        if (skip(&in[i].x))
+            skipped++;
+        else if (out[i]!=scalar(&in[i].x))
+        {
+            if (mismatches++==0ull)
+                std::cerr << name << " encode of (0x" << std::hex << bitsOf(in[i].x) << ",0x" << bitsOf(in[i].y) << ",0x" << bitsOf(in[i].z) << ") gave 0x" << out[i] << " instead of 0x" << scalar(&in[i].x) << std::dec << std::endl;
+        }
+        return mismatches;
+    });
+    std::cout << name << " encode: " << mismatches << " mismatches";
+    if (skipped)
+        std::cout << " (" << skipped << " inputs the scalar version can't encode skipped)";
+    std::cout << std::endl;
+    return mismatches;
+}
+
+template<typename code_t, typename Batch, typename Scalar>
+static uint64_t checkDecode(const char* name, const uint64_t count, const uint32_t seed, const uint32_t threadCount, Batch&& batch, Scalar&& scalar)
+{
+    const uint64_t mismatches = forEachChunk((count+ChunkSize-1ull)/ChunkSize,threadCount,[&](const uint64_t chunk) -> uint64_t
+    {
+        std::mt19937_64 generator(seed^(chunk*0x9e3779b97f4a7c15ull));
+        std::vector<code_t> in(ChunkSize);
+        std::vector<rgb32f> out(ChunkSize);
+        for (auto& code : in)
+            code = static_cast<code_t>(generator());
+        batch(in,out);
+
+        uint64_t mismatches = 0ull;
+        for (uint32_t i=0u; i<ChunkSize; i++)
+        if (!sameBits(out[i],scalar(in[i])))
+        {
+            if (mismatches++==0ull)
+                std::cerr << name << " decode of 0x" << std::hex << in[i] << " differs from the scalar version" << std::dec << std::endl;
+        }
+        return mismatches;
+    });
+    std::cout << name << " decode: " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Checks the batch floatutil conversions bit for bit against the scalar ones");
+
+    program.add_argument(NBL_COUNT_ARG.data())
+        .default_value(uint64_t(0x1ull<<26ull))
+        .scan<'u', uint64_t>()
+        .help("Number of random values to check every shared exponent encoder and decoder with, the half float conversions are always checked exhaustively");
+
+    program.add_argument(NBL_SEED_ARG.data())
+        .default_value(0x45u)
+        .scan<'u', uint32_t>()
+        .help("Seed of the random values");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u))
+        .scan<'u', uint32_t>()
+        .help("Number of threads to check with");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint64_t count = program.get<uint64_t>(NBL_COUNT_ARG.data());
+    const uint32_t seed = program.get<uint32_t>(NBL_SEED_ARG.data());
+    const uint32_t threadCount = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+
+    uint64_t mismatches = 0ull;
+    {
+        const uint64_t halfCompress = checkHalfCompress(threadCount);
+        std::cout << "half compress: " << halfCompress << " mismatches" << std::endl;
+        const uint64_t halfDecompress = checkHalfDecompress();
+        std::cout << "half decompress: " << halfDecompress << " mismatches" << std::endl;
+        mismatches += halfCompress+halfDecompress;
+    }
+
+    mismatches += checkEncode<uint32_t>("rgb9e5",count,seed,threadCount,
+        [](std::span<const rgb32f> in, std::span<uint32_t> out) -> void {rgb32f_to_rgb9e5(in,out);},
+        [](const float* rgb) -> uint32_t {return rgb32f_to_rgb9e5(rgb);},
+        [](const float* rgb) -> bool {return false;}
+    );
+    mismatches += checkDecode<uint32_t>("rgb9e5",count,seed,threadCount,
+        [](std::span<const uint32_t> in, std::span<rgb32f> out) -> void {rgb9e5_to_rgb32f(in,out);},
+        [](const uint32_t code) -> rgb32f {return rgb9e5_to_rgb32f(code);}
+    );
+    mismatches += checkEncode<uint64_t>("rgb19e7",count,seed,threadCount,
+        [](std::span<const rgb32f> in, std::span<uint64_t> out) -> void {rgb32f_to_rgb19e7(in,out);},
+        [](const float* rgb) -> uint64_t {return rgb32f_to_rgb19e7(rgb);},
+        [](const float* rgb) -> bool {return false;}
+    );
+    mismatches += checkDecode<uint64_t>("rgb19e7",count,seed,threadCount,
+        [](std::span<const uint64_t> in, std::span<rgb32f> out) -> void {rgb19e7_to_rgb32f(in,out);},
+        [](const uint64_t code) -> rgb32f {return rgb19e7_to_rgb32f(code);}
+    );
+    mismatches += checkEncode<uint64_t>("rgb18e7s3 (rounding down)",count,seed,threadCount,
+        [](std::span<const rgb32f> in, std::span<uint64_t> out) -> void {rgb32f_to_rgb18e7s3<ERD_DOWN>(in,out);},
+        [](const float* rgb) -> uint64_t {return rgb32f_to_rgb18e7s3<ERD_DOWN>(rgb);},
+        outsideRGB18E7S3Domain<ERD_DOWN>
+    );
+    mismatches += checkEncode<uint64_t>("rgb18e7s3 (rounding to nearest)",count,seed,threadCount,
+        [](std::span<const rgb32f> in, std::span<uint64_t> out) -> void {rgb32f_to_rgb18e7s3<ERD_NEAREST>(in,out);},
+        [](const float* rgb) -> uint64_t {return rgb32f_to_rgb18e7s3<ERD_NEAREST>(rgb);},
+        outsideRGB18E7S3Domain<ERD_NEAREST>
+    );
+    mismatches += checkEncode<uint64_t>("rgb18e7s3 (rounding up)",count,seed,threadCount,
+        [](std::span<const rgb32f> in, std::span<uint64_t> out) -> void {rgb32f_to_rgb18e7s3<ERD_UP>(in,out);},
+        [](const float* rgb) -> uint64_t {return rgb32f_to_rgb18e7s3<ERD_UP>(rgb);},
+        outsideRGB18E7S3Domain<ERD_UP>
+    );
+    mismatches += checkDecode<uint64_t>("rgb18e7s3",count,seed,threadCount,
+        [](std::span<const uint64_t> in, std::span<rgb32f> out) -> void {rgb18e7s3_to_rgb32f(in,out);},
+        [](const uint64_t code) -> rgb32f {return rgb18e7s3_to_rgb32f(code);}
+    );
+
+    if (mismatches)
+    {
+        std::cerr << mismatches << " mismatches in total" << std::endl;
+        return 1;
+    }
+    std::cout << "All batch conversions match the scalar ones" << std::endl;
+    return 0;
+}
@@ -0,0 +1,441 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Load time of synthetic glTF scenes through `CGLTFLoader`, as a multi-file .gltf and as a single .glb, mapped and unmapped
+/*
+    Cuts a `--grid` by `--grid` vertex height field into 1, 4, 16 and so on up to `--max-split` squared tiles, every tile is a mesh with its
+    own .bin buffer and its own PNG base colour texture, and all of the textures together always have `--texture` squared texels. So every
+    scene has about as much to read and decode, only spread over more files, which the loader fetches all at once.
+    The same scene also goes into a .glb, with every buffer and PNG in its BIN chunk, which gets loaded from a mapped file, where the BIN
+    chunk gets aliased, and from an unmapped one, where it gets read. The textures then get decoded from memory instead of fetched.
+    The files are written to `--dir` and loaded `--repeats` times, they stay in the page cache so this measures the parse, the fetches and
+    the decoding, not the disk. Every load has to give back all the tiles with the positions and indices they were written with.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <argparse/argparse.hpp>
+#include "nabla.h"
+#include "nbl/system/IApplicationFramework.h"
+
+constexpr std::string_view NBL_GRID_ARG = "--grid";
+constexpr std::string_view NBL_TEXTURE_ARG = "--texture";
+constexpr std::string_view NBL_MAX_SPLIT_ARG = "--max-split";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+constexpr std::string_view NBL_DIR_ARG = "--dir";
+
+using namespace nbl;
+
+// the contents of a tile's .bin, positions, normals and UVs followed by the indices
+struct STile
+{
+    std::string buffer;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    std::string textureName;
+    // the PNG as written, and where this tile's data starts in the BIN chunk of the .glb
+    std::string texture;
+    size_t binOffset = 0ull;
+    size_t textureBinOffset = 0ull;
+};
+
+static STile makeTile(const uint32_t grid, const uint32_t tile, const uint32_t tileX, const uint32_t tileY)
+{
+    STile retval = {};
+    retval.vertexCount = tile*tile;
+    retval.indexCount = (tile-1u)*(tile-1u)*6u;
+    std::vector<float> positions, normals, uvs;
+    for (uint32_t y=0u; y<tile; y++)
+    for (uint32_t x=0u; x<tile; x++)
+    {
+        const float u = float(tileX*tile+x)/float(grid);
+        const float v = float(tileY*tile+y)/float(grid);
+        const float height = std::sin(u*17.f)*std::cos(v*13.f)*0.25f;
+        positions.insert(positions.end(),{u,height,v});
+        normals.insert(normals.end(),{-height,1.f,height*0.5f});
+        uvs.insert(uvs.end(),{float(x)/float(tile-1u),float(y)/float(tile-1u)});
+    }
+    std::vector<uint32_t> indices;
+    for (uint32_t y=0u; y+1u<tile; y++)
+    for (uint32_t x=0u; x+1u<tile; x++)
+    {
+        const uint32_t corner = y*tile+x;
+        indices.insert(indices.end(),{corner,corner+tile+1u,corner+1u,corner,corner+tile,corner+tile+1u});
+    }
+    for (const auto* data : {&positions,&normals,&uvs})
+        retval.buffer.append(reinterpret_cast<const char*>(data->data()),data->size()*sizeof(float));
+    retval.buffer.append(reinterpret_cast<const char*>(indices.data()),indices.size()*sizeof(uint32_t));
+    return retval;
+}
+
+// encodes the texture with the PNG writer, a noisy gradient so it doesn't compress to nothing
+static bool writeTexture(asset::IAssetManager* assetManager, const system::path& filename, const uint32_t size, const uint32_t seed)
+{
+    asset::ICPUImage::SCreationParams info = {};
+    info.format = asset::EF_R8G8B8A8_SRGB;
+    info.type = asset::ICPUImage::ET_2D;
+    info.extent = {size,size,1u};
+    info.mipLevels = 1u;
+    info.arrayLayers = 1u;
+    info.samples = asset::ICPUImage::ESCF_1_BIT;
+    info.flags = static_cast<asset::IImage::E_CREATE_FLAGS>(0u);
+    info.usage = asset::IImage::EUF_SAMPLED_BIT;
+    auto texels = core::make_smart_refctd_ptr<asset::ICPUBuffer>(size_t(size)*size*asset::getTexelOrBlockBytesize(info.format));
+    {
+        std::mt19937 generator(seed);
+        auto* texel = reinterpret_cast<uint8_t*>(texels->getPointer());
+        for (uint32_t y=0u; y<size; y++)
+        for (uint32_t x=0u; x<size; x++, texel+=4u)
+        {
+            const uint32_t noise = generator();
+            texel[0] = uint8_t(x*255u/size+(noise&0xfu));
+            texel[1] = uint8_t(y*255u/size+((noise>>4u)&0xfu));
+            texel[2] = uint8_t(seed*37u+((noise>>8u)&0xfu));
+            texel[3] = 255u;
+        }
+    }
+    auto image = asset::ICPUImage::create(std::move(info));
+    if (!image)
+        return false;
+    auto regions = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<asset::ICPUImage::SBufferCopy>>(1u);
+    asset::ICPUImage::SBufferCopy& region = regions->front();
+    region.imageSubresource.aspectMask = asset::IImage::EAF_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0u;
+    region.imageSubresource.baseArrayLayer = 0u;
+    region.imageSubresource.layerCount = 1u;
+    region.bufferOffset = 0u;
+    region.bufferRowLength = size;
+    region.bufferImageHeight = 0u;
+    region.imageOffset = {0u,0u,0u};
+    region.imageExtent = {size,size,1u};
+    image->setBufferAndRegions(std::move(texels),regions);
+
+    asset::ICPUImageView::SCreationParams viewInfo = {};
+    viewInfo.flags = static_cast<asset::ICPUImageView::E_CREATE_FLAGS>(0u);
+    viewInfo.format = image->getCreationParameters().format;
+    viewInfo.image = std::move(image);
+    viewInfo.viewType = asset::IImageView<asset::ICPUImage>::ET_2D;
+    viewInfo.subresourceRange.aspectMask = asset::IImage::EAF_COLOR_BIT;
+    viewInfo.subresourceRange.baseArrayLayer = 0u;
+    viewInfo.subresourceRange.layerCount = 1u;
+    viewInfo.subresourceRange.baseMipLevel = 0u;
+    viewInfo.subresourceRange.levelCount = 1u;
+    auto view = asset::ICPUImageView::create(std::move(viewInfo));
+    return view && assetManager->writeAsset(filename.string(),asset::IAssetWriter::SAssetWriteParams(view.get()));
+}
+
+// every tile's buffer followed by its PNG, each starting on a 4 byte boundary
+static std::string makeBIN(std::vector<STile>& tiles)
+{
+    std::string bin;
+    for (auto& tile : tiles)
+    {
+        tile.binOffset = bin.size();
+        bin += tile.buffer;
+        tile.textureBinOffset = bin.size();
+        bin += tile.texture;
+        bin.resize((bin.size()+3ull)&~3ull,'\0');
+    }
+    return bin;
+}
+
+// every tile gets a buffer, four views and accessors into it, a texture, a material, a mesh and a node,
+// a `binary` scene has one buffer without an uri for the BIN chunk of `binSize` instead, and a view for each image in it
+static std::string makeGLTF(const std::vector<STile>& tiles, const bool binary, const size_t binSize=0ull)
+{
+    std::string buffers, bufferViews, imageViews, accessors, images, textures, materials, meshes, nodes, sceneNodes;
+    char entry[1024];
+    auto append = [&entry](std::string& array, const int length) -> void
+    {
+        if (!array.empty())
+            array += ",";
+        array.append(entry,length);
+    };
+    for (uint32_t i=0u; i<tiles.size(); i++)
+    {
+        const auto& tile = tiles[i];
+        const uint32_t buffer = binary ? 0u:i;
+        const size_t base = binary ? tile.binOffset:0ull;
+        if (!binary)
+            append(buffers,snprintf(entry,sizeof(entry),"{\"uri\":\"tile%u.bin\",\"byteLength\":%zu}",i,tile.buffer.size()));
+        const uint32_t firstView = i*4u;
+        const size_t vec3Size = size_t(tile.vertexCount)*12u;
+        const size_t vec2Size = size_t(tile.vertexCount)*8u;
+        append(bufferViews,snprintf(entry,sizeof(entry),
+            "{\"buffer\":%u,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":34962},"
+            "{\"buffer\":%u,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":34962},"
+            "{\"buffer\":%u,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":34962},"
+            "{\"buffer\":%u,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":34963}",
+            buffer,base,vec3Size,buffer,base+vec3Size,vec3Size,buffer,base+vec3Size*2u,vec2Size,buffer,base+vec3Size*2u+vec2Size,size_t(tile.indexCount)*4u));
+        append(accessors,snprintf(entry,sizeof(entry),
+            "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+            "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},"
+            "{\"bufferView\":%u,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},"
+            "{\"bufferView\":%u,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}",
+            firstView,tile.vertexCount,firstView+1u,tile.vertexCount,firstView+2u,tile.vertexCount,firstView+3u,tile.indexCount));
+        if (binary)
+        {
+            append(imageViews,snprintf(entry,sizeof(entry),"{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}",tile.textureBinOffset,tile.texture.size()));
+            append(images,snprintf(entry,sizeof(entry),"{\"bufferView\":%zu,\"mimeType\":\"image/png\"}",tiles.size()*4u+i));
+        }
+        else
+            append(images,snprintf(entry,sizeof(entry),"{\"uri\":\"%s\"}",tile.textureName.c_str()));
+        append(textures,snprintf(entry,sizeof(entry),"{\"source\":%u}",i));
+        append(materials,snprintf(entry,sizeof(entry),"{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":%u}}}",i));
+        append(meshes,snprintf(entry,sizeof(entry),"{\"primitives\":[{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u,\"material\":%u}]}",
+            firstView,firstView+1u,firstView+2u,firstView+3u,i));
+        append(nodes,snprintf(entry,sizeof(entry),"{\"mesh\":%u}",i));
+        append(sceneNodes,snprintf(entry,sizeof(entry),"%u",i));
+    }
+    if (binary)
+    {
+        append(buffers,snprintf(entry,sizeof(entry),"{\"byteLength\":%zu}",binSize));
+        bufferViews += ","+imageViews;
+    }
+    return "{\"asset\":{\"version\":\"2.0\",\"generator\":\"gltfLoaderBenchmark\"},\"scene\":0,\"scenes\":[{\"nodes\":["+sceneNodes+"]}],"
+        "\"nodes\":["+nodes+"],\"meshes\":["+meshes+"],\"materials\":["+materials+"],\"textures\":["+textures+"],\"images\":["+images+"],"
+        "\"accessors\":["+accessors+"],\"bufferViews\":["+bufferViews+"],\"buffers\":["+buffers+"]}";
+}
+
+// header, JSON chunk padded with spaces and BIN chunk padded with zeros, see `SGLBFormat.h`
+static std::string makeGLB(std::string json, std::string bin)
+{
+    json.resize((json.size()+3ull)&~3ull,' ');
+    bin.resize((bin.size()+3ull)&~3ull,'\0');
+    std::string glb;
+    auto appendUint = [&glb](const uint32_t value) -> void
+    {
+        glb.append(reinterpret_cast<const char*>(&value),sizeof(value));
+    };
+    appendUint(0x46546C67u); // "glTF"
+    appendUint(2u);
+    appendUint(uint32_t(12u+8u+json.size()+8u+bin.size()));
+    appendUint(uint32_t(json.size()));
+    appendUint(0x4E4F534Au); // "JSON"
+    glb += json;
+    appendUint(uint32_t(bin.size()));
+    appendUint(0x004E4942u); // "BIN\0"
+    glb += bin;
+    return glb;
+}
+
+static bool writeFile(const system::path& filename, const std::string& contents)
+{
+    std::ofstream out(filename,std::ios::binary|std::ios::trunc);
+    return bool(out.write(contents.data(),contents.size()));
+}
+
+static bool readFile(const system::path& filename, std::string& contents)
+{
+    std::ifstream in(filename,std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>());
+    return in.good() || in.eof();
+}
+
+// the positions and indices of every mesh, which the loader may return in any order
+static std::vector<std::string> getGeometry(const asset::SAssetBundle& bundle)
+{
+    std::vector<std::string> geometry;
+    for (const auto& asset : bundle.getContents())
+    {
+        const auto* mesh = static_cast<const asset::ICPUMesh*>(asset.get());
+        for (const auto* meshBuffer : mesh->getMeshBuffers())
+        {
+            const auto& indexBinding = meshBuffer->getIndexBufferBinding();
+            const uint32_t positionAttribute = meshBuffer->getPositionAttributeIx();
+            const auto& positionBinding = meshBuffer->getAttribBoundBuffer(positionAttribute);
+            if (!indexBinding.buffer || !positionBinding.buffer || meshBuffer->getIndexType()!=asset::EIT_32BIT)
+                return {};
+            const auto* indices = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(indexBinding.buffer->getPointer())+indexBinding.offset);
+            const uint32_t vertexCount = *std::max_element(indices,indices+meshBuffer->getIndexCount())+1u;
+            // the tiles are written with tightly packed float positions
+            std::string& tile = geometry.emplace_back(reinterpret_cast<const char*>(positionBinding.buffer->getPointer())+positionBinding.offset,size_t(vertexCount)*3u*sizeof(float));
+            tile.append(reinterpret_cast<const char*>(indices),size_t(meshBuffer->getIndexCount())*sizeof(uint32_t));
+        }
+    }
+    std::sort(geometry.begin(),geometry.end());
+    return geometry;
+}
+
+// median wall time of `repeats` loads, and the last bundle
+static double timeLoads(const uint32_t repeats, asset::SAssetBundle& bundle, const std::function<asset::SAssetBundle()>& load)
+{
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        bundle = load();
+        times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks loading glTF scenes spread over more and more buffer and image files");
+
+    program.add_argument(NBL_GRID_ARG.data())
+        .default_value(1024u)
+        .scan<'u', uint32_t>()
+        .help("Vertices along each side of the height field, gets rounded down to a multiple of the largest split");
+
+    program.add_argument(NBL_TEXTURE_ARG.data())
+        .default_value(2048u)
+        .scan<'u', uint32_t>()
+        .help("Texels along each side of all the textures put together, gets rounded down like the grid");
+
+    program.add_argument(NBL_MAX_SPLIT_ARG.data())
+        .default_value(8u)
+        .scan<'u', uint32_t>()
+        .help("Largest number of tiles along each side, the splits double from 1 up to it");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(3u)
+        .scan<'u', uint32_t>()
+        .help("Number of loads per scene, the median gets reported");
+
+    program.add_argument(NBL_DIR_ARG.data())
+        .default_value((std::filesystem::temp_directory_path()/"nbl_gltf_loader_benchmark").generic_string())
+        .help("Directory to write the scenes to, gets deleted afterwards");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+#if defined(_NBL_COMPILE_WITH_GLTF_LOADER_) && defined(_NBL_COMPILE_WITH_PNG_LOADER_) && defined(_NBL_COMPILE_WITH_PNG_WRITER_)
+    const uint32_t maxSplit = std::max(program.get<uint32_t>(NBL_MAX_SPLIT_ARG.data()),1u);
+    // a tile needs at least 2 vertices and 1 texel along each side
+    const uint32_t grid = std::max(program.get<uint32_t>(NBL_GRID_ARG.data())/maxSplit,2u)*maxSplit;
+    const uint32_t texture = std::max(program.get<uint32_t>(NBL_TEXTURE_ARG.data())/maxSplit,1u)*maxSplit;
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+    const system::path dir = program.get<std::string>(NBL_DIR_ARG.data());
+
+    #ifdef _NBL_PLATFORM_LINUX_
+        // `IApplicationFramework::createSystem` has no Linux branch
+        core::smart_refctd_ptr<system::ISystem> system = core::make_smart_refctd_ptr<system::CSystemLinux>();
+    #else
+        core::smart_refctd_ptr<system::ISystem> system = system::IApplicationFramework::createSystem();
+    #endif
+    if (!system)
+    {
+        std::cerr << "Could not create the system!" << std::endl;
+        return 1;
+    }
+    auto assetManager = core::make_smart_refctd_ptr<asset::IAssetManager>(core::smart_refctd_ptr(system));
+
+    std::cout << std::left << std::setw(8) << "tiles" << std::right << std::setw(8) << "files" << std::setw(12) << ".gltf MiB" << std::setw(12) << ".gltf ms"
+        << std::setw(12) << ".glb MiB" << std::setw(12) << "mapped ms" << std::setw(14) << "unmapped ms" << std::setw(8) << "match" << std::endl;
+    bool match = true;
+    for (uint32_t split=1u; split<=maxSplit; split*=2u)
+    {
+        const system::path sceneDir = dir/("split"+std::to_string(split));
+        std::filesystem::create_directories(sceneDir);
+
+        // everything the scene is made of, to check the loads against
+        std::vector<STile> tiles;
+        std::vector<std::string> expected;
+        size_t gltfSize = 0ull;
+        bool written = true;
+        for (uint32_t y=0u; y<split; y++)
+        for (uint32_t x=0u; x<split; x++)
+        {
+            const uint32_t i = tiles.size();
+            auto& tile = tiles.emplace_back(makeTile(grid,grid/split,x,y));
+            tile.textureName = "tile"+std::to_string(i)+".png";
+            written = written && writeFile(sceneDir/("tile"+std::to_string(i)+".bin"),tile.buffer);
+            written = written && writeTexture(assetManager.get(),sceneDir/tile.textureName,texture/split,i);
+            // the .glb embeds the very same PNG
+            written = written && readFile(sceneDir/tile.textureName,tile.texture);
+            gltfSize += tile.buffer.size()+tile.texture.size();
+            // only the positions and the indices
+            expected.push_back(tile.buffer.substr(0u,size_t(tile.vertexCount)*12u)+tile.buffer.substr(size_t(tile.vertexCount)*32u));
+        }
+        std::sort(expected.begin(),expected.end());
+        const std::string gltf = makeGLTF(tiles,false);
+        gltfSize += gltf.size();
+        const system::path gltfPath = sceneDir/"scene.gltf";
+        written = written && writeFile(gltfPath,gltf);
+        const std::string bin = makeBIN(tiles);
+        const std::string glb = makeGLB(makeGLTF(tiles,true,bin.size()),bin);
+        const system::path glbPath = sceneDir/"scene.glb";
+        written = written && writeFile(glbPath,glb);
+        if (!written)
+        {
+            std::cerr << "Could not write the scene to " << sceneDir << std::endl;
+            std::filesystem::remove_all(dir);
+            return 1;
+        }
+
+        // nothing may come out of the cache, every load has to parse and fetch everything
+        asset::IAssetLoader::SAssetLoadParams params;
+        params.cacheFlags = asset::IAssetLoader::ECF_DONT_CACHE_REFERENCES;
+        asset::SAssetBundle bundle;
+        const double gltfMs = timeLoads(repeats,bundle,[&]() -> asset::SAssetBundle
+        {
+            return assetManager->getAsset(gltfPath.string(),params);
+        });
+        bool same = getGeometry(bundle)==expected;
+        double glbMs[2];
+        for (const bool mapped : {true,false})
+        {
+            glbMs[mapped] = timeLoads(repeats,bundle,[&]() -> asset::SAssetBundle
+            {
+                system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+                auto flags = core::bitflag<system::IFileBase::E_CREATE_FLAGS>(system::IFileBase::ECF_READ);
+                if (mapped)
+                    flags |= system::IFileBase::ECF_MAPPABLE;
+                system->createFile(future,glbPath,flags);
+                if (auto file=future.acquire(); file && bool(*file))
+                    return assetManager->getAsset(file->get(),glbPath.string(),params);
+                return {};
+            });
+            same = same && getGeometry(bundle)==expected;
+        }
+        bundle = {};
+
+        constexpr double MiB = double(0x1u<<20u);
+        std::cout << std::left << std::setw(8) << tiles.size() << std::right << std::setw(8) << tiles.size()*2u+1u << std::fixed << std::setprecision(2)
+            << std::setw(12) << gltfSize/MiB << std::setw(12) << gltfMs << std::setw(12) << glb.size()/MiB << std::setw(12) << glbMs[true]
+            << std::setw(14) << glbMs[false] << std::setw(8) << (same ? "yes":"NO") << std::endl;
+        match = match && same;
+    }
+    std::filesystem::remove_all(dir);
+
+    if (!match)
+    {
+        std::cerr << "A scene failed to load or came back with different geometry!" << std::endl;
+        return 1;
+    }
+#else
+    std::cerr << "Nabla was built without the glTF loader or the PNG loader and writer" << std::endl;
+#endif
+    return 0;
+}
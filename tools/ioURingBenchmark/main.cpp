@@ -0,0 +1,263 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Unmapped read throughput of `CSystemLinux` with the io_uring backend against the plain POSIX one, with a cold and a warm page cache
+/*
+    Writes `--files` files of `--file-size` bytes into `--dir`, then reads all of them through `IFile::read` in `--request-size` requests,
+    keeping `--in-flight` of them outstanding, either front to back or in a random order. Before every cold run the files' pages get
+    dropped from the page cache with `posix_fadvise(POSIX_FADV_DONTNEED)`, which needs no root but only works for pages which are clean,
+    so the files get synced after writing. Some filesystems (tmpfs for one) ignore it, point `--dir` at a real disk.
+    The io_uring backend silently falls back to the POSIX one when the kernel doesn't let it set up a ring.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <argparse/argparse.hpp>
+#include <nbl/system/IApplicationFramework.h>
+
+#ifdef _NBL_PLATFORM_LINUX_
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+constexpr std::string_view NBL_DIR_ARG = "--dir";
+constexpr std::string_view NBL_FILES_ARG = "--files";
+constexpr std::string_view NBL_FILE_SIZE_ARG = "--file-size";
+constexpr std::string_view NBL_REQUEST_SIZE_ARG = "--request-size";
+constexpr std::string_view NBL_IN_FLIGHT_ARG = "--in-flight";
+constexpr std::string_view NBL_WORKERS_ARG = "--workers";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+
+using namespace nbl;
+using namespace nbl::system;
+
+#ifdef _NBL_PLATFORM_LINUX_
+struct SRequest
+{
+    uint32_t file;
+    size_t offset;
+    size_t size;
+};
+
+static bool dropFromPageCache(const std::vector<path>& filenames)
+{
+    bool dropped = true;
+    for (const auto& filename : filenames)
+    {
+        const int fd = open(filename.c_str(),O_RDONLY);
+        if (fd<0)
+            return false;
+        dropped = posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED)==0 && dropped;
+        close(fd);
+    }
+    return dropped;
+}
+
+// median wall time in seconds of `repeats` passes over all the requests, or a negative number if a read came up short
+static double timeReads(ISystem* system, const std::vector<path>& filenames, const std::vector<SRequest>& requests, const size_t requestSize,
+    const uint32_t inFlight, const uint32_t repeats, const bool cold)
+{
+    std::vector<core::smart_refctd_ptr<IFile>> files;
+    for (const auto& filename : filenames)
+    {
+        ISystem::future_t<core::smart_refctd_ptr<IFile>> future;
+        // not mappable, so the reads go through the caller
+        system->createFile(future,filename,IFileBase::ECF_READ);
+        if (auto file=future.acquire(); file && bool(*file))
+            files.push_back(std::move(*file));
+        else
+            return -1.0;
+    }
+
+    std::vector<std::byte> buffers(requestSize*inFlight);
+    std::vector<ISystem::future_t<size_t>> futures(inFlight);
+    std::vector<size_t> expected(inFlight,0ull);
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        if (cold && !dropFromPageCache(filenames))
+            return -1.0;
+
+        bool complete = true;
+        // waits for the read in a slot and checks it read everything it was asked to
+        auto retire = [&](const uint32_t slot) -> void
+        {
+            if (!expected[slot])
+                return;
+            if (auto lock=futures[slot].acquire())
+            {
+                complete = complete && *lock==expected[slot];
+                lock.discard();
+            }
+            else
+                complete = false;
+            expected[slot] = 0ull;
+        };
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i=0u; i<requests.size(); i++)
+        {
+            const uint32_t slot = i%inFlight;
+            retire(slot);
+            const auto& request = requests[i];
+            expected[slot] = request.size;
+            files[request.file]->read(futures[slot],buffers.data()+requestSize*slot,request.offset,request.size);
+        }
+        for (uint32_t slot=0u; slot<inFlight; slot++)
+            retire(slot);
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+        if (!complete)
+            return -1.0;
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks the io_uring backend of CSystemLinux against the POSIX one");
+
+    program.add_argument(NBL_DIR_ARG.data())
+        .default_value((std::filesystem::temp_directory_path()/"nbl_io_benchmark").generic_string())
+        .help("Directory to write the test files to, gets deleted afterwards");
+
+    program.add_argument(NBL_FILES_ARG.data())
+        .default_value(16u)
+        .scan<'u', uint32_t>()
+        .help("Number of test files");
+
+    program.add_argument(NBL_FILE_SIZE_ARG.data())
+        .default_value(uint64_t(64ull<<20ull))
+        .scan<'u', uint64_t>()
+        .help("Size of every test file in bytes");
+
+    program.add_argument(NBL_REQUEST_SIZE_ARG.data())
+        .default_value(uint64_t(256ull<<10ull))
+        .scan<'u', uint64_t>()
+        .help("Size of a single read in bytes");
+
+    program.add_argument(NBL_IN_FLIGHT_ARG.data())
+        .default_value(64u)
+        .scan<'u', uint32_t>()
+        .help("Number of reads kept outstanding, also the io_uring queue depth");
+
+    program.add_argument(NBL_WORKERS_ARG.data())
+        .default_value(4u)
+        .scan<'u', uint32_t>()
+        .help("Number of I/O worker threads for the multi-threaded POSIX backend");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(3u)
+        .scan<'u', uint32_t>()
+        .help("Number of passes per configuration, the median gets reported");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+#ifdef _NBL_PLATFORM_LINUX_
+    const path dir = program.get<std::string>(NBL_DIR_ARG.data());
+    const uint32_t fileCount = std::max(program.get<uint32_t>(NBL_FILES_ARG.data()),1u);
+    const size_t requestSize = std::max<uint64_t>(program.get<uint64_t>(NBL_REQUEST_SIZE_ARG.data()),1ull);
+    const size_t fileSize = std::max<uint64_t>(program.get<uint64_t>(NBL_FILE_SIZE_ARG.data()),requestSize);
+    const uint32_t inFlight = std::max(program.get<uint32_t>(NBL_IN_FLIGHT_ARG.data()),1u);
+    const uint32_t workers = std::max(program.get<uint32_t>(NBL_WORKERS_ARG.data()),1u);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+
+    std::vector<path> filenames;
+    {
+        std::filesystem::create_directories(dir);
+        std::vector<uint64_t> contents((fileSize+sizeof(uint64_t)-1u)/sizeof(uint64_t));
+        std::mt19937_64 generator(0x45u);
+        for (uint32_t f=0u; f<fileCount; f++)
+        {
+            for (auto& word : contents)
+                word = generator();
+            filenames.push_back(dir/("file"+std::to_string(f)+".bin"));
+            const int fd = open(filenames.back().c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+            const bool written = fd>=0 && write(fd,contents.data(),fileSize)==ssize_t(fileSize) && fsync(fd)==0;
+            if (fd>=0)
+                close(fd);
+            if (!written)
+            {
+                std::cerr << "Could not write " << filenames.back() << std::endl;
+                std::filesystem::remove_all(dir);
+                return 1;
+            }
+        }
+    }
+
+    std::vector<SRequest> sequential;
+    for (uint32_t f=0u; f<fileCount; f++)
+    for (size_t offset=0ull; offset<fileSize; offset+=requestSize)
+        sequential.push_back({f,offset,std::min(requestSize,fileSize-offset)});
+    std::vector<SRequest> shuffled = sequential;
+    std::shuffle(shuffled.begin(),shuffled.end(),std::mt19937(0x45u));
+
+    struct SBackend
+    {
+        const char* name;
+        CSystemLinux::SCreationParams params;
+    };
+    const SBackend backends[] = {
+        {"POSIX",{.useIOURing=false,.ioWorkerCount=1u}},
+        {"POSIX(workers)",{.useIOURing=false,.ioWorkerCount=workers}},
+        {"io_uring",{.useIOURing=true,.ioURingQueueDepth=inFlight}}
+    };
+
+    std::cout << std::left << std::setw(16) << "backend" << std::setw(12) << "order" << std::setw(8) << "cache" << std::right
+        << std::setw(12) << "median ms" << std::setw(10) << "GB/s" << std::endl;
+    const double totalBytes = double(fileCount)*fileSize;
+    bool failed = false;
+    for (const auto& backend : backends)
+    {
+        auto system = core::make_smart_refctd_ptr<CSystemLinux>(backend.params);
+        for (const bool random : {false,true})
+        for (const bool cold : {true,false})
+        {
+            const double seconds = timeReads(system.get(),filenames,random ? shuffled:sequential,requestSize,inFlight,repeats,cold);
+            std::cout << std::left << std::setw(16) << backend.name << std::setw(12) << (random ? "random":"sequential") << std::setw(8) << (cold ? "cold":"warm") << std::right;
+            if (seconds<0.0)
+            {
+                std::cout << std::setw(22) << "FAILED" << std::endl;
+                failed = true;
+                continue;
+            }
+            std::cout << std::setw(12) << std::fixed << std::setprecision(2) << seconds*1000.0 << std::setw(10) << totalBytes/seconds*1e-9 << std::endl;
+        }
+    }
+    std::filesystem::remove_all(dir);
+
+    if (failed)
+    {
+        std::cerr << "A read came up short or the page cache could not be dropped!" << std::endl;
+        return 1;
+    }
+#else
+    std::cerr << "io_uring is Linux only" << std::endl;
+#endif
+    return 0;
+}
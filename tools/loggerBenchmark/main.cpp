@@ -0,0 +1,203 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Logging throughput of `CAsyncFileLogger` against `CFileLogger` from many threads at once
+/*
+    Every thread logs `--messages` formatted lines, the thread count doubles from 1 up to `--threads`. The caller side rate is what the
+    logging threads see, the flushed rate includes waiting for everything to hit the file. Every 64th call gets timed on its own for
+    the p99 latency of a log call. Afterwards the lines in the file get counted, anything not dropped which isn't there fails the run.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <argparse/argparse.hpp>
+#include <nbl/system/IApplicationFramework.h>
+#include <nbl/system/CFileLogger.h>
+#include <nbl/system/CAsyncFileLogger.h>
+
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+constexpr std::string_view NBL_MESSAGES_ARG = "--messages";
+constexpr std::string_view NBL_OUTPUT_ARG = "--output";
+
+using namespace nbl;
+using namespace nbl::system;
+
+constexpr uint32_t SampleInterval = 64u;
+
+struct SResult
+{
+    double callerSeconds = 0.0;
+    double flushedSeconds = 0.0;
+    double p99Nanoseconds = 0.0;
+    uint64_t dropped = 0ull;
+    uint64_t lines = 0ull;
+};
+
+template<class Logger, typename... LoggerArgs>
+static SResult run(ISystem* system, const path& filename, const uint32_t threadCount, const uint64_t messagesPerThread, LoggerArgs&&... loggerArgs)
+{
+    // files don't get truncated when opened for writing
+    std::filesystem::remove(filename);
+    ISystem::future_t<core::smart_refctd_ptr<IFile>> future;
+    system->createFile(future,filename,IFileBase::ECF_WRITE);
+    auto file = future.acquire();
+    if (!file || !bool(*file))
+    {
+        std::cerr << "Could not create " << filename << std::endl;
+        std::exit(1);
+    }
+    auto logger = core::make_smart_refctd_ptr<Logger>(std::move(*file),false,core::bitflag(ILogger::ELL_ALL),std::forward<LoggerArgs>(loggerArgs)...);
+
+    std::atomic_uint32_t ready = 0u;
+    std::atomic_bool go = false;
+    std::vector<std::vector<double>> latencies(threadCount);
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&,t]() -> void
+        {
+            auto& samples = latencies[t];
+            samples.reserve(messagesPerThread/SampleInterval+1u);
+
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (uint64_t i=0ull; i<messagesPerThread; i++)
+            {
+                if (i%SampleInterval)
+                {
+                    logger->log("Thread %u loaded asset %llu in %f ms",ILogger::ELL_INFO,t,static_cast<unsigned long long>(i),double(i)*0.001);
+                    continue;
+                }
+                const auto start = std::chrono::steady_clock::now();
+                logger->log("Thread %u loaded asset %llu in %f ms",ILogger::ELL_INFO,t,static_cast<unsigned long long>(i),double(i)*0.001);
+                samples.push_back(std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-start).count());
+            }
+        });
+
+    while (ready.load()!=threadCount)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true,std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+    SResult result;
+    result.callerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    if constexpr (std::is_same_v<Logger,CAsyncFileLogger>)
+    {
+        logger->flush();
+        result.dropped = logger->getDroppedCount();
+    }
+    result.flushedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    logger = nullptr;
+    {
+        std::ifstream written(filename,std::ios::binary);
+        result.lines = std::count(std::istreambuf_iterator<char>(written),std::istreambuf_iterator<char>(),'\n');
+    }
+
+    std::vector<double> samples;
+    for (const auto& threadSamples : latencies)
+        samples.insert(samples.end(),threadSamples.begin(),threadSamples.end());
+    if (!samples.empty())
+    {
+        const auto p99 = samples.begin()+(samples.size()*99u)/100u;
+        std::nth_element(samples.begin(),p99,samples.end());
+        result.p99Nanoseconds = *p99;
+    }
+    return result;
+}
+
+// returns whether every message which wasn't dropped made it into the file
+static bool report(const char* name, const uint32_t threadCount, const uint64_t messagesPerThread, const SResult& result)
+{
+    const uint64_t messages = uint64_t(threadCount)*messagesPerThread;
+    std::cout << std::setw(8) << threadCount << "  " << std::left << std::setw(26) << name << std::right
+        << std::setw(14) << std::fixed << std::setprecision(2) << messages/result.callerSeconds*1e-6 << std::setw(14) << messages/result.flushedSeconds*1e-6
+        << std::setw(14) << std::setprecision(0) << result.p99Nanoseconds << std::setw(10) << result.dropped << std::setw(10) << messages-result.dropped-result.lines << std::endl;
+    return result.dropped+result.lines==messages;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks CAsyncFileLogger against CFileLogger");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u))
+        .scan<'u', uint32_t>()
+        .help("Largest number of threads to log from");
+
+    program.add_argument(NBL_MESSAGES_ARG.data())
+        .default_value(uint64_t(100000ull))
+        .scan<'u', uint64_t>()
+        .help("Number of lines every thread logs");
+
+    program.add_argument(NBL_OUTPUT_ARG.data())
+        .default_value(std::filesystem::temp_directory_path().generic_string())
+        .help("Directory to write the log files to, they get deleted afterwards");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t maxThreads = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+    const uint64_t messagesPerThread = program.get<uint64_t>(NBL_MESSAGES_ARG.data());
+    const path outputDir = program.get<std::string>(NBL_OUTPUT_ARG.data());
+
+    #ifdef _NBL_PLATFORM_LINUX_
+        // `IApplicationFramework::createSystem` has no Linux branch
+        core::smart_refctd_ptr<ISystem> system = core::make_smart_refctd_ptr<CSystemLinux>();
+    #else
+        core::smart_refctd_ptr<ISystem> system = IApplicationFramework::createSystem();
+    #endif
+    if (!system)
+    {
+        std::cerr << "Could not create the system!" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(8) << "threads" << "  " << std::left << std::setw(26) << "logger" << std::right
+        << std::setw(14) << "caller Ml/s" << std::setw(14) << "flushed Ml/s" << std::setw(14) << "p99 ns" << std::setw(10) << "dropped" << std::setw(10) << "lost" << std::endl;
+    const path filename = outputDir/"nbl_logger_benchmark.log";
+    bool complete = true;
+    for (uint32_t threadCount=1u; ; threadCount=std::min(threadCount*2u,maxThreads))
+    {
+        complete = report("CFileLogger",threadCount,messagesPerThread,run<CFileLogger>(system.get(),filename,threadCount,messagesPerThread)) && complete;
+        complete = report("CAsyncFileLogger",threadCount,messagesPerThread,run<CAsyncFileLogger>(system.get(),filename,threadCount,messagesPerThread,CAsyncFileLogger::EOP_BLOCK)) && complete;
+        complete = report("CAsyncFileLogger(EOP_DROP)",threadCount,messagesPerThread,run<CAsyncFileLogger>(system.get(),filename,threadCount,messagesPerThread,CAsyncFileLogger::EOP_DROP)) && complete;
+        if (threadCount==maxThreads)
+            break;
+    }
+    std::filesystem::remove(filename);
+
+    if (!complete)
+    {
+        std::cerr << "A logger lost messages!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,320 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Read throughput of entries in an LZ4 block compressed asset pack (.nbpak) opened through `ISystem::openFileArchive`
+/*
+    Packs `--entries` synthetic entries of `--entry-size` bytes in memory the same way `tools/lz4pack` does, half of them text which
+    LZ4 compresses and gets stored as blocks, half random bytes which get stored verbatim, and opens the pack from a memory view.
+    Then every entry gets read whole, `--requests` reads of `--request-size` bytes land at random offsets, and every entry gets opened
+    with `ECF_MAPPABLE` which decompresses it whole up front. Every byte read gets compared to what was packed.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <lz4/lib/lz4.h>
+#include <nbl/system/IApplicationFramework.h>
+#include <nbl/system/SLZ4PackFormat.h>
+
+constexpr std::string_view NBL_ENTRIES_ARG = "--entries";
+constexpr std::string_view NBL_ENTRY_SIZE_ARG = "--entry-size";
+constexpr std::string_view NBL_BLOCK_SIZE_ARG = "--block-size";
+constexpr std::string_view NBL_REQUESTS_ARG = "--requests";
+constexpr std::string_view NBL_REQUEST_SIZE_ARG = "--request-size";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+
+using namespace nbl;
+using namespace nbl::system;
+
+struct SEntry
+{
+    std::string path;
+    std::vector<char> contents;
+};
+
+// lines of an OBJ, compressible like most text assets
+static std::vector<char> makeText(std::mt19937& generator, const size_t size)
+{
+    std::string text;
+    char line[64];
+    while (text.size()<size)
+    {
+        const int length = snprintf(line,sizeof(line),"v %.4f %.4f %.4f\n",(generator()%20000u)*0.001f,(generator()%20000u)*0.001f,(generator()%20000u)*0.001f);
+        text.append(line,length);
+    }
+    return std::vector<char>(text.begin(),text.begin()+size);
+}
+
+static std::vector<char> makeRandom(std::mt19937& generator, const size_t size)
+{
+    std::vector<char> bytes(size);
+    for (auto& byte : bytes)
+        byte = static_cast<char>(generator());
+    return bytes;
+}
+
+static uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+{
+    return (value+alignment-1ull)/alignment*alignment;
+}
+
+// same layout and fallbacks as `tools/lz4pack`, see `SLZ4PackFormat.h`
+static std::vector<std::byte> pack(const std::vector<SEntry>& entries, const uint32_t blockSize)
+{
+    lz4pack::SHeader header = {};
+    memcpy(header.magic,lz4pack::Magic,sizeof(header.magic));
+    header.version = lz4pack::Version;
+    header.blockSize = blockSize;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.bucketCount = 2u;
+    while (header.bucketCount<(header.entryCount<<1u))
+        header.bucketCount <<= 1u;
+
+    std::vector<lz4pack::SEntry> toc(entries.size());
+    std::vector<uint32_t> buckets(header.bucketCount,lz4pack::InvalidEntry);
+    std::string strings;
+    for (uint32_t i=0u; i<header.entryCount; i++)
+    {
+        toc[i].pathHash = lz4pack::hashPath(entries[i].path);
+        toc[i].pathOffset = static_cast<uint32_t>(strings.size());
+        toc[i].pathLength = static_cast<uint32_t>(entries[i].path.size());
+        strings += entries[i].path;
+        auto bucket = toc[i].pathHash&(header.bucketCount-1u);
+        while (buckets[bucket]!=lz4pack::InvalidEntry)
+            bucket = (bucket+1u)&(header.bucketCount-1u);
+        buckets[bucket] = i;
+    }
+    header.stringsOffset = sizeof(header)+sizeof(lz4pack::SEntry)*toc.size()+sizeof(uint32_t)*buckets.size();
+    header.stringsSize = strings.size();
+
+    std::vector<std::byte> out(alignUp(header.stringsOffset+header.stringsSize,8ull));
+    std::vector<char> scratch(LZ4_compressBound(blockSize));
+    for (uint32_t i=0u; i<header.entryCount; i++)
+    {
+        const auto& contents = entries[i].contents;
+        const uint64_t blockCount = lz4pack::getBlockCount(contents.size(),blockSize);
+        std::vector<char> data(sizeof(uint64_t)*blockCount);
+        uint64_t end = 0ull;
+        for (uint64_t b=0ull; b<blockCount; b++)
+        {
+            const char* src = contents.data()+b*blockSize;
+            const int srcSize = static_cast<int>(std::min<uint64_t>(blockSize,contents.size()-b*blockSize));
+            int dstSize = LZ4_compress_default(src,scratch.data(),srcSize,static_cast<int>(scratch.size()));
+            if (dstSize<=0 || dstSize>=srcSize)
+            {
+                data.insert(data.end(),src,src+srcSize);
+                dstSize = srcSize;
+            }
+            else
+                data.insert(data.end(),scratch.data(),scratch.data()+dstSize);
+            end += dstSize;
+            memcpy(data.data()+sizeof(uint64_t)*b,&end,sizeof(uint64_t));
+        }
+        const bool compressed = data.size()<contents.size();
+        if (!compressed)
+            data = contents;
+
+        toc[i].dataOffset = out.size();
+        toc[i].dataSize = data.size();
+        toc[i].size = contents.size();
+        toc[i].flags = compressed ? lz4pack::SEntry::EF_LZ4_BLOCKS:lz4pack::SEntry::EF_NONE;
+        out.resize(alignUp(out.size()+data.size(),8ull));
+        memcpy(out.data()+toc[i].dataOffset,data.data(),data.size());
+    }
+
+    std::byte* dst = out.data();
+    memcpy(dst,&header,sizeof(header));
+    memcpy(dst+sizeof(header),toc.data(),sizeof(lz4pack::SEntry)*toc.size());
+    memcpy(dst+sizeof(header)+sizeof(lz4pack::SEntry)*toc.size(),buckets.data(),sizeof(uint32_t)*buckets.size());
+    memcpy(dst+header.stringsOffset,strings.data(),strings.size());
+    return out;
+}
+
+// reads `[offset,offset+size)` of `file` and compares it to `expected`
+static bool readAndCompare(IFile* file, std::vector<char>& buffer, const std::vector<char>& expected, const size_t offset, const size_t size)
+{
+    IFile::success_t success;
+    file->read(success,buffer.data(),offset,size);
+    return bool(success) && memcmp(buffer.data(),expected.data()+offset,size)==0;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks reading entries of an LZ4 block compressed asset pack");
+
+    program.add_argument(NBL_ENTRIES_ARG.data())
+        .default_value(32u)
+        .scan<'u', uint32_t>()
+        .help("Number of entries in the pack, half of them compressible");
+
+    program.add_argument(NBL_ENTRY_SIZE_ARG.data())
+        .default_value(uint64_t(8ull<<20ull))
+        .scan<'u', uint64_t>()
+        .help("Uncompressed size of every entry in bytes");
+
+    program.add_argument(NBL_BLOCK_SIZE_ARG.data())
+        .default_value(lz4pack::DefaultBlockSize)
+        .scan<'u', uint32_t>()
+        .help("Uncompressed size of a block, the granularity of random access");
+
+    program.add_argument(NBL_REQUESTS_ARG.data())
+        .default_value(16384u)
+        .scan<'u', uint32_t>()
+        .help("Number of random reads per kind of entry");
+
+    program.add_argument(NBL_REQUEST_SIZE_ARG.data())
+        .default_value(uint64_t(4096ull))
+        .scan<'u', uint64_t>()
+        .help("Size of a random read in bytes");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(3u)
+        .scan<'u', uint32_t>()
+        .help("Number of runs per kind of read, the median gets reported");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t entryCount = std::max(program.get<uint32_t>(NBL_ENTRIES_ARG.data()),2u)&~0x1u;
+    const size_t entrySize = std::max<uint64_t>(program.get<uint64_t>(NBL_ENTRY_SIZE_ARG.data()),1ull);
+    const uint32_t blockSize = std::clamp<uint32_t>(program.get<uint32_t>(NBL_BLOCK_SIZE_ARG.data()),1u,LZ4_MAX_INPUT_SIZE);
+    const uint32_t requestCount = std::max(program.get<uint32_t>(NBL_REQUESTS_ARG.data()),1u);
+    const size_t requestSize = std::clamp<uint64_t>(program.get<uint64_t>(NBL_REQUEST_SIZE_ARG.data()),1ull,entrySize);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+
+    #ifdef _NBL_PLATFORM_LINUX_
+        // `IApplicationFramework::createSystem` has no Linux branch
+        core::smart_refctd_ptr<ISystem> system = core::make_smart_refctd_ptr<CSystemLinux>();
+    #else
+        core::smart_refctd_ptr<ISystem> system = IApplicationFramework::createSystem();
+    #endif
+    if (!system)
+    {
+        std::cerr << "Could not create the system!" << std::endl;
+        return 1;
+    }
+
+    // even entries are text, odd ones random
+    std::vector<SEntry> entries(entryCount);
+    {
+        std::mt19937 generator(0x45u);
+        for (uint32_t i=0u; i<entryCount; i++)
+        {
+            entries[i].path = (i&0x1u ? "textures/noise":"models/mesh")+std::to_string(i/2u)+(i&0x1u ? ".bin":".obj");
+            entries[i].contents = i&0x1u ? makeRandom(generator,entrySize):makeText(generator,entrySize);
+        }
+    }
+    auto packed = pack(entries,blockSize);
+    auto archive = system->openFileArchive(core::make_smart_refctd_ptr<CFileView<CNullAllocator>>(path("benchmark.nbpak"),IFileBase::ECF_READ|IFileBase::ECF_MAPPABLE,IFileBase::time_point_t(),packed.data(),packed.size()));
+    if (!archive)
+    {
+        std::cerr << "Could not open the pack!" << std::endl;
+        return 1;
+    }
+    const double packedRatio = double(packed.size())/(double(entrySize)*entryCount);
+    std::cout << "pack is " << std::fixed << std::setprecision(1) << packedRatio*100.0 << "% of the entries' size" << std::endl;
+
+    std::cout << std::left << std::setw(12) << "entries" << std::setw(10) << "read" << std::right << std::setw(12) << "median ms" << std::setw(12) << "MiB/s" << std::setw(10) << "match" << std::endl;
+    std::vector<char> buffer(entrySize);
+    bool allMatch = true;
+    for (const bool compressible : {true,false})
+    {
+        // time `repeats` runs of `read`, which returns whether everything matched, and report `bytes` read per run
+        auto report = [&](const char* name, const double bytes, auto&& read) -> void
+        {
+            std::vector<double> times;
+            bool match = true;
+            for (uint32_t r=0u; r<repeats; r++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                match = read() && match;
+                times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+            }
+            std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+            const double ms = times[times.size()/2u];
+            std::cout << std::left << std::setw(12) << (compressible ? "LZ4 blocks":"stored") << std::setw(10) << name << std::right
+                << std::setw(12) << std::fixed << std::setprecision(2) << ms << std::setw(12) << bytes/double(0x1u<<20u)/ms*1000.0 << std::setw(10) << (match ? "yes":"NO") << std::endl;
+            allMatch = allMatch && match;
+        };
+
+        std::vector<core::smart_refctd_ptr<IFile>> files;
+        std::vector<const SEntry*> expected;
+        for (uint32_t i=compressible ? 0u:1u; i<entryCount; i+=2u)
+        {
+            files.push_back(archive->getFile(entries[i].path,IFileBase::ECF_READ,""));
+            expected.push_back(&entries[i]);
+            if (!files.back())
+            {
+                std::cerr << "Could not open " << entries[i].path << " in the pack!" << std::endl;
+                return 1;
+            }
+        }
+
+        report("whole",double(entrySize)*files.size(),[&]() -> bool
+        {
+            bool match = true;
+            for (size_t f=0u; f<files.size(); f++)
+                match = readAndCompare(files[f].get(),buffer,expected[f]->contents,0ull,entrySize) && match;
+            return match;
+        });
+
+        std::vector<std::pair<uint32_t,size_t>> requests(requestCount);
+        {
+            std::mt19937_64 generator(0x45u);
+            for (auto& request : requests)
+                request = {uint32_t(generator()%files.size()),generator()%(entrySize-requestSize+1ull)};
+        }
+        report("random",double(requestSize)*requestCount,[&]() -> bool
+        {
+            bool match = true;
+            for (const auto& request : requests)
+                match = readAndCompare(files[request.first].get(),buffer,expected[request.first]->contents,request.second,requestSize) && match;
+            return match;
+        });
+
+        report("mappable",double(entrySize)*files.size(),[&]() -> bool
+        {
+            bool match = true;
+            for (const auto* entry : expected)
+            {
+                auto file = archive->getFile(entry->path,core::bitflag<IFileBase::E_CREATE_FLAGS>(IFileBase::ECF_READ)|IFileBase::ECF_MAPPABLE,"");
+                const IFile* constFile = file.get();
+                const void* mapped = constFile ? constFile->getMappedPointer():nullptr;
+                match = mapped && memcmp(mapped,entry->contents.data(),entrySize)==0 && match;
+            }
+            return match;
+        });
+    }
+
+    if (!allMatch)
+    {
+        std::cerr << "A read from the pack didn't give back what was packed!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
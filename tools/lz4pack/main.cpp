@@ -0,0 +1,212 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <argparse/argparse.hpp>
+#include <lz4/lib/lz4.h>
+#include <lz4/lib/lz4hc.h>
+#include <nbl/system/SLZ4PackFormat.h>
+
+constexpr std::string_view NBL_INPUT_ARG = "--input";
+constexpr std::string_view NBL_OUTPUT_ARG = "--output";
+constexpr std::string_view NBL_BLOCK_SIZE_ARG = "--block-size";
+constexpr std::string_view NBL_HC_ARG = "--hc";
+
+using namespace nbl::system;
+
+static inline uint64_t alignUp(const uint64_t value, const uint64_t alignment)
+{
+    return (value+alignment-1ull)/alignment*alignment;
+}
+
+// returns the entry's on-disk data, either the bytes verbatim or the block table followed by the blocks
+static std::vector<char> packEntry(const std::vector<char>& contents, const uint32_t blockSize, const int hcLevel, bool& compressed)
+{
+    const uint64_t blockCount = lz4pack::getBlockCount(contents.size(),blockSize);
+    std::vector<char> out(sizeof(uint64_t)*blockCount);
+    std::vector<char> scratch(LZ4_compressBound(blockSize));
+
+    uint64_t end = 0ull;
+    for (uint64_t i=0ull; i<blockCount; i++)
+    {
+        const char* src = contents.data()+i*blockSize;
+        const int srcSize = static_cast<int>(std::min<uint64_t>(blockSize,contents.size()-i*blockSize));
+        int dstSize = hcLevel>0 ? LZ4_compress_HC(src,scratch.data(),srcSize,static_cast<int>(scratch.size()),hcLevel):
+            LZ4_compress_default(src,scratch.data(),srcSize,static_cast<int>(scratch.size()));
+        // incompressible blocks are stored raw, the loader tells them apart by their size
+        if (dstSize<=0 || dstSize>=srcSize)
+        {
+            out.insert(out.end(),src,src+srcSize);
+            dstSize = srcSize;
+        }
+        else
+            out.insert(out.end(),scratch.data(),scratch.data()+dstSize);
+        end += dstSize;
+        memcpy(out.data()+sizeof(uint64_t)*i,&end,sizeof(uint64_t));
+    }
+
+    // not worth decompressing, store the entry so the loader can hand out views into the mapped pack
+    compressed = out.size()<contents.size();
+    if (!compressed)
+        return contents;
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Packs a directory into an LZ4 block compressed Nabla asset pack (.nbpak)");
+
+    program.add_argument(NBL_INPUT_ARG.data())
+        .required()
+        .help("Input directory to pack, paths inside the pack are relative to it");
+
+    program.add_argument(NBL_OUTPUT_ARG.data())
+        .required()
+        .help("Output pack file path");
+
+    program.add_argument(NBL_BLOCK_SIZE_ARG.data())
+        .default_value(lz4pack::DefaultBlockSize)
+        .scan<'u', uint32_t>()
+        .help("Uncompressed size of a block, the granularity of random access");
+
+    program.add_argument(NBL_HC_ARG.data())
+        .default_value(0)
+        .scan<'i', int>()
+        .help("Use LZ4 HC with the given compression level (1-12) instead of the fast compressor, loading speed is the same");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const std::filesystem::path inputPath = program.get<std::string>(NBL_INPUT_ARG.data());
+    const std::filesystem::path outputPath = program.get<std::string>(NBL_OUTPUT_ARG.data());
+    const uint32_t blockSize = program.get<uint32_t>(NBL_BLOCK_SIZE_ARG.data());
+    const int hcLevel = program.get<int>(NBL_HC_ARG.data());
+
+    if (!std::filesystem::is_directory(inputPath))
+    {
+        std::cerr << "Directory does not exist: " << inputPath << std::endl;
+        return 1;
+    }
+    if (blockSize==0u || blockSize>static_cast<uint32_t>(LZ4_MAX_INPUT_SIZE))
+    {
+        std::cerr << "Invalid block size: " << blockSize << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    for (const auto& dirEntry : std::filesystem::recursive_directory_iterator(inputPath))
+    if (dirEntry.is_regular_file())
+        paths.push_back(std::filesystem::relative(dirEntry.path(),inputPath).generic_string());
+    std::sort(paths.begin(),paths.end());
+
+    lz4pack::SHeader header = {};
+    memcpy(header.magic,lz4pack::Magic,sizeof(header.magic));
+    header.version = lz4pack::Version;
+    header.blockSize = blockSize;
+    header.entryCount = static_cast<uint32_t>(paths.size());
+    // keep the load factor at or below one half
+    header.bucketCount = 2u;
+    while (header.bucketCount<(header.entryCount<<1u))
+        header.bucketCount <<= 1u;
+
+    std::vector<lz4pack::SEntry> entries(paths.size());
+    std::vector<uint32_t> buckets(header.bucketCount,lz4pack::InvalidEntry);
+    std::string strings;
+    for (uint32_t i=0u; i<header.entryCount; i++)
+    {
+        auto& entry = entries[i];
+        entry.pathHash = lz4pack::hashPath(paths[i]);
+        entry.pathOffset = static_cast<uint32_t>(strings.size());
+        entry.pathLength = static_cast<uint32_t>(paths[i].size());
+        strings += paths[i];
+
+        auto bucket = entry.pathHash&(header.bucketCount-1u);
+        while (buckets[bucket]!=lz4pack::InvalidEntry)
+            bucket = (bucket+1u)&(header.bucketCount-1u);
+        buckets[bucket] = i;
+    }
+    header.stringsOffset = sizeof(header)+sizeof(lz4pack::SEntry)*entries.size()+sizeof(uint32_t)*buckets.size();
+    header.stringsSize = strings.size();
+
+    std::ofstream output(outputPath, std::ios::binary|std::ios::trunc);
+    if (!output)
+    {
+        std::cerr << "Failed to open file: " << outputPath << std::endl;
+        return 1;
+    }
+
+    // data goes first, the table of contents gets written once all the offsets and sizes are known
+    uint64_t offset = alignUp(header.stringsOffset+header.stringsSize,8ull);
+    uint64_t totalSize = 0ull, totalPacked = 0ull;
+    for (uint32_t i=0u; i<header.entryCount; i++)
+    {
+        const auto filePath = inputPath/paths[i];
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "Failed to open file: " << filePath << std::endl;
+            return 1;
+        }
+        std::vector<char> contents(std::filesystem::file_size(filePath));
+        if (!file.read(contents.data(), contents.size()))
+        {
+            std::cerr << "Failed to read file: " << filePath << std::endl;
+            return 1;
+        }
+
+        bool compressed = false;
+        const auto data = packEntry(contents,blockSize,hcLevel,compressed);
+
+        auto& entry = entries[i];
+        entry.dataOffset = offset;
+        entry.dataSize = data.size();
+        entry.size = contents.size();
+        entry.flags = compressed ? lz4pack::SEntry::EF_LZ4_BLOCKS:lz4pack::SEntry::EF_NONE;
+
+        output.seekp(offset);
+        output.write(data.data(), data.size());
+        offset = alignUp(offset+data.size(),8ull);
+
+        totalSize += entry.size;
+        totalPacked += entry.dataSize;
+    }
+
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(entries.data()), sizeof(lz4pack::SEntry)*entries.size());
+    output.write(reinterpret_cast<const char*>(buckets.data()), sizeof(uint32_t)*buckets.size());
+    output.write(strings.data(), strings.size());
+    if (!output)
+    {
+        std::cerr << "Failed to write file: " << outputPath << std::endl;
+        return 1;
+    }
+
+    printf("{\"entries\": %u, \"size\": %s, \"packedSize\": %s}", header.entryCount, std::to_string(totalSize).c_str(), std::to_string(totalPacked).c_str());
+
+    return 0;
+}
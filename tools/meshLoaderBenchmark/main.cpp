@@ -0,0 +1,456 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Load time of synthetic text and binary STL and PLY files (and the parse time of a Mitsuba scene), mapped and unmapped
+/*
+    Generates a `--grid` by `--grid` vertex height field of triangles in every format, and for Mitsuba a scene with as many spheres.
+    Every file gets loaded `--repeats` times from memory, which the reader sees as a mapped file and parses in place, and as often from
+    a file written to `--dir`, which isn't mappable so the reader has the next chunk read on the `ISystem` worker while it parses the
+    current one. The written file stays in the page cache, so this measures the reads and the parse, not the disk.
+    Binary PLY only gets read in bulk out of a mapping, so for it the unmapped load is the property by property path, little and big
+    endian, with positions alone (copied whole) and with normals and 8bit colours (converted one by one). Binary STL gets decoded in bulk
+    either way, once as the triangle soup and once welded, which has to leave one vertex per grid point.
+    Both loads have to give identical meshbuffers with all the triangles, and the scene has to parse with all its shapes.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <argparse/argparse.hpp>
+#include "nabla.h"
+#include "nbl/system/IApplicationFramework.h"
+#ifdef NBL_MESH_LOADER_BENCHMARK_MITSUBA
+#include "nbl/ext/MitsubaLoader/ParserUtil.h"
+#endif // NBL_MESH_LOADER_BENCHMARK_MITSUBA
+
+constexpr std::string_view NBL_GRID_ARG = "--grid";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+constexpr std::string_view NBL_DIR_ARG = "--dir";
+
+using namespace nbl;
+
+struct SFormat
+{
+    std::string name;
+    std::string extension;
+    std::string contents;
+    uint32_t triangles;
+    // vertices the loaded mesh has to have, 0 for any number
+    uint32_t vertices = 0u;
+    asset::IAssetLoader::E_LOADER_PARAMETER_FLAGS loaderFlags = asset::IAssetLoader::ELPF_NONE;
+};
+
+static float heightAt(const uint32_t grid, const uint32_t x, const uint32_t y)
+{
+    return std::sin(float(x)/float(grid)*17.f)*std::cos(float(y)/float(grid)*13.f)*0.25f;
+}
+
+// calls `f` with the grid coordinates of the corners of every triangle, two per cell
+template<typename F>
+static uint32_t forEachTriangle(const uint32_t grid, F&& f)
+{
+    for (uint32_t y=0u; y+1u<grid; y++)
+    for (uint32_t x=0u; x+1u<grid; x++)
+    {
+        f(std::array<std::pair<uint32_t,uint32_t>,3>{{{x,y},{x+1u,y},{x+1u,y+1u}}});
+        f(std::array<std::pair<uint32_t,uint32_t>,3>{{{x,y},{x+1u,y+1u},{x,y+1u}}});
+    }
+    return (grid-1u)*(grid-1u)*2u;
+}
+
+static SFormat makeASCIISTL(const uint32_t grid)
+{
+    SFormat format = {"STL ascii","stl"};
+    std::string& stl = format.contents;
+    char line[256];
+    stl += "solid benchmark\n";
+    format.triangles = forEachTriangle(grid,[&](const std::array<std::pair<uint32_t,uint32_t>,3>& corners) -> void
+    {
+        // the loader recomputes the normal from the winding anyway
+        stl.append(line,snprintf(line,sizeof(line),"  facet normal %f %f %f\n    outer loop\n",0.f,1.f,0.f));
+        for (const auto& corner : corners)
+            stl.append(line,snprintf(line,sizeof(line),"      vertex %f %f %f\n",float(corner.first)/float(grid),heightAt(grid,corner.first,corner.second),float(corner.second)/float(grid)));
+        stl += "    endloop\n  endfacet\n";
+    });
+    stl += "endsolid benchmark\n";
+    return format;
+}
+
+static SFormat makeASCIIPLY(const uint32_t grid)
+{
+    SFormat format = {"PLY ascii","ply"};
+    std::string& ply = format.contents;
+    char line[256];
+    const uint32_t triangleCount = (grid-1u)*(grid-1u)*2u;
+    ply.append(line,snprintf(line,sizeof(line),
+        "ply\nformat ascii 1.0\ncomment height field\n"
+        "element vertex %u\nproperty float x\nproperty float y\nproperty float z\nproperty float nx\nproperty float ny\nproperty float nz\n"
+        "element face %u\nproperty list uchar int vertex_indices\nend_header\n",grid*grid,triangleCount));
+    for (uint32_t y=0u; y<grid; y++)
+    for (uint32_t x=0u; x<grid; x++)
+    {
+        const float height = heightAt(grid,x,y);
+        ply.append(line,snprintf(line,sizeof(line),"%f %f %f %f %f %f\n",float(x)/float(grid),height,float(y)/float(grid),-height,1.f,height*0.5f));
+    }
+    format.triangles = forEachTriangle(grid,[&](const std::array<std::pair<uint32_t,uint32_t>,3>& corners) -> void
+    {
+        ply.append(line,snprintf(line,sizeof(line),"3 %u %u %u\n",corners[0].second*grid+corners[0].first,corners[1].second*grid+corners[1].first,corners[2].second*grid+corners[2].first));
+    });
+    return format;
+}
+
+// every facet stores the same up normal, like the faces of a CAD model lying in one plane, so welding has to leave one vertex per grid point
+static SFormat makeBinarySTL(const uint32_t grid, const bool weld)
+{
+    SFormat format = {weld ? "STL binary weld":"STL binary","stl"};
+    std::string& stl = format.contents;
+    // the header may not start with "solid"
+    stl.append(80u,' ');
+    const uint32_t triangleCount = (grid-1u)*(grid-1u)*2u;
+    stl.append(reinterpret_cast<const char*>(&triangleCount),sizeof(triangleCount));
+    format.triangles = forEachTriangle(grid,[&](const std::array<std::pair<uint32_t,uint32_t>,3>& corners) -> void
+    {
+        float facet[12] = {0.f,1.f,0.f};
+        for (uint32_t i=0u; i<3u; i++)
+        {
+            facet[3u+i*3u] = float(corners[i].first)/float(grid);
+            facet[4u+i*3u] = heightAt(grid,corners[i].first,corners[i].second);
+            facet[5u+i*3u] = float(corners[i].second)/float(grid);
+        }
+        stl.append(reinterpret_cast<const char*>(facet),sizeof(facet));
+        // no colour
+        stl.append(2u,'\0');
+    });
+    if (weld)
+    {
+        format.vertices = grid*grid;
+        format.loaderFlags = asset::IAssetLoader::ELPF_WELD_VERTICES;
+    }
+    else
+        format.vertices = format.triangles*3u;
+    return format;
+}
+
+template<typename T>
+static void appendBinary(std::string& out, const T value, const bool bigEndian)
+{
+    char bytes[sizeof(T)];
+    memcpy(bytes,&value,sizeof(T));
+    // every platform Nabla builds for is little endian
+    if (bigEndian)
+        std::reverse(bytes,bytes+sizeof(T));
+    out.append(bytes,sizeof(T));
+}
+
+// positions alone can be copied straight out of the mapping, normals and 8bit colours make every property get converted on its own
+static SFormat makeBinaryPLY(const uint32_t grid, const bool bigEndian, const bool allAttributes)
+{
+    SFormat format = {std::string("PLY ")+(bigEndian ? "be":"le")+(allAttributes ? " xyz n rgb":" xyz"),"ply"};
+    std::string& ply = format.contents;
+    char line[512];
+    const uint32_t triangleCount = (grid-1u)*(grid-1u)*2u;
+    ply.append(line,snprintf(line,sizeof(line),
+        "ply\nformat binary_%s_endian 1.0\ncomment height field\n"
+        "element vertex %u\nproperty float x\nproperty float y\nproperty float z\n%s"
+        "element face %u\nproperty list uchar int vertex_indices\nend_header\n",
+        bigEndian ? "big":"little",grid*grid,
+        allAttributes ? "property float nx\nproperty float ny\nproperty float nz\nproperty uchar red\nproperty uchar green\nproperty uchar blue\n":"",
+        triangleCount));
+    for (uint32_t y=0u; y<grid; y++)
+    for (uint32_t x=0u; x<grid; x++)
+    {
+        const float height = heightAt(grid,x,y);
+        for (const float position : {float(x)/float(grid),height,float(y)/float(grid)})
+            appendBinary(ply,position,bigEndian);
+        if (!allAttributes)
+            continue;
+        for (const float normal : {-height,1.f,height*0.5f})
+            appendBinary(ply,normal,bigEndian);
+        for (const uint8_t colour : {uint8_t(x),uint8_t(y),uint8_t(x^y)})
+            appendBinary(ply,colour,bigEndian);
+    }
+    format.triangles = forEachTriangle(grid,[&](const std::array<std::pair<uint32_t,uint32_t>,3>& corners) -> void
+    {
+        appendBinary(ply,uint8_t(3u),bigEndian);
+        for (const auto& corner : corners)
+            appendBinary(ply,int32_t(corner.second*grid+corner.first),bigEndian);
+    });
+    return format;
+}
+
+#ifdef NBL_MESH_LOADER_BENCHMARK_MITSUBA
+static std::string makeMitsubaScene(const uint32_t sphereCount)
+{
+    constexpr uint32_t BSDFCount = 16u;
+    std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<scene version=\"0.5.0\">\n";
+    char line[512];
+    for (uint32_t i=0u; i<BSDFCount; i++)
+        xml.append(line,snprintf(line,sizeof(line),"\t<bsdf type=\"diffuse\" id=\"bsdf%u\">\n\t\t<rgb name=\"reflectance\" value=\"%f %f %f\"/>\n\t</bsdf>\n",i,i/float(BSDFCount),0.5f,1.f-i/float(BSDFCount)));
+    for (uint32_t i=0u; i<sphereCount; i++)
+    {
+        const float s = 0.1f+(i%7u)*0.01f;
+        xml.append(line,snprintf(line,sizeof(line),
+            "\t<shape type=\"sphere\">\n\t\t<transform name=\"toWorld\">\n\t\t\t<matrix value=\"%f 0 0 %f 0 %f 0 %f 0 0 %f %f 0 0 0 1\"/>\n\t\t</transform>\n\t\t<ref id=\"bsdf%u\"/>\n\t</shape>\n",
+            s,float(i%256u),s,float(i/256u),s,0.f,i%BSDFCount));
+    }
+    xml += "</scene>\n";
+    return xml;
+}
+#endif // NBL_MESH_LOADER_BENCHMARK_MITSUBA
+
+static core::smart_refctd_ptr<asset::ICPUMesh> loadMesh(asset::IAssetManager* assetManager, system::IFile* file, const std::string& name, const asset::IAssetLoader::E_LOADER_PARAMETER_FLAGS loaderFlags)
+{
+    // nothing may come out of the cache, every load has to parse
+    asset::IAssetLoader::SAssetLoadParams params;
+    params.loaderFlags = loaderFlags;
+    params.cacheFlags = asset::IAssetLoader::ECF_DONT_CACHE_REFERENCES;
+    const auto bundle = assetManager->getAsset(file,name,params);
+    const auto assets = bundle.getContents();
+    if (assets.empty())
+        return nullptr;
+    return core::smart_refctd_ptr_static_cast<asset::ICPUMesh>(assets[0]);
+}
+
+static bool sameContents(const asset::ICPUBuffer* a, const asset::ICPUBuffer* b)
+{
+    if (!a || !b)
+        return a==b;
+    return a->getSize()==b->getSize() && memcmp(a->getPointer(),b->getPointer(),a->getSize())==0;
+}
+
+static bool sameMeshBuffers(const asset::ICPUMesh* a, const asset::ICPUMesh* b)
+{
+    if (!a || !b)
+        return false;
+    const auto aMeshBuffers = a->getMeshBuffers();
+    const auto bMeshBuffers = b->getMeshBuffers();
+    if (aMeshBuffers.size()!=bMeshBuffers.size())
+        return false;
+    for (size_t i=0ull; i<aMeshBuffers.size(); i++)
+    {
+        const asset::ICPUMeshBuffer* aMB = aMeshBuffers.begin()[i];
+        const asset::ICPUMeshBuffer* bMB = bMeshBuffers.begin()[i];
+        if (aMB->getIndexCount()!=bMB->getIndexCount() || aMB->getIndexType()!=bMB->getIndexType() || aMB->getBaseVertex()!=bMB->getBaseVertex())
+            return false;
+        const auto& aIndices = aMB->getIndexBufferBinding();
+        const auto& bIndices = bMB->getIndexBufferBinding();
+        if (aIndices.offset!=bIndices.offset || !sameContents(aIndices.buffer.get(),bIndices.buffer.get()))
+            return false;
+        for (uint32_t binding=0u; binding<asset::ICPUMeshBuffer::MAX_ATTR_BUF_BINDING_COUNT; binding++)
+        {
+            const auto& aVertices = aMB->getVertexBufferBindings()[binding];
+            const auto& bVertices = bMB->getVertexBufferBindings()[binding];
+            if (aVertices.offset!=bVertices.offset || !sameContents(aVertices.buffer.get(),bVertices.buffer.get()))
+                return false;
+        }
+    }
+    return true;
+}
+
+static uint64_t indexCount(const asset::ICPUMesh* mesh)
+{
+    uint64_t count = 0ull;
+    for (const auto* meshBuffer : mesh->getMeshBuffers())
+        count += meshBuffer->getIndexCount();
+    return count;
+}
+
+// of the buffer the positions are in
+static uint64_t vertexCount(const asset::ICPUMesh* mesh)
+{
+    uint64_t count = 0ull;
+    for (const auto* meshBuffer : mesh->getMeshBuffers())
+    {
+        const uint32_t attribute = meshBuffer->getPositionAttributeIx();
+        const auto& binding = meshBuffer->getAttribBoundBuffer(attribute);
+        if (binding.buffer)
+            count += (binding.buffer->getSize()-binding.offset)/meshBuffer->getAttribStride(attribute);
+    }
+    return count;
+}
+
+static core::smart_refctd_ptr<system::IFile> makeMappedFile(std::string& contents, const std::string& name)
+{
+    // a view of memory is a mapped file to the reader
+    return core::make_smart_refctd_ptr<system::CFileView<system::CNullAllocator>>(system::path(name),system::IFile::ECF_READ,system::IFile::time_point_t(),contents.data(),contents.size());
+}
+
+static core::smart_refctd_ptr<system::IFile> makeUnmappedFile(system::ISystem* system, const std::string& contents, const system::path& filename)
+{
+    {
+        std::ofstream out(filename,std::ios::binary|std::ios::trunc);
+        if (!out.write(contents.data(),contents.size()))
+            return nullptr;
+    }
+    system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+    // not mappable, so the reads go through the caller
+    system->createFile(future,filename,system::IFileBase::ECF_READ);
+    if (auto file=future.acquire(); file && bool(*file))
+        return std::move(*file);
+    return nullptr;
+}
+
+// median wall time of `repeats` runs of `f`, which returns false on failure
+template<typename F>
+static double timeMedian(const uint32_t repeats, bool& success, F&& f)
+{
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        success = f() && success;
+        times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+
+static void report(const std::string& name, const size_t size, const double mappedMs, const double unmappedMs, const bool match)
+{
+    const double megabytes = size/double(0x1u<<20u);
+    std::cout << std::left << std::setw(18) << name << std::right << std::setw(10) << std::fixed << std::setprecision(2) << megabytes
+        << std::setw(12) << mappedMs << std::setw(10) << megabytes/mappedMs*1000.0
+        << std::setw(12) << unmappedMs << std::setw(10) << megabytes/unmappedMs*1000.0 << std::setw(8) << (match ? "yes":"NO") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks the text mesh and scene loaders reading mapped and unmapped files");
+
+    program.add_argument(NBL_GRID_ARG.data())
+        .default_value(256u)
+        .scan<'u', uint32_t>()
+        .help("Vertices along each side of the height field, also the square root of the number of spheres in the scene");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(3u)
+        .scan<'u', uint32_t>()
+        .help("Number of loads per format and file kind, the median gets reported");
+
+    program.add_argument(NBL_DIR_ARG.data())
+        .default_value((std::filesystem::temp_directory_path()/"nbl_mesh_loader_benchmark").generic_string())
+        .help("Directory to write the unmapped files to, gets deleted afterwards");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t grid = std::max(program.get<uint32_t>(NBL_GRID_ARG.data()),2u);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+    const system::path dir = program.get<std::string>(NBL_DIR_ARG.data());
+
+    #ifdef _NBL_PLATFORM_LINUX_
+        // `IApplicationFramework::createSystem` has no Linux branch
+        core::smart_refctd_ptr<system::ISystem> system = core::make_smart_refctd_ptr<system::CSystemLinux>();
+    #else
+        core::smart_refctd_ptr<system::ISystem> system = system::IApplicationFramework::createSystem();
+    #endif
+    if (!system)
+    {
+        std::cerr << "Could not create the system!" << std::endl;
+        return 1;
+    }
+    auto assetManager = core::make_smart_refctd_ptr<asset::IAssetManager>(core::smart_refctd_ptr(system));
+    std::filesystem::create_directories(dir);
+
+    std::vector<SFormat> formats;
+    formats.push_back(makeASCIISTL(grid));
+    for (const bool weld : {false,true})
+        formats.push_back(makeBinarySTL(grid,weld));
+    formats.push_back(makeASCIIPLY(grid));
+    for (const bool allAttributes : {false,true})
+    for (const bool bigEndian : {false,true})
+        formats.push_back(makeBinaryPLY(grid,bigEndian,allAttributes));
+
+    std::cout << std::left << std::setw(18) << "format" << std::right << std::setw(10) << "MiB" << std::setw(12) << "mapped ms" << std::setw(10) << "MiB/s"
+        << std::setw(12) << "unmapped ms" << std::setw(10) << "MiB/s" << std::setw(8) << "match" << std::endl;
+    bool match = true;
+    uint32_t load = 0u;
+    for (auto& format : formats)
+    {
+        auto mappedFile = makeMappedFile(format.contents,"benchmark."+format.extension);
+        auto unmappedFile = makeUnmappedFile(system.get(),format.contents,dir/("benchmark."+format.extension));
+        if (!unmappedFile)
+        {
+            std::cerr << "Could not write and open the " << format.name << " file in " << dir << std::endl;
+            std::filesystem::remove_all(dir);
+            return 1;
+        }
+
+        bool loaded = true;
+        core::smart_refctd_ptr<asset::ICPUMesh> mapped, unmapped;
+        const double mappedMs = timeMedian(repeats,loaded,[&]() -> bool
+        {
+            mapped = loadMesh(assetManager.get(),mappedFile.get(),"mapped"+std::to_string(load++)+"."+format.extension,format.loaderFlags);
+            return bool(mapped);
+        });
+        const double unmappedMs = timeMedian(repeats,loaded,[&]() -> bool
+        {
+            unmapped = loadMesh(assetManager.get(),unmappedFile.get(),"unmapped"+std::to_string(load++)+"."+format.extension,format.loaderFlags);
+            return bool(unmapped);
+        });
+        const bool same = loaded && indexCount(mapped.get())==format.triangles*3ull && (!format.vertices || vertexCount(mapped.get())==format.vertices) && sameMeshBuffers(mapped.get(),unmapped.get());
+        report(format.name,format.contents.size(),mappedMs,unmappedMs,same);
+        match = match && same;
+    }
+
+    #ifdef NBL_MESH_LOADER_BENCHMARK_MITSUBA
+    {
+        const uint32_t sphereCount = grid*grid;
+        std::string scene = makeMitsubaScene(sphereCount);
+        auto mappedFile = makeMappedFile(scene,"benchmark.xml");
+        auto unmappedFile = makeUnmappedFile(system.get(),scene,dir/"benchmark.xml");
+        if (!unmappedFile)
+        {
+            std::cerr << "Could not write and open the Mitsuba scene in " << dir << std::endl;
+            std::filesystem::remove_all(dir);
+            return 1;
+        }
+
+        asset::IAssetLoader::IAssetLoaderOverride loaderOverride(assetManager.get());
+        // a parser manager keeps everything it has parsed, so every parse gets a fresh one
+        auto parse = [&](system::IFile* file) -> bool
+        {
+            ext::MitsubaLoader::ParserManager parser(system.get(),&loaderOverride);
+            return parser.parse(file,system::logger_opt_ptr(nullptr)) && parser.shapegroups.size()==sphereCount;
+        };
+        bool parsed = true;
+        const double mappedMs = timeMedian(repeats,parsed,[&]() -> bool {return parse(mappedFile.get());});
+        const double unmappedMs = timeMedian(repeats,parsed,[&]() -> bool {return parse(unmappedFile.get());});
+        report("Mitsuba XML",scene.size(),mappedMs,unmappedMs,parsed);
+        match = match && parsed;
+    }
+    #endif // NBL_MESH_LOADER_BENCHMARK_MITSUBA
+    std::filesystem::remove_all(dir);
+
+    if (!match)
+    {
+        std::cerr << "A file failed to load, lost triangles or shapes, welded wrong, or loaded differently when mapped!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
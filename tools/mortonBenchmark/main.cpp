@@ -0,0 +1,197 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Throughput of the batch morton encoders and decoder against a loop over the scalar templates, on random coordinates which fit the code
+/*
+    The batch overloads pick AVX2, BMI2 or the plain code at runtime, so the numbers are for whatever the machine running this has.
+    Every batch result also gets compared against the scalar one.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/declarations.h>
+#include <nbl/core/math/morton.h>
+
+constexpr std::string_view NBL_COUNT_ARG = "--count";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+constexpr std::string_view NBL_SEED_ARG = "--seed";
+
+using namespace nbl;
+
+// median wall time of `repeats` runs of `f`
+template<typename F>
+static double timeMedian(const uint32_t repeats, F&& f)
+{
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+
+static void report(const char* name, const uint32_t bits, const size_t count, const double scalarMs, const double batchMs, const bool match)
+{
+    std::cout << std::left << std::setw(20) << name << std::right << std::setw(6) << bits
+        << std::setw(14) << std::fixed << std::setprecision(2) << count/(scalarMs*1000.0) << std::setw(14) << count/(batchMs*1000.0)
+        << std::setw(10) << scalarMs/batchMs << std::setw(10) << (match ? "yes":"NO") << std::endl;
+}
+
+template<typename T>
+static bool benchmark(const size_t count, const uint32_t repeats, const uint32_t seed)
+{
+    std::array<std::vector<T>,4> coords;
+    std::array<std::vector<T>,3> decoded, decodedScalar;
+    std::vector<T> codes(count), codesScalar(count);
+    {
+        std::mt19937_64 generator(seed);
+        for (uint32_t axis=0u; axis<4u; axis++)
+        {
+            coords[axis].resize(count);
+            for (auto& coord : coords[axis])
+                coord = static_cast<T>(generator());
+        }
+        for (uint32_t axis=0u; axis<3u; axis++)
+        {
+            decoded[axis].resize(count);
+            decodedScalar[axis].resize(count);
+        }
+    }
+    // keep only as many bits as fit a `D` dimensional code
+    auto fitCoords = [&](const uint32_t D) -> void
+    {
+        const T mask = (T(0x1u)<<T(sizeof(T)*8u/D))-T(0x1u);
+        for (auto& axis : coords)
+        for (auto& coord : axis)
+            coord &= mask;
+    };
+    constexpr uint32_t Bits = sizeof(T)*8u;
+    const auto& x = coords[0];
+    const auto& y = coords[1];
+    const auto& z = coords[2];
+    const auto& w = coords[3];
+
+    bool allMatch = true;
+    auto compare = [&](const char* name, const double scalarMs, const double batchMs) -> void
+    {
+        const bool match = codes==codesScalar;
+        report(name,Bits,count,scalarMs,batchMs,match);
+        allMatch = allMatch && match;
+    };
+
+    fitCoords(2u);
+    compare("morton2d_encode",timeMedian(repeats,[&]() -> void
+    {
+        for (size_t i=0u; i<count; i++)
+            codesScalar[i] = core::morton2d_encode<T>(x[i],y[i]);
+    }),timeMedian(repeats,[&]() -> void
+    {
+        core::morton2d_encode(std::span<const T>(x),std::span<const T>(y),std::span<T>(codes));
+    }));
+
+    fitCoords(3u);
+    compare("morton3d_encode",timeMedian(repeats,[&]() -> void
+    {
+        for (size_t i=0u; i<count; i++)
+            codesScalar[i] = core::morton3d_encode<T>(x[i],y[i],z[i]);
+    }),timeMedian(repeats,[&]() -> void
+    {
+        core::morton3d_encode(std::span<const T>(x),std::span<const T>(y),std::span<const T>(z),std::span<T>(codes));
+    }));
+    {
+        const double scalarMs = timeMedian(repeats,[&]() -> void
+        {
+            for (size_t i=0u; i<count; i++)
+            {
+                decodedScalar[0][i] = core::morton3d_decode_x<T>(codes[i]);
+                decodedScalar[1][i] = core::morton3d_decode_y<T>(codes[i]);
+                decodedScalar[2][i] = core::morton3d_decode_z<T>(codes[i]);
+            }
+        });
+        const double batchMs = timeMedian(repeats,[&]() -> void
+        {
+            core::morton3d_decode(std::span<const T>(codes),std::span<T>(decoded[0]),std::span<T>(decoded[1]),std::span<T>(decoded[2]));
+        });
+        const bool match = decoded==decodedScalar && std::equal(x.begin(),x.end(),decoded[0].begin());
+        report("morton3d_decode",Bits,count,scalarMs,batchMs,match);
+        allMatch = allMatch && match;
+    }
+
+    fitCoords(4u);
+    compare("morton4d_encode",timeMedian(repeats,[&]() -> void
+    {
+        for (size_t i=0u; i<count; i++)
+            codesScalar[i] = core::morton4d_encode<T>(x[i],y[i],z[i],w[i]);
+    }),timeMedian(repeats,[&]() -> void
+    {
+        core::morton4d_encode(std::span<const T>(x),std::span<const T>(y),std::span<const T>(z),std::span<const T>(w),std::span<T>(codes));
+    }));
+    return allMatch;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks the batch morton encoders and decoder against the scalar ones");
+
+    program.add_argument(NBL_COUNT_ARG.data())
+        .default_value(uint64_t(1ull<<24ull))
+        .scan<'u', uint64_t>()
+        .help("Number of codes to encode and decode");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(5u)
+        .scan<'u', uint32_t>()
+        .help("Number of runs per function, the median gets reported");
+
+    program.add_argument(NBL_SEED_ARG.data())
+        .default_value(0x45u)
+        .scan<'u', uint32_t>()
+        .help("Seed of the random coordinates");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const size_t count = std::max<uint64_t>(program.get<uint64_t>(NBL_COUNT_ARG.data()),1ull);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+    const uint32_t seed = program.get<uint32_t>(NBL_SEED_ARG.data());
+
+    std::cout << std::left << std::setw(20) << "function" << std::right << std::setw(6) << "bits"
+        << std::setw(14) << "scalar Mc/s" << std::setw(14) << "batch Mc/s" << std::setw(10) << "speedup" << std::setw(10) << "match" << std::endl;
+    bool match = benchmark<uint32_t>(count,repeats,seed);
+    match = benchmark<uint64_t>(count,repeats,seed) && match;
+
+    if (!match)
+    {
+        std::cerr << "A batch function didn't match the scalar one!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Load time of large synthetic OBJ files through `COBJMeshFileLoader`, and a check that its parallel parse matches the single threaded one
+/*
+    Generates a `--grid` by `--grid` vertex height field with positions, UVs and normals, split into two groups of quads which reference
+    their corners with absolute indices on even rows and negative (relative) ones on odd rows. It gets loaded `--repeats` times from memory
+    through `IAssetManager` with "\n", "\r\n" and "\r" line endings.
+    Files under the loader's 1 MiB chunk size get parsed by a single chunk. For the check a `--check-grid` height field small enough for
+    that gets loaded once as it is, and once more with comment lines of random length interleaved, which pushes it over many chunks without
+    changing the geometry, so the chunk boundaries land all over the statements. Every line ending must give identical meshbuffers.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <argparse/argparse.hpp>
+#include "nabla.h"
+#include "nbl/system/IApplicationFramework.h"
+
+constexpr std::string_view NBL_GRID_ARG = "--grid";
+constexpr std::string_view NBL_CHECK_GRID_ARG = "--check-grid";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+
+using namespace nbl;
+
+struct SLineEnding
+{
+    const char* name;
+    const char* chars;
+};
+constexpr SLineEnding LineEndings[] = {{"\\n","\n"},{"\\r\\n","\r\n"},{"\\r","\r"}};
+
+// `paddingMean` is the average length of the comment line following every statement, 0 for none
+static std::string makeOBJ(const uint32_t grid, const char* lineEnding, const uint32_t paddingMean, const uint32_t seed)
+{
+    std::mt19937 generator(seed);
+    std::string obj;
+    char line[256];
+    auto statement = [&](const int length) -> void
+    {
+        obj.append(line,length);
+        obj += lineEnding;
+        if (!paddingMean)
+            return;
+        obj += "# ";
+        obj.append(generator()%(paddingMean*2u),'x');
+        obj += lineEnding;
+    };
+
+    for (uint32_t y=0u; y<grid; y++)
+    for (uint32_t x=0u; x<grid; x++)
+    {
+        const float u = float(x)/float(grid);
+        const float v = float(y)/float(grid);
+        const float height = std::sin(u*17.f)*std::cos(v*13.f)*0.25f;
+        statement(snprintf(line,sizeof(line),"v %f %f %f",u,height,v));
+        statement(snprintf(line,sizeof(line),"vt %f %f",u,v));
+        statement(snprintf(line,sizeof(line),"vn %f %f %f",-height,1.f,height*0.5f));
+    }
+
+    const uint32_t vertexCount = grid*grid;
+    for (uint32_t y=0u; y+1u<grid; y++)
+    {
+        if (y==0u || y==grid/2u)
+            statement(snprintf(line,sizeof(line),"g part%u",y ? 1u:0u));
+        for (uint32_t x=0u; x+1u<grid; x++)
+        {
+            const uint32_t corners[4] = {y*grid+x,y*grid+x+1u,(y+1u)*grid+x+1u,(y+1u)*grid+x};
+            int length = snprintf(line,sizeof(line),"f");
+            for (const uint32_t corner : corners)
+            {
+                // all vertices got declared before the faces, so -1 is the last one
+                const int64_t index = y&0x1u ? int64_t(corner)-int64_t(vertexCount):int64_t(corner)+1;
+                length += snprintf(line+length,sizeof(line)-length," %lld/%lld/%lld",static_cast<long long>(index),static_cast<long long>(index),static_cast<long long>(index));
+            }
+            statement(length);
+        }
+    }
+    return obj;
+}
+
+static core::smart_refctd_ptr<asset::ICPUMesh> loadOBJ(asset::IAssetManager* assetManager, std::string& contents, const std::string& name)
+{
+    // a view of memory is a mapped file to the loader
+    auto file = core::make_smart_refctd_ptr<system::CFileView<system::CNullAllocator>>(system::path(name),system::IFile::ECF_READ,system::IFile::time_point_t(),contents.data(),contents.size());
+    // nothing may come out of the cache, every load has to parse
+    asset::IAssetLoader::SAssetLoadParams params;
+    params.cacheFlags = asset::IAssetLoader::ECF_DONT_CACHE_REFERENCES;
+    const auto bundle = assetManager->getAsset(file.get(),name,params);
+    const auto assets = bundle.getContents();
+    if (assets.empty())
+        return nullptr;
+    return core::smart_refctd_ptr_static_cast<asset::ICPUMesh>(assets[0]);
+}
+
+static bool sameContents(const asset::ICPUBuffer* a, const asset::ICPUBuffer* b)
+{
+    if (!a || !b)
+        return a==b;
+    return a->getSize()==b->getSize() && memcmp(a->getPointer(),b->getPointer(),a->getSize())==0;
+}
+
+static bool sameMeshBuffers(const asset::ICPUMesh* a, const asset::ICPUMesh* b)
+{
+    if (!a || !b)
+        return false;
+    const auto aMeshBuffers = a->getMeshBuffers();
+    const auto bMeshBuffers = b->getMeshBuffers();
+    if (aMeshBuffers.size()!=bMeshBuffers.size())
+        return false;
+    for (size_t i=0ull; i<aMeshBuffers.size(); i++)
+    {
+        const asset::ICPUMeshBuffer* aMB = aMeshBuffers.begin()[i];
+        const asset::ICPUMeshBuffer* bMB = bMeshBuffers.begin()[i];
+        if (aMB->getIndexCount()!=bMB->getIndexCount() || aMB->getIndexType()!=bMB->getIndexType() || aMB->getBaseVertex()!=bMB->getBaseVertex())
+            return false;
+        const auto& aIndices = aMB->getIndexBufferBinding();
+        const auto& bIndices = bMB->getIndexBufferBinding();
+        if (aIndices.offset!=bIndices.offset || !sameContents(aIndices.buffer.get(),bIndices.buffer.get()))
+            return false;
+        for (uint32_t binding=0u; binding<asset::ICPUMeshBuffer::MAX_ATTR_BUF_BINDING_COUNT; binding++)
+        {
+            const auto& aVertices = aMB->getVertexBufferBindings()[binding];
+            const auto& bVertices = bMB->getVertexBufferBindings()[binding];
+            if (aVertices.offset!=bVertices.offset || !sameContents(aVertices.buffer.get(),bVertices.buffer.get()))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks loading large OBJ files and checks the parallel parse against the single threaded one");
+
+    program.add_argument(NBL_GRID_ARG.data())
+        .default_value(1024u)
+        .scan<'u', uint32_t>()
+        .help("Vertices along each side of the benchmarked height field, 0 only runs the check");
+
+    program.add_argument(NBL_CHECK_GRID_ARG.data())
+        .default_value(64u)
+        .scan<'u', uint32_t>()
+        .help("Vertices along each side of the checked height field, has to stay under 1 MiB of OBJ");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(3u)
+        .scan<'u', uint32_t>()
+        .help("Number of loads per line ending, the median gets reported");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t grid = program.get<uint32_t>(NBL_GRID_ARG.data());
+    const uint32_t checkGrid = std::max(program.get<uint32_t>(NBL_CHECK_GRID_ARG.data()),2u);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+
+    #ifdef _NBL_PLATFORM_LINUX_
+        // `IApplicationFramework::createSystem` has no Linux branch
+        core::smart_refctd_ptr<system::ISystem> system = core::make_smart_refctd_ptr<system::CSystemLinux>();
+    #else
+        core::smart_refctd_ptr<system::ISystem> system = system::IApplicationFramework::createSystem();
+    #endif
+    if (!system)
+    {
+        std::cerr << "Could not create the system!" << std::endl;
+        return 1;
+    }
+    auto assetManager = core::make_smart_refctd_ptr<asset::IAssetManager>(core::smart_refctd_ptr(system));
+
+    // the sequential reference is always the "\n" file, the others have to match it
+    bool match = true;
+    {
+        std::string reference = makeOBJ(checkGrid,"\n",0u,0u);
+        const auto referenceMesh = loadOBJ(assetManager.get(),reference,"check_reference.obj");
+        // make every chunk about 1 MiB and have at least a few dozen of them, a chunk may not be much smaller than that
+        const uint32_t statements = checkGrid*checkGrid*4u;
+        const uint32_t paddingMean = std::max<uint32_t>((48u<<20u)/statements,1u);
+        std::cout << std::left << std::setw(10) << "endings" << std::setw(12) << "parse" << std::right << std::setw(12) << "MiB" << std::setw(10) << "match" << std::endl;
+        for (const auto& ending : LineEndings)
+        for (const uint32_t padding : {0u,paddingMean})
+        {
+            std::string obj = makeOBJ(checkGrid,ending.chars,padding,0x45u);
+            const auto mesh = loadOBJ(assetManager.get(),obj,std::string("check_")+(padding ? "padded":"plain")+std::to_string(&ending-LineEndings)+".obj");
+            const bool same = referenceMesh && sameMeshBuffers(referenceMesh.get(),mesh.get());
+            std::cout << std::left << std::setw(10) << ending.name << std::setw(12) << (padding ? "chunked":"sequential") << std::right
+                << std::setw(12) << std::fixed << std::setprecision(2) << obj.size()/double(0x1u<<20u) << std::setw(10) << (same ? "yes":"NO") << std::endl;
+            match = match && same;
+        }
+    }
+    if (!match)
+    {
+        std::cerr << "The chunked parse gave different meshbuffers than the sequential one!" << std::endl;
+        return 1;
+    }
+
+    if (grid<2u)
+        return 0;
+    std::cout << std::endl << std::left << std::setw(10) << "endings" << std::right << std::setw(12) << "MiB" << std::setw(12) << "median ms" << std::setw(10) << "MiB/s" << std::endl;
+    uint32_t load = 0u;
+    for (const auto& ending : LineEndings)
+    {
+        std::string obj = makeOBJ(grid,ending.chars,0u,0u);
+        std::vector<double> times;
+        for (uint32_t r=0u; r<repeats; r++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const auto mesh = loadOBJ(assetManager.get(),obj,"benchmark"+std::to_string(load++)+".obj");
+            times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+            if (!mesh)
+            {
+                std::cerr << "Could not load the " << ending.name << " OBJ!" << std::endl;
+                return 1;
+            }
+        }
+        std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+        const double megabytes = obj.size()/double(0x1u<<20u);
+        std::cout << std::left << std::setw(10) << ending.name << std::right << std::setw(12) << std::fixed << std::setprecision(2) << megabytes
+            << std::setw(12) << times[times.size()/2u] << std::setw(10) << megabytes/times[times.size()/2u]*1000.0 << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Stress test of the sharded concurrent object caches against the ones with a single lock, set up like the caches of `IAssetManager`
+/*
+    The caches start out with `--keys` entries. Every thread then looks up random keys, and `--write-percent` of the time inserts an object
+    of its own instead, removing its oldest one once it has `--window` of them, like parallel loaders adding to and evicting from the asset
+    cache. The thread count doubles from 1 up to `--threads`. After every run all the objects the threads inserted must be gone again
+    and the initial ones still there.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <string>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/declarations.h>
+
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+constexpr std::string_view NBL_OPS_ARG = "--ops";
+constexpr std::string_view NBL_KEYS_ARG = "--keys";
+constexpr std::string_view NBL_WRITE_PERCENT_ARG = "--write-percent";
+constexpr std::string_view NBL_WINDOW_ARG = "--window";
+
+using namespace nbl;
+
+// the asset cache maps paths to bundles, the CPU to GPU cache maps asset pointers to objects
+static std::string makeKey(const uint64_t i, std::string*)
+{
+    return "media/models/scene"+std::to_string(i%64u)+"/mesh"+std::to_string(i)+".obj";
+}
+static const void* makeKey(const uint64_t i, const void**)
+{
+    return reinterpret_cast<const void*>(uintptr_t((i+1u)*64u));
+}
+
+// the caches hold pointers (`IAssetManager`'s hold smart pointers), the vector based unique cache relies on it
+using object_t = const void*;
+static object_t makeObject(const uint64_t i)
+{
+    return reinterpret_cast<object_t>(uintptr_t(i));
+}
+
+struct SResult
+{
+    double seconds = 0.0;
+    bool consistent = true;
+};
+
+template<class Cache>
+static SResult run(const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t keyCount, const uint32_t writePercentage, const uint32_t window)
+{
+    using key_t = std::remove_cv_t<typename Cache::KeyType>;
+    auto key = [](const uint64_t i) -> key_t {return makeKey(i,static_cast<key_t*>(nullptr));};
+    // precompute the keys so the timing is of the cache and not of `std::to_string`
+    std::vector<key_t> keys;
+    for (uint64_t i=0u; i<keyCount; i++)
+        keys.push_back(key(i));
+
+    Cache cache;
+    for (uint32_t i=0u; i<keyCount; i++)
+        cache.insert(keys[i],makeObject(i));
+
+    std::atomic_uint32_t ready = 0u;
+    std::atomic_bool go = false;
+    std::atomic_bool consistent = true;
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&,t]() -> void
+        {
+            std::mt19937 generator(t);
+            // a thread's own objects go under keys nobody else uses, so that a unique cache never refuses them
+            std::vector<key_t> ownKeys;
+            for (uint32_t i=0u; i<window; i++)
+                ownKeys.push_back(key(keyCount+uint64_t(t)*window+i));
+            std::deque<std::pair<uint32_t,object_t>> inserted;
+            uint64_t nextObject = (uint64_t(t)+1u)<<32u;
+            uint32_t nextKey = 0u;
+            object_t found[4];
+            bool threadConsistent = true;
+
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (uint64_t op=0ull; op<opsPerThread; op++)
+            {
+                if (generator()%100u>=writePercentage)
+                {
+                    const uint32_t k = generator()%keyCount;
+                    size_t storageSize = sizeof(found)/sizeof(found[0]);
+                    cache.findAndStoreRange(keys[k],storageSize,found);
+                    // the initial objects never get removed
+                    threadConsistent = threadConsistent && std::find(found,found+storageSize,makeObject(k))!=found+storageSize;
+                    continue;
+                }
+                if (inserted.size()==window)
+                {
+                    const auto oldest = inserted.front();
+                    inserted.pop_front();
+                    threadConsistent = cache.removeObject(oldest.second,ownKeys[oldest.first]) && threadConsistent;
+                }
+                const object_t object = makeObject(nextObject++);
+                threadConsistent = cache.insert(ownKeys[nextKey],object) && threadConsistent;
+                inserted.emplace_back(nextKey,object);
+                nextKey = (nextKey+1u)%window;
+            }
+            for (const auto& object : inserted)
+                threadConsistent = cache.removeObject(object.second,ownKeys[object.first]) && threadConsistent;
+            if (!threadConsistent)
+                consistent = false;
+        });
+
+    while (ready.load()!=threadCount)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true,std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return {seconds,consistent && cache.getSize()==keyCount};
+}
+
+template<class Cache>
+static bool report(const char* name, const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t keyCount, const uint32_t writePercentage, const uint32_t window)
+{
+    const auto result = run<Cache>(threadCount,opsPerThread,keyCount,writePercentage,window);
+    const double mops = threadCount*opsPerThread/result.seconds*1e-6;
+    std::cout << std::setw(8) << threadCount << "  " << std::left << std::setw(40) << name << std::right
+        << std::setw(12) << std::fixed << std::setprecision(2) << mops << std::setw(12) << mops/threadCount << std::setw(12) << (result.consistent ? "yes":"NO") << std::endl;
+    return result.consistent;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Stress tests the sharded concurrent object caches against the single lock ones");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u))
+        .scan<'u', uint32_t>()
+        .help("Largest number of threads to run with");
+
+    program.add_argument(NBL_OPS_ARG.data())
+        .default_value(uint64_t(1000000ull))
+        .scan<'u', uint64_t>()
+        .help("Number of lookups and insertions every thread does");
+
+    program.add_argument(NBL_KEYS_ARG.data())
+        .default_value(16384u)
+        .scan<'u', uint32_t>()
+        .help("Number of entries the caches start out with");
+
+    program.add_argument(NBL_WRITE_PERCENT_ARG.data())
+        .default_value(10u)
+        .scan<'u', uint32_t>()
+        .help("Percentage of operations which insert instead of looking up");
+
+    program.add_argument(NBL_WINDOW_ARG.data())
+        .default_value(64u)
+        .scan<'u', uint32_t>()
+        .help("Number of its own objects a thread keeps in the cache");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t maxThreads = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+    const uint64_t opsPerThread = program.get<uint64_t>(NBL_OPS_ARG.data());
+    const uint32_t keyCount = std::max(program.get<uint32_t>(NBL_KEYS_ARG.data()),1u);
+    const uint32_t writePercentage = std::min(program.get<uint32_t>(NBL_WRITE_PERCENT_ARG.data()),100u);
+    const uint32_t window = std::max(program.get<uint32_t>(NBL_WINDOW_ARG.data()),1u);
+
+    std::cout << std::setw(8) << "threads" << "  " << std::left << std::setw(40) << "cache" << std::right
+        << std::setw(12) << "Mops/s" << std::setw(12) << "per thread" << std::setw(12) << "consistent" << std::endl;
+    bool consistent = true;
+    for (uint32_t threadCount=1u; ; threadCount=std::min(threadCount*2u,maxThreads))
+    {
+        consistent = report<core::CConcurrentMultiObjectCache<std::string,object_t,std::multimap>>("CConcurrentMultiObjectCache<multimap>",threadCount,opsPerThread,keyCount,writePercentage,window) && consistent;
+        consistent = report<core::CConcurrentHashMultiObjectCache<std::string,object_t>>("CConcurrentHashMultiObjectCache",threadCount,opsPerThread,keyCount,writePercentage,window) && consistent;
+        consistent = report<core::CConcurrentObjectCache<const void*,object_t>>("CConcurrentObjectCache<vector>",threadCount,opsPerThread,keyCount,writePercentage,window) && consistent;
+        consistent = report<core::CConcurrentHashObjectCache<const void*,object_t>>("CConcurrentHashObjectCache",threadCount,opsPerThread,keyCount,writePercentage,window) && consistent;
+        if (threadCount==maxThreads)
+            break;
+    }
+
+    if (!consistent)
+    {
+        std::cerr << "A cache lost or kept an object it shouldn't have!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
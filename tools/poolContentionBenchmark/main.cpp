@@ -0,0 +1,177 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Throughput of the thread-safe pool address allocators under contention, `PoolAddressAllocatorMT` against `LockFreePoolAddressAllocator`
+/*
+    Every thread keeps a window of live blocks and keeps replacing random ones of them, `--batch` at a time through `multi_free_addr`
+    and `multi_alloc_addr`. The thread count doubles from 1 up to `--threads`.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/declarations.h>
+#include <nbl/core/alloc/PoolAddressAllocator.h>
+#include <nbl/core/alloc/LockFreePoolAddressAllocator.h>
+
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+constexpr std::string_view NBL_OPS_ARG = "--ops";
+constexpr std::string_view NBL_WINDOW_ARG = "--window";
+constexpr std::string_view NBL_BATCH_ARG = "--batch";
+
+using namespace nbl;
+using size_type = uint32_t;
+
+constexpr size_type BlockSize = 64u;
+
+struct SResult
+{
+    double seconds = 0.0;
+    uint64_t failed = 0ull;
+};
+
+template<class AddressAllocator>
+static SResult run(const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t window, const uint32_t batch)
+{
+    using traits = core::address_allocator_traits<AddressAllocator>;
+    // room for every window plus a batch in flight per thread, and then some so the allocator never runs dry
+    const size_type bufferSize = BlockSize*(threadCount*(window+batch)*2u);
+    void* reserved = _NBL_ALIGNED_MALLOC(AddressAllocator::reserved_size(BlockSize,bufferSize,BlockSize),_NBL_SIMD_ALIGNMENT);
+    AddressAllocator alctr(reserved,0u,0u,BlockSize,bufferSize,BlockSize);
+
+    std::atomic_uint32_t ready = 0u;
+    std::atomic_bool go = false;
+    std::atomic_uint64_t failed = 0ull;
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&,t]() -> void
+        {
+            std::mt19937 generator(t);
+            const std::vector<size_type> sizes(window,BlockSize);
+            std::vector<size_type> live(window,AddressAllocator::invalid_address);
+            traits::multi_alloc_addr(alctr,window,live.data(),sizes.data(),BlockSize);
+            std::vector<uint32_t> slots(batch);
+            std::vector<size_type> addresses(batch);
+            uint64_t threadFailed = 0ull;
+
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (uint64_t op=0ull; op<opsPerThread; op+=batch)
+            {
+                for (uint32_t i=0u; i<batch; i++)
+                {
+                    slots[i] = generator()%window;
+                    addresses[i] = live[slots[i]];
+                    live[slots[i]] = AddressAllocator::invalid_address;
+                }
+                traits::multi_free_addr(alctr,batch,addresses.data(),sizes.data());
+                std::fill(addresses.begin(),addresses.end(),AddressAllocator::invalid_address);
+                traits::multi_alloc_addr(alctr,batch,addresses.data(),sizes.data(),BlockSize);
+                for (uint32_t i=0u; i<batch; i++)
+                {
+                    // the same slot could have been picked twice
+                    if (live[slots[i]]!=AddressAllocator::invalid_address)
+                        traits::multi_free_addr(alctr,1u,live.data()+slots[i],sizes.data());
+                    live[slots[i]] = addresses[i];
+                    if (addresses[i]==AddressAllocator::invalid_address)
+                        threadFailed++;
+                }
+            }
+            failed += threadFailed;
+            std::erase(live,AddressAllocator::invalid_address);
+            traits::multi_free_addr(alctr,static_cast<uint32_t>(live.size()),live.data(),sizes.data());
+        });
+
+    while (ready.load()!=threadCount)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true,std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    _NBL_ALIGNED_FREE(reserved);
+    return {seconds,failed};
+}
+
+template<class AddressAllocator>
+static void report(const char* name, const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t window, const uint32_t batch)
+{
+    const auto result = run<AddressAllocator>(threadCount,opsPerThread,window,batch);
+    // an op is a free and an alloc
+    const double mops = threadCount*opsPerThread/result.seconds*1e-6;
+    std::cout << std::setw(8) << threadCount << "  " << std::left << std::setw(40) << name << std::right
+        << std::setw(14) << std::fixed << std::setprecision(2) << mops << std::setw(14) << mops/threadCount << std::setw(10) << result.failed << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks the thread-safe pool address allocators under contention");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u))
+        .scan<'u', uint32_t>()
+        .help("Largest number of threads to run with");
+
+    program.add_argument(NBL_OPS_ARG.data())
+        .default_value(uint64_t(4000000ull))
+        .scan<'u', uint64_t>()
+        .help("Number of free+alloc pairs every thread does");
+
+    program.add_argument(NBL_WINDOW_ARG.data())
+        .default_value(256u)
+        .scan<'u', uint32_t>()
+        .help("Number of blocks every thread keeps allocated");
+
+    program.add_argument(NBL_BATCH_ARG.data())
+        .default_value(1u)
+        .scan<'u', uint32_t>()
+        .help("Number of blocks freed and allocated per call");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t maxThreads = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+    const uint64_t opsPerThread = program.get<uint64_t>(NBL_OPS_ARG.data());
+    const uint32_t window = std::max(program.get<uint32_t>(NBL_WINDOW_ARG.data()),1u);
+    const uint32_t batch = std::clamp(program.get<uint32_t>(NBL_BATCH_ARG.data()),1u,window);
+
+    std::cout << std::setw(8) << "threads" << "  " << std::left << std::setw(40) << "allocator" << std::right
+        << std::setw(14) << "Mops/s" << std::setw(14) << "per thread" << std::setw(10) << "failed" << std::endl;
+    for (uint32_t threadCount=1u; ; threadCount=std::min(threadCount*2u,maxThreads))
+    {
+        report<core::PoolAddressAllocatorMT<size_type,std::recursive_mutex>>("PoolAddressAllocatorMT<recursive_mutex>",threadCount,opsPerThread,window,batch);
+        report<core::LockFreePoolAddressAllocator<size_type>>("LockFreePoolAddressAllocator",threadCount,opsPerThread,window,batch);
+        report<core::LockFreePoolAddressAllocator<size_type,64u>>("LockFreePoolAddressAllocator<_,64>",threadCount,opsPerThread,window,batch);
+        if (threadCount==maxThreads)
+            break;
+    }
+    return 0;
+}
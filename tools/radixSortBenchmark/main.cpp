@@ -0,0 +1,149 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Throughput of `core::radix_sort` and `core::radix_sort_by_key` against `std::sort`, single and multi threaded, on uniformly random keys
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/algorithm/radix_sort.h>
+
+constexpr std::string_view NBL_MIN_KEYS_ARG = "--min-keys";
+constexpr std::string_view NBL_MAX_KEYS_ARG = "--max-keys";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+constexpr std::string_view NBL_SEED_ARG = "--seed";
+
+using namespace nbl;
+
+// median wall time of `repeats` runs of `sort`, which gets fresh unsorted keys every time and returns a pointer to the sorted range
+template<typename Key, typename Sort>
+static double timeSort(const std::vector<Key>& original, std::vector<Key>& keys, const uint32_t repeats, bool& sorted, Sort&& sort)
+{
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        keys = original;
+        const auto start = std::chrono::steady_clock::now();
+        const Key* result = sort(keys);
+        times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+        sorted = sorted && std::is_sorted(result,result+keys.size());
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+
+template<typename Key>
+static bool benchmark(const size_t keyCount, const uint32_t repeats, const uint32_t seed)
+{
+    std::vector<Key> original(keyCount);
+    {
+        std::mt19937_64 generator(seed);
+        for (auto& key : original)
+            key = static_cast<Key>(generator());
+    }
+    std::vector<Key> keys, scratch(keyCount);
+    std::vector<uint32_t> values(keyCount), valuesScratch(keyCount);
+
+    bool sorted = true;
+    auto report = [&](const char* name, const double ms) -> void
+    {
+        std::cout << std::setw(12) << keyCount << std::setw(8) << sizeof(Key)*8u << "  " << std::left << std::setw(30) << name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(2) << ms << std::setw(14) << keyCount/(ms*1000.0) << std::endl;
+    };
+    report("std::sort",timeSort(original,keys,repeats,sorted,[](std::vector<Key>& k) -> const Key*
+    {
+        std::sort(k.begin(),k.end());
+        return k.data();
+    }));
+    report("std::sort(par)",timeSort(original,keys,repeats,sorted,[](std::vector<Key>& k) -> const Key*
+    {
+        std::sort(core::execution::par,k.begin(),k.end());
+        return k.data();
+    }));
+    report("core::radix_sort",timeSort(original,keys,repeats,sorted,[&](std::vector<Key>& k) -> const Key*
+    {
+        return &*core::radix_sort(k.begin(),scratch.begin(),k.size());
+    }));
+    report("core::radix_sort(par)",timeSort(original,keys,repeats,sorted,[&](std::vector<Key>& k) -> const Key*
+    {
+        return &*core::radix_sort(core::execution::par,k.begin(),scratch.begin(),k.size());
+    }));
+    report("core::radix_sort_by_key(par)",timeSort(original,keys,repeats,sorted,[&](std::vector<Key>& k) -> const Key*
+    {
+        std::iota(values.begin(),values.end(),0u);
+        return &*core::radix_sort_by_key(core::execution::par,k.begin(),scratch.begin(),values.begin(),valuesScratch.begin(),k.size()).first;
+    }));
+    return sorted;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks core::radix_sort against std::sort");
+
+    program.add_argument(NBL_MIN_KEYS_ARG.data())
+        .default_value(uint64_t(1000000ull))
+        .scan<'u', uint64_t>()
+        .help("Smallest number of keys to sort, the key count goes up 10x at a time");
+
+    program.add_argument(NBL_MAX_KEYS_ARG.data())
+        .default_value(uint64_t(100000000ull))
+        .scan<'u', uint64_t>()
+        .help("Largest number of keys to sort, needs about 2.5x the keys' size in memory");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(5u)
+        .scan<'u', uint32_t>()
+        .help("Number of runs per sort, the median gets reported");
+
+    program.add_argument(NBL_SEED_ARG.data())
+        .default_value(0x45u)
+        .scan<'u', uint32_t>()
+        .help("Seed of the random keys");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint64_t minKeys = std::max<uint64_t>(program.get<uint64_t>(NBL_MIN_KEYS_ARG.data()),1ull);
+    const uint64_t maxKeys = program.get<uint64_t>(NBL_MAX_KEYS_ARG.data());
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+    const uint32_t seed = program.get<uint32_t>(NBL_SEED_ARG.data());
+
+    std::cout << std::setw(12) << "keys" << std::setw(8) << "bits" << "  " << std::left << std::setw(30) << "sort" << std::right
+        << std::setw(12) << "median ms" << std::setw(14) << "Mkeys/s" << std::endl;
+    bool sorted = true;
+    for (uint64_t keyCount=minKeys; keyCount<=maxKeys; keyCount*=10ull)
+    {
+        sorted = benchmark<uint32_t>(keyCount,repeats,seed) && sorted;
+        sorted = benchmark<uint64_t>(keyCount,repeats,seed) && sorted;
+    }
+
+    if (!sorted)
+    {
+        std::cerr << "A sort produced an unsorted range!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Throughput of `SReadWriteParkingLock` against `SReadWriteSpinLock` and `std::shared_mutex` under contention
+/*
+    Every thread keeps taking the lock, as a reader with the given percentage of probability and otherwise as a writer. Writers bump all
+    `--critical-section` counters of the shared state, readers check they all agree, which catches a lock letting
+    a reader in alongside a writer. The thread count doubles from 1 up to `--threads`, which defaults to twice the hardware threads so
+    the oversubscribed case where spinning waiters eat the lock holder's time slices gets measured too.
+    Before that every lock with upgradable guards gets checked for a reader upgrading to a writer while a second reader still holds the
+    lock for long enough that the upgrader parks, the second reader letting go must wake it.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <shared_mutex>
+#include <memory>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/system/SReadWriteSpinLock.h>
+
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+constexpr std::string_view NBL_OPS_ARG = "--ops";
+constexpr std::string_view NBL_CRITICAL_SECTION_ARG = "--critical-section";
+
+using namespace nbl;
+
+constexpr uint32_t ReadPercentages[] = {50u,90u,99u,100u};
+
+template<class Lock, typename F>
+static void readLocked(Lock& lock, F&& f)
+{
+    if constexpr (std::is_same_v<Lock,std::shared_mutex>)
+    {
+        std::shared_lock guard(lock);
+        f();
+    }
+    else
+    {
+        system::read_lock_guard<std::memory_order_seq_cst,std::memory_order_seq_cst,Lock> guard(lock);
+        f();
+    }
+}
+
+template<class Lock, typename F>
+static void writeLocked(Lock& lock, F&& f)
+{
+    if constexpr (std::is_same_v<Lock,std::shared_mutex>)
+    {
+        std::unique_lock guard(lock);
+        f();
+    }
+    else
+    {
+        system::write_lock_guard<std::memory_order_seq_cst,std::memory_order_seq_cst,Lock> guard(lock);
+        f();
+    }
+}
+
+struct SResult
+{
+    double seconds = 0.0;
+    uint64_t torn = 0ull;
+};
+
+template<class Lock>
+static SResult run(const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t readPercentage, const uint32_t criticalSection)
+{
+    Lock lock;
+    std::vector<uint64_t> counters(criticalSection,0ull);
+    // the counters are only ever touched under the lock, `volatile` keeps the reads and writes in the critical section
+    volatile uint64_t* const shared = counters.data();
+
+    std::atomic_uint32_t ready = 0u;
+    std::atomic_bool go = false;
+    std::atomic_uint64_t torn = 0ull;
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&,t]() -> void
+        {
+            std::mt19937 generator(t);
+            uint64_t threadTorn = 0ull;
+
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (uint64_t op=0ull; op<opsPerThread; op++)
+            {
+                if (generator()%100u<readPercentage)
+                    readLocked(lock,[&]() -> void
+                    {
+                        const uint64_t first = shared[0];
+                        for (uint32_t i=1u; i<criticalSection; i++)
+                        if (shared[i]!=first)
+                            threadTorn++;
+                    });
+                else
+                    writeLocked(lock,[&]() -> void
+                    {
+                        for (uint32_t i=0u; i<criticalSection; i++)
+                            shared[i] = shared[i]+1ull;
+                    });
+            }
+            torn += threadTorn;
+        });
+
+    while (ready.load()!=threadCount)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true,std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return {seconds,torn};
+}
+
+// returns whether the upgrade got through within a second of the other reader letting go
+template<class Lock>
+static bool upgradeWithTwoReaders()
+{
+    using read_guard_t = system::read_lock_guard<std::memory_order_seq_cst,std::memory_order_seq_cst,Lock>;
+    using write_guard_t = system::write_lock_guard<std::memory_order_seq_cst,std::memory_order_seq_cst,Lock>;
+    auto lock = std::make_unique<Lock>();
+    std::atomic_bool bothReading = false;
+    std::atomic_bool upgraded = false;
+
+    // the other reader
+    lock->lock_read();
+    std::thread upgrader([&]() -> void
+    {
+        read_guard_t reader(*lock);
+        bothReading = true;
+        write_guard_t writer(std::move(reader));
+        upgraded = true;
+    });
+    while (!bothReading.load())
+        std::this_thread::yield();
+    // long enough for the upgrader to run out of backoff spins and park
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (upgraded.load())
+    {
+        upgrader.join();
+        return false;
+    }
+    lock->unlock_read();
+    const auto deadline = std::chrono::steady_clock::now()+std::chrono::seconds(1);
+    while (!upgraded.load() && std::chrono::steady_clock::now()<deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (!upgraded.load())
+    {
+        // the upgrader is stuck in the lock for good, so neither of them may go away
+        upgrader.detach();
+        lock.release();
+        return false;
+    }
+    upgrader.join();
+    return true;
+}
+
+template<class Lock>
+static bool report(const char* name, const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t readPercentage, const uint32_t criticalSection)
+{
+    const auto result = run<Lock>(threadCount,opsPerThread,readPercentage,criticalSection);
+    const double mops = threadCount*opsPerThread/result.seconds*1e-6;
+    std::cout << std::setw(8) << threadCount << std::setw(8) << readPercentage << "  " << std::left << std::setw(24) << name << std::right
+        << std::setw(12) << std::fixed << std::setprecision(2) << mops << std::setw(12) << mops/threadCount << std::setw(8) << result.torn << std::endl;
+    return result.torn==0ull;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks SReadWriteParkingLock against SReadWriteSpinLock and std::shared_mutex");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u)*2u)
+        .scan<'u', uint32_t>()
+        .help("Largest number of threads to run with, more than the hardware threads measures oversubscription");
+
+    program.add_argument(NBL_OPS_ARG.data())
+        .default_value(uint64_t(1000000ull))
+        .scan<'u', uint64_t>()
+        .help("Number of times every thread takes the lock");
+
+    program.add_argument(NBL_CRITICAL_SECTION_ARG.data())
+        .default_value(16u)
+        .scan<'u', uint32_t>()
+        .help("Number of 64bit counters read or written while holding the lock");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t maxThreads = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+    const uint64_t opsPerThread = program.get<uint64_t>(NBL_OPS_ARG.data());
+    const uint32_t criticalSection = std::max(program.get<uint32_t>(NBL_CRITICAL_SECTION_ARG.data()),1u);
+
+    bool upgrades = upgradeWithTwoReaders<system::SReadWriteParkingLock>();
+    upgrades = upgradeWithTwoReaders<system::SReadWriteSpinLock>() && upgrades;
+    if (!upgrades)
+    {
+        std::cerr << "A read lock upgrade deadlocked or got in while another reader held the lock!" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(8) << "threads" << std::setw(8) << "read %" << "  " << std::left << std::setw(24) << "lock" << std::right
+        << std::setw(12) << "Mops/s" << std::setw(12) << "per thread" << std::setw(8) << "torn" << std::endl;
+    bool consistent = true;
+    for (const uint32_t readPercentage : ReadPercentages)
+    for (uint32_t threadCount=1u; ; threadCount=std::min(threadCount*2u,maxThreads))
+    {
+        consistent = report<system::SReadWriteParkingLock>("SReadWriteParkingLock",threadCount,opsPerThread,readPercentage,criticalSection) && consistent;
+        consistent = report<system::SReadWriteSpinLock>("SReadWriteSpinLock",threadCount,opsPerThread,readPercentage,criticalSection) && consistent;
+        consistent = report<std::shared_mutex>("std::shared_mutex",threadCount,opsPerThread,readPercentage,criticalSection) && consistent;
+        if (threadCount==maxThreads)
+            break;
+    }
+
+    if (!consistent)
+    {
+        std::cerr << "A reader saw a write in progress!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Throughput of `SobolSampler::sampleBatch` and `OwenSampler::sampleBatch` against loops over their `sample`
+/*
+    Fills a `--samples` by `--dims` table starting at sample `--first-sample`, the scalar loops go one dimension at a time because that's
+    the only order in which `OwenSampler::sample` doesn't rebuild its tree all the time. The batches run sequentially and with a parallel
+    policy, and every table gets compared against the scalar one.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/declarations.h>
+
+constexpr std::string_view NBL_SAMPLES_ARG = "--samples";
+constexpr std::string_view NBL_FIRST_SAMPLE_ARG = "--first-sample";
+constexpr std::string_view NBL_DIMS_ARG = "--dims";
+constexpr std::string_view NBL_REPEATS_ARG = "--repeats";
+constexpr std::string_view NBL_SEED_ARG = "--seed";
+
+using namespace nbl;
+
+// median wall time of `repeats` runs of `f`
+template<typename F>
+static double timeMedian(const uint32_t repeats, F&& f)
+{
+    std::vector<double> times;
+    for (uint32_t r=0u; r<repeats; r++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        times.push_back(std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+    std::nth_element(times.begin(),times.begin()+times.size()/2u,times.end());
+    return times[times.size()/2u];
+}
+
+static void report(const char* name, const char* policy, const size_t count, const double scalarMs, const double batchMs, const bool match)
+{
+    std::cout << std::left << std::setw(14) << name << std::setw(8) << policy << std::right
+        << std::setw(14) << std::fixed << std::setprecision(2) << count/(scalarMs*1000.0) << std::setw(14) << count/(batchMs*1000.0)
+        << std::setw(10) << scalarMs/batchMs << std::setw(10) << (match ? "yes":"NO") << std::endl;
+}
+
+// `Sampler` has to be mutable for `OwenSampler::sample`
+template<class Sampler>
+static bool benchmark(const char* name, Sampler& sampler, const uint32_t firstSample, const uint32_t sampleCount, const uint32_t dimCount, const uint32_t repeats)
+{
+    const size_t count = size_t(sampleCount)*dimCount;
+    std::vector<uint32_t> scalar(count), batch(count);
+    const double scalarMs = timeMedian(repeats,[&]() -> void
+    {
+        for (uint32_t d=0u; d<dimCount; d++)
+        for (uint32_t s=0u; s<sampleCount; s++)
+            scalar[size_t(s)*dimCount+d] = sampler.sample(d,firstSample+s);
+    });
+
+    bool allMatch = true;
+    auto compare = [&](const char* policy, const double batchMs) -> void
+    {
+        const bool match = batch==scalar;
+        report(name,policy,count,scalarMs,batchMs,match);
+        allMatch = allMatch && match;
+        std::fill(batch.begin(),batch.end(),0u);
+    };
+    compare("seq",timeMedian(repeats,[&]() -> void
+    {
+        sampler.sampleBatch(batch.data(),firstSample,sampleCount,0u,dimCount);
+    }));
+    compare("par",timeMedian(repeats,[&]() -> void
+    {
+        sampler.sampleBatch(core::execution::par,batch.data(),firstSample,sampleCount,0u,dimCount);
+    }));
+    return allMatch;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks the batch Sobol and Owen samplers against the scalar ones");
+
+    program.add_argument(NBL_SAMPLES_ARG.data())
+        .default_value(1u<<20u)
+        .scan<'u', uint32_t>()
+        .help("Number of samples per dimension");
+
+    program.add_argument(NBL_FIRST_SAMPLE_ARG.data())
+        .default_value(0u)
+        .scan<'u', uint32_t>()
+        .help("Index of the first sample, an odd one leaves a partial batch at either end");
+
+    program.add_argument(NBL_DIMS_ARG.data())
+        .default_value(16u)
+        .scan<'u', uint32_t>()
+        .help("Number of dimensions");
+
+    program.add_argument(NBL_REPEATS_ARG.data())
+        .default_value(3u)
+        .scan<'u', uint32_t>()
+        .help("Number of runs per sampler, the median gets reported");
+
+    program.add_argument(NBL_SEED_ARG.data())
+        .default_value(0x45u)
+        .scan<'u', uint32_t>()
+        .help("Seed of the Owen scrambling");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    // `OwenSampler`'s tree covers this many, it keeps the constant to itself
+    constexpr uint32_t MaxSamples = 0x1u<<24u;
+    const uint32_t firstSample = std::min(program.get<uint32_t>(NBL_FIRST_SAMPLE_ARG.data()),MaxSamples-1u);
+    const uint32_t sampleCount = std::clamp(program.get<uint32_t>(NBL_SAMPLES_ARG.data()),1u,MaxSamples-firstSample);
+    const uint32_t dimCount = std::max(program.get<uint32_t>(NBL_DIMS_ARG.data()),1u);
+    const uint32_t repeats = std::max(program.get<uint32_t>(NBL_REPEATS_ARG.data()),1u);
+    const uint32_t seed = program.get<uint32_t>(NBL_SEED_ARG.data());
+
+    std::cout << std::left << std::setw(14) << "sampler" << std::setw(8) << "policy" << std::right
+        << std::setw(14) << "scalar Ms/s" << std::setw(14) << "batch Ms/s" << std::setw(10) << "speedup" << std::setw(10) << "match" << std::endl;
+    core::SobolSampler sobol(dimCount);
+    bool match = benchmark("SobolSampler",sobol,firstSample,sampleCount,dimCount,repeats);
+    core::OwenSampler<> owen(dimCount,seed);
+    match = benchmark("OwenSampler",owen,firstSample,sampleCount,dimCount,repeats) && match;
+
+    if (!match)
+    {
+        std::cerr << "A batch sampler didn't match the scalar one!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
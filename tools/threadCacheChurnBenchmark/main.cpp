@@ -0,0 +1,182 @@
+/*
+# Copyright(c) 2024 DevSH Graphics Programming Sp.z O.O.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissionsand
+# limitations under the License.
+*/
+
+// Small object churn throughput of `CThreadCachedMemoryPool` against the locked `CMemoryPool` it puts the thread caches in front of
+/*
+    Both pools are set up like the deferred operation pool of `CVulkanLogicalDevice`, a `PoolAddressAllocator` with `--object-size` blocks.
+    Every thread keeps a window of live objects of random sizes up to `--object-size` in steps of 8 bytes and keeps replacing random ones
+    of them. The thread count doubles from 1 up to `--threads`, the thread cache statistics show how many allocations stayed off the lock.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <nbl/core/declarations.h>
+#include <nbl/core/alloc/PoolAddressAllocator.h>
+#include <nbl/core/containers/CMemoryPool.h>
+
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+constexpr std::string_view NBL_OPS_ARG = "--ops";
+constexpr std::string_view NBL_WINDOW_ARG = "--window";
+constexpr std::string_view NBL_OBJECT_SIZE_ARG = "--object-size";
+
+using namespace nbl;
+
+using locked_pool_t = core::CMemoryPool<core::PoolAddressAllocator<uint32_t>,core::default_aligned_allocator,true,uint32_t>;
+using cached_pool_t = core::CThreadCachedMemoryPool<core::PoolAddressAllocator<uint32_t>,core::default_aligned_allocator,uint32_t>;
+
+constexpr uint32_t SizeGranularity = 8u;
+constexpr uint32_t PoolBlockSize = 1u<<20u;
+
+struct SResult
+{
+    double seconds = 0.0;
+    uint64_t failed = 0ull;
+};
+
+template<class Pool>
+static SResult run(Pool& pool, const uint32_t threadCount, const uint64_t opsPerThread, const uint32_t window, const uint32_t objectSize)
+{
+    std::atomic_uint32_t ready = 0u;
+    std::atomic_bool go = false;
+    std::atomic_uint64_t failed = 0ull;
+    std::vector<std::thread> threads;
+    for (uint32_t t=0u; t<threadCount; t++)
+        threads.emplace_back([&,t]() -> void
+        {
+            std::mt19937 generator(t);
+            std::uniform_int_distribution<uint32_t> sizeDist(1u,objectSize/SizeGranularity);
+            std::vector<void*> live(window);
+            std::vector<uint32_t> sizes(window);
+            for (uint32_t i=0u; i<window; i++)
+            {
+                sizes[i] = sizeDist(generator)*SizeGranularity;
+                live[i] = pool.allocate(sizes[i],SizeGranularity);
+            }
+            uint64_t threadFailed = 0ull;
+
+            ready++;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (uint64_t op=0ull; op<opsPerThread; op++)
+            {
+                const uint32_t slot = generator()%window;
+                if (live[slot])
+                    pool.deallocate(live[slot],sizes[slot]);
+                sizes[slot] = sizeDist(generator)*SizeGranularity;
+                live[slot] = pool.allocate(sizes[slot],SizeGranularity);
+                if (!live[slot])
+                    threadFailed++;
+            }
+            failed += threadFailed;
+            for (uint32_t i=0u; i<window; i++)
+            if (live[i])
+                pool.deallocate(live[i],sizes[i]);
+        });
+
+    while (ready.load()!=threadCount)
+        std::this_thread::yield();
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true,std::memory_order_release);
+    for (auto& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return {seconds,failed};
+}
+
+static void report(const char* name, const uint32_t threadCount, const uint64_t opsPerThread, const SResult& result, const cached_pool_t::statistics_t* stats=nullptr)
+{
+    // an op is a deallocate and an allocate
+    const double mops = threadCount*opsPerThread/result.seconds*1e-6;
+    std::cout << std::setw(8) << threadCount << "  " << std::left << std::setw(26) << name << std::right
+        << std::setw(12) << std::fixed << std::setprecision(2) << mops << std::setw(12) << mops/threadCount << std::setw(10) << result.failed;
+    if (stats)
+    {
+        const uint64_t allocations = stats->hits+stats->refills;
+        std::cout << std::setw(10) << std::setprecision(1) << (allocations ? 100.0*stats->hits/allocations:0.0) << std::setw(12) << stats->bypasses
+            << std::setw(14) << stats->blocksRefilled << std::setw(14) << stats->blocksReturned;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    argparse::ArgumentParser program("Benchmarks small object churn on CThreadCachedMemoryPool against the locked CMemoryPool");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(std::max(std::thread::hardware_concurrency(),1u))
+        .scan<'u', uint32_t>()
+        .help("Largest number of threads to run with");
+
+    program.add_argument(NBL_OPS_ARG.data())
+        .default_value(uint64_t(4000000ull))
+        .scan<'u', uint64_t>()
+        .help("Number of deallocate+allocate pairs every thread does");
+
+    program.add_argument(NBL_WINDOW_ARG.data())
+        .default_value(1024u)
+        .scan<'u', uint32_t>()
+        .help("Number of objects every thread keeps alive");
+
+    program.add_argument(NBL_OBJECT_SIZE_ARG.data())
+        .default_value(64u)
+        .scan<'u', uint32_t>()
+        .help("Largest object size and the pool's block size, gets rounded up to a multiple of 8");
+
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << std::endl << program;
+        return 1;
+    }
+
+    const uint32_t maxThreads = std::max(program.get<uint32_t>(NBL_THREADS_ARG.data()),1u);
+    const uint64_t opsPerThread = program.get<uint64_t>(NBL_OPS_ARG.data());
+    const uint32_t window = std::max(program.get<uint32_t>(NBL_WINDOW_ARG.data()),1u);
+    const uint32_t objectSize = core::alignUp(std::max(program.get<uint32_t>(NBL_OBJECT_SIZE_ARG.data()),1u),SizeGranularity);
+
+    std::cout << std::setw(8) << "threads" << "  " << std::left << std::setw(26) << "pool" << std::right
+        << std::setw(12) << "Mops/s" << std::setw(12) << "per thread" << std::setw(10) << "failed"
+        << std::setw(10) << "hit %" << std::setw(12) << "bypasses" << std::setw(14) << "refilled" << std::setw(14) << "returned" << std::endl;
+    for (uint32_t threadCount=1u; ; threadCount=std::min(threadCount*2u,maxThreads))
+    {
+        // the windows, plus whatever the thread caches can hold on to in their 8 default bins
+        const uint64_t worstCaseBytes = uint64_t(threadCount)*(window+cached_pool_t::allocator_type::MaxBinLength*8u)*objectSize;
+        const uint32_t maxBlocks = static_cast<uint32_t>(worstCaseBytes/PoolBlockSize)+2u;
+        {
+            locked_pool_t pool(PoolBlockSize,1u,maxBlocks,objectSize);
+            report("CMemoryPool<_,_,true>",threadCount,opsPerThread,run(pool,threadCount,opsPerThread,window,objectSize));
+        }
+        {
+            cached_pool_t pool(PoolBlockSize,1u,maxBlocks,objectSize);
+            const auto result = run(pool,threadCount,opsPerThread,window,objectSize);
+            pool.flushThreadCaches();
+            const auto stats = pool.getStatistics();
+            report("CThreadCachedMemoryPool",threadCount,opsPerThread,result,&stats);
+        }
+        if (threadCount==maxThreads)
+            break;
+    }
+    return 0;
+}
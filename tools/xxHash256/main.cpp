@@ -17,56 +17,239 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <optional>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 #include <argparse/argparse.hpp>
 #include <nbl/core/xxHash256.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 constexpr std::string_view NBL_FILE_ARG = "--file";
+constexpr std::string_view NBL_DIRECTORY_ARG = "--directory";
+constexpr std::string_view NBL_THREADS_ARG = "--threads";
+
+using hash_t = std::array<uint64_t, 4>;
+
+// read-only view of a whole file, we DO NOT want to link Nabla just for its `ISystem`
+class MappedFile
+{
+public:
+    MappedFile(const std::filesystem::path& filePath)
+    {
+#ifdef _WIN32
+        m_file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+            return;
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping)
+            return;
+        m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_data)
+            m_size = size.QuadPart;
+#else
+        m_file = open(filePath.c_str(), O_RDONLY);
+        if (m_file < 0)
+            return;
+        const auto size = lseek(m_file, 0, SEEK_END);
+        if (size <= 0)
+            return;
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, m_file, 0);
+        if (data == MAP_FAILED)
+            return;
+        // we go through it once front to back
+        madvise(data, size, MADV_SEQUENTIAL);
+        m_data = data;
+        m_size = size;
+#endif
+    }
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+#else
+        if (m_data)
+            munmap(m_data, m_size);
+        if (m_file >= 0)
+            close(m_file);
+#endif
+    }
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(m_data); }
+    size_t size() const { return m_size; }
+
+private:
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+static std::optional<hash_t> hashFile(const std::filesystem::path& filePath)
+{
+    std::error_code error;
+    const auto fileSize = std::filesystem::file_size(filePath, error);
+    if (error)
+        return std::nullopt;
+
+    MappedFile mapped(filePath);
+    if (mapped.data())
+        return nbl::core::XXHash_256(mapped.data(), mapped.size());
+
+    // can't map (or empty), stream it through a small buffer instead
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+
+    nbl::core::XXHash256Hasher hasher(fileSize);
+    std::vector<char> buffer(std::min<size_t>(fileSize, 1ull << 20));
+    for (size_t remaining = fileSize; remaining;)
+    {
+        const size_t chunk = std::min(remaining, buffer.size());
+        if (!file.read(buffer.data(), chunk))
+            return std::nullopt;
+        hasher.update(reinterpret_cast<const uint8_t*>(buffer.data()), chunk);
+        remaining -= chunk;
+    }
+    return hasher.finalize();
+}
+
+static std::string toJson(const hash_t& hash)
+{
+    return "[" + std::to_string(hash[0]) + "," + std::to_string(hash[1]) + "," + std::to_string(hash[2]) + "," + std::to_string(hash[3]) + "]";
+}
+
+static std::string escapeJson(const std::string& str)
+{
+    std::string retval;
+    for (const char c : str)
+    {
+        if (c == '"' || c == '\\')
+            retval += '\\';
+        retval += c;
+    }
+    return retval;
+}
 
 int main(int argc, char* argv[]) {
     argparse::ArgumentParser program("Compute & returns xxHash256 to stdout as json");
 
     program.add_argument(NBL_FILE_ARG.data())
-        .required()
         .help("Input file path to hash for");
 
-    try 
+    program.add_argument(NBL_DIRECTORY_ARG.data())
+        .help("Input directory to recursively hash all files in, in parallel");
+
+    program.add_argument(NBL_THREADS_ARG.data())
+        .default_value(0u)
+        .scan<'u', uint32_t>()
+        .help("Number of threads to hash a directory with, 0 means all hardware threads");
+
+    try
     {
         program.parse_args(argc, argv);
     }
-    catch (const std::exception& err) 
+    catch (const std::exception& err)
     {
         std::cerr << err.what() << std::endl << program;
         return 1;
     }
-   
-    std::filesystem::path filePath = program.get<std::string>(NBL_FILE_ARG.data());
 
-    if (!std::filesystem::exists(filePath)) 
+    if (program.is_used(NBL_FILE_ARG.data()) == program.is_used(NBL_DIRECTORY_ARG.data()))
     {
-        std::cerr << "File does not exist: " << filePath << std::endl;
+        std::cerr << "Exactly one of " << NBL_FILE_ARG << " or " << NBL_DIRECTORY_ARG << " is required" << std::endl << program;
         return 1;
     }
 
-    const auto fileSize = std::filesystem::file_size(filePath);
-
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file) 
+    if (program.is_used(NBL_FILE_ARG.data()))
     {
-        std::cerr << "Failed to open file: " << filePath << std::endl;
-        return 1;
+        std::filesystem::path filePath = program.get<std::string>(NBL_FILE_ARG.data());
+
+        if (!std::filesystem::exists(filePath))
+        {
+            std::cerr << "File does not exist: " << filePath << std::endl;
+            return 1;
+        }
+
+        const auto hash = hashFile(filePath);
+        if (!hash)
+        {
+            std::cerr << "Failed to read file: " << filePath << std::endl;
+            return 1;
+        }
+
+        printf("{\"u64hash\": %s}", toJson(*hash).c_str());
+        return 0;
     }
 
-    std::vector<char> buffer(fileSize);
-    if (!file.read(buffer.data(), fileSize)) {
-        std::cerr << "Failed to read file: " << filePath << std::endl;
+    const std::filesystem::path directoryPath = program.get<std::string>(NBL_DIRECTORY_ARG.data());
+    if (!std::filesystem::is_directory(directoryPath))
+    {
+        std::cerr << "Directory does not exist: " << directoryPath << std::endl;
         return 1;
     }
 
-    std::array<uint64_t, 4> hash = {};
-    nbl::core::XXHash_256(buffer.data(), fileSize, hash.data());
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directoryPath))
+        if (entry.is_regular_file())
+            files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
 
-    printf("{\"u64hash\": [%s,%s,%s,%s]}", std::to_string(hash[0]).c_str(), std::to_string(hash[1]).c_str(), std::to_string(hash[2]).c_str(), std::to_string(hash[3]).c_str());
+    // files are handed out one at a time so a few big ones don't leave the other threads idle
+    std::vector<std::optional<hash_t>> hashes(files.size());
+    std::atomic_size_t nextFile = 0;
+    auto worker = [&]() -> void
+    {
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+            hashes[i] = hashFile(files[i]);
+    };
+
+    uint32_t threadCount = program.get<uint32_t>(NBL_THREADS_ARG.data());
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    threadCount = std::min<size_t>(threadCount, std::max<size_t>(files.size(), 1));
+    {
+        std::vector<std::jthread> threads;
+        for (uint32_t i = 1; i < threadCount; ++i)
+            threads.emplace_back(worker);
+        worker();
+    }
+
+    std::string json = "{\"files\": [";
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (!hashes[i])
+        {
+            std::cerr << "Failed to read file: " << files[i] << std::endl;
+            return 1;
+        }
+        if (i)
+            json += ", ";
+        json += "{\"path\": \"" + escapeJson(std::filesystem::relative(files[i], directoryPath).generic_string()) + "\", \"u64hash\": " + toJson(*hashes[i]) + "}";
+    }
+    json += "]}";
+    printf("%s", json.c_str());
 
     return 0;
-}
\ No newline at end of file
+}